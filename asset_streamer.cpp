@@ -0,0 +1,170 @@
+#include "asset_streamer.h"
+
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <exception>
+
+AssetStreamer::AssetStreamer(FileSource& source, unsigned threadCount) : mSource(source), mNextId(1), mStopping(false), mStatistics()
+{
+	for (auto i = 0u; i < threadCount; i++) {
+		mThreads.emplace_back([this] { Main(); });
+	}
+}
+
+AssetStreamer::~AssetStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+	for (auto& thread : mThreads) {
+		thread.join();
+	}
+}
+
+// ============================================================================
+// Request an asset to be loaded and decoded in the background.
+//
+// The decode function is called on a background thread with the contents of
+// the file and it may throw to fail the request. Requests with the highest
+// priority are started first, and requests with the same priority in order.
+// ============================================================================
+uint64_t AssetStreamer::Request(const std::string& path, int priority, const CancellationToken& token, DecodeFunction decode)
+{
+	uint64_t id;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		id = mNextId++;
+		mRequests.push_back({ id, priority, path, token, std::move(decode) });
+		std::push_heap(mRequests.begin(), mRequests.end(), IsLowerPriority);
+		mStatistics.requestCount++;
+	}
+	mCondition.notify_one();
+	return id;
+}
+
+// ============================================================================
+// Load and decode the request with the highest priority on this thread.
+//
+// This is the work of the background threads, but it can be called directly
+// as well to drive a streamer without any threads step by step. Returns false
+// when there was no pending request.
+// ============================================================================
+bool AssetStreamer::ProcessRequest()
+{
+	PendingRequest request;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mRequests.empty()) {
+			return false;
+		}
+		std::pop_heap(mRequests.begin(), mRequests.end(), IsLowerPriority);
+		request = std::move(mRequests.back());
+		mRequests.pop_back();
+	}
+
+	// the request is checked for cancellation before and after each stage.
+	AssetCompletion completion;
+	completion.id = request.id;
+	completion.priority = request.priority;
+	completion.status = AssetStatus::Cancelled;
+	completion.token = request.token;
+	if (!request.token.IsCancelled()) {
+		PROFILE_SCOPE("LoadAsset");
+		try {
+			auto contents = mSource.Open(request.path);
+			if (!request.token.IsCancelled()) {
+				completion.asset = request.decode(std::move(contents));
+				completion.status = AssetStatus::Loaded;
+			}
+		} catch (const std::exception& exception) {
+			completion.status = AssetStatus::Failed;
+			completion.error = exception.what();
+		}
+	}
+	mCompletions.Push(std::move(completion));
+	return true;
+}
+
+// ============================================================================
+// Deliver the completed requests to the render thread within a byte budget.
+//
+// Loaded assets are handed out by priority until the next one would exceed
+// the budget. The rest waits for the next frames, but the first asset of a
+// frame is always handed out so that the assets larger than the budget are
+// not stuck. Failed and cancelled requests do not use any budget.
+// ============================================================================
+uint64_t AssetStreamer::Update(uint64_t byteBudget, const CompletionFunction& complete)
+{
+	AssetCompletion completion;
+	while (mCompletions.Pop(completion)) {
+		mReady.push_back(std::move(completion));
+	}
+	std::stable_sort(mReady.begin(), mReady.end(), [](const AssetCompletion& first, const AssetCompletion& second) {
+		return first.priority > second.priority;
+	});
+
+	uint64_t bytes = 0;
+	size_t count = 0;
+	for (; count < mReady.size(); count++) {
+		auto& ready = mReady[count];
+		if (ready.status == AssetStatus::Loaded && ready.token.IsCancelled()) {
+			ready.status = AssetStatus::Cancelled;
+			ready.asset.reset();
+		}
+		if (ready.status == AssetStatus::Loaded) {
+			auto size = ready.asset->UploadSize();
+			if (bytes != 0 && bytes + size > byteBudget) {
+				break;
+			}
+			bytes += size;
+			mStatistics.loadedCount++;
+		} else if (ready.status == AssetStatus::Failed) {
+			mStatistics.failedCount++;
+		} else {
+			mStatistics.cancelledCount++;
+		}
+		complete(ready);
+	}
+	mReady.erase(mReady.begin(), mReady.begin() + count);
+	mStatistics.uploadedBytes += bytes;
+	mStatistics.deferredCount += mReady.size();
+	return bytes;
+}
+
+// ============================================================================
+// Get the amount of requests which have not been started yet.
+// ============================================================================
+size_t AssetStreamer::PendingRequestCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRequests.size();
+}
+
+// ============================================================================
+// Order the requests by priority and then by the order of the requests.
+// ============================================================================
+bool AssetStreamer::IsLowerPriority(const PendingRequest& first, const PendingRequest& second)
+{
+	return first.priority < second.priority || (first.priority == second.priority && first.id > second.id);
+}
+
+// ============================================================================
+// The main function of the background threads.
+// ============================================================================
+void AssetStreamer::Main()
+{
+	FrameProfiler::Instance().SetThreadName("AssetStreamer");
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mStopping || !mRequests.empty(); });
+			if (mStopping) {
+				return;
+			}
+		}
+		ProcessRequest();
+	}
+}
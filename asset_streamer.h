@@ -0,0 +1,120 @@
+#pragma once
+
+#include "file_source.h"
+#include "mpsc_queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// A token which cancels the asset requests it was given to.
+//
+// Copies of a token share the same state, so the requester keeps a copy and
+// cancels the request while the streamer checks it between the stages.
+// ============================================================================
+class CancellationToken
+{
+public:
+	CancellationToken() : mCancelled(std::make_shared<std::atomic<bool>>(false)) {}
+	void Cancel() const { mCancelled->store(true, std::memory_order_relaxed); }
+	bool IsCancelled() const { return mCancelled->load(std::memory_order_relaxed); }
+private:
+	std::shared_ptr<std::atomic<bool>>	mCancelled;
+};
+
+// ============================================================================
+// An interface for a decoded asset which is ready to be uploaded.
+// ============================================================================
+class Asset
+{
+public:
+	virtual ~Asset() = default;
+	virtual uint64_t UploadSize() const = 0;
+};
+
+// ============================================================================
+// The states in which an asset request completes.
+// ============================================================================
+enum class AssetStatus
+{
+	Loaded,
+	Failed,
+	Cancelled
+};
+
+// ============================================================================
+// A completed asset request delivered to the render thread.
+// ============================================================================
+struct AssetCompletion
+{
+	uint64_t				id;
+	int						priority;
+	AssetStatus				status;
+	std::unique_ptr<Asset>	asset;
+	std::string				error;
+	CancellationToken		token;
+};
+
+// ============================================================================
+// The counters of the asset streamer.
+// ============================================================================
+struct AssetStreamerStatistics
+{
+	uint64_t	requestCount;
+	uint64_t	loadedCount;
+	uint64_t	failedCount;
+	uint64_t	cancelledCount;
+	uint64_t	uploadedBytes;
+	uint64_t	deferredCount;
+};
+
+// ============================================================================
+// A service that loads assets in the background by priority.
+//
+// Requests are read and decoded on the background threads in the order of
+// their priority. Completions are delivered to the render thread through a
+// lock-free queue and handed out within a per-frame upload byte budget.
+// ============================================================================
+class AssetStreamer
+{
+public:
+	typedef std::function<std::unique_ptr<Asset>(std::unique_ptr<FileContents> contents)> DecodeFunction;
+	typedef std::function<void(AssetCompletion& completion)> CompletionFunction;
+	AssetStreamer(FileSource& source, unsigned threadCount);
+	~AssetStreamer();
+	uint64_t Request(const std::string& path, int priority, const CancellationToken& token, DecodeFunction decode);
+	bool ProcessRequest();
+	uint64_t Update(uint64_t byteBudget, const CompletionFunction& complete);
+	size_t PendingRequestCount() const;
+	size_t ReadyCount() const { return mReady.size(); }
+	const AssetStreamerStatistics& Statistics() const { return mStatistics; }
+private:
+	struct PendingRequest
+	{
+		uint64_t			id;
+		int					priority;
+		std::string			path;
+		CancellationToken	token;
+		DecodeFunction		decode;
+	};
+	static bool IsLowerPriority(const PendingRequest& first, const PendingRequest& second);
+	void Main();
+private:
+	FileSource&						mSource;
+	mutable std::mutex				mMutex;
+	std::condition_variable			mCondition;
+	std::vector<PendingRequest>		mRequests;
+	uint64_t						mNextId;
+	bool							mStopping;
+	MpscQueue<AssetCompletion>		mCompletions;
+	std::vector<AssetCompletion>	mReady;
+	AssetStreamerStatistics			mStatistics;
+	std::vector<std::thread>		mThreads;
+};
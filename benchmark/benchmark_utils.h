@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// A summary of the samples collected during a benchmark run.
+// ============================================================================
+struct Summary
+{
+	double mean;
+	double p50;
+	double p99;
+	double max;
+};
+
+// ============================================================================
+// Summarize the given samples with the mean and nearest rank percentiles.
+// ============================================================================
+inline Summary Summarize(std::vector<double> samples)
+{
+	Summary summary = {};
+	if (samples.empty()) {
+		return summary;
+	}
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](double p) {
+		auto rank = static_cast<size_t>(p * samples.size() + 0.5);
+		return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+	};
+	for (auto sample : samples) {
+		summary.mean += sample;
+	}
+	summary.mean /= samples.size();
+	summary.p50 = percentile(0.50);
+	summary.p99 = percentile(0.99);
+	summary.max = samples.back();
+	return summary;
+}
+
+// ============================================================================
+// Format a summary as a JSON object.
+// ============================================================================
+inline std::string SummaryJson(const Summary& summary)
+{
+	char buffer[160];
+	std::snprintf(buffer, sizeof(buffer), "{\"mean\": %.6f, \"p50\": %.6f, \"p99\": %.6f, \"max\": %.6f}", summary.mean, summary.p50, summary.p99, summary.max);
+	return buffer;
+}
+
+// ============================================================================
+// Get the elapsed time between two time points in milliseconds.
+// ============================================================================
+inline double Milliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// ============================================================================
+// Parse a comma separated list of unsigned integers (e.g. "1,2,3").
+//
+// The list always contains at least one value, so the callers may take the
+// first value of it. An empty list or a value that is not a number is a usage
+// error, which is reported before the program exits.
+// ============================================================================
+inline std::vector<unsigned> ParseList(const std::string& text)
+{
+	std::vector<unsigned> values;
+	size_t start = 0;
+	do {
+		auto end = text.find(',', start);
+		if (end == std::string::npos) {
+			end = text.size();
+		}
+		auto item = text.substr(start, end - start);
+		char* itemEnd = nullptr;
+		auto value = std::strtoul(item.c_str(), &itemEnd, 10);
+		if (item.empty() || item[0] == '-' || *itemEnd != '\0') {
+			std::fprintf(stderr, "invalid list of numbers: \"%s\"\n", text.c_str());
+			std::exit(1);
+		}
+		values.push_back(static_cast<unsigned>(value));
+		start = end + 1;
+	} while (start <= text.size());
+	return values;
+}
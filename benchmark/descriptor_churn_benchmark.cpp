@@ -0,0 +1,142 @@
+#include "descriptor_allocator.h"
+#include "benchmark_utils.h"
+
+#include <random>
+
+// ============================================================================
+// The options of the descriptor churn benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				frames = 2000;
+	unsigned				liveTarget = 4000;
+	unsigned				churnPerFrame = 200;
+	unsigned				tablesPerFrame = 500;
+	unsigned				frameLatency = 2;
+	unsigned				increment = 32;
+	unsigned				seed = 1234;
+	std::vector<unsigned>	tableSizes = { 1, 4, 16 };
+};
+
+// ============================================================================
+// Run the allocators for a single descriptor table size and print it as JSON.
+//
+// Each frame frees and allocates views in the CPU heaps at random, with up to
+// eight descriptors in a view like the mips or the planes of a texture. The
+// frame then builds its descriptor tables in the ring from random live views,
+// once with a copy batch for each table and once with a copy for each view.
+// The simulated GPU completes frames so that the frame latency is kept in
+// flight.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned tableSize, bool first)
+{
+	SimulatedDescriptorDevice device(options.increment);
+	SimulatedTimeline timeline;
+	CpuDescriptorAllocator allocator(device, DescriptorHeapType::Resource, 1024);
+	DescriptorRing ring(device, timeline, DescriptorHeapType::Resource, std::max(2 * options.tablesPerFrame * tableSize * (options.frameLatency + 1), 1024u));
+	DescriptorCopyBatch batch(device, DescriptorHeapType::Resource);
+	std::mt19937 random(options.seed);
+
+	std::vector<DescriptorRange> live;
+	auto allocateView = [&] { live.push_back(allocator.Allocate(1 + random() % 8)); };
+	while (live.size() < options.liveTarget) {
+		allocateView();
+	}
+
+	std::vector<double> allocateTimes, freeTimes, batchedTimes, unbatchedTimes, batchedCalls, unbatchedCalls;
+	auto churn = std::min(options.churnPerFrame, options.liveTarget - 1);
+	for (auto frame = 0u; frame < options.frames; frame++) {
+		ring.Reclaim();
+
+		// churn the views of the CPU heaps.
+		auto start = std::chrono::steady_clock::now();
+		for (auto i = 0u; i < churn; i++) {
+			auto index = random() % live.size();
+			std::swap(live[index], live.back());
+			allocator.Free(live.back());
+			live.pop_back();
+		}
+		freeTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / std::max(churn, 1u));
+		start = std::chrono::steady_clock::now();
+		for (auto i = 0u; i < churn; i++) {
+			allocateView();
+		}
+		allocateTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / std::max(churn, 1u));
+
+		// build the tables of the frame with the batched and with the separate copies.
+		for (auto batched : { true, false }) {
+			auto calls = device.CopyCallCount();
+			start = std::chrono::steady_clock::now();
+			for (auto i = 0u; i < options.tablesPerFrame; i++) {
+				auto table = ring.Allocate(tableSize);
+				for (auto j = 0u; j < tableSize; j++) {
+					auto& view = live[random() % live.size()];
+					batch.Copy(table.CpuHandle(j), view.cpuHandle, 1, view.increment);
+					if (!batched) {
+						batch.Flush();
+					}
+				}
+				batch.Flush();
+			}
+			auto time = Milliseconds(std::chrono::steady_clock::now() - start);
+			(batched ? batchedTimes : unbatchedTimes).push_back(time);
+			(batched ? batchedCalls : unbatchedCalls).push_back(device.CopyCallCount() - calls);
+		}
+		ring.EndFrame(timeline.Signal());
+		while (timeline.PendingCount() >= options.frameLatency) {
+			timeline.Advance();
+		}
+	}
+
+	std::printf("%s\n    {\"tableSize\": %u, \"frames\": %u, \"liveTarget\": %u, \"churnPerFrame\": %u, \"tablesPerFrame\": %u, \"heaps\": %u, \"ringWaits\": %u,\n",
+		first ? "" : ",", tableSize, options.frames, options.liveTarget, options.churnPerFrame, options.tablesPerFrame, allocator.HeapCount(), ring.WaitCount());
+	std::printf("     \"allocateNs\": %s,\n", SummaryJson(Summarize(allocateTimes)).c_str());
+	std::printf("     \"freeNs\": %s,\n", SummaryJson(Summarize(freeTimes)).c_str());
+	std::printf("     \"batchedTablesMs\": %s, \"batchedCopyCalls\": %.0f,\n", SummaryJson(Summarize(batchedTimes)).c_str(), Summarize(batchedCalls).mean);
+	std::printf("     \"unbatchedTablesMs\": %s, \"unbatchedCopyCalls\": %.0f}", SummaryJson(Summarize(unbatchedTimes)).c_str(), Summarize(unbatchedCalls).mean);
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the descriptor churn benchmark.
+//
+// Benchmark measures the allocation and free latency of the CPU descriptor
+// heaps under churn and the cost of building the descriptor tables of a frame
+// in the shader visible ring with and without batching the copies.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--live") {
+			options.liveTarget = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--churn") {
+			options.churnPerFrame = ParseList(value)[0];
+		} else if (name == "--tables") {
+			options.tablesPerFrame = ParseList(value)[0];
+		} else if (name == "--latency") {
+			options.frameLatency = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--increment") {
+			options.increment = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--seed") {
+			options.seed = ParseList(value)[0];
+		} else if (name == "--table-sizes") {
+			options.tableSizes = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"descriptor_churn\", \"runs\": [");
+	auto first = true;
+	for (auto tableSize : options.tableSizes) {
+		RunConfiguration(options, std::max(tableSize, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,158 @@
+#include "null_renderer.h"
+#include "software_renderer.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+
+// ============================================================================
+// The options of the frame benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	std::string					backend = "software";
+	unsigned					frames = 300;
+	unsigned					warmupFrames = 30;
+	unsigned					threads = std::max(std::thread::hardware_concurrency(), 1u);
+	unsigned					gpuFrameTime = 0;
+	std::vector<unsigned>		triangleCounts = { 1, 1000, 10000 };
+	std::vector<unsigned>		latencies = { 1, 2, 3 };
+	std::vector<std::string>	resolutions = { "1280x720", "1920x1080" };
+};
+
+// ============================================================================
+// Generate a deterministic set of small clockwise triangles.
+//
+// The first triangle is always the application triangle so that the run with
+// a single triangle measures the same frame as the application would render.
+// ============================================================================
+std::vector<Vertex> GenerateTriangles(unsigned count)
+{
+	std::vector<Vertex> vertices;
+	if (count == 0) {
+		return vertices;
+	}
+	vertices = TriangleVertices();
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-0.95f, 0.95f), color(0.f, 1.f), angle(0.f, 6.2831853f);
+	for (auto i = 1u; i < count; i++) {
+		auto x = position(random), y = position(random), a = angle(random);
+		for (auto j = 0; j < 3; j++) {
+			auto corner = a - j * 2.0943951f;
+			vertices.push_back({ { x + 0.05f * std::cos(corner), y + 0.05f * std::sin(corner), 0.f }, { color(random), color(random), color(random), 1.f } });
+		}
+	}
+	return vertices;
+}
+
+// ============================================================================
+// Create a rendering backend with the given frame latency.
+// ============================================================================
+std::unique_ptr<RenderBackend> CreateBackend(const Options& options, unsigned latency)
+{
+	if (options.backend == "null") {
+		return std::make_unique<NullRenderer>(latency, std::chrono::microseconds(options.gpuFrameTime));
+	}
+	if (options.backend == "software") {
+		return std::make_unique<SoftwareRenderer>(options.threads, latency);
+	}
+	std::fprintf(stderr, "unknown backend: %s\n", options.backend.c_str());
+	std::exit(1);
+}
+
+// ============================================================================
+// Run the render loop for a single configuration and print it as JSON.
+//
+// CPU frame time is measured over the whole Render() call, while submission
+// time excludes the time the frame pipeline spent waiting for a free slot.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned width, unsigned height, unsigned triangles, unsigned latency, bool first)
+{
+	auto backend = CreateBackend(options, latency);
+	backend->SetWindow(width, height);
+	backend->SetGeometry(GenerateTriangles(triangles));
+	for (auto i = 0u; i < options.warmupFrames; i++) {
+		backend->Render();
+	}
+	backend->WaitForGPU();
+
+	std::vector<double> frameTimes, submitTimes;
+	frameTimes.reserve(options.frames);
+	submitTimes.reserve(options.frames);
+	auto start = std::chrono::steady_clock::now();
+	for (auto i = 0u; i < options.frames; i++) {
+		auto frameStart = std::chrono::steady_clock::now();
+		backend->Render();
+		auto frameTime = std::chrono::steady_clock::now() - frameStart;
+		frameTimes.push_back(Milliseconds(frameTime));
+		submitTimes.push_back(Milliseconds(frameTime - backend->Pipeline().LastWaitTime()));
+	}
+	backend->WaitForGPU();
+	auto total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s\n    {\"backend\": \"%s\", \"width\": %u, \"height\": %u, \"triangles\": %u, \"frameLatency\": %u, \"threads\": %u, \"frames\": %u, \"fps\": %.3f,\n",
+		first ? "" : ",", options.backend.c_str(), width, height, triangles, latency, options.threads, options.frames, options.frames / total);
+	std::printf("     \"cpuFrameTimeMs\": %s,\n", SummaryJson(Summarize(frameTimes)).c_str());
+	std::printf("     \"submitTimeMs\": %s}", SummaryJson(Summarize(submitTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the frame benchmark.
+//
+// Benchmark renders the given amount of frames for each combination of the
+// resolution, triangle count and frame latency and reports results as JSON.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--backend") {
+			options.backend = value;
+		} else if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--warmup") {
+			options.warmupFrames = ParseList(value)[0];
+		} else if (name == "--threads") {
+			options.threads = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--gpu-time-us") {
+			options.gpuFrameTime = ParseList(value)[0];
+		} else if (name == "--triangles") {
+			options.triangleCounts = ParseList(value);
+		} else if (name == "--latencies") {
+			options.latencies = ParseList(value);
+		} else if (name == "--resolutions") {
+			options.resolutions.clear();
+			for (size_t start = 0, end = 0; start < value.size(); start = end + 1) {
+				end = value.find(',', start);
+				end = (end == std::string::npos) ? value.size() : end;
+				options.resolutions.push_back(value.substr(start, end - start));
+			}
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"frame\", \"runs\": [");
+	auto first = true;
+	for (auto& resolution : options.resolutions) {
+		unsigned width = 0, height = 0;
+		if (std::sscanf(resolution.c_str(), "%ux%u", &width, &height) != 2) {
+			std::fprintf(stderr, "invalid resolution: %s\n", resolution.c_str());
+			return 1;
+		}
+		for (auto triangles : options.triangleCounts) {
+			for (auto latency : options.latencies) {
+				RunConfiguration(options, width, height, triangles, std::max(latency, 1u), first);
+				first = false;
+			}
+		}
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
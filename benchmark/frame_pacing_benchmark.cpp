@@ -0,0 +1,128 @@
+#include "frame_pacer.h"
+#include "benchmark_utils.h"
+
+#include <deque>
+#include <random>
+
+// ============================================================================
+// The options of the frame pacing benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				frames = 2000;
+	unsigned				refreshHz = 60;
+	std::vector<unsigned>	maxLatencies = { 1, 2 };
+	double					marginMilliseconds = 1.0;
+};
+
+// ============================================================================
+// A generator of the CPU and GPU work durations of the frames.
+// ============================================================================
+struct WorkTrace
+{
+	const char*	name;
+	double		cpuMilliseconds;
+	double		gpuMilliseconds;
+	double		jitterMilliseconds;
+};
+
+// ============================================================================
+// Simulate the frames of a present mode on a simulated display and print JSON.
+//
+// The CPU work of a frame starts when the pacer allows it and the GPU work
+// follows the CPU work and the GPU work of the previous frame. Frames with
+// vertical sync are shown in order, one per vertical blank, and tearing
+// frames as soon as the GPU is done. The next frame waits while the maximum
+// latency of frames are not yet shown, as the blocking present or the latency
+// waitable object does. Latency is measured from the start of the CPU
+// work, where the input is sampled, to the moment the frame is shown.
+// ============================================================================
+void RunConfiguration(const Options& options, const WorkTrace& trace, PresentMode mode, unsigned maxLatency, bool first)
+{
+	const uint64_t refresh = 1000000000ull / options.refreshHz;
+	SimulatedClock clock(1000000000ull);
+	SimulatedDisplayClock display(refresh, 0);
+	FramePacer pacer(clock, display, { mode, maxLatency, static_cast<uint64_t>(options.marginMilliseconds * 1e6), 16 });
+
+	std::mt19937 random(1234);
+	std::normal_distribution<double> jitter(0.0, trace.jitterMilliseconds);
+	auto duration = [&](double milliseconds) { return static_cast<uint64_t>(std::max(milliseconds + jitter(random), 0.1) * 1e6); };
+	std::deque<uint64_t> queued;
+	std::vector<double> latencies;
+	uint64_t gpuEnd = 0, lastShown = 0;
+	unsigned repeatedVblanks = 0;
+	for (auto i = 0u; i < options.frames; i++) {
+		// wait until a queued frame has been shown when the queue is full.
+		while (!queued.empty() && queued.front() <= clock.Now()) {
+			queued.pop_front();
+		}
+		if (queued.size() >= maxLatency) {
+			clock.SleepUntil(queued[queued.size() - maxLatency]);
+		}
+
+		auto start = pacer.BeginFrame();
+		clock.SleepUntil(start + duration(trace.cpuMilliseconds));
+		gpuEnd = std::max(clock.Now(), gpuEnd) + duration(trace.gpuMilliseconds);
+		uint64_t shown = gpuEnd;
+		if (mode != PresentMode::Tearing) {
+			auto vblank = display.LastVblank(gpuEnd);
+			shown = std::max((vblank == gpuEnd) ? vblank : vblank + refresh, lastShown + refresh);
+			if (lastShown != 0) {
+				repeatedVblanks += static_cast<unsigned>((shown - lastShown) / refresh - 1);
+			}
+		}
+		queued.push_back(shown);
+		lastShown = shown;
+		pacer.EndFrame(gpuEnd - start);
+		latencies.push_back((shown - start) / 1e6);
+	}
+
+	const char* modeNames[] = { "vsync", "tearing", "latency_waitable" };
+	std::printf("%s\n    {\"trace\": \"%s\", \"mode\": \"%s\", \"frames\": %u, \"maxLatency\": %u, \"repeatedVblanks\": %u, \"missedFrames\": %llu,\n",
+		first ? "" : ",", trace.name, modeNames[static_cast<unsigned>(mode)], options.frames, maxLatency, repeatedVblanks, static_cast<unsigned long long>(pacer.MissedFrameCount()));
+	std::printf("     \"latencyMs\": %s}", SummaryJson(Summarize(latencies)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the frame pacing benchmark.
+//
+// Benchmark simulates the present modes with the frame pacer against a
+// simulated display clock for a few work patterns and reports the input to
+// display latency and the vertical blanks where a frame was shown again.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--refresh-hz") {
+			options.refreshHz = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--max-latency") {
+			options.maxLatencies = ParseList(value);
+		} else if (name == "--margin-ms") {
+			options.marginMilliseconds = std::max(std::atof(value.c_str()), 0.0);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	const WorkTrace traces[] = { { "light", 3.0, 4.0, 0.2 }, { "jittery", 4.0, 7.0, 2.0 }, { "heavy", 5.0, 14.0, 1.0 } };
+	std::printf("{\"benchmark\": \"frame_pacing\", \"runs\": [");
+	auto first = true;
+	for (auto& trace : traces) {
+		// the vsync and the tearing frames use the default maximum latency of the swap chain.
+		for (auto mode : { PresentMode::Vsync, PresentMode::Tearing }) {
+			RunConfiguration(options, trace, mode, 3, first);
+			first = false;
+		}
+		for (auto maxLatency : options.maxLatencies) {
+			RunConfiguration(options, trace, PresentMode::LatencyWaitable, std::max(maxLatency, 1u), false);
+		}
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include "bounding_volume_hierarchy.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+#include <random>
+
+// ============================================================================
+// The options of the frustum culling benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 10;
+	float					movingFraction = 0.1f;
+	std::vector<unsigned>	objectCounts = { 10000, 100000, 1000000 };
+};
+
+// ============================================================================
+// Generate a deterministic set of object boxes scattered around the camera.
+// ============================================================================
+std::vector<Aabb> GenerateObjects(unsigned count)
+{
+	std::vector<Aabb> objects(count);
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-500.f, 500.f), extent(0.5f, 4.f);
+	for (auto& object : objects) {
+		for (auto axis = 0; axis < 3; axis++) {
+			auto center = position(random), halfSize = extent(random);
+			object.minimum[axis] = center - halfSize;
+			object.maximum[axis] = center + halfSize;
+		}
+	}
+	return objects;
+}
+
+// ============================================================================
+// Build a perspective view projection looking along the z axis rotated by yaw.
+// ============================================================================
+std::array<float, 16> ViewProjection(float yaw)
+{
+	const float nearZ = 0.1f, farZ = 400.f;
+	auto c = std::cos(yaw), s = std::sin(yaw), depth = farZ / (farZ - nearZ);
+	return { {
+		c, 0.f, -s, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		s * depth, 0.f, c * depth, -nearZ * depth,
+		s, 0.f, c, 0.f
+	} };
+}
+
+// ============================================================================
+// Run the culling for a single configuration and print it as JSON.
+//
+// Every repeat moves a fraction of the objects and refits the hierarchy,
+// then culls the objects with the hierarchy and by testing every object with
+// the vector and with the scalar kernels.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned objectCount, bool first)
+{
+	auto objects = GenerateObjects(objectCount);
+	auto buildStart = std::chrono::steady_clock::now();
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(objects);
+	auto buildTime = Milliseconds(std::chrono::steady_clock::now() - buildStart);
+	SoaBounds bounds;
+	bounds.Resize(objectCount);
+	for (auto i = 0u; i < objectCount; i++) {
+		bounds.Set(i, objects[i]);
+	}
+
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<float> offset(-1.f, 1.f);
+	auto movingCount = static_cast<unsigned>(objectCount * options.movingFraction);
+	std::vector<uint32_t> visible, bruteForce(objectCount);
+	std::vector<double> refitTimes, hierarchyTimes, vectorTimes, scalarTimes;
+	size_t visibleCount = 0;
+	for (auto i = 0u; i < options.repeats; i++) {
+		for (auto j = 0u; j < movingCount; j++) {
+			auto id = static_cast<uint32_t>(random() % objectCount);
+			auto& object = objects[id];
+			for (auto axis = 0; axis < 3; axis++) {
+				auto delta = offset(random);
+				object.minimum[axis] += delta;
+				object.maximum[axis] += delta;
+			}
+			hierarchy.Update(id, object);
+			bounds.Set(id, object);
+		}
+		auto start = std::chrono::steady_clock::now();
+		hierarchy.Refit();
+		auto refitted = std::chrono::steady_clock::now();
+		auto frustum = Frustum::FromMatrix(ViewProjection(i * 0.6f));
+		hierarchy.Cull(frustum, visible);
+		auto culled = std::chrono::steady_clock::now();
+		visibleCount = CullBounds(bounds, 0, objectCount, frustum, FRUSTUM_ALL_PLANES, nullptr, bruteForce.data());
+		auto vectorCulled = std::chrono::steady_clock::now();
+		auto scalarCount = CullBoundsScalar(bounds, 0, objectCount, frustum, FRUSTUM_ALL_PLANES, nullptr, bruteForce.data());
+		auto scalarCulled = std::chrono::steady_clock::now();
+		if (visible.size() != visibleCount || scalarCount != visibleCount) {
+			std::fprintf(stderr, "visible object counts differ: %zu, %zu, %zu\n", visible.size(), visibleCount, scalarCount);
+			std::exit(1);
+		}
+		refitTimes.push_back(Milliseconds(refitted - start));
+		hierarchyTimes.push_back(Milliseconds(culled - refitted));
+		vectorTimes.push_back(Milliseconds(vectorCulled - culled));
+		scalarTimes.push_back(Milliseconds(scalarCulled - vectorCulled));
+	}
+
+	auto hierarchyCull = Summarize(hierarchyTimes);
+	std::printf("%s\n    {\"objects\": %u, \"movingObjects\": %u, \"nodes\": %zu, \"visible\": %zu, \"buildMs\": %.3f,\n",
+		first ? "" : ",", objectCount, movingCount, hierarchy.NodeCount(), visibleCount, buildTime);
+	std::printf("     \"mobjectsPerSecond\": %.1f, \"refitMs\": %s,\n", objectCount / (hierarchyCull.p50 / 1000.0) / 1e6, SummaryJson(Summarize(refitTimes)).c_str());
+	std::printf("     \"hierarchyCullMs\": %s,\n", SummaryJson(hierarchyCull).c_str());
+	std::printf("     \"vectorCullMs\": %s,\n", SummaryJson(Summarize(vectorTimes)).c_str());
+	std::printf("     \"scalarCullMs\": %s}", SummaryJson(Summarize(scalarTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the frustum culling benchmark.
+//
+// Benchmark scatters the given amount of objects, moves a fraction of them
+// each frame and reports the refit and culling times of the hierarchy next
+// to testing every object with the vector and the scalar kernels.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--moving-percent") {
+			options.movingFraction = std::min(ParseList(value)[0], 100u) / 100.f;
+		} else if (name == "--objects") {
+			options.objectCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"frustum_culling\", \"runs\": [");
+	auto first = true;
+	for (auto objects : options.objectCounts) {
+		RunConfiguration(options, std::max(objects, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include "gpu_memory_allocator.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+#include <random>
+
+// ============================================================================
+// The options of the heap allocator benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				operations = 200000;
+	unsigned				liveTarget = 2000;
+	unsigned				blockMb = 64;
+	unsigned				seed = 1234;
+	std::vector<unsigned>	maxSizesKb = { 64, 1024, 16384 };
+};
+
+// ============================================================================
+// A heap factory that hands out fake heap handles without any memory.
+// ============================================================================
+class NullHeapFactory : public GpuHeapFactory
+{
+public:
+	void* CreateHeap(HeapType, ResourceClass, uint64_t) override { return reinterpret_cast<void*>(++mHeapCount); }
+	void DestroyHeap(void*) override {}
+private:
+	uintptr_t	mHeapCount = 0;
+};
+
+// ============================================================================
+// Get the fragmentation of the free memory of the given statistics.
+//
+// Fragmentation is zero when all free memory is in a single block and grows
+// towards one when the free memory is split into many small blocks.
+// ============================================================================
+double Fragmentation(const HeapStatistics& statistics)
+{
+	auto freeBytes = statistics.reservedBytes - statistics.usedBytes;
+	return (freeBytes == 0) ? 0.0 : 1.0 - static_cast<double>(statistics.largestFreeBlock) / freeBytes;
+}
+
+// ============================================================================
+// Measure the cost of timing a single operation, which the latencies include.
+// ============================================================================
+double TimerOverhead()
+{
+	std::vector<double> samples;
+	for (auto i = 0; i < 10000; i++) {
+		auto start = std::chrono::steady_clock::now();
+		samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+	}
+	return Summarize(samples).p50;
+}
+
+// ============================================================================
+// Run a randomized workload with the given maximum size and print it as JSON.
+//
+// Sizes are log-uniformly distributed between 256 bytes and the maximum size
+// and rounded and aligned to 64KB like D3D12 placed buffers. The workload allocates until the
+// live target is reached and then frees and allocates at random.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned maxSizeKb, bool first)
+{
+	NullHeapFactory factory;
+	GpuMemoryAllocator allocator(factory, static_cast<uint64_t>(options.blockMb) << 20);
+	std::mt19937 random(options.seed);
+	std::uniform_real_distribution<double> logSize(std::log(256.0), std::log(maxSizeKb * 1024.0));
+
+	std::vector<GpuAllocation> live;
+	std::vector<double> allocateTimes, freeTimes, fragmentation, utilization;
+	for (auto i = 0u; i < options.operations; i++) {
+		auto allocate = live.size() < options.liveTarget / 2 || (live.size() < options.liveTarget * 2 && random() % 2 == 0);
+		auto start = std::chrono::steady_clock::now();
+		if (allocate) {
+			auto size = (static_cast<uint64_t>(std::exp(logSize(random))) + 65535) & ~65535ull;
+			live.push_back(allocator.Allocate(HeapType::Default, ResourceClass::Buffer, size, 65536));
+			allocateTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+		} else {
+			auto index = random() % live.size();
+			std::swap(live[index], live.back());
+			start = std::chrono::steady_clock::now();
+			allocator.Free(live.back());
+			freeTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+			live.pop_back();
+		}
+		if (i % 1000 == 0) {
+			auto statistics = allocator.Statistics(HeapType::Default);
+			fragmentation.push_back(Fragmentation(statistics));
+			utilization.push_back(static_cast<double>(statistics.usedBytes) / statistics.reservedBytes);
+		}
+	}
+
+	// defragment the blocks. The copies are taken as completed right away, as there is no GPU.
+	auto before = allocator.Statistics(HeapType::Default);
+	auto defragmentStart = std::chrono::steady_clock::now();
+	auto moves = allocator.Defragment(HeapType::Default, ResourceClass::Buffer, UINT64_MAX, 1, [&](const GpuAllocation& from, const GpuAllocation& to) {
+		for (auto& allocation : live) {
+			if (allocation.block == from.block && allocation.offset == from.offset) {
+				allocation = to;
+				return true;
+			}
+		}
+		return false;
+	});
+	allocator.ReleaseRetired(1);
+	allocator.ReleaseEmptyBlocks();
+	auto defragmentTime = Milliseconds(std::chrono::steady_clock::now() - defragmentStart);
+	auto after = allocator.Statistics(HeapType::Default);
+
+	std::printf("%s\n    {\"maxSizeKb\": %u, \"operations\": %u, \"liveTarget\": %u, \"blockMb\": %u,\n", first ? "" : ",", maxSizeKb, options.operations, options.liveTarget, options.blockMb);
+	std::printf("     \"allocateNs\": %s,\n", SummaryJson(Summarize(allocateTimes)).c_str());
+	std::printf("     \"freeNs\": %s,\n", SummaryJson(Summarize(freeTimes)).c_str());
+	std::printf("     \"fragmentation\": %s,\n", SummaryJson(Summarize(fragmentation)).c_str());
+	std::printf("     \"utilization\": %s,\n", SummaryJson(Summarize(utilization)).c_str());
+	std::printf("     \"defragment\": {\"moves\": %u, \"timeMs\": %.3f, \"blocksBefore\": %u, \"blocksAfter\": %u, \"utilizationBefore\": %.3f, \"utilizationAfter\": %.3f}}",
+		moves, defragmentTime, before.blockCount, after.blockCount, static_cast<double>(before.usedBytes) / before.reservedBytes, static_cast<double>(after.usedBytes) / after.reservedBytes);
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the heap allocator benchmark.
+//
+// Benchmark measures the allocation and free latency, the fragmentation and
+// the utilization of the heap blocks under randomized workloads, and the
+// effect of a defragmentation pass.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--operations") {
+			options.operations = ParseList(value)[0];
+		} else if (name == "--live") {
+			options.liveTarget = std::max(ParseList(value)[0], 2u);
+		} else if (name == "--block-mb") {
+			options.blockMb = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--seed") {
+			options.seed = ParseList(value)[0];
+		} else if (name == "--max-sizes-kb") {
+			options.maxSizesKb = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"heap_allocator\", \"timerOverheadNs\": %.1f, \"runs\": [", TimerOverhead());
+	auto first = true;
+	for (auto maxSizeKb : options.maxSizesKb) {
+		RunConfiguration(options, std::max(maxSizeKb, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
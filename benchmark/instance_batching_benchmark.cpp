@@ -0,0 +1,147 @@
+#include "command_recorder.h"
+#include "instance_batcher.h"
+#include "benchmark_utils.h"
+
+#include <random>
+
+// ============================================================================
+// The options of the instance batching benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 10;
+	unsigned				pipelines = 8;
+	unsigned				geometries = 64;
+	std::vector<unsigned>	instanceCounts = { 10000, 100000, 1000000 };
+};
+
+// ============================================================================
+// A submitted draw of the benchmark scene.
+// ============================================================================
+struct Submission
+{
+	uint32_t		pipeline;
+	uint32_t		geometry;
+	InstanceData	instance;
+};
+
+// ============================================================================
+// Generate a deterministic set of draws with random pipelines and geometries.
+// ============================================================================
+std::vector<Submission> GenerateSubmissions(const Options& options, unsigned count)
+{
+	std::vector<Submission> submissions(count);
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-1.f, 1.f), scale(0.01f, 0.05f), angle(0.f, 6.2831853f);
+	for (auto& submission : submissions) {
+		submission.pipeline = random() % options.pipelines;
+		submission.geometry = random() % options.geometries;
+		submission.instance = { { position(random), position(random) }, scale(random), angle(random), static_cast<uint32_t>(random()) };
+	}
+	return submissions;
+}
+
+// ============================================================================
+// Run the batcher for a single configuration and print it as JSON.
+//
+// Batched draws are recorded with one instanced draw per batch, next to the
+// draws without batching that record one draw for each submission. A state
+// change is counted whenever the pipeline or the geometry of a draw differs
+// from the previous draw.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned instanceCount, bool first)
+{
+	auto submissions = GenerateSubmissions(options, instanceCount);
+	InstanceBatcher batcher;
+	batcher.Reserve(instanceCount);
+	CommandBufferRecorder recorder(1);
+	std::vector<double> submitTimes, buildTimes, batchedRecordTimes, unbatchedRecordTimes, referenceSortTimes;
+	for (auto i = 0u; i < options.repeats; i++) {
+		auto start = std::chrono::steady_clock::now();
+		batcher.Reset();
+		for (auto& submission : submissions) {
+			batcher.Submit(submission.pipeline, submission.geometry, submission.instance);
+		}
+		auto submitted = std::chrono::steady_clock::now();
+		batcher.Build();
+		auto built = std::chrono::steady_clock::now();
+		auto& context = recorder.BeginList(0);
+		for (auto& batch : batcher.Batches()) {
+			context.DrawIndexed(36, batch.instanceCount, 0, 0, batch.firstInstance);
+		}
+		recorder.EndList(0);
+		auto recorded = std::chrono::steady_clock::now();
+		submitTimes.push_back(Milliseconds(submitted - start));
+		buildTimes.push_back(Milliseconds(built - submitted));
+		batchedRecordTimes.push_back(Milliseconds(recorded - built));
+
+		// record a draw for each submission as the renderer would without batching.
+		start = std::chrono::steady_clock::now();
+		auto& unbatchedContext = recorder.BeginList(0);
+		for (size_t j = 0; j < submissions.size(); j++) {
+			unbatchedContext.DrawIndexed(36, 1, 0, 0, 0);
+		}
+		recorder.EndList(0);
+		unbatchedRecordTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+
+		// sort the same keys with the standard library as the reference.
+		std::vector<uint64_t> keys(submissions.size());
+		for (size_t j = 0; j < submissions.size(); j++) {
+			keys[j] = (static_cast<uint64_t>(InstanceBatcher::SortKey(submissions[j].pipeline, submissions[j].geometry)) << 32) | j;
+		}
+		start = std::chrono::steady_clock::now();
+		std::stable_sort(keys.begin(), keys.end(), [](uint64_t a, uint64_t b) { return (a >> 32) < (b >> 32); });
+		referenceSortTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+	}
+
+	auto unbatchedStateChanges = 0u;
+	for (size_t i = 0; i < submissions.size(); i++) {
+		auto changed = (i == 0 || submissions[i].pipeline != submissions[i - 1].pipeline || submissions[i].geometry != submissions[i - 1].geometry);
+		unbatchedStateChanges += changed ? 1 : 0;
+	}
+	auto build = Summarize(buildTimes);
+	std::printf("%s\n    {\"instances\": %u, \"pipelines\": %u, \"geometries\": %u, \"batches\": %zu, \"pipelineChanges\": %u, \"geometryChanges\": %u, \"unbatchedDraws\": %u, \"unbatchedStateChanges\": %u,\n",
+		first ? "" : ",", instanceCount, options.pipelines, options.geometries, batcher.Batches().size(), batcher.PipelineChangeCount(), batcher.GeometryChangeCount(), instanceCount, unbatchedStateChanges);
+	std::printf("     \"minstancesPerSecond\": %.1f, \"submitMs\": %s,\n", instanceCount / (build.p50 / 1000.0) / 1e6, SummaryJson(Summarize(submitTimes)).c_str());
+	std::printf("     \"sortAndPackMs\": %s,\n", SummaryJson(build).c_str());
+	std::printf("     \"referenceSortMs\": %s,\n", SummaryJson(Summarize(referenceSortTimes)).c_str());
+	std::printf("     \"batchedRecordMs\": %s,\n", SummaryJson(Summarize(batchedRecordTimes)).c_str());
+	std::printf("     \"unbatchedRecordMs\": %s}", SummaryJson(Summarize(unbatchedRecordTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the instance batching benchmark.
+//
+// Benchmark submits the given amount of instances with random pipelines and
+// geometries and reports the throughput of the sorting and the packing with
+// the amount of draws and state changes with and without the batching.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--pipelines") {
+			options.pipelines = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--geometries") {
+			options.geometries = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--instances") {
+			options.instanceCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"instance_batching\", \"runs\": [");
+	auto first = true;
+	for (auto instances : options.instanceCounts) {
+		RunConfiguration(options, std::max(instances, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
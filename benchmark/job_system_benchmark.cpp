@@ -0,0 +1,146 @@
+#include "job_system.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+
+// ============================================================================
+// The options of the job system benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 20;
+	unsigned				jobs = 100000;
+	unsigned				elements = 1 << 20;
+	unsigned				grainSize = 4096;
+	unsigned				depth = 18;
+	std::vector<unsigned>	threadCounts;
+};
+
+// ============================================================================
+// A compute bound kernel for a single element of the parallel loop.
+// ============================================================================
+float Kernel(unsigned index)
+{
+	auto x = static_cast<float>(index) * 0.001f;
+	for (auto i = 0; i < 4; i++) {
+		x = std::sin(x) * 0.5f + std::cos(x * 1.5f);
+	}
+	return x;
+}
+
+// ============================================================================
+// Count the leaves of a binary tree of jobs of the given depth.
+//
+// Each job starts a job for one subtree, descends into the other one itself
+// and waits for the started job, so the waits run other jobs meanwhile. The
+// small subtrees are counted serially by running the kernel for each leaf.
+// ============================================================================
+uint64_t CountLeaves(JobSystem& jobSystem, unsigned depth)
+{
+	if (depth <= 6) {
+		uint64_t leaves = 0;
+		for (auto i = 0u; i < (1u << depth); i++) {
+			leaves += (Kernel(i) < 1000.f) ? 1 : 0;
+		}
+		return leaves;
+	}
+	uint64_t left = 0;
+	JobCounter counter;
+	jobSystem.Run([&] { left = CountLeaves(jobSystem, depth - 1); }, &counter);
+	auto right = CountLeaves(jobSystem, depth - 1);
+	jobSystem.Wait(counter);
+	return left + right;
+}
+
+// ============================================================================
+// Measure the workloads with the given thread count and print them as JSON.
+//
+// The job overhead is measured with empty jobs started from the first thread.
+// The parallel loop and the job tree are compared to the single thread time.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned threads, std::vector<double>& baseline, bool first)
+{
+	JobSystem jobSystem(threads);
+	std::vector<float> output(options.elements);
+	std::vector<double> jobTimes, loopTimes, treeTimes;
+	for (auto repeat = 0u; repeat < options.repeats; repeat++) {
+		auto start = std::chrono::steady_clock::now();
+		JobCounter counter;
+		for (auto i = 0u; i < options.jobs; i++) {
+			jobSystem.Run([] {}, &counter);
+		}
+		jobSystem.Wait(counter);
+		jobTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / options.jobs);
+
+		start = std::chrono::steady_clock::now();
+		jobSystem.ParallelFor(options.elements, options.grainSize, [&](unsigned begin, unsigned end) {
+			for (auto i = begin; i < end; i++) {
+				output[i] = Kernel(i);
+			}
+		});
+		loopTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+
+		start = std::chrono::steady_clock::now();
+		if (CountLeaves(jobSystem, options.depth) != (1ull << options.depth)) {
+			std::fprintf(stderr, "job tree returned a wrong leaf count\n");
+			std::exit(1);
+		}
+		treeTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+	}
+
+	auto jobs = Summarize(jobTimes), loop = Summarize(loopTimes), tree = Summarize(treeTimes);
+	if (baseline.empty()) {
+		baseline = { loop.p50, tree.p50 };
+	}
+	std::printf("%s\n    {\"threads\": %u, \"loopSpeedup\": %.2f, \"treeSpeedup\": %.2f, \"steals\": %llu,\n",
+		first ? "" : ",", threads, baseline[0] / loop.p50, baseline[1] / tree.p50, static_cast<unsigned long long>(jobSystem.StealCount()));
+	std::printf("     \"emptyJobNs\": %s,\n", SummaryJson(jobs).c_str());
+	std::printf("     \"parallelForMs\": %s,\n", SummaryJson(loop).c_str());
+	std::printf("     \"jobTreeMs\": %s}", SummaryJson(tree).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the job system benchmark.
+//
+// Benchmark runs the workloads with an increasing amount of threads, which by
+// default doubles from one up to the amount of cores of the machine.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+	for (auto i = 1u; i < cores; i *= 2) {
+		options.threadCounts.push_back(i);
+	}
+	options.threadCounts.push_back(cores);
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--jobs") {
+			options.jobs = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--elements") {
+			options.elements = ParseList(value)[0];
+		} else if (name == "--grain-size") {
+			options.grainSize = ParseList(value)[0];
+		} else if (name == "--depth") {
+			options.depth = std::min(ParseList(value)[0], 40u);
+		} else if (name == "--threads") {
+			options.threadCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"job_system\", \"repeats\": %u, \"jobs\": %u, \"elements\": %u, \"depth\": %u, \"runs\": [", options.repeats, options.jobs, options.elements, options.depth);
+	std::vector<double> baseline;
+	auto first = true;
+	for (auto threads : options.threadCounts) {
+		RunConfiguration(options, std::max(threads, 1u), baseline, first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,116 @@
+#include "memory_budget.h"
+#include "benchmark_utils.h"
+
+// ============================================================================
+// The options of the memory budget benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				frames = 1200;
+	unsigned				budgetMb = 2048;
+	unsigned				pressureMb = 1024;
+	unsigned				streamMbPerFrame = 8;
+	std::vector<unsigned>	pollFrames = { 1, 30, 120 };
+};
+
+// ============================================================================
+// Run the budget policy with a poll interval and print it as JSON.
+//
+// The app keeps a fixed amount of geometry resident and streams data into a
+// cache every frame, which only the trimmer releases. Another app takes the
+// pressure amount of the budget during the middle third of the frames, and
+// the app is hidden for a few frames near the end. The usage the simulated
+// OS reports is the tracked memory plus the untracked memory of the driver.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned pollFrames, bool first)
+{
+	const uint64_t megabyte = 1024 * 1024;
+	const uint64_t untracked = 64 * megabyte;
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.95, 0.85, pollFrames });
+	uint64_t cached = 0;
+	budget.AddTrimmer(MemorySegment::Local, "StreamingCache", [&](uint64_t bytes) {
+		auto freed = std::min(bytes, cached);
+		cached -= freed;
+		budget.Free(MemoryCategory::Geometry, MemorySegment::Local, freed);
+		return freed;
+	});
+	budget.Allocate(MemoryCategory::Geometry, MemorySegment::Local, options.budgetMb * megabyte / 4);
+	budget.Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, 128 * megabyte);
+
+	std::vector<double> updateTimes, usageRatios;
+	unsigned framesOverBudget = 0;
+	for (auto frame = 0u; frame < options.frames; frame++) {
+		auto pressure = (frame >= options.frames / 3 && frame < options.frames * 2 / 3);
+		auto background = (frame >= options.frames * 5 / 6 && frame < options.frames * 5 / 6 + 30);
+		auto frameBudget = (options.budgetMb - (pressure ? options.pressureMb : 0)) * megabyte;
+		if (!background) {
+			cached += options.streamMbPerFrame * megabyte;
+			budget.Allocate(MemoryCategory::Geometry, MemorySegment::Local, options.streamMbPerFrame * megabyte);
+		}
+
+		// the simulated OS sees the memory of the app before the policy of the frame.
+		auto& statistics = budget.Statistics();
+		auto usage = untracked;
+		for (auto size : statistics.categories[static_cast<unsigned>(MemorySegment::Local)]) {
+			usage += size;
+		}
+		provider.Set(MemorySegment::Local, frameBudget, usage);
+		provider.Set(MemorySegment::NonLocal, frameBudget, 0);
+		framesOverBudget += (usage > frameBudget) ? 1 : 0;
+		usageRatios.push_back(static_cast<double>(usage) / frameBudget);
+
+		auto start = std::chrono::steady_clock::now();
+		budget.Update(background);
+		updateTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	auto& statistics = budget.Statistics();
+	std::printf("%s\n    {\"pollFrames\": %u, \"frames\": %u, \"queries\": %u, \"framesOverBudget\": %u, \"overBudgetPolls\": %u, \"trims\": %u, \"trimmedMb\": %.1f,\n",
+		first ? "" : ",", pollFrames, options.frames, provider.QueryCount(), framesOverBudget, statistics.overBudgetPolls, statistics.trimCount, statistics.trimmedBytes / static_cast<double>(megabyte));
+	std::printf("     \"usageOfBudget\": %s,\n", SummaryJson(Summarize(usageRatios)).c_str());
+	std::printf("     \"updateNs\": %s}", SummaryJson(Summarize(updateTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the memory budget benchmark.
+//
+// Benchmark runs the budget policy against a simulated OS budget that shrinks
+// while another app needs memory and reports how often and how far the app
+// went over the budget, the trimmed memory and the cost of the policy.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 6u);
+		} else if (name == "--budget-mb") {
+			options.budgetMb = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--pressure-mb") {
+			options.pressureMb = ParseList(value)[0];
+		} else if (name == "--stream-mb") {
+			options.streamMbPerFrame = ParseList(value)[0];
+		} else if (name == "--poll-frames") {
+			options.pollFrames = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+	if (options.pressureMb >= options.budgetMb) {
+		std::fprintf(stderr, "pressure must be less than the budget\n");
+		return 1;
+	}
+
+	std::printf("{\"benchmark\": \"memory_budget\", \"runs\": [");
+	auto first = true;
+	for (auto pollFrames : options.pollFrames) {
+		RunConfiguration(options, std::max(pollFrames, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
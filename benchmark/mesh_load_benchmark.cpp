@@ -0,0 +1,150 @@
+#include "mesh_file.h"
+#include "benchmark_utils.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+// ============================================================================
+// The options of the mesh load benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 10;
+	std::string				directory = ".";
+	std::vector<unsigned>	vertexCounts = { 10000, 100000, 1000000, 4000000 };
+};
+
+// ============================================================================
+// A copy queue that only writes the staging memory and completes right away.
+//
+// The benchmark measures the CPU side of the loading, so the copies to the
+// destination buffers, which the GPU would perform, are skipped.
+// ============================================================================
+class StagingCopyQueue : public CopyQueue
+{
+public:
+	explicit StagingCopyQueue(uint64_t stagingSize) : mStaging(static_cast<size_t>(stagingSize)) {}
+	uint8_t* StagingMemory() override { return mStaging.data(); }
+	uint64_t StagingSize() const override { return mStaging.size(); }
+	uint64_t Submit(const std::vector<CopyCommand>&) override { auto fence = mTimeline.Signal(); mTimeline.Advance(); return fence; }
+	GpuTimeline& Timeline() override { return mTimeline; }
+private:
+	std::vector<uint8_t>	mStaging;
+	SimulatedTimeline		mTimeline;
+};
+
+// ============================================================================
+// Write a mesh file with random half float vertices and a triangle list.
+// ============================================================================
+void WriteTestMesh(const std::string& path, unsigned vertexCount)
+{
+	std::vector<HalfVertex> vertices(vertexCount);
+	std::mt19937 random(1234);
+	for (auto& vertex : vertices) {
+		for (auto& value : vertex.position.value) {
+			value = static_cast<uint16_t>(random());
+		}
+		for (auto& value : vertex.color.value) {
+			value = static_cast<uint8_t>(random());
+		}
+	}
+	std::vector<uint32_t> indices(static_cast<size_t>(vertexCount) * 2);
+	for (auto& index : indices) {
+		index = random() % vertexCount;
+	}
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	WriteMesh(output, vertices.data(), vertexCount, indices.data(), static_cast<uint32_t>(indices.size()), MeshBounds{ { -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f } });
+}
+
+// ============================================================================
+// Load a mesh by reading the whole file into memory as a reference.
+// ============================================================================
+void LoadWithStream(const std::string& path, GeometryUploader& uploader, void* vertexBuffer, void* indexBuffer)
+{
+	std::ifstream input(path, std::ios::binary);
+	MeshFileHeader header;
+	input.read(reinterpret_cast<char*>(&header), sizeof(header));
+	std::vector<char> data(static_cast<size_t>(header.fileSize));
+	input.seekg(0);
+	input.read(data.data(), static_cast<std::streamsize>(data.size()));
+	uploader.Upload(vertexBuffer, 0, data.data() + header.vertices.offset, header.vertices.size);
+	uploader.Upload(indexBuffer, 0, data.data() + header.indices.offset, header.indices.size);
+}
+
+// ============================================================================
+// Load a mesh file repeatedly with both methods and print the timing as JSON.
+//
+// The file stays in the page cache after the first load, so the results show
+// the cost of the loading itself rather than the speed of the storage.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned vertexCount, bool first)
+{
+	auto path = options.directory + "/mesh_load_benchmark_" + std::to_string(vertexCount) + ".mesh";
+	WriteTestMesh(path, vertexCount);
+	StagingCopyQueue queue(64 * 1024 * 1024);
+	GeometryUploader uploader(queue, 16 * 1024 * 1024);
+	auto vertexBuffer = reinterpret_cast<void*>(static_cast<uintptr_t>(1));
+	auto indexBuffer = reinterpret_cast<void*>(static_cast<uintptr_t>(2));
+
+	uint64_t fileSize = 0;
+	std::vector<double> mappedTimes, streamTimes;
+	for (auto i = 0u; i <= options.repeats; i++) {
+		auto start = std::chrono::steady_clock::now();
+		{
+			MeshFile mesh(path);
+			mesh.Upload(uploader, vertexBuffer, indexBuffer);
+			uploader.Flush();
+			fileSize = mesh.Header().fileSize;
+		}
+		auto mapped = std::chrono::steady_clock::now();
+		LoadWithStream(path, uploader, vertexBuffer, indexBuffer);
+		uploader.Flush();
+		auto streamed = std::chrono::steady_clock::now();
+		if (i != 0) {
+			mappedTimes.push_back(Milliseconds(mapped - start));
+			streamTimes.push_back(Milliseconds(streamed - mapped));
+		}
+	}
+	std::remove(path.c_str());
+
+	auto mappedSummary = Summarize(mappedTimes), streamSummary = Summarize(streamTimes);
+	std::printf("%s\n    {\"vertices\": %u, \"fileMb\": %.2f, \"mappedGbPerSecond\": %.2f, \"streamGbPerSecond\": %.2f,\n",
+		first ? "" : ",", vertexCount, fileSize / 1048576.0, fileSize / (mappedSummary.p50 / 1000.0) / 1e9, fileSize / (streamSummary.p50 / 1000.0) / 1e9);
+	std::printf("     \"mappedMs\": %s,\n", SummaryJson(mappedSummary).c_str());
+	std::printf("     \"streamMs\": %s}", SummaryJson(streamSummary).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the mesh load benchmark.
+//
+// Benchmark writes a mesh file for each vertex count and compares loading it
+// through a memory mapping with reading it into memory with a file stream.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--directory") {
+			options.directory = value;
+		} else if (name == "--vertices") {
+			options.vertexCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"mesh_load\", \"runs\": [");
+	auto first = true;
+	for (auto count : options.vertexCounts) {
+		RunConfiguration(options, std::max(count, 3u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include "mesh_optimizer.h"
+#include "vertex_format.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+#include <random>
+
+// ============================================================================
+// The options of the mesh optimizer benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 3;
+	unsigned				spheres = 4;
+	std::vector<unsigned>	triangleCounts = { 10000, 100000, 1000000 };
+};
+
+// ============================================================================
+// Generate a deterministic unindexed mesh of spheres in a row.
+//
+// Spheres overlap in the views along the row so the triangle order matters
+// for the overdraw. Triangles are shuffled to model an unoptimized export,
+// and each corner of a triangle is stored as its own vertex.
+// ============================================================================
+std::vector<Vertex> GenerateSpheres(unsigned triangleCount, unsigned sphereCount)
+{
+	auto rings = std::max(static_cast<unsigned>(std::sqrt(triangleCount / sphereCount / 4.0)), 2u);
+	auto segments = rings * 2;
+	std::vector<std::array<Vertex, 3>> triangles;
+	for (auto sphere = 0u; sphere < sphereCount; sphere++) {
+		auto vertex = [&](unsigned ring, unsigned segment) {
+			auto theta = 3.14159265f * ring / rings, phi = 6.2831853f * segment / segments;
+			return Vertex{ { std::sin(theta) * std::cos(phi) + sphere * 1.5f, std::cos(theta), std::sin(theta) * std::sin(phi) }, { static_cast<float>(ring) / rings, static_cast<float>(segment) / segments, 0.f, 1.f } };
+		};
+		for (auto ring = 0u; ring < rings; ring++) {
+			for (auto segment = 0u; segment < segments; segment++) {
+				triangles.push_back({ vertex(ring, segment), vertex(ring, segment + 1), vertex(ring + 1, segment) });
+				triangles.push_back({ vertex(ring, segment + 1), vertex(ring + 1, segment + 1), vertex(ring + 1, segment) });
+			}
+		}
+	}
+	std::mt19937 random(1234);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+	std::vector<Vertex> vertices;
+	vertices.reserve(triangles.size() * 3);
+	for (auto& triangle : triangles) {
+		vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+	}
+	return vertices;
+}
+
+// ============================================================================
+// Time the optimization stages for a mesh and print the results as JSON.
+//
+// Stages run as in the mesh optimization and are timed separately, and the
+// reported statistics are the ones of the last repeat.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned triangleCount, bool first)
+{
+	auto source = GenerateSpheres(triangleCount, options.spheres);
+	std::vector<double> deduplicateTimes, cacheTimes, overdrawTimes, fetchTimes, totalTimes;
+	MeshOptimizationReport report = {};
+	float cacheOnlyAcmr = 0.f, cacheOnlyOverdraw = 0.f;
+	for (auto i = 0u; i < options.repeats; i++) {
+		auto vertices = source;
+		std::vector<uint32_t> indices(vertices.size());
+		for (size_t j = 0; j < indices.size(); j++) {
+			indices[j] = static_cast<uint32_t>(j);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<uint32_t> remap;
+		auto uniqueCount = DeduplicateVertices(vertices.data(), vertices.size(), sizeof(Vertex), remap);
+		std::vector<Vertex> unique(uniqueCount);
+		RemapVertices(vertices.data(), vertices.size(), sizeof(Vertex), remap, unique.data());
+		RemapIndices(indices, remap);
+		auto deduplicated = std::chrono::steady_clock::now();
+		OptimizeVertexCache(indices, unique.size());
+		auto cacheOptimized = std::chrono::steady_clock::now();
+		cacheOnlyAcmr = AnalyzeVertexCache(indices, unique.size()).acmr;
+		cacheOnlyOverdraw = AnalyzeOverdraw(indices, unique[0].position.data(), sizeof(Vertex), unique.size()).overdraw;
+		auto overdrawStart = std::chrono::steady_clock::now();
+		OptimizeOverdraw(indices, unique[0].position.data(), sizeof(Vertex), unique.size());
+		auto overdrawOptimized = std::chrono::steady_clock::now();
+		OptimizeVertexFetch(unique.data(), unique.size(), sizeof(Vertex), indices);
+		auto fetchOptimized = std::chrono::steady_clock::now();
+
+		deduplicateTimes.push_back(Milliseconds(deduplicated - start));
+		cacheTimes.push_back(Milliseconds(cacheOptimized - deduplicated));
+		overdrawTimes.push_back(Milliseconds(overdrawOptimized - overdrawStart));
+		fetchTimes.push_back(Milliseconds(fetchOptimized - overdrawOptimized));
+		totalTimes.push_back(Milliseconds((cacheOptimized - start) + (fetchOptimized - overdrawStart)));
+
+		// collect the report of the whole optimization for the statistics.
+		vertices = source;
+		indices.clear();
+		report = OptimizeMesh(vertices, indices, sizeof(HalfVertex));
+	}
+
+	std::printf("%s\n    {\"triangles\": %zu, \"verticesBefore\": %zu, \"verticesAfter\": %zu, \"acmrBefore\": %.3f, \"acmrCacheOptimized\": %.3f, \"acmrAfter\": %.3f, \"atvrAfter\": %.3f,\n",
+		first ? "" : ",", report.indexCount / 3, report.vertexCountBefore, report.vertexCountAfter, report.acmrBefore, cacheOnlyAcmr, report.acmrAfter, report.atvrAfter);
+	std::printf("     \"overdrawBefore\": %.3f, \"overdrawCacheOptimized\": %.3f, \"overdrawAfter\": %.3f, \"bytesBefore\": %llu, \"bytesAfter\": %llu, \"bytesSaved\": %lld,\n",
+		report.overdrawBefore, cacheOnlyOverdraw, report.overdrawAfter, static_cast<unsigned long long>(report.bytesBefore), static_cast<unsigned long long>(report.bytesAfter),
+		static_cast<long long>(report.bytesBefore) - static_cast<long long>(report.bytesAfter));
+	std::printf("     \"deduplicateMs\": %s,\n", SummaryJson(Summarize(deduplicateTimes)).c_str());
+	std::printf("     \"vertexCacheMs\": %s,\n", SummaryJson(Summarize(cacheTimes)).c_str());
+	std::printf("     \"overdrawMs\": %s,\n", SummaryJson(Summarize(overdrawTimes)).c_str());
+	std::printf("     \"vertexFetchMs\": %s,\n", SummaryJson(Summarize(fetchTimes)).c_str());
+	std::printf("     \"totalMs\": %s}", SummaryJson(Summarize(totalTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the mesh optimizer benchmark.
+//
+// Benchmark optimizes an unindexed mesh of about the given triangle counts
+// and reports the time of each stage with the ACMR, the overdraw and the
+// stream sizes in the half float vertex format before and after.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--spheres") {
+			options.spheres = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--triangles") {
+			options.triangleCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"mesh_optimizer\", \"runs\": [");
+	auto first = true;
+	for (auto triangles : options.triangleCounts) {
+		RunConfiguration(options, triangles, first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
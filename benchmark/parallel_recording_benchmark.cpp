@@ -0,0 +1,118 @@
+#include "command_recorder.h"
+#include "benchmark_utils.h"
+
+#include <thread>
+
+// ============================================================================
+// The options of the parallel recording benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				frames = 200;
+	unsigned				chunkSize = 256;
+	unsigned				drawCost = 64;
+	std::vector<unsigned>	threadCounts;
+	std::vector<unsigned>	drawCounts = { 10000, 100000 };
+};
+
+// ============================================================================
+// Record a single draw with a simulated CPU cost of the draw setup.
+//
+// The cost stands for the work a renderer does per draw, e.g. computing the
+// constants and resolving the bindings. Its result is stored into the draw
+// so that the work cannot be optimized away.
+// ============================================================================
+void RecordDraw(CommandContext& context, unsigned index, unsigned cost)
+{
+	auto state = static_cast<uint32_t>(index) * 2654435761u;
+	for (auto i = 0u; i < cost; i++) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+	}
+	context.Draw(3, 1, index * 3, state & 1023);
+}
+
+// ============================================================================
+// Record the frames with the given thread and draw count and print as JSON.
+//
+// Each frame records the draws in parallel and submits them together with a
+// frame list, like the renderer does. The hash of the submitted commands is
+// reported to verify that the output does not depend on the thread count.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned threads, unsigned draws, double singleThreadMs, double& meanMs, bool first)
+{
+	JobSystem jobSystem(threads);
+	CommandBufferRecorder recorder(threads + 1);
+	ParallelRecorder parallelRecorder(jobSystem, recorder, options.chunkSize);
+	auto record = [&](CommandContext& context, unsigned begin, unsigned end) {
+		for (auto i = begin; i < end; i++) {
+			RecordDraw(context, i, options.drawCost);
+		}
+	};
+
+	std::vector<double> frameTimes;
+	for (auto frame = 0u; frame < options.frames; frame++) {
+		auto start = std::chrono::steady_clock::now();
+		recorder.BeginFrame(frame % 2);
+		recorder.BeginList(0);
+		recorder.EndList(0);
+		auto listCount = parallelRecorder.Record(1, draws, record);
+		recorder.Submit(listCount + 1);
+		frameTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+	}
+
+	auto summary = Summarize(frameTimes);
+	meanMs = summary.mean;
+	std::printf("%s\n    {\"threads\": %u, \"draws\": %u, \"lists\": %u, \"speedup\": %.2f, \"hash\": \"%016llx\",\n",
+		first ? "" : ",", threads, draws, std::min({ (draws + options.chunkSize - 1) / options.chunkSize, threads }) + 1, (singleThreadMs > 0.0) ? singleThreadMs / summary.mean : 1.0, static_cast<unsigned long long>(recorder.SubmittedHash()));
+	std::printf("     \"recordMs\": %s}", SummaryJson(summary).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the parallel recording benchmark.
+//
+// Benchmark records the draws of the frames into a recording-only backend
+// with an increasing amount of threads to measure how recording scales.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1u; i <= std::max(std::thread::hardware_concurrency(), 1u); i *= 2) {
+		options.threadCounts.push_back(i);
+	}
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--chunk-size") {
+			options.chunkSize = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--draw-cost") {
+			options.drawCost = ParseList(value)[0];
+		} else if (name == "--threads") {
+			options.threadCounts = ParseList(value);
+		} else if (name == "--draws") {
+			options.drawCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"parallel_recording\", \"frames\": %u, \"chunkSize\": %u, \"drawCost\": %u, \"runs\": [", options.frames, options.chunkSize, options.drawCost);
+	auto first = true;
+	for (auto draws : options.drawCounts) {
+		auto singleThreadMs = 0.0;
+		for (auto threads : options.threadCounts) {
+			auto meanMs = 0.0;
+			RunConfiguration(options, std::max(threads, 1u), draws, singleThreadMs, meanMs, first);
+			if (singleThreadMs == 0.0) {
+				singleThreadMs = meanMs;
+			}
+			first = false;
+		}
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include "frame_profiler.h"
+#include "benchmark_utils.h"
+
+#include <thread>
+
+// ============================================================================
+// Measure the average cost of a single profiling scope in nanoseconds.
+// ============================================================================
+double MeasureScope(unsigned iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (auto i = 0u; i < iterations; i++) {
+		PROFILE_SCOPE("Scope");
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// ============================================================================
+// Measure the average cost of reading the profiling clock in nanoseconds.
+// ============================================================================
+double MeasureClock(unsigned iterations)
+{
+	uint64_t sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (auto i = 0u; i < iterations; i++) {
+		sum += FrameProfiler::Now();
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	return (sum != 0) ? elapsed / iterations : 0.0;
+}
+
+// ============================================================================
+// The entry point of the profiler benchmark.
+//
+// Benchmark measures the per-scope overhead with the profiler enabled and
+// disabled, the clock read cost and the Chrome trace export time.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	auto iterations = (argc > 1) ? ParseList(argv[1])[0] : 10000000u;
+	auto& profiler = FrameProfiler::Instance();
+	profiler.SetThreadName("Main");
+
+	std::vector<double> enabled, disabled, clock;
+	for (auto run = 0; run < 10; run++) {
+		profiler.SetEnabled(true);
+		profiler.BeginFrame();
+		enabled.push_back(MeasureScope(iterations / 10));
+		profiler.SetEnabled(false);
+		disabled.push_back(MeasureScope(iterations / 10));
+		clock.push_back(MeasureClock(iterations / 10));
+	}
+	profiler.SetEnabled(true);
+
+	auto exportStart = std::chrono::steady_clock::now();
+	auto trace = profiler.ExportChromeTrace(1);
+	auto exportTime = Milliseconds(std::chrono::steady_clock::now() - exportStart);
+
+	std::printf("{\"benchmark\": \"profiler\", \"iterations\": %u,\n", iterations);
+	std::printf(" \"enabledScopeNs\": %s,\n", SummaryJson(Summarize(enabled)).c_str());
+	std::printf(" \"disabledScopeNs\": %s,\n", SummaryJson(Summarize(disabled)).c_str());
+	std::printf(" \"clockReadNs\": %s,\n", SummaryJson(Summarize(clock)).c_str());
+	std::printf(" \"exportMs\": %.3f, \"exportBytes\": %zu}\n", exportTime, trace.size());
+	return 0;
+}
@@ -0,0 +1,172 @@
+#include "render_graph.h"
+#include "benchmark_utils.h"
+
+#include <random>
+
+// ============================================================================
+// The options of the render graph benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				iterations = 1000;
+	unsigned				seed = 1234;
+	std::vector<unsigned>	passCounts = { 100, 1000 };
+};
+
+// ============================================================================
+// A render graph backend that hands out fake textures without any memory.
+//
+// Textures are cached by their offset and size like a real backend would, so
+// the steady state of the benchmark does not create any textures.
+// ============================================================================
+class NullRenderGraphBackend : public RenderGraphBackend
+{
+public:
+	void TextureAllocationInfo(const TextureDesc& desc, uint64_t& size, uint64_t& alignment) override
+	{
+		auto bytesPerPixel = (desc.format == TextureFormat::RGBA16F) ? 8ull : 4ull;
+		alignment = 64 * 1024;
+		size = (desc.width * desc.height * bytesPerPixel + alignment - 1) & ~(alignment - 1);
+	}
+	void ReserveTransientMemory(uint64_t size) override
+	{
+		if (size > mReservedBytes) {
+			mReservedBytes = size;
+			mTextures.clear();
+		}
+	}
+	void* AcquireTransientTexture(const TextureDesc& desc, uint64_t offset, bool& created) override
+	{
+		for (auto& texture : mTextures) {
+			if (texture.offset == offset && texture.width == desc.width && texture.height == desc.height && texture.format == desc.format) {
+				created = false;
+				return texture.handle;
+			}
+		}
+		created = true;
+		mTextures.push_back({ offset, desc.width, desc.height, desc.format, reinterpret_cast<void*>(++mTextureCount) });
+		return mTextures.back().handle;
+	}
+	void ResourceBarriers(const std::vector<ResourceBarrier>&) override {}
+private:
+	struct Texture
+	{
+		uint64_t		offset;
+		uint32_t		width;
+		uint32_t		height;
+		TextureFormat	format;
+		void*			handle;
+	};
+	std::vector<Texture>	mTextures;
+	uint64_t				mReservedBytes = 0;
+	uintptr_t				mTextureCount = 0;
+};
+
+// ============================================================================
+// Declare a randomized frame with the given amount of passes.
+//
+// Every pass writes a new transient texture and reads one or two textures of
+// the recent passes, which keeps the lifetimes short. Textures of every tenth
+// pass are never read and the last pass writes the imported back buffer, so
+// the passes that do not lead to the back buffer are culled.
+// ============================================================================
+void DeclareFrame(RenderGraph& graph, void* backBuffer, unsigned passCount, unsigned seed)
+{
+	static const TextureDesc Formats[] = {
+		{ 1920, 1080, TextureFormat::RGBA8 },
+		{ 1920, 1080, TextureFormat::RGBA16F },
+		{ 960, 540, TextureFormat::RGBA16F },
+		{ 1920, 1080, TextureFormat::D32 }
+	};
+	std::mt19937 random(seed);
+	std::vector<uint32_t> outputs;
+	graph.Reset();
+	auto output = graph.ImportTexture("BackBuffer", backBuffer, ResourceState::Present);
+	for (auto i = 0u; i < passCount; i++) {
+		auto pass = graph.AddPass("Pass", nullptr);
+		auto reads = outputs.empty() ? 0u : std::min<unsigned>(1 + random() % 2, static_cast<unsigned>(outputs.size()));
+		for (auto j = 0u; j < reads; j++) {
+			auto window = std::min<size_t>(outputs.size(), 8);
+			graph.Read(pass, outputs[outputs.size() - 1 - random() % window], ResourceState::ShaderResource);
+		}
+		if (i + 1 == passCount) {
+			graph.Write(pass, output, ResourceState::RenderTarget);
+		} else {
+			auto texture = graph.CreateTexture("Texture", Formats[random() % 4]);
+			graph.Write(pass, texture, ResourceState::RenderTarget);
+			if (i % 10 != 9) {
+				outputs.push_back(texture);
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Measure the render graph with the given amount of passes and print as JSON.
+//
+// Declaration, compilation and execution against the null backend are timed
+// separately. Execution includes the barrier inference of the state tracker.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned passCount, bool first)
+{
+	NullRenderGraphBackend backend;
+	RenderGraph graph(backend);
+	ResourceStateTracker tracker;
+	auto backBuffer = reinterpret_cast<void*>(static_cast<uintptr_t>(-1));
+	tracker.Register(backBuffer, 1, ResourceState::Present);
+
+	std::vector<double> declareTimes, compileTimes, executeTimes;
+	for (auto i = 0u; i < options.iterations; i++) {
+		auto start = std::chrono::steady_clock::now();
+		DeclareFrame(graph, backBuffer, passCount, options.seed);
+		auto declared = std::chrono::steady_clock::now();
+		graph.Compile();
+		auto compiled = std::chrono::steady_clock::now();
+		graph.Execute(tracker);
+		auto executed = std::chrono::steady_clock::now();
+		declareTimes.push_back(Milliseconds(declared - start));
+		compileTimes.push_back(Milliseconds(compiled - declared));
+		executeTimes.push_back(Milliseconds(executed - compiled));
+	}
+
+	auto& statistics = graph.Statistics();
+	std::printf("%s\n    {\"passes\": %u, \"culledPasses\": %u, \"transientTextures\": %u, \"transientMb\": %.1f, \"aliasedMb\": %.1f, \"barriers\": %u, \"barrierBatches\": %u,\n",
+		first ? "" : ",", passCount, statistics.culledPassCount, statistics.transientTextureCount, statistics.transientBytes / 1048576.0, statistics.aliasedBytes / 1048576.0, statistics.barrierCount, statistics.barrierBatchCount);
+	std::printf("     \"declareMs\": %s,\n", SummaryJson(Summarize(declareTimes)).c_str());
+	std::printf("     \"compileMs\": %s,\n", SummaryJson(Summarize(compileTimes)).c_str());
+	std::printf("     \"executeMs\": %s}", SummaryJson(Summarize(executeTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the render graph benchmark.
+//
+// Benchmark declares, compiles and executes the same frame repeatedly for
+// each pass count, like a renderer rebuilding its graph on every frame.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--iterations") {
+			options.iterations = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--seed") {
+			options.seed = ParseList(value)[0];
+		} else if (name == "--passes") {
+			options.passCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"render_graph\", \"iterations\": %u, \"runs\": [", options.iterations);
+	auto first = true;
+	for (auto passCount : options.passCounts) {
+		RunConfiguration(options, std::max(passCount, 1u), first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
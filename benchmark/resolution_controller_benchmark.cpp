@@ -0,0 +1,157 @@
+#include "resolution_controller.h"
+#include "benchmark_utils.h"
+
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <random>
+
+// ============================================================================
+// The options of the resolution controller benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	double						budgetMilliseconds = 15.0;
+	double						fixedMilliseconds = 2.0;
+	unsigned					latency = 2;
+	std::vector<std::string>	traces;
+};
+
+// ============================================================================
+// A trace of the frame times measured at the full resolution.
+// ============================================================================
+struct FrameTrace
+{
+	std::string			name;
+	std::vector<double>	milliseconds;
+};
+
+// ============================================================================
+// Load a recorded trace with the time of a frame in milliseconds per line.
+//
+// Empty lines and the lines starting with a # are skipped.
+// ============================================================================
+FrameTrace LoadTrace(const std::string& path)
+{
+	std::ifstream input(path);
+	if (!input) {
+		std::fprintf(stderr, "failed to open trace: %s\n", path.c_str());
+		std::exit(1);
+	}
+	FrameTrace trace = { path, {} };
+	std::string line;
+	while (std::getline(input, line)) {
+		if (!line.empty() && line[0] != '#') {
+			trace.milliseconds.push_back(std::atof(line.c_str()));
+		}
+	}
+	return trace;
+}
+
+// ============================================================================
+// Generate the deterministic traces used when no trace files are given.
+//
+// The traces model a constant overload, short load spikes, a slow ramp up
+// and down, and a noisy load close to the budget which would oscillate
+// without the hysteresis.
+// ============================================================================
+std::vector<FrameTrace> GenerateTraces()
+{
+	std::mt19937 random(1234);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	std::vector<FrameTrace> traces = { { "overload", {} }, { "spikes", {} }, { "ramp", {} }, { "noisy", {} } };
+	for (auto i = 0; i < 3000; i++) {
+		traces[0].milliseconds.push_back(24.0 + noise(random));
+		traces[1].milliseconds.push_back(((i / 250) % 2 == 1 && i % 250 < 40) ? 32.0 + noise(random) : 11.0 + 0.5 * noise(random));
+		traces[2].milliseconds.push_back(10.0 + 25.0 * std::sin(3.14159265 * i / 3000.0) + 0.5 * noise(random));
+		traces[3].milliseconds.push_back(15.0 + 2.5 * noise(random));
+	}
+	return traces;
+}
+
+// ============================================================================
+// Replay a trace through the controller and print the results as JSON.
+//
+// The frame time at a scale is the fixed part of the frame plus the rest
+// scaled with the pixel count. Measurements reach the controller after the
+// frame latency, as the GPU timestamps of a frame are read back only when
+// its frame slot is reused.
+// ============================================================================
+void RunTrace(const Options& options, const FrameTrace& trace, bool first)
+{
+	ResolutionController controller({ options.budgetMilliseconds, 0.5f, 1.f, 0.05f, 0.75, 1.0, 30, 2, options.latency });
+	std::deque<double> inFlight;
+	std::vector<double> updateTimes;
+	unsigned nativeOverBudget = 0, controlledOverBudget = 0;
+	double scaleSum = 0.0;
+	float minimumScale = 1.f;
+	for (auto frame : trace.milliseconds) {
+		auto scale = controller.Scale();
+		auto fixed = std::min(options.fixedMilliseconds, frame);
+		auto measured = fixed + (frame - fixed) * scale * scale;
+		nativeOverBudget += (frame > options.budgetMilliseconds) ? 1 : 0;
+		controlledOverBudget += (measured > options.budgetMilliseconds) ? 1 : 0;
+		scaleSum += scale;
+		minimumScale = std::min(minimumScale, scale);
+
+		// feed the measurement of the frame that has left the flight.
+		inFlight.push_back(measured);
+		if (inFlight.size() > options.latency) {
+			auto start = std::chrono::steady_clock::now();
+			controller.Update(inFlight.front());
+			updateTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - start) * 1e6);
+			inFlight.pop_front();
+		}
+	}
+
+	auto frames = static_cast<unsigned>(trace.milliseconds.size());
+	std::printf("%s\n    {\"trace\": \"%s\", \"frames\": %u, \"budgetMs\": %.2f, \"nativeOverBudget\": %u, \"controlledOverBudget\": %u,\n",
+		first ? "" : ",", trace.name.c_str(), frames, options.budgetMilliseconds, nativeOverBudget, controlledOverBudget);
+	std::printf("     \"meanScale\": %.3f, \"minimumScale\": %.2f, \"scaleChanges\": %u,\n", frames ? scaleSum / frames : 0.0, minimumScale, controller.ChangeCount());
+	std::printf("     \"updateNs\": %s}", SummaryJson(Summarize(updateTimes)).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the resolution controller benchmark.
+//
+// Benchmark replays frame time traces recorded at the full resolution, or
+// generated traces when none are given, and reports the frames over budget
+// with and without the controller with the scale and its amount of changes.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--budget-ms") {
+			options.budgetMilliseconds = std::max(std::atof(value.c_str()), 0.1);
+		} else if (name == "--fixed-ms") {
+			options.fixedMilliseconds = std::max(std::atof(value.c_str()), 0.0);
+		} else if (name == "--latency") {
+			options.latency = ParseList(value)[0];
+		} else if (name == "--trace") {
+			options.traces.push_back(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<FrameTrace> traces;
+	for (auto& path : options.traces) {
+		traces.push_back(LoadTrace(path));
+	}
+	if (traces.empty()) {
+		traces = GenerateTraces();
+	}
+
+	std::printf("{\"benchmark\": \"resolution_controller\", \"runs\": [");
+	auto first = true;
+	for (auto& trace : traces) {
+		RunTrace(options, trace, first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
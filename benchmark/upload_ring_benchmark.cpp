@@ -0,0 +1,106 @@
+#include "upload_ring.h"
+#include "benchmark_utils.h"
+
+#include <cstring>
+
+// ============================================================================
+// The options of the upload ring benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				frames = 1000;
+	unsigned				allocationsPerFrame = 1000;
+	unsigned				frameLatency = 2;
+	unsigned				capacityKb = 16384;
+	std::vector<unsigned>	sizes = { 64, 256, 4096 };
+};
+
+// ============================================================================
+// Run the allocator for a single allocation size and print it as JSON.
+//
+// Each frame allocates the given amount of blocks and fills them with data
+// like a renderer would fill constants or dynamic vertices. The simulated GPU
+// completes frames so that the frame latency is kept in flight.
+// ============================================================================
+void RunConfiguration(const Options& options, unsigned size, bool first)
+{
+	std::vector<uint8_t> memory(static_cast<size_t>(options.capacityKb) * 1024);
+	std::vector<uint8_t> source(size, 0x5a);
+	SimulatedTimeline timeline;
+	UploadRing ring(timeline, memory.data(), 0, memory.size());
+
+	std::vector<double> allocateTimes, frameTimes;
+	allocateTimes.reserve(options.frames);
+	frameTimes.reserve(options.frames);
+	uint64_t checksum = 0;
+	for (auto frame = 0u; frame < options.frames; frame++) {
+		auto frameStart = std::chrono::steady_clock::now();
+		ring.Reclaim();
+
+		// measure the allocation cost alone with the first half of the blocks.
+		auto half = options.allocationsPerFrame / 2;
+		auto allocateStart = std::chrono::steady_clock::now();
+		for (auto i = 0u; i < half; i++) {
+			checksum += ring.Allocate(size, 256).offset;
+		}
+		auto allocateTime = std::chrono::steady_clock::now() - allocateStart;
+		allocateTimes.push_back(std::chrono::duration<double, std::nano>(allocateTime).count() / std::max(half, 1u));
+
+		// fill the rest of the blocks like a renderer would.
+		for (auto i = half; i < options.allocationsPerFrame; i++) {
+			auto allocation = ring.Allocate(size, 256);
+			std::memcpy(allocation.cpuAddress, source.data(), size);
+		}
+		ring.EndFrame(timeline.Signal());
+		while (timeline.PendingCount() >= options.frameLatency) {
+			timeline.Advance();
+		}
+		frameTimes.push_back(Milliseconds(std::chrono::steady_clock::now() - frameStart));
+	}
+
+	auto frameSummary = Summarize(frameTimes);
+	auto bytesPerFrame = static_cast<double>(options.allocationsPerFrame) * size;
+	std::printf("%s\n    {\"size\": %u, \"allocationsPerFrame\": %u, \"frameLatency\": %u, \"capacityKb\": %u, \"waits\": %u, \"checksum\": %llu,\n",
+		first ? "" : ",", size, options.allocationsPerFrame, options.frameLatency, options.capacityKb, ring.WaitCount(), static_cast<unsigned long long>(checksum));
+	std::printf("     \"allocateNs\": %s,\n", SummaryJson(Summarize(allocateTimes)).c_str());
+	std::printf("     \"frameTimeMs\": %s,\n", SummaryJson(frameSummary).c_str());
+	std::printf("     \"throughputGBs\": %.3f}", bytesPerFrame / (frameSummary.mean * 1e6));
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the upload ring benchmark.
+//
+// Benchmark measures the cost of a single allocation and the throughput of
+// filling the ring for each allocation size and reports results as JSON.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--frames") {
+			options.frames = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--allocations") {
+			options.allocationsPerFrame = ParseList(value)[0];
+		} else if (name == "--latency") {
+			options.frameLatency = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--capacity-kb") {
+			options.capacityKb = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--sizes") {
+			options.sizes = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"upload_ring\", \"runs\": [");
+	auto first = true;
+	for (auto size : options.sizes) {
+		RunConfiguration(options, size, first);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
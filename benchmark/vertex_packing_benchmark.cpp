@@ -0,0 +1,85 @@
+#include "vertex_packing.h"
+#include "benchmark_utils.h"
+
+#include <random>
+
+// ============================================================================
+// The options of the vertex packing benchmark parsed from the command line.
+// ============================================================================
+struct Options
+{
+	unsigned				repeats = 20;
+	std::vector<unsigned>	vertexCounts = { 1000, 100000, 1000000 };
+};
+
+// ============================================================================
+// Generate a deterministic set of authoring vertices within the unit cube.
+// ============================================================================
+std::vector<Vertex> GenerateVertices(unsigned count)
+{
+	std::vector<Vertex> vertices(count);
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-1.f, 1.f), color(0.f, 1.f);
+	for (auto& vertex : vertices) {
+		vertex = { { position(random), position(random), position(random) }, { color(random), color(random), color(random), 1.f } };
+	}
+	return vertices;
+}
+
+// ============================================================================
+// Time a packing kernel and print its throughput as JSON.
+// ============================================================================
+template <typename T, typename Kernel>
+void RunKernel(const Options& options, const char* format, const char* kernel, const std::vector<Vertex>& vertices, Kernel pack, bool first)
+{
+	std::vector<T> output(vertices.size());
+	pack(vertices.data(), vertices.size(), output.data());
+	std::vector<double> times;
+	for (auto i = 0u; i < options.repeats; i++) {
+		auto start = std::chrono::steady_clock::now();
+		pack(vertices.data(), vertices.size(), output.data());
+		times.push_back(Milliseconds(std::chrono::steady_clock::now() - start));
+	}
+	auto summary = Summarize(times);
+	auto seconds = summary.p50 / 1000.0;
+	std::printf("%s\n    {\"format\": \"%s\", \"kernel\": \"%s\", \"vertices\": %zu, \"inputBytesPerVertex\": %zu, \"outputBytesPerVertex\": %zu, \"sizeReduction\": %.2f,\n",
+		first ? "" : ",", format, kernel, vertices.size(), sizeof(Vertex), sizeof(T), static_cast<double>(sizeof(Vertex)) / sizeof(T));
+	std::printf("     \"mverticesPerSecond\": %.1f, \"inputGbPerSecond\": %.2f, \"timeMs\": %s}",
+		vertices.size() / seconds / 1e6, vertices.size() * sizeof(Vertex) / seconds / 1e9, SummaryJson(summary).c_str());
+	std::fflush(stdout);
+}
+
+// ============================================================================
+// The entry point of the vertex packing benchmark.
+//
+// Benchmark packs the authoring vertices into each quantized format with the
+// scalar and the vectorized kernels and reports the throughput of each.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (auto i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i], value = argv[i + 1];
+		if (name == "--repeats") {
+			options.repeats = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--vertices") {
+			options.vertexCounts = ParseList(value);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("{\"benchmark\": \"vertex_packing\", \"runs\": [");
+	auto first = true;
+	for (auto count : options.vertexCounts) {
+		auto vertices = GenerateVertices(std::max(count, 1u));
+		RunKernel<HalfVertex>(options, "half", "scalar", vertices, [](const Vertex* input, size_t size, HalfVertex* output) { PackVerticesScalar(input, size, output); }, first);
+		RunKernel<HalfVertex>(options, "half", "simd", vertices, [](const Vertex* input, size_t size, HalfVertex* output) { PackVertices(input, size, output); }, false);
+		RunKernel<SnormVertex>(options, "snorm16", "scalar", vertices, [](const Vertex* input, size_t size, SnormVertex* output) { PackVerticesScalar(input, size, 1.f, output); }, false);
+		RunKernel<SnormVertex>(options, "snorm16", "simd", vertices, [](const Vertex* input, size_t size, SnormVertex* output) { PackVertices(input, size, 1.f, output); }, false);
+		first = false;
+	}
+	std::printf("\n]}\n");
+	return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// ============================================================================
+// Read a plain value from a binary stream.
+// ============================================================================
+template <typename T>
+inline bool ReadValue(std::istream& stream, T& value)
+{
+	return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// ============================================================================
+// Write a plain value into a binary stream.
+// ============================================================================
+template <typename T>
+inline void WriteValue(std::ostream& stream, const T& value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// ============================================================================
+// Get the amount of bytes left in a binary stream.
+//
+// Zero is returned when the stream cannot seek, so the sizes read from a
+// file can be checked against the data that is actually there.
+// ============================================================================
+inline uint64_t RemainingSize(std::istream& stream)
+{
+	auto position = stream.tellg();
+	if (position < 0 || !stream.seekg(0, std::ios::end)) {
+		stream.clear();
+		return 0;
+	}
+	auto end = stream.tellg();
+	stream.seekg(position);
+	return (end > position) ? static_cast<uint64_t>(end - position) : 0;
+}
@@ -0,0 +1,223 @@
+#include "bounding_volume_hierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+
+// the relative tolerance of the node tests against the frustum planes.
+const float PlaneTolerance = 1e-5f;
+
+// the fraction of the marked nodes above which a refit scans all the nodes.
+const size_t DirtyScanRatio = 16;
+
+// ============================================================================
+// Build the hierarchy over the boxes of the objects.
+//
+// Objects are split recursively at the median of their centers along the
+// longest axis of the centers until they fit into a leaf. The identifier of
+// an object is its index in the given boxes.
+// ============================================================================
+void BoundingVolumeHierarchy::Build(const std::vector<Aabb>& objects)
+{
+	mNodes.clear();
+	mDirtyNodes.clear();
+	mObjectIds.resize(objects.size());
+	std::iota(mObjectIds.begin(), mObjectIds.end(), 0u);
+	mObjectPositions.resize(objects.size());
+	mObjectLeaves.resize(objects.size());
+	if (objects.empty()) {
+		mObjectBounds.Resize(0);
+		return;
+	}
+	std::vector<std::array<float, 3>> centers(objects.size());
+	for (size_t i = 0; i < objects.size(); i++) {
+		for (auto axis = 0; axis < 3; axis++) {
+			centers[i][axis] = (objects[i].minimum[axis] + objects[i].maximum[axis]) * 0.5f;
+		}
+	}
+	mNodes.reserve(2 * (objects.size() / BVH_LEAF_SIZE + 1));
+	BuildNode(0, 0, static_cast<uint32_t>(objects.size()), centers);
+
+	// store the boxes in the leaf order and fit the nodes from the bottom up.
+	mObjectBounds.Resize(objects.size());
+	for (uint32_t i = 0; i < mObjectIds.size(); i++) {
+		mObjectBounds.Set(i, objects[mObjectIds[i]]);
+		mObjectPositions[mObjectIds[i]] = i;
+	}
+	for (auto i = mNodes.size(); i > 0; i--) {
+		FitNode(static_cast<uint32_t>(i - 1));
+	}
+}
+
+// ============================================================================
+// Change the box of a moved object.
+//
+// The new box is stored right away, but the nodes above the object are only
+// marked and keep their old boxes until the next refit.
+// ============================================================================
+void BoundingVolumeHierarchy::Update(uint32_t id, const Aabb& bounds)
+{
+	if (id >= mObjectIds.size()) {
+		throw std::out_of_range("object identifier is not in the hierarchy");
+	}
+	mObjectBounds.Set(mObjectPositions[id], bounds);
+	for (auto node = mObjectLeaves[id]; !mNodes[node].dirty; node = mNodes[node].parent) {
+		mNodes[node].dirty = true;
+		mDirtyNodes.push_back(node);
+		if (node == 0) {
+			break;
+		}
+	}
+}
+
+// ============================================================================
+// Refit the boxes of the nodes marked by the updated objects.
+//
+// Children are always stored after their parents, so fitting the marked
+// nodes in a descending order fits the children before their parents. When
+// most of the nodes are marked, scanning all the nodes is faster than
+// sorting the marked ones.
+// ============================================================================
+void BoundingVolumeHierarchy::Refit()
+{
+	if (mDirtyNodes.size() * DirtyScanRatio >= mNodes.size()) {
+		for (auto node = static_cast<uint32_t>(mNodes.size()); node > 0; node--) {
+			if (mNodes[node - 1].dirty) {
+				FitNode(node - 1);
+				mNodes[node - 1].dirty = false;
+			}
+		}
+	} else {
+		std::sort(mDirtyNodes.begin(), mDirtyNodes.end(), std::greater<uint32_t>());
+		for (auto node : mDirtyNodes) {
+			FitNode(node);
+			mNodes[node].dirty = false;
+		}
+	}
+	mDirtyNodes.clear();
+}
+
+// ============================================================================
+// Find the objects whose boxes are visible in a frustum.
+//
+// The identifiers of the visible objects are written in the leaf order. The
+// result is the same as testing every object box against the frustum.
+// ============================================================================
+void BoundingVolumeHierarchy::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	if (!mNodes.empty()) {
+		CullNode(0, frustum, FRUSTUM_ALL_PLANES, visible);
+	}
+}
+
+// ============================================================================
+// Create the nodes for a range of the objects and return the node index.
+// ============================================================================
+uint32_t BoundingVolumeHierarchy::BuildNode(uint32_t parent, uint32_t first, uint32_t count, const std::vector<std::array<float, 3>>& centers)
+{
+	auto index = static_cast<uint32_t>(mNodes.size());
+	mNodes.push_back({ Aabb(), parent, 0, first, count, false });
+	if (count <= BVH_LEAF_SIZE) {
+		for (auto i = first; i < first + count; i++) {
+			mObjectLeaves[mObjectIds[i]] = index;
+		}
+		return index;
+	}
+
+	float minimum[3] = { INFINITY, INFINITY, INFINITY }, maximum[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (auto i = first; i < first + count; i++) {
+		for (auto axis = 0; axis < 3; axis++) {
+			minimum[axis] = std::min(minimum[axis], centers[mObjectIds[i]][axis]);
+			maximum[axis] = std::max(maximum[axis], centers[mObjectIds[i]][axis]);
+		}
+	}
+	auto axis = 0;
+	for (auto i = 1; i < 3; i++) {
+		if (maximum[i] - minimum[i] > maximum[axis] - minimum[axis]) {
+			axis = i;
+		}
+	}
+	auto begin = mObjectIds.begin() + first, middle = begin + count / 2, end = begin + count;
+	std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+	BuildNode(index, first, count / 2, centers);
+	auto right = BuildNode(index, first + count / 2, count - count / 2, centers);
+	mNodes[index].right = right;
+	return index;
+}
+
+// ============================================================================
+// Fit the box of a node around its objects or around its two children.
+// ============================================================================
+void BoundingVolumeHierarchy::FitNode(uint32_t index)
+{
+	auto& node = mNodes[index];
+	if (node.right == 0) {
+		node.bounds = mObjectBounds.Get(node.first);
+		for (auto i = node.first + 1; i < node.first + node.count; i++) {
+			auto bounds = mObjectBounds.Get(i);
+			for (auto axis = 0; axis < 3; axis++) {
+				node.bounds.minimum[axis] = std::min(node.bounds.minimum[axis], bounds.minimum[axis]);
+				node.bounds.maximum[axis] = std::max(node.bounds.maximum[axis], bounds.maximum[axis]);
+			}
+		}
+	} else {
+		auto& left = mNodes[index + 1].bounds;
+		auto& right = mNodes[node.right].bounds;
+		for (auto axis = 0; axis < 3; axis++) {
+			node.bounds.minimum[axis] = std::min(left.minimum[axis], right.minimum[axis]);
+			node.bounds.maximum[axis] = std::max(left.maximum[axis], right.maximum[axis]);
+		}
+	}
+}
+
+// ============================================================================
+// Cull a node and its children against the planes in the plane mask.
+//
+// A node outside of a plane is skipped with all of its children, and the
+// planes the node is completely inside of are removed from the mask of its
+// children. A node inside of all the planes writes out all of its objects
+// without testing them, and the objects of a leaf are tested against the
+// remaining planes with the vector kernels. The node tests are done with a
+// small tolerance, so rounding never skips or accepts an object which the
+// object test itself would not.
+// ============================================================================
+void BoundingVolumeHierarchy::CullNode(uint32_t index, const Frustum& frustum, unsigned planeMask, std::vector<uint32_t>& visible) const
+{
+	auto& node = mNodes[index];
+	for (auto p = 0; p < 6; p++) {
+		if ((planeMask & (1u << p)) == 0) {
+			continue;
+		}
+		auto& plane = frustum.planes[p];
+		auto distance = 0.f, radius = 0.f;
+		for (auto axis = 0; axis < 3; axis++) {
+			auto center = (node.bounds.minimum[axis] + node.bounds.maximum[axis]) * 0.5f;
+			auto extent = (node.bounds.maximum[axis] - node.bounds.minimum[axis]) * 0.5f;
+			distance += plane.normal[axis] * center;
+			radius += std::fabs(plane.normal[axis]) * extent;
+		}
+		auto tolerance = (std::fabs(distance) + std::fabs(plane.distance) + radius) * PlaneTolerance;
+		distance += plane.distance;
+		if (distance + radius < -tolerance) {
+			return;
+		}
+		if (distance - radius > tolerance) {
+			planeMask &= ~(1u << p);
+		}
+	}
+
+	if (planeMask == 0) {
+		visible.insert(visible.end(), mObjectIds.begin() + node.first, mObjectIds.begin() + node.first + node.count);
+	} else if (node.right == 0) {
+		auto count = visible.size();
+		visible.resize(count + node.count);
+		count += CullBounds(mObjectBounds, node.first, node.first + node.count, frustum, planeMask, mObjectIds.data(), visible.data() + count);
+		visible.resize(count);
+	} else {
+		CullNode(index + 1, frustum, planeMask, visible);
+		CullNode(node.right, frustum, planeMask, visible);
+	}
+}
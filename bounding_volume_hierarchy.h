@@ -0,0 +1,53 @@
+#pragma once
+
+#include "frustum_culling.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// the maximum amount of objects in a leaf of the hierarchy.
+#define BVH_LEAF_SIZE 8
+
+// ============================================================================
+// A bounding volume hierarchy over the bounding boxes of the scene objects.
+//
+// Nodes are stored in a depth first order, so the left child of a node is
+// always the next node. Object boxes are stored in the leaf order as arrays
+// of centers and extents, so each leaf is a contiguous range for the vector
+// culling kernels. Moving objects only update their boxes and mark their
+// leaves, and a refit then recomputes the marked leaves and their ancestors
+// without rebuilding the tree.
+// ============================================================================
+class BoundingVolumeHierarchy
+{
+public:
+	void Build(const std::vector<Aabb>& objects);
+	void Update(uint32_t id, const Aabb& bounds);
+	void Refit();
+	void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+	size_t ObjectCount() const { return mObjectIds.size(); }
+	size_t NodeCount() const { return mNodes.size(); }
+	Aabb Bounds(uint32_t id) const { return mObjectBounds.Get(mObjectPositions.at(id)); }
+	Aabb NodeBounds(uint32_t node) const { return mNodes.at(node).bounds; }
+private:
+	struct Node
+	{
+		Aabb		bounds;
+		uint32_t	parent;
+		uint32_t	right;
+		uint32_t	first;
+		uint32_t	count;
+		bool		dirty;
+	};
+	uint32_t BuildNode(uint32_t parent, uint32_t first, uint32_t count, const std::vector<std::array<float, 3>>& centers);
+	void FitNode(uint32_t index);
+	void CullNode(uint32_t index, const Frustum& frustum, unsigned planeMask, std::vector<uint32_t>& visible) const;
+private:
+	std::vector<Node>		mNodes;
+	SoaBounds				mObjectBounds;
+	std::vector<uint32_t>	mObjectIds;
+	std::vector<uint32_t>	mObjectPositions;
+	std::vector<uint32_t>	mObjectLeaves;
+	std::vector<uint32_t>	mDirtyNodes;
+};
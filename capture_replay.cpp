@@ -0,0 +1,254 @@
+#include "capture_replay.h"
+#include "instance_batcher.h"
+#include "vertex_packing.h"
+
+#include <cmath>
+
+// constants of the 64-bit FNV-1a hash function.
+const uint64_t FnvOffset64 = 14695981039346656037ull;
+const uint64_t FnvPrime64 = 1099511628211ull;
+
+// the largest width and height of a replayed frame, which is the largest texture size of D3D12.
+const uint32_t MaxFrameSize = 16384;
+
+// the identity transform used until a frame sets its transform.
+const std::array<float, 16> IdentityTransform = { {
+	1.f, 0.f, 0.f, 0.f,
+	0.f, 1.f, 0.f, 0.f,
+	0.f, 0.f, 1.f, 0.f,
+	0.f, 0.f, 0.f, 1.f
+} };
+
+// a helper to feed bytes into a 64-bit FNV-1a hash.
+static uint64_t Fnv64(uint64_t hash, const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * FnvPrime64;
+	}
+	return hash;
+}
+
+// a helper to read a 32-bit float stored in an instance stream.
+static float StreamFloat(uint32_t bits)
+{
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+CaptureReplayer::CaptureReplayer(RenderBackend& backend, Clock& clock) : mBackend(backend), mClock(clock), mTransform(IdentityTransform), mPipelineKey(0), mInstanceCount(0)
+{
+}
+
+// ============================================================================
+// Replay the frames of a capture and get the stats of each frame.
+//
+// The backend is resized whenever a frame has a different render size than
+// the previous frame, which is not included in the time of the frame.
+// ============================================================================
+std::vector<CaptureFrameStats> CaptureReplayer::Replay(const uint8_t* data, size_t size, const OutputHashCallback& outputHash)
+{
+	CaptureReader reader(data, size);
+	if ((reader.Header().flags & CAPTURE_FLAG_MISSING_BUFFERS) != 0) {
+		throw std::runtime_error("capture is missing resident buffers");
+	}
+
+	std::vector<CaptureFrameStats> frames;
+	CaptureFrameStats stats = {};
+	unsigned width = 0, height = 0;
+	bool inFrame = false;
+	mBuffers.clear();
+	CaptureRecord record;
+	while (reader.Next(record)) {
+		switch (record.command) {
+		case CaptureCommand::CreateBuffer: {
+			auto desc = CaptureReader::Payload<CaptureBuffer>(record);
+			auto validIndices = (desc.stride == sizeof(uint16_t) || desc.stride == sizeof(uint32_t));
+			auto validVertices = (desc.vertexFormat <= static_cast<uint32_t>(CaptureVertexFormat::Half) && desc.stride != 0);
+			auto valid = (desc.kind == static_cast<uint32_t>(CaptureBufferKind::Index)) ? validIndices : (desc.kind == static_cast<uint32_t>(CaptureBufferKind::Vertex) && validVertices);
+			if (desc.buffer == CAPTURE_NO_BUFFER || desc.size > size || !valid) {
+				throw std::runtime_error("invalid buffer in capture file");
+			}
+			auto& buffer = mBuffers[desc.buffer];
+			buffer.desc = desc;
+			buffer.data.assign(static_cast<size_t>(desc.size), 0);
+			break;
+		}
+		case CaptureCommand::UploadBuffer: {
+			auto upload = CaptureReader::Payload<CaptureUpload>(record);
+			auto buffer = mBuffers.find(upload.buffer);
+			if (buffer == mBuffers.end() || upload.size > record.size - sizeof(upload) || upload.offset > buffer->second.data.size() || upload.size > buffer->second.data.size() - upload.offset) {
+				throw std::runtime_error("invalid upload in capture file");
+			}
+			std::memcpy(buffer->second.data.data() + upload.offset, record.payload + sizeof(upload), static_cast<size_t>(upload.size));
+			break;
+		}
+		case CaptureCommand::DestroyBuffer:
+			mBuffers.erase(CaptureReader::Payload<uint32_t>(record));
+			break;
+		case CaptureCommand::BeginFrame: {
+			auto frame = CaptureReader::Payload<CaptureFrame>(record);
+			if (inFrame || frame.width == 0 || frame.height == 0 || frame.width > MaxFrameSize || frame.height > MaxFrameSize) {
+				throw std::runtime_error("invalid frame in capture file");
+			}
+			if (frame.width != width || frame.height != height) {
+				width = frame.width;
+				height = frame.height;
+				mBackend.SetWindow(width, height);
+			}
+			stats = {};
+			stats.geometryHash = FnvOffset64;
+			mTransform = IdentityTransform;
+			mPipelineKey = 0;
+			mInstanceCount = 0;
+			mVertices.clear();
+			inFrame = true;
+			break;
+		}
+		case CaptureCommand::SetTransform:
+			mTransform = CaptureReader::Payload<std::array<float, 16>>(record);
+			break;
+		case CaptureCommand::SetPipeline:
+			mPipelineKey = CaptureReader::Payload<uint64_t>(record);
+			break;
+		case CaptureCommand::SetInstances: {
+			auto instances = CaptureReader::Payload<CaptureInstances>(record);
+			if (instances.streamCount != INSTANCE_STREAM_COUNT || record.size - sizeof(instances) < sizeof(uint32_t) * INSTANCE_STREAM_COUNT * static_cast<uint64_t>(instances.instanceCount)) {
+				throw std::runtime_error("invalid instances in capture file");
+			}
+			mInstanceCount = instances.instanceCount;
+			mInstances.resize(static_cast<size_t>(INSTANCE_STREAM_COUNT) * mInstanceCount);
+			std::memcpy(mInstances.data(), record.payload + sizeof(instances), sizeof(uint32_t) * mInstances.size());
+			break;
+		}
+		case CaptureCommand::Draw:
+			if (!inFrame) {
+				throw std::runtime_error("draw outside of a frame in capture file");
+			}
+			ExpandDraw(CaptureReader::Payload<CaptureDraw>(record), stats);
+			break;
+		case CaptureCommand::EndFrame: {
+			if (!inFrame) {
+				throw std::runtime_error("invalid frame in capture file");
+			}
+			auto start = mClock.Now();
+			mBackend.SetGeometry(mVertices);
+			mBackend.Render();
+			mBackend.WaitForGPU();
+			stats.milliseconds = (mClock.Now() - start) / 1e6;
+			stats.geometryHash = Fnv64(stats.geometryHash, mVertices.data(), sizeof(Vertex) * mVertices.size());
+			stats.outputHash = outputHash ? outputHash() : 0;
+			frames.push_back(stats);
+			inFrame = false;
+			break;
+		}
+		}
+	}
+	return frames;
+}
+
+// ============================================================================
+// Expand an instanced draw into the triangle list of the frame.
+//
+// Vertices are placed with the instance data and then transformed into the
+// normalized device coordinates exactly as the vertex shader of the renderer.
+// ============================================================================
+void CaptureReplayer::ExpandDraw(const CaptureDraw& draw, CaptureFrameStats& stats)
+{
+	auto vertices = mBuffers.find(draw.vertexBuffer);
+	auto indices = mBuffers.find(draw.indexBuffer);
+	if (vertices == mBuffers.end() || vertices->second.desc.kind != static_cast<uint32_t>(CaptureBufferKind::Vertex)) {
+		throw std::runtime_error("draw without a vertex buffer in capture file");
+	}
+	auto indexed = (draw.indexBuffer != CAPTURE_NO_BUFFER);
+	if (indexed && (indices == mBuffers.end() || indices->second.desc.kind != static_cast<uint32_t>(CaptureBufferKind::Index))) {
+		throw std::runtime_error("draw without an index buffer in capture file");
+	}
+	if (static_cast<uint64_t>(draw.firstInstance) + draw.instanceCount > mInstanceCount) {
+		throw std::runtime_error("draw outside of the instances in capture file");
+	}
+	stats.geometryHash = Fnv64(stats.geometryHash, &mPipelineKey, sizeof(mPipelineKey));
+	stats.drawCount++;
+	stats.triangleCount += draw.count / 3 * draw.instanceCount;
+
+	auto stream = [&](InstanceStream index, uint32_t instance) { return mInstances[static_cast<size_t>(index) * mInstanceCount + instance]; };
+	for (auto instance = draw.firstInstance; instance < draw.firstInstance + draw.instanceCount; instance++) {
+		auto offsetX = StreamFloat(stream(InstanceStream::OffsetX, instance));
+		auto offsetY = StreamFloat(stream(InstanceStream::OffsetY, instance));
+		auto scale = StreamFloat(stream(InstanceStream::Scale, instance));
+		auto rotation = StreamFloat(stream(InstanceStream::Rotation, instance));
+		auto color = stream(InstanceStream::Color, instance);
+		auto sine = std::sin(rotation), cosine = std::cos(rotation);
+		for (uint64_t i = draw.first; i < static_cast<uint64_t>(draw.first) + draw.count; i++) {
+			int64_t index = static_cast<int64_t>(i);
+			if (indexed) {
+				auto& buffer = indices->second;
+				if ((i + 1) * buffer.desc.stride > buffer.data.size()) {
+					throw std::runtime_error("draw outside of the index buffer in capture file");
+				}
+				if (buffer.desc.stride == sizeof(uint16_t)) {
+					uint16_t value;
+					std::memcpy(&value, buffer.data.data() + i * sizeof(value), sizeof(value));
+					index = value;
+				} else {
+					uint32_t value;
+					std::memcpy(&value, buffer.data.data() + i * sizeof(value), sizeof(value));
+					index = value;
+				}
+				index += draw.baseVertex;
+			}
+			if (index < 0) {
+				throw std::runtime_error("draw outside of the vertex buffer in capture file");
+			}
+
+			// place the vertex with the instance and then transform it with the row major transform.
+			auto vertex = ReadVertex(vertices->second, static_cast<uint64_t>(index));
+			float placed[4] = {
+				(cosine * vertex.position[0] - sine * vertex.position[1]) * scale + offsetX,
+				(sine * vertex.position[0] + cosine * vertex.position[1]) * scale + offsetY,
+				vertex.position[2],
+				1.f
+			};
+			float transformed[4];
+			for (auto row = 0; row < 4; row++) {
+				transformed[row] = mTransform[row * 4] * placed[0] + mTransform[row * 4 + 1] * placed[1] + mTransform[row * 4 + 2] * placed[2] + mTransform[row * 4 + 3] * placed[3];
+			}
+			auto w = (transformed[3] != 0.f) ? transformed[3] : 1.f;
+			vertex.position = { { transformed[0] / w, transformed[1] / w, transformed[2] / w } };
+			for (auto channel = 0; channel < 4; channel++) {
+				vertex.color[channel] *= ((color >> (channel * 8)) & 0xff) / 255.f;
+			}
+			mVertices.push_back(vertex);
+		}
+	}
+}
+
+// ============================================================================
+// Read a vertex of a vertex buffer in the float authoring format.
+// ============================================================================
+Vertex CaptureReplayer::ReadVertex(const Buffer& buffer, uint64_t index) const
+{
+	auto format = static_cast<CaptureVertexFormat>(buffer.desc.vertexFormat);
+	auto size = (format == CaptureVertexFormat::Half) ? sizeof(HalfVertex) : sizeof(Vertex);
+	if (buffer.desc.stride < size || index * buffer.desc.stride + size > buffer.data.size()) {
+		throw std::runtime_error("draw outside of the vertex buffer in capture file");
+	}
+	auto data = buffer.data.data() + index * buffer.desc.stride;
+	Vertex vertex;
+	if (format == CaptureVertexFormat::Half) {
+		HalfVertex packed;
+		std::memcpy(&packed, data, sizeof(packed));
+		for (auto i = 0; i < 3; i++) {
+			vertex.position[i] = HalfToFloat(packed.position.value[i]);
+		}
+		for (auto i = 0; i < 4; i++) {
+			vertex.color[i] = packed.color.value[i] / 255.f;
+		}
+	} else if (format == CaptureVertexFormat::Float) {
+		std::memcpy(&vertex, data, sizeof(vertex));
+	} else {
+		throw std::runtime_error("invalid vertex format in capture file");
+	}
+	return vertex;
+}
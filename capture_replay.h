@@ -0,0 +1,59 @@
+#pragma once
+
+#include "clock.h"
+#include "command_capture.h"
+#include "render_backend.h"
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// The measurements and the hashes of a replayed frame.
+//
+// The geometry hash covers the triangles and the pipeline states submitted
+// into the backend, while the output hash is given by the caller, e.g. from
+// the frame buffer of the software renderer.
+// ============================================================================
+struct CaptureFrameStats
+{
+	double		milliseconds;
+	unsigned	drawCount;
+	unsigned	triangleCount;
+	uint64_t	geometryHash;
+	uint64_t	outputHash;
+};
+
+// ============================================================================
+// A player that re-executes a capture on a rendering backend.
+//
+// Draws are expanded on the CPU into triangle lists as the vertex shader of
+// the renderer would transform them, and each frame is then rendered and
+// waited for. Only the rendering is timed, so the frame times are comparable
+// between the backends and between the builds being bisected.
+// ============================================================================
+class CaptureReplayer
+{
+public:
+	typedef std::function<uint64_t()> OutputHashCallback;
+	CaptureReplayer(RenderBackend& backend, Clock& clock);
+	std::vector<CaptureFrameStats> Replay(const uint8_t* data, size_t size, const OutputHashCallback& outputHash = nullptr);
+private:
+	struct Buffer
+	{
+		CaptureBuffer			desc;
+		std::vector<uint8_t>	data;
+	};
+	void ExpandDraw(const CaptureDraw& draw, CaptureFrameStats& stats);
+	Vertex ReadVertex(const Buffer& buffer, uint64_t index) const;
+private:
+	RenderBackend&							mBackend;
+	Clock&									mClock;
+	std::unordered_map<uint32_t, Buffer>	mBuffers;
+	std::array<float, 16>					mTransform;
+	uint64_t								mPipelineKey;
+	std::vector<uint32_t>					mInstances;
+	uint32_t								mInstanceCount;
+	std::vector<Vertex>						mVertices;
+};
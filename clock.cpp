@@ -0,0 +1,35 @@
+#include "clock.h"
+
+#include <chrono>
+#include <thread>
+
+// ============================================================================
+// Get the time of the monotonic system clock in nanoseconds.
+// ============================================================================
+uint64_t SteadyClock::Now()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+// ============================================================================
+// Block the calling thread until the given time.
+// ============================================================================
+void SteadyClock::SleepUntil(uint64_t time)
+{
+	auto now = Now();
+	if (time > now) {
+		std::this_thread::sleep_for(std::chrono::nanoseconds(time - now));
+	}
+}
+
+// ============================================================================
+// Move the simulated time forward to the given time.
+// ============================================================================
+void SimulatedClock::SleepUntil(uint64_t time)
+{
+	auto now = mTime.load(std::memory_order_relaxed);
+	while (now < time && !mTime.compare_exchange_weak(now, time, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+	}
+	mSleepCount.fetch_add(1, std::memory_order_relaxed);
+}
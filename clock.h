@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ============================================================================
+// An interface for a monotonic clock with the time in nanoseconds.
+//
+// Clock abstracts the time source of the loops, so that they can be driven
+// with a simulated time and tested without sleeping for real.
+// ============================================================================
+class Clock
+{
+public:
+	virtual ~Clock() = default;
+	virtual uint64_t Now() = 0;
+	virtual void SleepUntil(uint64_t time) = 0;
+};
+
+// ============================================================================
+// A clock that reads the monotonic system clock.
+// ============================================================================
+class SteadyClock : public Clock
+{
+public:
+	uint64_t Now() override;
+	void SleepUntil(uint64_t time) override;
+};
+
+// ============================================================================
+// A clock that only advances when explicitly told to.
+//
+// Sleeping moves the time forward to the requested time right away, so loops
+// run as fast as possible while they observe the time they expect.
+// ============================================================================
+class SimulatedClock : public Clock
+{
+public:
+	explicit SimulatedClock(uint64_t time = 0) : mTime(time), mSleepCount(0) {}
+	uint64_t Now() override { return mTime.load(std::memory_order_acquire); }
+	void SleepUntil(uint64_t time) override;
+	void Advance(uint64_t nanoseconds) { mTime.fetch_add(nanoseconds, std::memory_order_acq_rel); }
+	unsigned SleepCount() const { return mSleepCount.load(std::memory_order_relaxed); }
+private:
+	std::atomic<uint64_t>	mTime;
+	std::atomic<unsigned>	mSleepCount;
+};
@@ -0,0 +1,360 @@
+#include "command_capture.h"
+
+// a helper to get the size of a payload padded to the record alignment.
+static size_t PaddedSize(size_t size)
+{
+	return (size + CAPTURE_RECORD_ALIGNMENT - 1) & ~static_cast<size_t>(CAPTURE_RECORD_ALIGNMENT - 1);
+}
+
+// a helper to append a record into a section, which returns null when the record does not fit.
+static uint8_t* AppendRecord(std::vector<uint8_t>& section, size_t& sectionSize, CaptureCommand command, size_t size)
+{
+	auto padded = PaddedSize(size);
+	if (size > UINT32_MAX || section.size() - sectionSize < sizeof(CaptureRecordHeader) + padded) {
+		return nullptr;
+	}
+	CaptureRecordHeader header = { static_cast<uint32_t>(command), static_cast<uint32_t>(size) };
+	auto record = section.data() + sectionSize;
+	std::memcpy(record, &header, sizeof(header));
+	std::memset(record + sizeof(header) + size, 0, padded - size);
+	sectionSize += sizeof(header) + padded;
+	return record + sizeof(header);
+}
+
+CaptureWriter::CaptureWriter(size_t residentCapacity, size_t frameCapacity) :
+	mResident(residentCapacity),
+	mResidentSize(0),
+	mFrames(frameCapacity),
+	mFramesSize(0),
+	mFramesEnd(0),
+	mNextBuffer(CAPTURE_NO_BUFFER + 1),
+	mStartBuffer(CAPTURE_NO_BUFFER + 1),
+	mRemainingFrames(0),
+	mCapturedFrames(0),
+	mFrameNumber(0),
+	mStarted(false),
+	mInFrame(false),
+	mOverflowed(false),
+	mMissingBuffers(false)
+{
+}
+
+// ============================================================================
+// Start to capture the given amount of frames from the next frame onwards.
+//
+// The previous capture is dropped and the buffer changes recorded during it
+// are applied into the resident section before the new capture starts.
+// ============================================================================
+void CaptureWriter::Start(unsigned frameCount)
+{
+	FlushPendingChanges();
+	mStarted = (frameCount != 0);
+	mStartBuffer = mNextBuffer;
+	mRemainingFrames = frameCount;
+	mCapturedFrames = 0;
+	mFrameNumber = 0;
+	mInFrame = false;
+	mOverflowed = false;
+}
+
+// ============================================================================
+// Record the creation of a buffer and get the identifier of the buffer.
+//
+// Buffers are always recorded into the resident section, as they cannot be
+// used by the frames captured before they were created.
+// ============================================================================
+uint32_t CaptureWriter::CreateBuffer(CaptureBufferKind kind, CaptureVertexFormat vertexFormat, uint32_t stride, uint64_t size)
+{
+	auto buffer = mNextBuffer++;
+	auto payload = AppendResident(CaptureCommand::CreateBuffer, sizeof(CaptureBuffer));
+	if (payload != nullptr) {
+		CaptureBuffer record = { buffer, static_cast<uint32_t>(kind), static_cast<uint32_t>(vertexFormat), stride, size };
+		std::memcpy(payload, &record, sizeof(record));
+	}
+	return buffer;
+}
+
+// ============================================================================
+// Record the data uploaded into a buffer.
+//
+// Uploads into the buffers that existed when the capture started are part
+// of the captured frames, while the other uploads complete their buffers.
+// ============================================================================
+void CaptureWriter::UploadBuffer(uint32_t buffer, uint64_t offset, const void* data, uint64_t size)
+{
+	auto payloadSize = sizeof(CaptureUpload) + static_cast<size_t>(size);
+	auto payload = (mStarted && buffer < mStartBuffer) ? AppendFrame(CaptureCommand::UploadBuffer, payloadSize) : AppendResident(CaptureCommand::UploadBuffer, payloadSize);
+	if (payload != nullptr) {
+		CaptureUpload record = { buffer, 0, offset, size };
+		std::memcpy(payload, &record, sizeof(record));
+		std::memcpy(payload + sizeof(record), data, static_cast<size_t>(size));
+	}
+}
+
+// ============================================================================
+// Record the destruction of a buffer.
+//
+// The records of the buffer are removed from the resident section unless a
+// capture may still need them, in which case the removal is deferred.
+// ============================================================================
+void CaptureWriter::DestroyBuffer(uint32_t buffer)
+{
+	if (mStarted) {
+		if (auto payload = AppendFrame(CaptureCommand::DestroyBuffer, sizeof(buffer))) {
+			std::memcpy(payload, &buffer, sizeof(buffer));
+			return;
+		}
+	}
+	RemoveResident(buffer);
+}
+
+// ============================================================================
+// Begin a frame, which is recorded when a capture is running.
+// ============================================================================
+void CaptureWriter::BeginFrame(uint32_t width, uint32_t height)
+{
+	if (!Capturing()) {
+		return;
+	}
+	mInFrame = true;
+	if (auto payload = AppendFrame(CaptureCommand::BeginFrame, sizeof(CaptureFrame))) {
+		CaptureFrame record = { mFrameNumber++, width, height, 0 };
+		std::memcpy(payload, &record, sizeof(record));
+	}
+}
+
+// ============================================================================
+// Record the 4x4 row major transform of the following draws.
+// ============================================================================
+void CaptureWriter::SetTransform(const float* transform)
+{
+	if (!mInFrame) {
+		return;
+	}
+	if (auto payload = AppendFrame(CaptureCommand::SetTransform, 16 * sizeof(float))) {
+		std::memcpy(payload, transform, 16 * sizeof(float));
+	}
+}
+
+// ============================================================================
+// Record the pipeline state of the following draws.
+// ============================================================================
+void CaptureWriter::SetPipeline(const PipelineStateDesc& desc)
+{
+	if (!mInFrame) {
+		return;
+	}
+	if (auto payload = AppendFrame(CaptureCommand::SetPipeline, sizeof(uint64_t))) {
+		auto key = desc.Key();
+		std::memcpy(payload, &key, sizeof(key));
+	}
+}
+
+// ============================================================================
+// Record the instance streams used by the following draws.
+// ============================================================================
+void CaptureWriter::SetInstances(const uint32_t* const* streams, uint32_t streamCount, uint32_t instanceCount)
+{
+	if (!mInFrame) {
+		return;
+	}
+	auto streamSize = sizeof(uint32_t) * instanceCount;
+	if (auto payload = AppendFrame(CaptureCommand::SetInstances, sizeof(CaptureInstances) + streamCount * streamSize)) {
+		CaptureInstances record = { instanceCount, streamCount };
+		std::memcpy(payload, &record, sizeof(record));
+		for (auto i = 0u; i < streamCount && instanceCount != 0; i++) {
+			std::memcpy(payload + sizeof(record) + i * streamSize, streams[i], streamSize);
+		}
+	}
+}
+
+// ============================================================================
+// Record a draw with the current state.
+// ============================================================================
+void CaptureWriter::Draw(const CaptureDraw& draw)
+{
+	if (!mInFrame) {
+		return;
+	}
+	if (auto payload = AppendFrame(CaptureCommand::Draw, sizeof(draw))) {
+		std::memcpy(payload, &draw, sizeof(draw));
+	}
+}
+
+// ============================================================================
+// End a frame, which completes the capture after its last frame.
+// ============================================================================
+void CaptureWriter::EndFrame()
+{
+	if (!mInFrame) {
+		return;
+	}
+	if (AppendFrame(CaptureCommand::EndFrame, 0) != nullptr) {
+		mInFrame = false;
+		mFramesEnd = mFramesSize;
+		mCapturedFrames++;
+		mRemainingFrames--;
+	}
+}
+
+// ============================================================================
+// Write the captured frames with the resident buffers into a capture file.
+// ============================================================================
+void CaptureWriter::Write(std::ostream& output) const
+{
+	CaptureFileHeader header = {};
+	header.magic = CAPTURE_FILE_MAGIC;
+	header.version = CAPTURE_FILE_VERSION;
+	header.frameCount = mCapturedFrames;
+	header.flags = mMissingBuffers ? CAPTURE_FLAG_MISSING_BUFFERS : 0;
+	header.residentSize = mResidentSize;
+	header.frameSize = mFramesEnd;
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(mResident.data()), static_cast<std::streamsize>(mResidentSize));
+	output.write(reinterpret_cast<const char*>(mFrames.data()), static_cast<std::streamsize>(mFramesEnd));
+	if (!output) {
+		throw std::runtime_error("failed to write the capture file");
+	}
+}
+
+// ============================================================================
+// Append a record into the resident section.
+//
+// A buffer that does not fit makes every following capture incomplete, which
+// is marked into the captures so they are not replayed with missing data.
+// ============================================================================
+uint8_t* CaptureWriter::AppendResident(CaptureCommand command, size_t size)
+{
+	auto payload = AppendRecord(mResident, mResidentSize, command, size);
+	if (payload == nullptr) {
+		mMissingBuffers = true;
+	}
+	return payload;
+}
+
+// ============================================================================
+// Append a record into the frame section.
+//
+// A record that does not fit ends the capture with the frames completed so
+// far. When the record is a buffer change, the capture is dropped instead,
+// so the pending changes and the change itself go into the resident section.
+// ============================================================================
+uint8_t* CaptureWriter::AppendFrame(CaptureCommand command, size_t size)
+{
+	auto payload = AppendRecord(mFrames, mFramesSize, command, size);
+	if (payload != nullptr) {
+		return payload;
+	}
+	EndCapture();
+	if (command == CaptureCommand::UploadBuffer || command == CaptureCommand::DestroyBuffer) {
+		FlushPendingChanges();
+		return (command == CaptureCommand::UploadBuffer) ? AppendResident(command, size) : nullptr;
+	}
+	return nullptr;
+}
+
+// ============================================================================
+// Apply the buffer changes recorded during a capture into the resident section.
+// ============================================================================
+void CaptureWriter::FlushPendingChanges()
+{
+	size_t offset = 0;
+	while (offset < mFramesSize) {
+		CaptureRecordHeader header;
+		std::memcpy(&header, mFrames.data() + offset, sizeof(header));
+		auto payload = mFrames.data() + offset + sizeof(header);
+		if (header.command == static_cast<uint32_t>(CaptureCommand::UploadBuffer)) {
+			if (auto record = AppendResident(CaptureCommand::UploadBuffer, header.size)) {
+				std::memcpy(record, payload, header.size);
+			}
+		} else if (header.command == static_cast<uint32_t>(CaptureCommand::DestroyBuffer)) {
+			uint32_t buffer;
+			std::memcpy(&buffer, payload, sizeof(buffer));
+			RemoveResident(buffer);
+		}
+		offset += sizeof(header) + PaddedSize(header.size);
+	}
+	mFramesSize = 0;
+	mFramesEnd = 0;
+	mStarted = false;
+	mCapturedFrames = 0;
+}
+
+// ============================================================================
+// Remove the creation and the uploads of a buffer from the resident section.
+// ============================================================================
+void CaptureWriter::RemoveResident(uint32_t buffer)
+{
+	size_t read = 0, write = 0;
+	while (read < mResidentSize) {
+		CaptureRecordHeader header;
+		std::memcpy(&header, mResident.data() + read, sizeof(header));
+		auto recordSize = sizeof(header) + PaddedSize(header.size);
+		uint32_t recordBuffer;
+		std::memcpy(&recordBuffer, mResident.data() + read + sizeof(header), sizeof(recordBuffer));
+		if (recordBuffer != buffer) {
+			std::memmove(mResident.data() + write, mResident.data() + read, recordSize);
+			write += recordSize;
+		}
+		read += recordSize;
+	}
+	mResidentSize = write;
+}
+
+// ============================================================================
+// End the running capture with the frames completed so far.
+// ============================================================================
+void CaptureWriter::EndCapture()
+{
+	mRemainingFrames = 0;
+	mInFrame = false;
+	mOverflowed = true;
+}
+
+CaptureReader::CaptureReader(const uint8_t* data, size_t size) : mData(data), mOffset(sizeof(CaptureFileHeader)), mEnd(0)
+{
+	if (size < sizeof(CaptureFileHeader)) {
+		throw std::runtime_error("capture file is too small");
+	}
+	std::memcpy(&mHeader, data, sizeof(mHeader));
+	if (mHeader.magic != CAPTURE_FILE_MAGIC) {
+		throw std::runtime_error("not a capture file");
+	}
+	if (mHeader.version != CAPTURE_FILE_VERSION) {
+		throw std::runtime_error("unsupported capture file version");
+	}
+	auto available = size - sizeof(CaptureFileHeader);
+	if (mHeader.residentSize > available || mHeader.frameSize > available - mHeader.residentSize) {
+		throw std::runtime_error("capture file is truncated");
+	}
+	mEnd = sizeof(CaptureFileHeader) + static_cast<size_t>(mHeader.residentSize + mHeader.frameSize);
+}
+
+// ============================================================================
+// Read the next record of the capture.
+//
+// Function returns false after the last record. The records of the resident
+// section are read first and then the records of the frame section.
+// ============================================================================
+bool CaptureReader::Next(CaptureRecord& record)
+{
+	if (mOffset == mEnd) {
+		return false;
+	}
+	CaptureRecordHeader header;
+	if (mEnd - mOffset < sizeof(header)) {
+		throw std::runtime_error("capture record is truncated");
+	}
+	std::memcpy(&header, mData + mOffset, sizeof(header));
+	if (PaddedSize(header.size) > mEnd - mOffset - sizeof(header)) {
+		throw std::runtime_error("capture record is truncated");
+	}
+	if (header.command > static_cast<uint32_t>(CaptureCommand::EndFrame)) {
+		throw std::runtime_error("invalid command in capture file");
+	}
+	record.command = static_cast<CaptureCommand>(header.command);
+	record.payload = mData + mOffset + sizeof(header);
+	record.size = header.size;
+	mOffset += sizeof(header) + PaddedSize(header.size);
+	return true;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "pipeline_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// the magic number at the start of a capture file ("RCAP").
+#define CAPTURE_FILE_MAGIC 0x50414352u
+
+// the version of the capture file format. Files with another version are rejected.
+#define CAPTURE_FILE_VERSION 1
+
+// the alignment of the records within a capture file.
+#define CAPTURE_RECORD_ALIGNMENT 8
+
+// the flag of a capture whose resident buffers did not fit into the writer.
+#define CAPTURE_FLAG_MISSING_BUFFERS 0x1u
+
+// the identifier used when a draw does not use a buffer.
+#define CAPTURE_NO_BUFFER 0u
+
+// ============================================================================
+// The commands of the records in a capture.
+// ============================================================================
+enum class CaptureCommand : uint32_t
+{
+	CreateBuffer,
+	UploadBuffer,
+	DestroyBuffer,
+	BeginFrame,
+	SetTransform,
+	SetPipeline,
+	SetInstances,
+	Draw,
+	EndFrame
+};
+
+// ============================================================================
+// The kinds of the captured buffers and the formats of the vertex buffers.
+// ============================================================================
+enum class CaptureBufferKind : uint32_t { Vertex, Index };
+enum class CaptureVertexFormat : uint32_t { Float, Half };
+
+// ============================================================================
+// The header at the start of a capture file.
+//
+// Header is followed by the resident section, which creates and fills the
+// buffers that existed when the capture started, and the frame section with
+// the commands of the captured frames in their recording order.
+// ============================================================================
+struct CaptureFileHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	frameCount;
+	uint32_t	flags;
+	uint64_t	residentSize;
+	uint64_t	frameSize;
+};
+
+static_assert(sizeof(CaptureFileHeader) == 32, "the size of the capture file header must not change");
+
+// ============================================================================
+// The header of a record, which is followed by the payload of the command.
+//
+// The size is the size of the payload, which is padded to the alignment.
+// ============================================================================
+struct CaptureRecordHeader
+{
+	uint32_t	command;
+	uint32_t	size;
+};
+
+// ============================================================================
+// The payloads of the records in a capture.
+//
+// An upload is followed by the uploaded bytes and a set of instances by the
+// instance streams, each with 32 bits for each of the instances.
+// ============================================================================
+struct CaptureBuffer
+{
+	uint32_t	buffer;
+	uint32_t	kind;
+	uint32_t	vertexFormat;
+	uint32_t	stride;
+	uint64_t	size;
+};
+
+struct CaptureUpload
+{
+	uint32_t	buffer;
+	uint32_t	reserved;
+	uint64_t	offset;
+	uint64_t	size;
+};
+
+struct CaptureFrame
+{
+	uint32_t	frame;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	reserved;
+};
+
+struct CaptureInstances
+{
+	uint32_t	instanceCount;
+	uint32_t	streamCount;
+};
+
+struct CaptureDraw
+{
+	uint32_t	vertexBuffer;
+	uint32_t	indexBuffer;
+	uint32_t	count;
+	uint32_t	instanceCount;
+	uint32_t	first;
+	int32_t		baseVertex;
+	uint32_t	firstInstance;
+	uint32_t	reserved;
+};
+
+// ============================================================================
+// A writer that records the commands of a window of frames into memory.
+//
+// Both sections are allocated up front, so recording only copies the commands
+// without any allocations. The resident section always holds the buffers that
+// are alive, so a capture can be started at any frame. The buffers that exist
+// when a capture starts are left untouched until the next capture, and their
+// later changes are recorded into the frame section instead. A frame that does
+// not fit ends the capture with the frames recorded before it.
+// ============================================================================
+class CaptureWriter
+{
+public:
+	CaptureWriter(size_t residentCapacity, size_t frameCapacity);
+	void Start(unsigned frameCount);
+	uint32_t CreateBuffer(CaptureBufferKind kind, CaptureVertexFormat vertexFormat, uint32_t stride, uint64_t size);
+	void UploadBuffer(uint32_t buffer, uint64_t offset, const void* data, uint64_t size);
+	void DestroyBuffer(uint32_t buffer);
+	void BeginFrame(uint32_t width, uint32_t height);
+	void SetTransform(const float* transform);
+	void SetPipeline(const PipelineStateDesc& desc);
+	void SetInstances(const uint32_t* const* streams, uint32_t streamCount, uint32_t instanceCount);
+	void Draw(const CaptureDraw& draw);
+	void EndFrame();
+	void Write(std::ostream& output) const;
+	bool Capturing() const { return mRemainingFrames != 0; }
+	bool Complete() const { return mStarted && mRemainingFrames == 0 && mCapturedFrames != 0; }
+	unsigned CapturedFrames() const { return mCapturedFrames; }
+	bool Overflowed() const { return mOverflowed; }
+private:
+	uint8_t* AppendResident(CaptureCommand command, size_t size);
+	uint8_t* AppendFrame(CaptureCommand command, size_t size);
+	void FlushPendingChanges();
+	void RemoveResident(uint32_t buffer);
+	void EndCapture();
+private:
+	std::vector<uint8_t>	mResident;
+	size_t					mResidentSize;
+	std::vector<uint8_t>	mFrames;
+	size_t					mFramesSize;
+	size_t					mFramesEnd;
+	uint32_t				mNextBuffer;
+	uint32_t				mStartBuffer;
+	unsigned				mRemainingFrames;
+	unsigned				mCapturedFrames;
+	uint32_t				mFrameNumber;
+	bool					mStarted;
+	bool					mInFrame;
+	bool					mOverflowed;
+	bool					mMissingBuffers;
+};
+
+// ============================================================================
+// A record read from a capture.
+// ============================================================================
+struct CaptureRecord
+{
+	CaptureCommand	command;
+	const uint8_t*	payload;
+	size_t			size;
+};
+
+// ============================================================================
+// A reader that walks the records of a capture file in memory.
+//
+// The header and the bounds of every record are validated while reading, so
+// a truncated or a corrupted capture is rejected with an exception.
+// ============================================================================
+class CaptureReader
+{
+public:
+	CaptureReader(const uint8_t* data, size_t size);
+	const CaptureFileHeader& Header() const { return mHeader; }
+	bool Next(CaptureRecord& record);
+	template <typename T> static T Payload(const CaptureRecord& record);
+private:
+	CaptureFileHeader	mHeader;
+	const uint8_t*		mData;
+	size_t				mOffset;
+	size_t				mEnd;
+};
+
+// ============================================================================
+// Read the fixed part of the payload of a record.
+// ============================================================================
+template <typename T>
+T CaptureReader::Payload(const CaptureRecord& record)
+{
+	if (record.size < sizeof(T)) {
+		throw std::runtime_error("capture record is too small");
+	}
+	T payload;
+	std::memcpy(&payload, record.payload, sizeof(T));
+	return payload;
+}
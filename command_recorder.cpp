@@ -0,0 +1,100 @@
+#include "command_recorder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ParallelRecorder::ParallelRecorder(JobSystem& jobSystem, CommandRecorder& recorder, unsigned minChunkSize) : mJobSystem(jobSystem), mRecorder(recorder), mMinChunkSize(std::max(minChunkSize, 1u))
+{
+}
+
+// ============================================================================
+// Record the given amount of draw items into lists starting from a list.
+//
+// Items are split into at most one chunk per thread of the system, but chunks
+// are not made smaller than the minimum chunk size as each list has a fixed
+// cost. Function returns the amount of lists that were recorded.
+// ============================================================================
+unsigned ParallelRecorder::Record(unsigned firstList, unsigned itemCount, const RecordCallback& record)
+{
+	if (firstList >= mRecorder.ListCount()) {
+		throw std::out_of_range("recording into a list the recorder does not have");
+	}
+	auto chunkCount = (itemCount + mMinChunkSize - 1) / mMinChunkSize;
+	chunkCount = std::max(std::min({ chunkCount, mJobSystem.ThreadCount(), mRecorder.ListCount() - firstList }), 1u);
+	mJobSystem.ParallelFor(chunkCount, 1, [&](unsigned chunk, unsigned) {
+		auto begin = static_cast<unsigned>(static_cast<uint64_t>(itemCount) * chunk / chunkCount);
+		auto end = static_cast<unsigned>(static_cast<uint64_t>(itemCount) * (chunk + 1) / chunkCount);
+		auto& context = mRecorder.BeginList(firstList + chunk);
+		record(context, begin, end);
+		mRecorder.EndList(firstList + chunk);
+	});
+	return chunkCount;
+}
+
+CommandBufferRecorder::CommandBufferRecorder(unsigned listCount) : mSubmittedHash(14695981039346656037ull), mSubmittedDraws(0), mSubmitCount(0)
+{
+	for (auto i = 0u; i < std::max(listCount, 1u); i++) {
+		mLists.push_back(std::make_unique<List>());
+	}
+}
+
+// ============================================================================
+// Clear a command buffer and start recording into it.
+// ============================================================================
+CommandContext& CommandBufferRecorder::BeginList(unsigned list)
+{
+	auto& buffer = *mLists.at(list);
+	buffer.commands.clear();
+	buffer.recording = true;
+	return buffer;
+}
+
+// ============================================================================
+// Finish recording into a command buffer.
+// ============================================================================
+void CommandBufferRecorder::EndList(unsigned list)
+{
+	mLists.at(list)->recording = false;
+}
+
+// ============================================================================
+// Submit the first command buffers in the order of their indices.
+//
+// The draws are folded into the FNV-1a hash of all submitted commands.
+// ============================================================================
+void CommandBufferRecorder::Submit(unsigned listCount)
+{
+	for (auto i = 0u; i < listCount; i++) {
+		auto& buffer = *mLists.at(i);
+		if (buffer.recording) {
+			throw std::logic_error("submitting a command list that is still being recorded");
+		}
+		for (auto& command : buffer.commands) {
+			auto bytes = reinterpret_cast<const uint8_t*>(&command);
+			for (auto j = 0u; j < sizeof(command); j++) {
+				mSubmittedHash = (mSubmittedHash ^ bytes[j]) * 1099511628211ull;
+			}
+		}
+		mSubmittedDraws += buffer.commands.size();
+	}
+	mSubmitCount++;
+}
+
+// ============================================================================
+// Store a draw into the command buffer.
+// ============================================================================
+void CommandBufferRecorder::List::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	commands.push_back({ vertexCount, instanceCount, firstVertex, firstInstance, 0, 0 });
+}
+
+// ============================================================================
+// Store an indexed draw into the command buffer.
+//
+// The index count and the first index are stored in the vertex count and the
+// first vertex fields of the command, which is then marked as indexed.
+// ============================================================================
+void CommandBufferRecorder::List::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+	commands.push_back({ indexCount, instanceCount, firstIndex, firstInstance, baseVertex, 1 });
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "job_system.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// ============================================================================
+// An interface for a command list being recorded by a single thread.
+// ============================================================================
+class CommandContext
+{
+public:
+	virtual ~CommandContext() = default;
+	virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) = 0;
+	virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) = 0;
+};
+
+// ============================================================================
+// An interface for the devices that record command lists in parallel.
+//
+// Each list has its own allocator per frame slot, so different lists can be
+// recorded on different threads at the same time. Submission executes the
+// lists in the order of their indices with a single call.
+// ============================================================================
+class CommandRecorder
+{
+public:
+	virtual ~CommandRecorder() = default;
+	virtual unsigned ListCount() const = 0;
+	virtual void BeginFrame(unsigned frameIndex) = 0;
+	virtual CommandContext& BeginList(unsigned list) = 0;
+	virtual void EndList(unsigned list) = 0;
+	virtual void Submit(unsigned listCount) = 0;
+};
+
+// ============================================================================
+// A helper that splits the draws of a frame into lists recorded in parallel.
+//
+// Draw items are divided into contiguous chunks that are each recorded into
+// their own list as a job. Chunk boundaries only depend on the item count and
+// the thread count, so the submitted commands do not depend on the timing.
+// ============================================================================
+class ParallelRecorder
+{
+public:
+	typedef std::function<void(CommandContext& context, unsigned begin, unsigned end)> RecordCallback;
+	ParallelRecorder(JobSystem& jobSystem, CommandRecorder& recorder, unsigned minChunkSize);
+	unsigned Record(unsigned firstList, unsigned itemCount, const RecordCallback& record);
+private:
+	JobSystem&			mJobSystem;
+	CommandRecorder&	mRecorder;
+	unsigned			mMinChunkSize;
+};
+
+// ============================================================================
+// A recording-only device that stores the draws into CPU command buffers.
+//
+// Submission folds the commands of the lists into a hash in the submission
+// order, which allows to verify that parallel recording is deterministic.
+// ============================================================================
+class CommandBufferRecorder : public CommandRecorder
+{
+public:
+	struct DrawCommand
+	{
+		uint32_t	vertexCount;
+		uint32_t	instanceCount;
+		uint32_t	firstVertex;
+		uint32_t	firstInstance;
+		int32_t		baseVertex;
+		uint32_t	indexed;
+	};
+	explicit CommandBufferRecorder(unsigned listCount);
+	unsigned ListCount() const override { return static_cast<unsigned>(mLists.size()); }
+	void BeginFrame(unsigned) override {}
+	CommandContext& BeginList(unsigned list) override;
+	void EndList(unsigned list) override;
+	void Submit(unsigned listCount) override;
+	const std::vector<DrawCommand>& Commands(unsigned list) const { return mLists.at(list)->commands; }
+	uint64_t SubmittedHash() const { return mSubmittedHash; }
+	uint64_t SubmittedDraws() const { return mSubmittedDraws; }
+	unsigned SubmitCount() const { return mSubmitCount; }
+private:
+	class List : public CommandContext
+	{
+	public:
+		void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) override;
+		std::vector<DrawCommand>	commands;
+		bool						recording = false;
+	};
+private:
+	std::vector<std::unique_ptr<List>>	mLists;
+	uint64_t							mSubmittedHash;
+	uint64_t							mSubmittedDraws;
+	unsigned							mSubmitCount;
+};
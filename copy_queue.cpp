@@ -0,0 +1,20 @@
+#include "copy_queue.h"
+
+#include <cstring>
+
+SimulatedCopyQueue::SimulatedCopyQueue(uint64_t stagingSize) : mStaging(static_cast<size_t>(stagingSize))
+{
+}
+
+// ============================================================================
+// Copy the batch into the host memory destinations and signal the timeline.
+// ============================================================================
+uint64_t SimulatedCopyQueue::Submit(const std::vector<CopyCommand>& copies)
+{
+	for (auto& copy : copies) {
+		auto destination = static_cast<uint8_t*>(copy.destination) + copy.destinationOffset;
+		std::memcpy(destination, mStaging.data() + copy.stagingOffset, static_cast<size_t>(copy.size));
+	}
+	mBatches.push_back(copies);
+	return mTimeline.Signal();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "gpu_timeline.h"
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// A copy from the staging buffer of a copy queue into a destination buffer.
+//
+// Destination is an opaque handle of the backend (e.g. an ID3D12Resource*).
+// ============================================================================
+struct CopyCommand
+{
+	void*		destination;
+	uint64_t	destinationOffset;
+	uint64_t	stagingOffset;
+	uint64_t	size;
+};
+
+// ============================================================================
+// An interface for a queue that copies data from a staging buffer to the GPU.
+//
+// Queue owns a CPU writable staging buffer. Copies are submitted in batches
+// and each batch is followed by a signal on the timeline of the queue.
+// ============================================================================
+class CopyQueue
+{
+public:
+	virtual ~CopyQueue() = default;
+	virtual uint8_t* StagingMemory() = 0;
+	virtual uint64_t StagingSize() const = 0;
+	virtual uint64_t Submit(const std::vector<CopyCommand>& copies) = 0;
+	virtual GpuTimeline& Timeline() = 0;
+};
+
+// ============================================================================
+// A copy queue that copies on the CPU and completes on a simulated timeline.
+//
+// Copies are performed into host memory when the batch is submitted. Each
+// batch is recorded so tests can inspect the ordering and the batching.
+// ============================================================================
+class SimulatedCopyQueue : public CopyQueue
+{
+public:
+	explicit SimulatedCopyQueue(uint64_t stagingSize);
+	uint8_t* StagingMemory() override { return mStaging.data(); }
+	uint64_t StagingSize() const override { return mStaging.size(); }
+	uint64_t Submit(const std::vector<CopyCommand>& copies) override;
+	GpuTimeline& Timeline() override { return mTimeline; }
+	SimulatedTimeline& Simulation() { return mTimeline; }
+	const std::vector<std::vector<CopyCommand>>& Batches() const { return mBatches; }
+private:
+	std::vector<uint8_t>					mStaging;
+	std::vector<std::vector<CopyCommand>>	mBatches;
+	SimulatedTimeline						mTimeline;
+};
@@ -0,0 +1,105 @@
+#include "cpu_queue.h"
+
+CpuQueue::CpuQueue() : mSignaledValue(0), mCompletedValue(0), mExit(false)
+{
+	mThread = std::thread(&CpuQueue::QueueMain, this);
+}
+
+CpuQueue::~CpuQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWorkAvailable.notify_one();
+	mThread.join();
+}
+
+// ============================================================================
+// Submit a work item to be executed after the previously submitted items.
+// ============================================================================
+void CpuQueue::Submit(std::function<void()> work)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPackets.push_back({ std::move(work), 0 });
+	}
+	mWorkAvailable.notify_one();
+}
+
+// ============================================================================
+// Add a signal after the previously submitted work items.
+// ============================================================================
+uint64_t CpuQueue::Signal()
+{
+	uint64_t value;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		value = ++mSignaledValue;
+		mPackets.push_back({ nullptr, value });
+	}
+	mWorkAvailable.notify_one();
+	return value;
+}
+
+// ============================================================================
+// Get the last signal value the queue has completed.
+// ============================================================================
+uint64_t CpuQueue::CompletedValue()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCompletedValue;
+}
+
+// ============================================================================
+// Block until the queue has completed the given signal value.
+//
+// Any exception thrown by an executed work item is rethrown here so failures
+// on the queue thread are reported on the thread that waits for the results.
+// ============================================================================
+void CpuQueue::Wait(uint64_t value)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mSignalCompleted.wait(lock, [&] { return mCompletedValue >= value || mError; });
+	if (mError) {
+		auto error = mError;
+		mError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+// ============================================================================
+// The main loop of the queue thread.
+//
+// Thread pops packets in submission order. Work items are executed without a
+// lock, while signals are completed and announced to all waiting threads.
+// ============================================================================
+void CpuQueue::QueueMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;) {
+		mWorkAvailable.wait(lock, [this] { return mExit || !mPackets.empty(); });
+		if (mPackets.empty()) {
+			return;
+		}
+		auto packet = std::move(mPackets.front());
+		mPackets.pop_front();
+		if (packet.work) {
+			lock.unlock();
+			std::exception_ptr error;
+			try {
+				packet.work();
+			} catch (...) {
+				error = std::current_exception();
+			}
+			lock.lock();
+			if (error) {
+				mError = error;
+				mSignalCompleted.notify_all();
+			}
+		} else {
+			mCompletedValue = packet.signal;
+			mSignalCompleted.notify_all();
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "gpu_timeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// ============================================================================
+// A command queue that executes submitted work on a dedicated CPU thread.
+//
+// Queue works like a GPU queue for the software backends. Work is executed in
+// submission order and signals are completed after all preceding work items.
+// ============================================================================
+class CpuQueue : public GpuTimeline
+{
+public:
+	CpuQueue();
+	~CpuQueue();
+	void Submit(std::function<void()> work);
+	uint64_t Signal() override;
+	uint64_t CompletedValue() override;
+	void Wait(uint64_t value) override;
+private:
+	void QueueMain();
+private:
+	struct Packet
+	{
+		std::function<void()>	work;
+		uint64_t				signal;
+	};
+	std::deque<Packet>		mPackets;
+	std::mutex				mMutex;
+	std::condition_variable	mWorkAvailable;
+	std::condition_variable	mSignalCompleted;
+	std::exception_ptr		mError;
+	uint64_t				mSignaledValue;
+	uint64_t				mCompletedValue;
+	bool					mExit;
+	std::thread				mThread;
+};
@@ -0,0 +1,72 @@
+#include "d3d12_barrier_batch.h"
+
+// ============================================================================
+// Convert the resource state flags into the D3D12 resource states.
+// ============================================================================
+D3D12_RESOURCE_STATES D3D12BarrierBatch::ToD3D12(ResourceState state)
+{
+	static const struct { ResourceState state; D3D12_RESOURCE_STATES d3d12State; } mapping[] = {
+		{ ResourceState::VertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER },
+		{ ResourceState::IndexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER },
+		{ ResourceState::ConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER },
+		{ ResourceState::ShaderResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE },
+		{ ResourceState::CopySource, D3D12_RESOURCE_STATE_COPY_SOURCE },
+		{ ResourceState::DepthRead, D3D12_RESOURCE_STATE_DEPTH_READ },
+		{ ResourceState::IndirectArgument, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT },
+		{ ResourceState::RenderTarget, D3D12_RESOURCE_STATE_RENDER_TARGET },
+		{ ResourceState::UnorderedAccess, D3D12_RESOURCE_STATE_UNORDERED_ACCESS },
+		{ ResourceState::DepthWrite, D3D12_RESOURCE_STATE_DEPTH_WRITE },
+		{ ResourceState::CopyDest, D3D12_RESOURCE_STATE_COPY_DEST }
+	};
+	auto d3d12State = D3D12_RESOURCE_STATE_COMMON;
+	for (auto& entry : mapping) {
+		if ((state & entry.state) == entry.state) {
+			d3d12State |= entry.d3d12State;
+		}
+	}
+	return d3d12State;
+}
+
+// ============================================================================
+// Record the queued barriers of the tracker with a single ResourceBarrier call.
+// ============================================================================
+void D3D12BarrierBatch::Flush(ResourceStateTracker& tracker, ID3D12GraphicsCommandList* commandList)
+{
+	mBarriers.clear();
+	tracker.Flush(mBarriers);
+	Record(mBarriers, commandList);
+}
+
+// ============================================================================
+// Record the given barriers with a single ResourceBarrier call.
+//
+// An aliasing barrier does not name the previous resource, so that it covers
+// any resource which was placed into the same memory before.
+// ============================================================================
+void D3D12BarrierBatch::Record(const std::vector<ResourceBarrier>& barriers, ID3D12GraphicsCommandList* commandList)
+{
+	if (barriers.empty()) {
+		return;
+	}
+	mD3D12Barriers.clear();
+	for (auto& barrier : barriers) {
+		D3D12_RESOURCE_BARRIER d3d12Barrier = {};
+		d3d12Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		if (barrier.type == ResourceBarrier::Type::UnorderedAccess) {
+			d3d12Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			d3d12Barrier.UAV.pResource = static_cast<ID3D12Resource*>(barrier.resource);
+		} else if (barrier.type == ResourceBarrier::Type::Aliasing) {
+			d3d12Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+			d3d12Barrier.Aliasing.pResourceBefore = nullptr;
+			d3d12Barrier.Aliasing.pResourceAfter = static_cast<ID3D12Resource*>(barrier.resource);
+		} else {
+			d3d12Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			d3d12Barrier.Transition.pResource = static_cast<ID3D12Resource*>(barrier.resource);
+			d3d12Barrier.Transition.Subresource = (barrier.subresource == ALL_SUBRESOURCES) ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : barrier.subresource;
+			d3d12Barrier.Transition.StateBefore = ToD3D12(barrier.before);
+			d3d12Barrier.Transition.StateAfter = ToD3D12(barrier.after);
+		}
+		mD3D12Barriers.push_back(d3d12Barrier);
+	}
+	commandList->ResourceBarrier(static_cast<UINT>(mD3D12Barriers.size()), mD3D12Barriers.data());
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "resource_state_tracker.h"
+
+#include <d3d12.h>
+#include <vector>
+
+// ============================================================================
+// A helper to record the inferred barriers into a command list.
+//
+// Barriers are converted into D3D12 barriers and recorded with a single call
+// to ResourceBarrier. The buffers are reused to avoid per-frame allocations.
+// ============================================================================
+class D3D12BarrierBatch
+{
+public:
+	static D3D12_RESOURCE_STATES ToD3D12(ResourceState state);
+	void Flush(ResourceStateTracker& tracker, ID3D12GraphicsCommandList* commandList);
+	void Record(const std::vector<ResourceBarrier>& barriers, ID3D12GraphicsCommandList* commandList);
+private:
+	std::vector<ResourceBarrier>		mBarriers;
+	std::vector<D3D12_RESOURCE_BARRIER>	mD3D12Barriers;
+};
@@ -0,0 +1,70 @@
+#include "d3d12_command_recorder.h"
+#include "dx_helpers.h"
+
+#include <algorithm>
+
+// ============================================================================
+// Record a non-indexed draw into the command list.
+// ============================================================================
+void D3D12CommandContext::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	mCommandList->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+// ============================================================================
+// Record an indexed draw into the command list.
+// ============================================================================
+void D3D12CommandContext::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+	mCommandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+}
+
+D3D12CommandRecorder::D3D12CommandRecorder(ID3D12Device* device, ID3D12CommandQueue* queue, unsigned frameLatency, unsigned listCount) : mQueue(queue), mFrameIndex(0)
+{
+	frameLatency = std::max(frameLatency, 1u);
+	listCount = std::max(listCount, 1u);
+	mAllocators.resize(frameLatency * listCount);
+	for (auto& allocator : mAllocators) {
+		ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+	}
+	for (auto i = 0u; i < listCount; i++) {
+		auto context = std::make_unique<D3D12CommandContext>();
+		ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mAllocators[i].Get(), nullptr, IID_PPV_ARGS(&context->mCommandList)));
+		ThrowIfFailed(context->mCommandList->Close());
+		mContexts.push_back(std::move(context));
+	}
+}
+
+// ============================================================================
+// Reset a list and its allocator of the current frame slot for recording.
+//
+// Different lists may be begun from different threads at the same time.
+// ============================================================================
+CommandContext& D3D12CommandRecorder::BeginList(unsigned list)
+{
+	auto& context = *mContexts.at(list);
+	auto& allocator = mAllocators[mFrameIndex * mContexts.size() + list];
+	ThrowIfFailed(allocator->Reset());
+	ThrowIfFailed(context.mCommandList->Reset(allocator.Get(), nullptr));
+	return context;
+}
+
+// ============================================================================
+// Close a recorded list so that it can be submitted.
+// ============================================================================
+void D3D12CommandRecorder::EndList(unsigned list)
+{
+	ThrowIfFailed(mContexts.at(list)->mCommandList->Close());
+}
+
+// ============================================================================
+// Execute the first lists in the order of their indices with a single call.
+// ============================================================================
+void D3D12CommandRecorder::Submit(unsigned listCount)
+{
+	mSubmitLists.clear();
+	for (auto i = 0u; i < listCount; i++) {
+		mSubmitLists.push_back(mContexts.at(i)->CommandList());
+	}
+	mQueue->ExecuteCommandLists(static_cast<UINT>(mSubmitLists.size()), mSubmitLists.data());
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "command_recorder.h"
+
+#include <d3d12.h>
+#include <memory>
+#include <vector>
+#include <wrl.h>
+
+// ============================================================================
+// A command context that records into a D3D12 graphics command list.
+//
+// Users may record any commands directly into the command list of the context.
+// ============================================================================
+class D3D12CommandContext : public CommandContext
+{
+public:
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) override;
+	ID3D12GraphicsCommandList* CommandList() const { return mCommandList.Get(); }
+private:
+	friend class D3D12CommandRecorder;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	mCommandList;
+};
+
+// ============================================================================
+// A command recorder that records D3D12 command lists for a direct queue.
+//
+// Each list owns a command allocator for every frame slot, so the allocator
+// of a slot can be reset as soon as the frame pipeline has reused the slot.
+// ============================================================================
+class D3D12CommandRecorder : public CommandRecorder
+{
+public:
+	D3D12CommandRecorder(ID3D12Device* device, ID3D12CommandQueue* queue, unsigned frameLatency, unsigned listCount);
+	unsigned ListCount() const override { return static_cast<unsigned>(mContexts.size()); }
+	void BeginFrame(unsigned frameIndex) override { mFrameIndex = frameIndex; }
+	CommandContext& BeginList(unsigned list) override;
+	void EndList(unsigned list) override;
+	void Submit(unsigned listCount) override;
+	ID3D12GraphicsCommandList* CommandList(unsigned list) const { return mContexts.at(list)->CommandList(); }
+private:
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>					mQueue;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>	mAllocators;
+	std::vector<std::unique_ptr<D3D12CommandContext>>			mContexts;
+	std::vector<ID3D12CommandList*>								mSubmitLists;
+	unsigned													mFrameIndex;
+};
@@ -0,0 +1,81 @@
+#include "d3d12_copy_queue.h"
+#include "dx_helpers.h"
+
+using namespace Microsoft::WRL;
+
+D3D12CopyQueue::D3D12CopyQueue(ID3D12Device* device, uint64_t stagingSize) : mDevice(device), mStagingMemory(nullptr), mStagingSize(stagingSize)
+{
+	// create a command queue for the copy engine.
+	D3D12_COMMAND_QUEUE_DESC queueDescriptor = {};
+	queueDescriptor.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDescriptor.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+	queueDescriptor.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	queueDescriptor.NodeMask = 0;
+	ThrowIfFailed(device->CreateCommandQueue(&queueDescriptor, IID_PPV_ARGS(&mQueue)));
+	mTimeline = std::make_unique<D3D12Timeline>(device, mQueue.Get());
+
+	// construct properties for the upload heap.
+	D3D12_HEAP_PROPERTIES heapProperties = {};
+	heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+	heapProperties.CreationNodeMask = 1;
+	heapProperties.VisibleNodeMask = 1;
+	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+
+	// construct a descriptor for the staging buffer (derived from CD3DX12_RESOURCE_DESC).
+	D3D12_RESOURCE_DESC resourceDescriptor = {};
+	resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resourceDescriptor.Alignment = 0;
+	resourceDescriptor.Width = stagingSize;
+	resourceDescriptor.Height = 1;
+	resourceDescriptor.DepthOrArraySize = 1;
+	resourceDescriptor.MipLevels = 1;
+	resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
+	resourceDescriptor.SampleDesc.Count = 1;
+	resourceDescriptor.SampleDesc.Quality = 0;
+	resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	// create the staging buffer and keep it mapped for the lifetime of the queue.
+	D3D12_RANGE range = {};
+	ThrowIfFailed(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDescriptor, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mStagingBuffer)));
+	ThrowIfFailed(mStagingBuffer->Map(0, &range, reinterpret_cast<void**>(&mStagingMemory)));
+}
+
+// ============================================================================
+// Record the copies into a command list and execute it on the copy queue.
+//
+// Command allocators are pooled and an allocator is reused only when the copy
+// queue has passed the batch it was last used for. Returns the batch fence.
+// ============================================================================
+uint64_t D3D12CopyQueue::Submit(const std::vector<CopyCommand>& copies)
+{
+	// take the oldest allocator if it's free or create a new one.
+	ComPtr<ID3D12CommandAllocator> allocator;
+	if (!mAllocators.empty() && mAllocators.front().fenceValue <= mTimeline->CompletedValue()) {
+		allocator = mAllocators.front().allocator;
+		mAllocators.pop_front();
+		ThrowIfFailed(allocator->Reset());
+	} else {
+		ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)));
+	}
+
+	// record the copies of the batch.
+	if (mCommandList) {
+		ThrowIfFailed(mCommandList->Reset(allocator.Get(), nullptr));
+	} else {
+		ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator.Get(), nullptr, IID_PPV_ARGS(&mCommandList)));
+	}
+	for (auto& copy : copies) {
+		auto destination = static_cast<ID3D12Resource*>(copy.destination);
+		mCommandList->CopyBufferRegion(destination, copy.destinationOffset, mStagingBuffer.Get(), copy.stagingOffset, copy.size);
+	}
+	ThrowIfFailed(mCommandList->Close());
+
+	// execute the batch and signal its completion.
+	ID3D12CommandList* commandList = mCommandList.Get();
+	mQueue->ExecuteCommandLists(1, &commandList);
+	auto fenceValue = mTimeline->Signal();
+	mAllocators.push_back({ allocator, fenceValue });
+	return fenceValue;
+}
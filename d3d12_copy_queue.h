@@ -0,0 +1,42 @@
+#pragma once
+
+#include "copy_queue.h"
+#include "d3d12_timeline.h"
+
+#include <d3d12.h>
+#include <deque>
+#include <memory>
+#include <wrl.h>
+
+// ============================================================================
+// A copy queue implementation on top of a D3D12 copy command queue.
+//
+// Staging buffer is a persistently mapped buffer in an upload heap. Copy
+// destinations are ID3D12Resource buffers, which the D3D12 implicitly
+// promotes to the copy destination state and decays back to common.
+// ============================================================================
+class D3D12CopyQueue : public CopyQueue
+{
+public:
+	D3D12CopyQueue(ID3D12Device* device, uint64_t stagingSize);
+	uint8_t* StagingMemory() override { return mStagingMemory; }
+	uint64_t StagingSize() const override { return mStagingSize; }
+	uint64_t Submit(const std::vector<CopyCommand>& copies) override;
+	GpuTimeline& Timeline() override { return *mTimeline; }
+	ID3D12Fence* Fence() const { return mTimeline->Fence(); }
+private:
+	struct Allocator
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>	allocator;
+		uint64_t										fenceValue;
+	};
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device>				mDevice;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>			mQueue;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	mCommandList;
+	Microsoft::WRL::ComPtr<ID3D12Resource>				mStagingBuffer;
+	uint8_t*											mStagingMemory;
+	uint64_t											mStagingSize;
+	std::deque<Allocator>								mAllocators;
+	std::unique_ptr<D3D12Timeline>						mTimeline;
+};
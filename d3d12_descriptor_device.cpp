@@ -0,0 +1,50 @@
+#include "d3d12_descriptor_device.h"
+#include "dx_helpers.h"
+
+// the D3D12 heap types of the descriptor heap types.
+const D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapTypes[DESCRIPTOR_HEAP_TYPE_COUNT] = {
+	D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+	D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
+	D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+	D3D12_DESCRIPTOR_HEAP_TYPE_DSV
+};
+
+// ============================================================================
+// Create a new descriptor heap with the given type and capacity.
+// ============================================================================
+DescriptorHeapInfo D3D12DescriptorDevice::CreateHeap(DescriptorHeapType type, uint32_t capacity, bool shaderVisible)
+{
+	auto heapType = DescriptorHeapTypes[static_cast<unsigned>(type)];
+	D3D12_DESCRIPTOR_HEAP_DESC heapDescriptor = {};
+	heapDescriptor.NumDescriptors = capacity;
+	heapDescriptor.Type = heapType;
+	heapDescriptor.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ID3D12DescriptorHeap* heap = nullptr;
+	ThrowIfFailed(mDevice->CreateDescriptorHeap(&heapDescriptor, IID_PPV_ARGS(&heap)));
+	auto gpuStart = shaderVisible ? heap->GetGPUDescriptorHandleForHeapStart().ptr : 0;
+	return { heap, heap->GetCPUDescriptorHandleForHeapStart().ptr, gpuStart, mDevice->GetDescriptorHandleIncrementSize(heapType), capacity };
+}
+
+// ============================================================================
+// Release a descriptor heap created by the device.
+// ============================================================================
+void D3D12DescriptorDevice::DestroyHeap(void* heap)
+{
+	static_cast<ID3D12DescriptorHeap*>(heap)->Release();
+}
+
+// ============================================================================
+// Copy the descriptors of the source ranges into the destination ranges.
+// ============================================================================
+void D3D12DescriptorDevice::CopyDescriptors(DescriptorHeapType type, uint32_t destinationCount, const uint64_t* destinationStarts, const uint32_t* destinationSizes, uint32_t sourceCount, const uint64_t* sourceStarts, const uint32_t* sourceSizes)
+{
+	mDestinationStarts.resize(destinationCount);
+	for (auto i = 0u; i < destinationCount; i++) {
+		mDestinationStarts[i].ptr = static_cast<SIZE_T>(destinationStarts[i]);
+	}
+	mSourceStarts.resize(sourceCount);
+	for (auto i = 0u; i < sourceCount; i++) {
+		mSourceStarts[i].ptr = static_cast<SIZE_T>(sourceStarts[i]);
+	}
+	mDevice->CopyDescriptors(destinationCount, mDestinationStarts.data(), destinationSizes, sourceCount, mSourceStarts.data(), sourceSizes, DescriptorHeapTypes[static_cast<unsigned>(type)]);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "descriptor_allocator.h"
+
+#include <d3d12.h>
+#include <vector>
+#include <wrl.h>
+
+// ============================================================================
+// A descriptor device that creates D3D12 descriptor heaps.
+//
+// Handles are ID3D12DescriptorHeap pointers. The ranges of a copy are turned
+// into D3D12 handles in arrays that are kept between the copies.
+// ============================================================================
+class D3D12DescriptorDevice : public DescriptorDevice
+{
+public:
+	explicit D3D12DescriptorDevice(ID3D12Device* device) : mDevice(device) {}
+	DescriptorHeapInfo CreateHeap(DescriptorHeapType type, uint32_t capacity, bool shaderVisible) override;
+	void DestroyHeap(void* heap) override;
+	void CopyDescriptors(DescriptorHeapType type, uint32_t destinationCount, const uint64_t* destinationStarts, const uint32_t* destinationSizes, uint32_t sourceCount, const uint64_t* sourceStarts, const uint32_t* sourceSizes) override;
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device>		mDevice;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>	mDestinationStarts;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>	mSourceStarts;
+};
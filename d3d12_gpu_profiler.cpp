@@ -0,0 +1,138 @@
+#include "d3d12_gpu_profiler.h"
+#include "dx_helpers.h"
+#include "frame_profiler.h"
+
+// the amount of timestamp queries reserved for each frame slot.
+#define QUERIES_PER_FRAME (GPU_PROFILER_MAX_SCOPES * 2)
+
+D3D12GpuProfiler::D3D12GpuProfiler(ID3D12Device* device, ID3D12CommandQueue* queue, unsigned frameLatency) : mQueue(queue), mFrames(frameLatency), mFrameIndex(0), mTimestampFrequency(0), mFrameMilliseconds(0.0)
+{
+	ThrowIfFailed(mQueue->GetTimestampFrequency(&mTimestampFrequency));
+
+	// create a query heap with timestamp queries for each frame slot.
+	D3D12_QUERY_HEAP_DESC queryHeapDescriptor = {};
+	queryHeapDescriptor.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDescriptor.Count = QUERIES_PER_FRAME * frameLatency;
+	queryHeapDescriptor.NodeMask = 0;
+	ThrowIfFailed(device->CreateQueryHeap(&queryHeapDescriptor, IID_PPV_ARGS(&mQueryHeap)));
+
+	// construct properties for the readback heap.
+	D3D12_HEAP_PROPERTIES heapProperties = {};
+	heapProperties.Type = D3D12_HEAP_TYPE_READBACK;
+	heapProperties.CreationNodeMask = 1;
+	heapProperties.VisibleNodeMask = 1;
+	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+
+	// construct a descriptor for the readback buffer (derived from CD3DX12_RESOURCE_DESC).
+	D3D12_RESOURCE_DESC resourceDescriptor = {};
+	resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resourceDescriptor.Alignment = 0;
+	resourceDescriptor.Width = sizeof(uint64_t) * QUERIES_PER_FRAME * frameLatency;
+	resourceDescriptor.Height = 1;
+	resourceDescriptor.DepthOrArraySize = 1;
+	resourceDescriptor.MipLevels = 1;
+	resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
+	resourceDescriptor.SampleDesc.Count = 1;
+	resourceDescriptor.SampleDesc.Quality = 0;
+	resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
+	ThrowIfFailed(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDescriptor, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mReadbackBuffer)));
+}
+
+// ============================================================================
+// Begin recording the GPU scopes for the given frame slot.
+//
+// Note that the frame slot must be free i.e. the GPU has completed the frame
+// that used the slot earlier, so its timestamps can be read back right away.
+// ============================================================================
+void D3D12GpuProfiler::BeginFrame(unsigned frameIndex)
+{
+	CollectResults(frameIndex);
+	mFrameIndex = frameIndex;
+	mFrames[frameIndex].names.clear();
+	mFrames[frameIndex].frame = FrameProfiler::Instance().Frame();
+}
+
+// ============================================================================
+// Add a timestamp query to mark the beginning of a GPU scope.
+//
+// Function returns the scope index to be given to the EndScope function. The
+// scopes exceeding the per-frame limit are silently ignored.
+// ============================================================================
+unsigned D3D12GpuProfiler::BeginScope(ID3D12GraphicsCommandList* commandList, const char* name)
+{
+	auto& frame = mFrames[mFrameIndex];
+	auto scope = static_cast<unsigned>(frame.names.size());
+	if (scope < GPU_PROFILER_MAX_SCOPES) {
+		frame.names.push_back(name);
+		commandList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, mFrameIndex * QUERIES_PER_FRAME + scope * 2);
+	}
+	return scope;
+}
+
+// ============================================================================
+// Add a timestamp query to mark the end of a GPU scope.
+// ============================================================================
+void D3D12GpuProfiler::EndScope(ID3D12GraphicsCommandList* commandList, unsigned scope)
+{
+	if (scope < GPU_PROFILER_MAX_SCOPES) {
+		commandList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, mFrameIndex * QUERIES_PER_FRAME + scope * 2 + 1);
+	}
+}
+
+// ============================================================================
+// Resolve the timestamps of the current frame into the readback buffer.
+// ============================================================================
+void D3D12GpuProfiler::EndFrame(ID3D12GraphicsCommandList* commandList)
+{
+	auto count = static_cast<UINT>(mFrames[mFrameIndex].names.size()) * 2;
+	if (count > 0) {
+		auto first = mFrameIndex * QUERIES_PER_FRAME;
+		commandList->ResolveQueryData(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, count, mReadbackBuffer.Get(), first * sizeof(uint64_t));
+	}
+}
+
+// ============================================================================
+// Read the resolved timestamps of a frame slot into the frame profiler.
+//
+// GPU ticks are converted into the system clock with the queue calibration.
+// This expects the system clock to be based on the QueryPerformanceCounter.
+// The frame time is zero when the slot has no results to read.
+// ============================================================================
+void D3D12GpuProfiler::CollectResults(unsigned frameIndex)
+{
+	auto& frame = mFrames[frameIndex];
+	mFrameMilliseconds = 0.0;
+	if (frame.names.empty()) {
+		return;
+	}
+
+	// get the GPU and CPU timestamps of the same moment to convert the ticks.
+	UINT64 gpuCalibration = 0, cpuCalibration = 0;
+	LARGE_INTEGER cpuFrequency;
+	ThrowIfFailed(mQueue->GetClockCalibration(&gpuCalibration, &cpuCalibration));
+	QueryPerformanceFrequency(&cpuFrequency);
+	auto toNanoseconds = [&](uint64_t gpuTimestamp) {
+		auto gpuSeconds = (static_cast<double>(gpuTimestamp) - static_cast<double>(gpuCalibration)) / mTimestampFrequency;
+		auto cpuSeconds = static_cast<double>(cpuCalibration) / cpuFrequency.QuadPart;
+		return static_cast<uint64_t>((cpuSeconds + gpuSeconds) * 1e9);
+	};
+
+	// map the range of the frame slot and record the scopes.
+	auto first = frameIndex * QUERIES_PER_FRAME;
+	D3D12_RANGE range = { first * sizeof(uint64_t), (first + frame.names.size() * 2) * sizeof(uint64_t) };
+	uint64_t* timestamps = nullptr;
+	ThrowIfFailed(mReadbackBuffer->Map(0, &range, reinterpret_cast<void**>(&timestamps)));
+	for (size_t i = 0; i < frame.names.size(); i++) {
+		auto begin = timestamps[first + i * 2];
+		auto end = timestamps[first + i * 2 + 1];
+		FrameProfiler::Instance().RecordGpu(frame.names[i], toNanoseconds(begin), toNanoseconds(end), frame.frame);
+		if (i == 0) {
+			mFrameMilliseconds = static_cast<double>(end - begin) * 1000.0 / mTimestampFrequency;
+		}
+	}
+	D3D12_RANGE emptyRange = {};
+	mReadbackBuffer->Unmap(0, &emptyRange);
+	frame.names.clear();
+}
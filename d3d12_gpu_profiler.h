@@ -0,0 +1,42 @@
+#pragma once
+
+#include <d3d12.h>
+#include <vector>
+#include <wrl.h>
+
+// the maximum amount of GPU scopes recorded within a single frame.
+#define GPU_PROFILER_MAX_SCOPES 32
+
+// ============================================================================
+// A profiler that measures GPU scopes with D3D12 timestamp queries.
+//
+// Timestamps are resolved into a readback buffer per frame slot. Results are
+// read when the slot is reused and passed to the frame profiler GPU track.
+// The duration of the first scope of the frame read last is also kept, so
+// it can drive the decisions based on the GPU frame time.
+// ============================================================================
+class D3D12GpuProfiler
+{
+public:
+	D3D12GpuProfiler(ID3D12Device* device, ID3D12CommandQueue* queue, unsigned frameLatency);
+	void BeginFrame(unsigned frameIndex);
+	unsigned BeginScope(ID3D12GraphicsCommandList* commandList, const char* name);
+	void EndScope(ID3D12GraphicsCommandList* commandList, unsigned scope);
+	void EndFrame(ID3D12GraphicsCommandList* commandList);
+	double FrameMilliseconds() const { return mFrameMilliseconds; }
+private:
+	struct FrameScopes
+	{
+		std::vector<const char*>	names;
+		uint64_t					frame;
+	};
+	void CollectResults(unsigned frameIndex);
+private:
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>	mQueue;
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap>		mQueryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource>		mReadbackBuffer;
+	std::vector<FrameScopes>					mFrames;
+	unsigned									mFrameIndex;
+	uint64_t									mTimestampFrequency;
+	double										mFrameMilliseconds;
+};
@@ -0,0 +1,35 @@
+#include "d3d12_heap_factory.h"
+#include "dx_helpers.h"
+
+// ============================================================================
+// Create a new heap with the given type, resource class and size.
+//
+// Size is rounded up to the 64KB placement alignment which heaps require.
+// ============================================================================
+void* D3D12HeapFactory::CreateHeap(HeapType heapType, ResourceClass resourceClass, uint64_t size)
+{
+	D3D12_HEAP_DESC heapDescriptor = {};
+	heapDescriptor.SizeInBytes = (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~static_cast<uint64_t>(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+	heapDescriptor.Properties.Type = (heapType == HeapType::Upload) ? D3D12_HEAP_TYPE_UPLOAD : (heapType == HeapType::Readback) ? D3D12_HEAP_TYPE_READBACK : D3D12_HEAP_TYPE_DEFAULT;
+	heapDescriptor.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapDescriptor.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapDescriptor.Properties.CreationNodeMask = 1;
+	heapDescriptor.Properties.VisibleNodeMask = 1;
+	heapDescriptor.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	switch (resourceClass) {
+	case ResourceClass::Buffer:			heapDescriptor.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS; break;
+	case ResourceClass::Texture:		heapDescriptor.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES; break;
+	case ResourceClass::RenderTarget:	heapDescriptor.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES; break;
+	}
+	ID3D12Heap* heap = nullptr;
+	ThrowIfFailed(mDevice->CreateHeap(&heapDescriptor, IID_PPV_ARGS(&heap)));
+	return heap;
+}
+
+// ============================================================================
+// Release a heap created by the factory.
+// ============================================================================
+void D3D12HeapFactory::DestroyHeap(void* heap)
+{
+	static_cast<ID3D12Heap*>(heap)->Release();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "gpu_memory_allocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+// ============================================================================
+// A heap factory that creates D3D12 heaps for the placed resources.
+//
+// Heaps are restricted to a single resource class, so the allocator works on
+// the resource heap tier 1 hardware as well. Handles are ID3D12Heap pointers.
+// ============================================================================
+class D3D12HeapFactory : public GpuHeapFactory
+{
+public:
+	explicit D3D12HeapFactory(ID3D12Device* device) : mDevice(device) {}
+	void* CreateHeap(HeapType heapType, ResourceClass resourceClass, uint64_t size) override;
+	void DestroyHeap(void* heap) override;
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device>	mDevice;
+};
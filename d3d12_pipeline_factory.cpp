@@ -0,0 +1,208 @@
+#include "d3d12_pipeline_factory.h"
+#include "dx_helpers.h"
+
+#include <cwchar>
+#include <stdexcept>
+
+using namespace Microsoft::WRL;
+
+// a helper to feed bytes into a 64-bit FNV-1a hash.
+static uint64_t Fnv64(uint64_t hash, const ShaderBytecode& bytecode)
+{
+	for (auto byte : bytecode) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// helpers to convert the pipeline state enums into the D3D12 values.
+static D3D12_FILL_MODE ToD3D12(FillMode mode)
+{
+	return (mode == FillMode::Wireframe) ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+}
+static D3D12_CULL_MODE ToD3D12(CullMode mode)
+{
+	switch (mode) {
+	case CullMode::Front:	return D3D12_CULL_MODE_FRONT;
+	case CullMode::Back:	return D3D12_CULL_MODE_BACK;
+	default:				return D3D12_CULL_MODE_NONE;
+	}
+}
+static DXGI_FORMAT ToD3D12(RenderTargetFormat format)
+{
+	switch (format) {
+	case RenderTargetFormat::BGRA8:		return DXGI_FORMAT_B8G8R8A8_UNORM;
+	case RenderTargetFormat::RGBA16F:	return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	default:							return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+static D3D12_PRIMITIVE_TOPOLOGY_TYPE ToD3D12(PrimitiveTopology topology)
+{
+	switch (topology) {
+	case PrimitiveTopology::Line:	return D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+	case PrimitiveTopology::Point:	return D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+	default:						return D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	}
+}
+
+// ============================================================================
+// Create a descriptor for the blend state of the given blend mode.
+//
+// Opaque mode matches the CD3DX12_BLEND_DESC(CD3DX12_DEFAULT) while the other
+// modes enable the blending of the color with the source alpha.
+// ============================================================================
+static D3D12_BLEND_DESC BlendDescriptor(BlendMode mode)
+{
+	D3D12_BLEND_DESC blendDescriptor = {};
+	blendDescriptor.AlphaToCoverageEnable = false;
+	blendDescriptor.IndependentBlendEnable = false;
+	blendDescriptor.RenderTarget[0].BlendEnable = (mode != BlendMode::Opaque);
+	blendDescriptor.RenderTarget[0].LogicOpEnable = false;
+	blendDescriptor.RenderTarget[0].SrcBlend = (mode == BlendMode::Opaque) ? D3D12_BLEND_ONE : D3D12_BLEND_SRC_ALPHA;
+	blendDescriptor.RenderTarget[0].DestBlend = (mode == BlendMode::Alpha) ? D3D12_BLEND_INV_SRC_ALPHA : (mode == BlendMode::Additive) ? D3D12_BLEND_ONE : D3D12_BLEND_ZERO;
+	blendDescriptor.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
+	blendDescriptor.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+	blendDescriptor.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
+	blendDescriptor.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+	blendDescriptor.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
+	blendDescriptor.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+	return blendDescriptor;
+}
+
+D3D12PipelineFactory::D3D12PipelineFactory(ID3D12Device2* device, ID3D12RootSignature* rootSignature) : mDevice(device), mRootSignature(rootSignature)
+{
+	CreateLibrary({});
+}
+
+// ============================================================================
+// Add the shaders of a program that pipelines may refer with the identifier.
+//
+// Programs are named in the pipeline library with a hash of the bytecode, so
+// a changed shader never loads a stale pipeline stored by an earlier build.
+// ============================================================================
+void D3D12PipelineFactory::AddShaderProgram(uint16_t id, const ShaderBytecode& vertexShader, const ShaderBytecode& pixelShader)
+{
+	auto hash = Fnv64(Fnv64(14695981039346656037ull, vertexShader), pixelShader);
+	mShaderPrograms[id] = { vertexShader, pixelShader, hash };
+}
+
+// ============================================================================
+// Add an input layout that pipelines may refer with the identifier.
+//
+// Note that the semantic names are not copied, so they must be literals.
+// ============================================================================
+void D3D12PipelineFactory::AddInputLayout(uint16_t id, const std::vector<D3D12_INPUT_ELEMENT_DESC>& elements)
+{
+	mInputLayouts[id] = elements;
+}
+
+// ============================================================================
+// Create a graphics pipeline state for the given description.
+//
+// The pipeline is first looked up from the pipeline library. A pipeline that
+// is not found is created with the device and stored into the library.
+// ============================================================================
+std::shared_ptr<PipelineObject> D3D12PipelineFactory::Create(const PipelineStateDesc& desc)
+{
+	auto program = mShaderPrograms.find(desc.shaderProgram);
+	auto inputLayout = mInputLayouts.find(desc.inputLayout);
+	if (program == mShaderPrograms.end() || inputLayout == mInputLayouts.end()) {
+		throw std::invalid_argument("unknown shader program or input layout");
+	}
+
+	// create a descriptor for the rasterizer state (derived from CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT))
+	D3D12_RASTERIZER_DESC rasterizerDescriptor = {};
+	rasterizerDescriptor.FillMode = ToD3D12(desc.fillMode);
+	rasterizerDescriptor.CullMode = ToD3D12(desc.cullMode);
+	rasterizerDescriptor.FrontCounterClockwise = false;
+	rasterizerDescriptor.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+	rasterizerDescriptor.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+	rasterizerDescriptor.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+	rasterizerDescriptor.DepthClipEnable = true;
+	rasterizerDescriptor.MultisampleEnable = false;
+	rasterizerDescriptor.AntialiasedLineEnable = false;
+	rasterizerDescriptor.ForcedSampleCount = 0;
+	rasterizerDescriptor.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+	// create a desciptor for the pipeline state object.
+	auto& elements = inputLayout->second;
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStatedescriptor = {};
+	pipelineStatedescriptor.InputLayout = { elements.data(), static_cast<UINT>(elements.size()) };
+	pipelineStatedescriptor.pRootSignature = mRootSignature.Get();
+	pipelineStatedescriptor.VS = { program->second.vertexShader.data(), program->second.vertexShader.size() };
+	pipelineStatedescriptor.PS = { program->second.pixelShader.data(), program->second.pixelShader.size() };
+	pipelineStatedescriptor.RasterizerState = rasterizerDescriptor;
+	pipelineStatedescriptor.BlendState = BlendDescriptor(desc.blendMode);
+	pipelineStatedescriptor.DepthStencilState.DepthEnable = false;
+	pipelineStatedescriptor.DepthStencilState.StencilEnable = false;
+	pipelineStatedescriptor.SampleMask = UINT_MAX;
+	pipelineStatedescriptor.PrimitiveTopologyType = ToD3D12(desc.topology);
+	pipelineStatedescriptor.NumRenderTargets = 1;
+	pipelineStatedescriptor.RTVFormats[0] = ToD3D12(desc.renderTargetFormat);
+	pipelineStatedescriptor.SampleDesc.Count = 1;
+
+	// try to load the pipeline from the library with a name of the key and the program hash.
+	wchar_t name[40];
+	std::swprintf(name, sizeof(name) / sizeof(name[0]), L"%016llx-%016llx", static_cast<unsigned long long>(desc.Key()), static_cast<unsigned long long>(program->second.hash));
+	ComPtr<ID3D12PipelineState> state;
+	{
+		std::lock_guard<std::mutex> lock(mLibraryMutex);
+		if (mLibrary && SUCCEEDED(mLibrary->LoadGraphicsPipeline(name, &pipelineStatedescriptor, IID_PPV_ARGS(&state)))) {
+			return std::make_shared<D3D12Pipeline>(state);
+		}
+	}
+
+	// create a new pipeline and store it into the library for the following runs.
+	ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&pipelineStatedescriptor, IID_PPV_ARGS(&state)));
+	{
+		std::lock_guard<std::mutex> lock(mLibraryMutex);
+		if (mLibrary) {
+			mLibrary->StorePipeline(name, state.Get());
+		}
+	}
+	return std::make_shared<D3D12Pipeline>(state);
+}
+
+// ============================================================================
+// Replace the pipeline library with a previously serialized one.
+// ============================================================================
+void D3D12PipelineFactory::LoadPipelineLibrary(const std::vector<uint8_t>& data)
+{
+	std::lock_guard<std::mutex> lock(mLibraryMutex);
+	CreateLibrary(data);
+}
+
+// ============================================================================
+// Serialize the pipeline library with all the stored pipelines.
+// ============================================================================
+std::vector<uint8_t> D3D12PipelineFactory::SerializePipelineLibrary()
+{
+	std::lock_guard<std::mutex> lock(mLibraryMutex);
+	std::vector<uint8_t> data;
+	if (mLibrary) {
+		data.resize(mLibrary->GetSerializedSize());
+		ThrowIfFailed(mLibrary->Serialize(data.data(), data.size()));
+	}
+	return data;
+}
+
+// ============================================================================
+// Create the pipeline library from the serialized data.
+//
+// A library serialized with another driver or adapter is rejected by D3D12,
+// so an empty library is created instead. The library is left null if the
+// driver does not support libraries at all and pipelines are not stored.
+// ============================================================================
+void D3D12PipelineFactory::CreateLibrary(const std::vector<uint8_t>& data)
+{
+	// the library refers the data without a copy so the data must be kept alive.
+	mLibrary = nullptr;
+	mLibraryData = data;
+	if (!mLibraryData.empty() && SUCCEEDED(mDevice->CreatePipelineLibrary(mLibraryData.data(), mLibraryData.size(), IID_PPV_ARGS(&mLibrary)))) {
+		return;
+	}
+	mLibraryData.clear();
+	if (FAILED(mDevice->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mLibrary)))) {
+		mLibrary = nullptr;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pipeline_cache.h"
+#include "shader_cache.h"
+
+#include <d3d12.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <wrl.h>
+
+// ============================================================================
+// A pipeline object that holds a D3D12 pipeline state.
+// ============================================================================
+class D3D12Pipeline : public PipelineObject
+{
+public:
+	explicit D3D12Pipeline(Microsoft::WRL::ComPtr<ID3D12PipelineState> state) : mState(std::move(state)) {}
+	ID3D12PipelineState* State() const { return mState.Get(); }
+private:
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>	mState;
+};
+
+// ============================================================================
+// A pipeline factory that creates D3D12 graphics pipeline states.
+//
+// Created pipelines are stored into a D3D12 pipeline library which can be
+// serialized, so the following runs can load them without driver compiles.
+// Shader programs and input layouts must be added before any pipeline.
+// ============================================================================
+class D3D12PipelineFactory : public PipelineFactory
+{
+public:
+	D3D12PipelineFactory(ID3D12Device2* device, ID3D12RootSignature* rootSignature);
+	void AddShaderProgram(uint16_t id, const ShaderBytecode& vertexShader, const ShaderBytecode& pixelShader);
+	void AddInputLayout(uint16_t id, const std::vector<D3D12_INPUT_ELEMENT_DESC>& elements);
+	std::shared_ptr<PipelineObject> Create(const PipelineStateDesc& desc) override;
+	void LoadPipelineLibrary(const std::vector<uint8_t>& data) override;
+	std::vector<uint8_t> SerializePipelineLibrary() override;
+private:
+	struct ShaderProgram
+	{
+		ShaderBytecode	vertexShader;
+		ShaderBytecode	pixelShader;
+		uint64_t		hash;
+	};
+	void CreateLibrary(const std::vector<uint8_t>& data);
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device2>							mDevice;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature>						mRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineLibrary>					mLibrary;
+	std::vector<uint8_t>											mLibraryData;
+	std::unordered_map<uint16_t, ShaderProgram>						mShaderPrograms;
+	std::unordered_map<uint16_t, std::vector<D3D12_INPUT_ELEMENT_DESC>>	mInputLayouts;
+	std::mutex														mLibraryMutex;
+};
@@ -0,0 +1,188 @@
+#include "d3d12_render_graph_backend.h"
+#include "dx_helpers.h"
+
+using namespace Microsoft::WRL;
+
+// a helper to construct a resource descriptor for a transient texture.
+static D3D12_RESOURCE_DESC TextureDescriptor(const TextureDesc& desc)
+{
+	D3D12_RESOURCE_DESC descriptor = {};
+	descriptor.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	descriptor.Alignment = 0;
+	descriptor.Width = desc.width;
+	descriptor.Height = desc.height;
+	descriptor.DepthOrArraySize = 1;
+	descriptor.MipLevels = 1;
+	descriptor.SampleDesc.Count = 1;
+	descriptor.SampleDesc.Quality = 0;
+	descriptor.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	switch (desc.format) {
+	case TextureFormat::RGBA8:		descriptor.Format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+	case TextureFormat::BGRA8:		descriptor.Format = DXGI_FORMAT_B8G8R8A8_UNORM; break;
+	case TextureFormat::RGBA16F:	descriptor.Format = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+	case TextureFormat::D32:		descriptor.Format = DXGI_FORMAT_D32_FLOAT; break;
+	}
+	switch (desc.format) {
+	case TextureFormat::D32:	descriptor.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL; break;
+	case TextureFormat::BGRA8:	descriptor.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET; break;
+	default:					descriptor.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS; break;
+	}
+	return descriptor;
+}
+
+D3D12RenderGraphBackend::D3D12RenderGraphBackend(ID3D12Device* device, GpuMemoryAllocator& allocator, GpuTimeline& timeline)
+	: mDevice(device), mAllocator(allocator), mTimeline(timeline), mCommandList(nullptr), mHeapAllocation(), mLastFenceValue(0)
+{
+}
+
+D3D12RenderGraphBackend::~D3D12RenderGraphBackend()
+{
+	mTimeline.Wait(mLastFenceValue);
+	for (auto& retired : mRetired) {
+		if (retired.allocation.heap != nullptr) {
+			mAllocator.Free(retired.allocation);
+		}
+	}
+	for (auto& retiring : mRetiring) {
+		if (retiring.allocation.heap != nullptr) {
+			mAllocator.Free(retiring.allocation);
+		}
+	}
+	mTextures.clear();
+	if (mHeapAllocation.heap != nullptr) {
+		mAllocator.Free(mHeapAllocation);
+	}
+}
+
+// ============================================================================
+// Get the size and the placement alignment of a transient texture.
+// ============================================================================
+void D3D12RenderGraphBackend::TextureAllocationInfo(const TextureDesc& desc, uint64_t& size, uint64_t& alignment)
+{
+	auto descriptor = TextureDescriptor(desc);
+	auto allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &descriptor);
+	size = allocationInfo.SizeInBytes;
+	alignment = allocationInfo.Alignment;
+}
+
+// ============================================================================
+// Ensure that the transient memory range is at least the given size.
+//
+// A larger range replaces the old one, so the textures placed into the old
+// range are retired and recreated within the new range when acquired.
+// ============================================================================
+void D3D12RenderGraphBackend::ReserveTransientMemory(uint64_t size)
+{
+	if (size <= mHeapAllocation.size) {
+		return;
+	}
+	for (auto& texture : mTextures) {
+		Retire(texture.resource, {});
+	}
+	mTextures.clear();
+	if (mHeapAllocation.heap != nullptr) {
+		Retire(nullptr, mHeapAllocation);
+	}
+	mHeapAllocation = mAllocator.Allocate(HeapType::Default, ResourceClass::RenderTarget, size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+}
+
+// ============================================================================
+// Get a texture placed at the given offset of the transient memory range.
+// ============================================================================
+void* D3D12RenderGraphBackend::AcquireTransientTexture(const TextureDesc& desc, uint64_t offset, bool& created)
+{
+	for (auto& texture : mTextures) {
+		if (texture.offset == offset && texture.desc.width == desc.width && texture.desc.height == desc.height && texture.desc.format == desc.format) {
+			texture.used = true;
+			created = false;
+			return texture.resource.Get();
+		}
+	}
+	auto descriptor = TextureDescriptor(desc);
+	auto heap = static_cast<ID3D12Heap*>(mHeapAllocation.heap);
+	ComPtr<ID3D12Resource> resource;
+	ThrowIfFailed(mDevice->CreatePlacedResource(heap, mHeapAllocation.offset + offset, &descriptor, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource)));
+	mTextures.push_back({ desc, offset, resource, true });
+	created = true;
+	return resource.Get();
+}
+
+// ============================================================================
+// Record the barriers of the render graph into the current command list.
+// ============================================================================
+void D3D12RenderGraphBackend::ResourceBarriers(const std::vector<ResourceBarrier>& barriers)
+{
+	mBarrierBatch.Record(barriers, mCommandList);
+}
+
+// ============================================================================
+// Mark the end of a frame that used the transient textures.
+//
+// Textures which were not acquired during the frame are retired, and retired
+// textures and memory are released once the GPU has completed their frames.
+// ============================================================================
+void D3D12RenderGraphBackend::EndFrame(uint64_t fenceValue)
+{
+	for (auto texture = mTextures.begin(); texture != mTextures.end();) {
+		if (texture->used) {
+			texture->used = false;
+			++texture;
+		} else {
+			Retire(texture->resource, {});
+			texture = mTextures.erase(texture);
+		}
+	}
+	for (auto& retiring : mRetiring) {
+		retiring.fenceValue = fenceValue;
+		mRetired.push_back(retiring);
+	}
+	mRetiring.clear();
+	mLastFenceValue = fenceValue;
+
+	auto completedValue = mTimeline.CompletedValue();
+	while (!mRetired.empty() && mRetired.front().fenceValue <= completedValue) {
+		if (mRetired.front().allocation.heap != nullptr) {
+			mAllocator.Free(mRetired.front().allocation);
+		}
+		mRetired.pop_front();
+	}
+}
+
+// ============================================================================
+// Release the transient textures and memory right away and get the bytes.
+//
+// Waits the GPU to complete the last frame, so this is meant for the moments
+// the memory matters more than a stall, e.g. when the app is hidden. The next
+// frame reserves the memory and creates the textures again.
+// ============================================================================
+uint64_t D3D12RenderGraphBackend::ReleaseTransientMemory()
+{
+	mTimeline.Wait(mLastFenceValue);
+	uint64_t releasedBytes = 0;
+	auto release = [&](const GpuAllocation& allocation) {
+		if (allocation.heap != nullptr) {
+			releasedBytes += allocation.size;
+			mAllocator.Free(allocation);
+		}
+	};
+	for (auto& retired : mRetired) {
+		release(retired.allocation);
+	}
+	for (auto& retiring : mRetiring) {
+		release(retiring.allocation);
+	}
+	release(mHeapAllocation);
+	mRetired.clear();
+	mRetiring.clear();
+	mTextures.clear();
+	mHeapAllocation = {};
+	return releasedBytes;
+}
+
+// ============================================================================
+// Queue a texture or a memory range to be released after the current frame.
+// ============================================================================
+void D3D12RenderGraphBackend::Retire(ComPtr<ID3D12Resource> resource, const GpuAllocation& allocation)
+{
+	mRetiring.push_back({ 0, resource, allocation });
+}
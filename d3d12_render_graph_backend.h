@@ -0,0 +1,60 @@
+#pragma once
+
+#include "d3d12_barrier_batch.h"
+#include "gpu_memory_allocator.h"
+#include "gpu_timeline.h"
+#include "render_graph.h"
+
+#include <d3d12.h>
+#include <deque>
+#include <vector>
+#include <wrl.h>
+
+// ============================================================================
+// A render graph backend that places the transient textures into a D3D12 heap.
+//
+// Transient memory is a single range of a render target heap reserved from
+// the GPU memory allocator. Placed textures are kept while the graph keeps
+// acquiring them and they are released once the GPU has completed the frame.
+// ============================================================================
+class D3D12RenderGraphBackend : public RenderGraphBackend
+{
+public:
+	D3D12RenderGraphBackend(ID3D12Device* device, GpuMemoryAllocator& allocator, GpuTimeline& timeline);
+	~D3D12RenderGraphBackend();
+	void TextureAllocationInfo(const TextureDesc& desc, uint64_t& size, uint64_t& alignment) override;
+	void ReserveTransientMemory(uint64_t size) override;
+	void* AcquireTransientTexture(const TextureDesc& desc, uint64_t offset, bool& created) override;
+	void ResourceBarriers(const std::vector<ResourceBarrier>& barriers) override;
+	void EndFrame(uint64_t fenceValue);
+	uint64_t ReleaseTransientMemory();
+	uint64_t TransientMemorySize() const { return mHeapAllocation.size; }
+	void SetCommandList(ID3D12GraphicsCommandList* commandList) { mCommandList = commandList; }
+	ID3D12GraphicsCommandList* CommandList() const { return mCommandList; }
+private:
+	struct PlacedTexture
+	{
+		TextureDesc								desc;
+		uint64_t								offset;
+		Microsoft::WRL::ComPtr<ID3D12Resource>	resource;
+		bool									used;
+	};
+	struct RetiredMemory
+	{
+		uint64_t								fenceValue;
+		Microsoft::WRL::ComPtr<ID3D12Resource>	resource;
+		GpuAllocation							allocation;
+	};
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> resource, const GpuAllocation& allocation);
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device>	mDevice;
+	GpuMemoryAllocator&						mAllocator;
+	GpuTimeline&							mTimeline;
+	ID3D12GraphicsCommandList*				mCommandList;
+	GpuAllocation							mHeapAllocation;
+	std::vector<PlacedTexture>				mTextures;
+	std::vector<RetiredMemory>				mRetiring;
+	std::deque<RetiredMemory>				mRetired;
+	D3D12BarrierBatch						mBarrierBatch;
+	uint64_t								mLastFenceValue;
+};
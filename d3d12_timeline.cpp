@@ -0,0 +1,48 @@
+#include "d3d12_timeline.h"
+#include "dx_helpers.h"
+
+D3D12Timeline::D3D12Timeline(ID3D12Device* device, ID3D12CommandQueue* queue) : mQueue(queue), mFenceEvent(nullptr), mFenceValue(0)
+{
+	ThrowIfFailed(device->CreateFence(mFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+	mFenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if (mFenceEvent == nullptr) {
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+D3D12Timeline::~D3D12Timeline()
+{
+	CloseHandle(mFenceEvent);
+}
+
+// ============================================================================
+// Add a signal command with the next fence value into the command queue.
+// ============================================================================
+uint64_t D3D12Timeline::Signal()
+{
+	ThrowIfFailed(mQueue->Signal(mFence.Get(), ++mFenceValue));
+	return mFenceValue;
+}
+
+// ============================================================================
+// Get the last fence value the GPU has completed.
+// ============================================================================
+uint64_t D3D12Timeline::CompletedValue()
+{
+	return mFence->GetCompletedValue();
+}
+
+// ============================================================================
+// Wait until the GPU has completed the given fence value.
+//
+// The function returns immediately if the value has already been completed so
+// the CPU only blocks when it actually has to wait for the GPU to catch up.
+// ============================================================================
+void D3D12Timeline::Wait(uint64_t value)
+{
+	if (mFence->GetCompletedValue() >= value) {
+		return;
+	}
+	ThrowIfFailed(mFence->SetEventOnCompletion(value, mFenceEvent));
+	WaitForSingleObjectEx(mFenceEvent, INFINITE, false);
+}
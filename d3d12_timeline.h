@@ -0,0 +1,28 @@
+#pragma once
+
+#include "gpu_timeline.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+// ============================================================================
+// A timeline implementation on top of a D3D12 fence and a command queue.
+//
+// Signals are added into the command queue so they are completed by the GPU
+// after the previously submitted work. Waiting is done with a Win32 event.
+// ============================================================================
+class D3D12Timeline : public GpuTimeline
+{
+public:
+	D3D12Timeline(ID3D12Device* device, ID3D12CommandQueue* queue);
+	~D3D12Timeline();
+	uint64_t Signal() override;
+	uint64_t CompletedValue() override;
+	void Wait(uint64_t value) override;
+	ID3D12Fence* Fence() const { return mFence.Get(); }
+private:
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>	mQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence>			mFence;
+	HANDLE										mFenceEvent;
+	uint64_t									mFenceValue;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "vertex_format.h"
+
+#include <array>
+#include <d3d12.h>
+#include <utility>
+
+// ============================================================================
+// Convert a vertex element format into the matching DXGI format.
+// ============================================================================
+constexpr DXGI_FORMAT ToDXGIFormat(VertexElementFormat format)
+{
+	return format == VertexElementFormat::Float3 ? DXGI_FORMAT_R32G32B32_FLOAT
+		: format == VertexElementFormat::Float4 ? DXGI_FORMAT_R32G32B32A32_FLOAT
+		: format == VertexElementFormat::Half4 ? DXGI_FORMAT_R16G16B16A16_FLOAT
+		: format == VertexElementFormat::Snorm16x4 ? DXGI_FORMAT_R16G16B16A16_SNORM
+		: DXGI_FORMAT_R8G8B8A8_UNORM;
+}
+
+// a helper to expand the elements of a vertex layout into the input element descriptors.
+template <size_t N, size_t... I>
+constexpr std::array<D3D12_INPUT_ELEMENT_DESC, N> ToD3D12InputLayout(const std::array<VertexElement, N>& elements, std::index_sequence<I...>)
+{
+	return { {
+		{
+			elements[I].semantic,
+			elements[I].semanticIndex,
+			ToDXGIFormat(elements[I].format),
+			0,
+			elements[I].offset,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			0
+		}...
+	} };
+}
+
+// ============================================================================
+// Generate the input layout of a vertex type at compile time.
+//
+// The layout is derived from the VertexLayout of the type and it's checked to
+// cover the whole vertex, so the stride of the buffer is the size of the type.
+// ============================================================================
+template <typename T>
+constexpr auto D3D12InputLayout()
+{
+	static_assert(IsValidVertexLayout<T>(), "vertex layout does not match the vertex type");
+	return ToD3D12InputLayout(VertexLayout<T>::Elements(), std::make_index_sequence<std::tuple_size<decltype(VertexLayout<T>::Elements())>::value>());
+}
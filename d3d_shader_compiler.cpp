@@ -0,0 +1,25 @@
+#include "d3d_shader_compiler.h"
+#include "dx_helpers.h"
+
+#include <d3dcompiler.h>
+#include <wrl.h>
+
+using namespace Microsoft::WRL;
+
+// ============================================================================
+// Compile a HLSL shader program into bytecode.
+//
+// Compilation errors are written into the debugger output before throwing an
+// exception with the failure HRESULT like all the other D3D failures.
+// ============================================================================
+ShaderBytecode D3DShaderCompiler::Compile(const ShaderSource& source)
+{
+	ComPtr<ID3DBlob> bytecode, error;
+	auto hr = D3DCompile(source.source.data(), source.source.size(), "", nullptr, nullptr, source.entryPoint.c_str(), source.target.c_str(), source.flags, 0, &bytecode, &error);
+	if (FAILED(hr) && error) {
+		OutputDebugStringA(static_cast<const char*>(error->GetBufferPointer()));
+	}
+	ThrowIfFailed(hr);
+	auto data = static_cast<const uint8_t*>(bytecode->GetBufferPointer());
+	return ShaderBytecode(data, data + bytecode->GetBufferSize());
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "shader_cache.h"
+
+// ============================================================================
+// A shader compiler that uses the D3DCompile function of the D3D compiler.
+// ============================================================================
+class D3DShaderCompiler : public ShaderCompiler
+{
+public:
+	ShaderBytecode Compile(const ShaderSource& source) override;
+};
@@ -0,0 +1,256 @@
+#include "descriptor_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+SimulatedDescriptorDevice::SimulatedDescriptorDevice(uint32_t increment) : mIncrement(increment), mCopyCallCount(0), mCopiedDescriptorCount(0)
+{
+	if (increment == 0) {
+		throw std::invalid_argument("descriptor increment must be non-zero");
+	}
+}
+
+// ============================================================================
+// Create a heap of descriptors in system memory.
+//
+// The GPU start of a shader visible heap is the same as its CPU start, which
+// keeps the GPU handles unique without any real GPU address space.
+// ============================================================================
+DescriptorHeapInfo SimulatedDescriptorDevice::CreateHeap(DescriptorHeapType, uint32_t capacity, bool shaderVisible)
+{
+	mHeaps.emplace_back(new uint8_t[static_cast<size_t>(capacity) * mIncrement]());
+	auto start = reinterpret_cast<uint64_t>(mHeaps.back().get());
+	return { mHeaps.back().get(), start, shaderVisible ? start : 0, mIncrement, capacity };
+}
+
+// ============================================================================
+// Release a heap created by the device.
+// ============================================================================
+void SimulatedDescriptorDevice::DestroyHeap(void* heap)
+{
+	auto found = std::find_if(mHeaps.begin(), mHeaps.end(), [heap](const std::unique_ptr<uint8_t[]>& memory) { return memory.get() == heap; });
+	if (found == mHeaps.end()) {
+		throw std::invalid_argument("descriptor heap was not created by the device");
+	}
+	mHeaps.erase(found);
+}
+
+// ============================================================================
+// Copy the descriptors of the source ranges into the destination ranges.
+//
+// The ranges on both sides are walked at the same time, so a range on either
+// side may span several ranges on the other side.
+// ============================================================================
+void SimulatedDescriptorDevice::CopyDescriptors(DescriptorHeapType, uint32_t destinationCount, const uint64_t* destinationStarts, const uint32_t* destinationSizes, uint32_t sourceCount, const uint64_t* sourceStarts, const uint32_t* sourceSizes)
+{
+	uint32_t destination = 0, destinationOffset = 0, source = 0, sourceOffset = 0;
+	while (destination < destinationCount && source < sourceCount) {
+		auto count = std::min(destinationSizes[destination] - destinationOffset, sourceSizes[source] - sourceOffset);
+		auto to = reinterpret_cast<uint8_t*>(destinationStarts[destination] + static_cast<uint64_t>(destinationOffset) * mIncrement);
+		auto from = reinterpret_cast<const uint8_t*>(sourceStarts[source] + static_cast<uint64_t>(sourceOffset) * mIncrement);
+		std::memcpy(to, from, static_cast<size_t>(count) * mIncrement);
+		mCopiedDescriptorCount += count;
+		destinationOffset += count;
+		sourceOffset += count;
+		if (destinationOffset == destinationSizes[destination]) {
+			destination++;
+			destinationOffset = 0;
+		}
+		if (sourceOffset == sourceSizes[source]) {
+			source++;
+			sourceOffset = 0;
+		}
+	}
+	if (destination != destinationCount || source != sourceCount) {
+		throw std::invalid_argument("descriptor copy ranges must have the same amount of descriptors");
+	}
+	mCopyCallCount++;
+}
+
+CpuDescriptorAllocator::CpuDescriptorAllocator(DescriptorDevice& device, DescriptorHeapType type, uint32_t heapCapacity) : mDevice(device), mType(type), mHeapCapacity(heapCapacity), mAllocatedCount(0)
+{
+	if (heapCapacity == 0) {
+		throw std::invalid_argument("descriptor heap capacity must be non-zero");
+	}
+}
+
+CpuDescriptorAllocator::~CpuDescriptorAllocator()
+{
+	for (auto& heap : mHeaps) {
+		mDevice.DestroyHeap(heap.info.heap);
+	}
+}
+
+// ============================================================================
+// Allocate a range of contiguous descriptors.
+//
+// The existing heaps are tried in order with a first fit search of their free
+// ranges before a new heap is created. Throws a length error if the range is
+// larger than a heap. Heap creation errors are thrown by the device.
+// ============================================================================
+DescriptorRange CpuDescriptorAllocator::Allocate(uint32_t count)
+{
+	if (count == 0 || count > mHeapCapacity) {
+		throw std::length_error("descriptor range does not fit into a descriptor heap");
+	}
+	DescriptorRange range = {};
+	for (uint32_t heap = 0; heap < mHeaps.size(); heap++) {
+		if (TryAllocate(heap, count, range)) {
+			return range;
+		}
+	}
+	mHeaps.push_back({ mDevice.CreateHeap(mType, mHeapCapacity, false), { { 0, mHeapCapacity } } });
+	TryAllocate(static_cast<uint32_t>(mHeaps.size() - 1), count, range);
+	return range;
+}
+
+// ============================================================================
+// Free a range of descriptors and merge it with the adjacent free ranges.
+// ============================================================================
+void CpuDescriptorAllocator::Free(const DescriptorRange& range)
+{
+	if (range.heap >= mHeaps.size() || range.count == 0 || range.index + range.count > mHeapCapacity) {
+		throw std::invalid_argument("descriptor range was not allocated from the allocator");
+	}
+	auto& freeRanges = mHeaps[range.heap].freeRanges;
+	auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), range.index, [](const FreeRange& free, uint32_t index) { return free.index < index; });
+	auto previous = (next != freeRanges.begin()) ? next - 1 : freeRanges.end();
+	if ((next != freeRanges.end() && range.index + range.count > next->index) || (previous != freeRanges.end() && previous->index + previous->count > range.index)) {
+		throw std::invalid_argument("descriptor range is already free");
+	}
+	auto mergePrevious = (previous != freeRanges.end() && previous->index + previous->count == range.index);
+	auto mergeNext = (next != freeRanges.end() && range.index + range.count == next->index);
+	if (mergePrevious && mergeNext) {
+		previous->count += range.count + next->count;
+		freeRanges.erase(next);
+	} else if (mergePrevious) {
+		previous->count += range.count;
+	} else if (mergeNext) {
+		next->index = range.index;
+		next->count += range.count;
+	} else {
+		freeRanges.insert(next, { range.index, range.count });
+	}
+	mAllocatedCount -= range.count;
+}
+
+// ============================================================================
+// Try to allocate the descriptors from the first fitting free range of a heap.
+// ============================================================================
+bool CpuDescriptorAllocator::TryAllocate(uint32_t heap, uint32_t count, DescriptorRange& range)
+{
+	auto& freeRanges = mHeaps[heap].freeRanges;
+	auto free = std::find_if(freeRanges.begin(), freeRanges.end(), [count](const FreeRange& candidate) { return candidate.count >= count; });
+	if (free == freeRanges.end()) {
+		return false;
+	}
+	auto& info = mHeaps[heap].info;
+	range = { info.cpuStart + static_cast<uint64_t>(free->index) * info.increment, 0, info.increment, count, heap, free->index };
+	free->index += count;
+	free->count -= count;
+	if (free->count == 0) {
+		freeRanges.erase(free);
+	}
+	mAllocatedCount += count;
+	return true;
+}
+
+DescriptorRing::DescriptorRing(DescriptorDevice& device, GpuTimeline& timeline, DescriptorHeapType type, uint32_t capacity) : mDevice(device), mInfo(CreateHeap(device, type, capacity)), mRing(timeline, capacity)
+{
+}
+
+DescriptorRing::~DescriptorRing()
+{
+	mDevice.DestroyHeap(mInfo.heap);
+}
+
+// ============================================================================
+// Create the shader visible heap of the ring after checking its description.
+// ============================================================================
+DescriptorHeapInfo DescriptorRing::CreateHeap(DescriptorDevice& device, DescriptorHeapType type, uint32_t capacity)
+{
+	if (capacity == 0) {
+		throw std::invalid_argument("descriptor ring capacity must be non-zero");
+	}
+	if (type == DescriptorHeapType::RenderTarget || type == DescriptorHeapType::DepthStencil) {
+		throw std::invalid_argument("descriptor ring type must be shader visible");
+	}
+	return device.CreateHeap(type, capacity, true);
+}
+
+// ============================================================================
+// Allocate a table of contiguous descriptors for the current frame.
+//
+// The ring places the table after the previous table or wraps around to the
+// start of the heap. Throws a length error if the table can never fit.
+// ============================================================================
+DescriptorRange DescriptorRing::Allocate(uint32_t count)
+{
+	if (count == 0 || count > mInfo.capacity) {
+		throw std::length_error("descriptor ring is too small for the table");
+	}
+	auto index = static_cast<uint32_t>(mRing.Allocate(count, 1));
+	return { mInfo.cpuStart + static_cast<uint64_t>(index) * mInfo.increment, mInfo.gpuStart + static_cast<uint64_t>(index) * mInfo.increment, mInfo.increment, count, 0, index };
+}
+
+DescriptorCopyBatch::DescriptorCopyBatch(DescriptorDevice& device, DescriptorHeapType type) : mDevice(device), mType(type), mIncrement(0), mPendingCount(0)
+{
+}
+
+// ============================================================================
+// Queue a copy of a source range into a table at the given offset.
+// ============================================================================
+void DescriptorCopyBatch::Copy(const DescriptorRange& destination, uint32_t offset, const DescriptorRange& source)
+{
+	if (offset + source.count > destination.count || destination.increment != source.increment) {
+		throw std::invalid_argument("descriptor copy does not fit into the destination table");
+	}
+	Copy(destination.CpuHandle(offset), source.cpuHandle, source.count, source.increment);
+}
+
+// ============================================================================
+// Queue a copy of contiguous descriptors between two CPU handles.
+//
+// A copy that continues the last destination or the last source range grows
+// that range, so tables filled from contiguous views become a single range.
+// ============================================================================
+void DescriptorCopyBatch::Copy(uint64_t destination, uint64_t source, uint32_t count, uint32_t increment)
+{
+	if (count == 0) {
+		return;
+	}
+	if (mPendingCount != 0 && increment != mIncrement) {
+		throw std::invalid_argument("descriptor copies of a batch must have the same increment");
+	}
+	mIncrement = increment;
+	if (mPendingCount != 0 && mDestinationStarts.back() + static_cast<uint64_t>(mDestinationSizes.back()) * increment == destination) {
+		mDestinationSizes.back() += count;
+	} else {
+		mDestinationStarts.push_back(destination);
+		mDestinationSizes.push_back(count);
+	}
+	if (mPendingCount != 0 && mSourceStarts.back() + static_cast<uint64_t>(mSourceSizes.back()) * increment == source) {
+		mSourceSizes.back() += count;
+	} else {
+		mSourceStarts.push_back(source);
+		mSourceSizes.push_back(count);
+	}
+	mPendingCount += count;
+}
+
+// ============================================================================
+// Issue the queued copies with a single copy of the device.
+// ============================================================================
+void DescriptorCopyBatch::Flush()
+{
+	if (mPendingCount == 0) {
+		return;
+	}
+	mDevice.CopyDescriptors(mType, static_cast<uint32_t>(mDestinationStarts.size()), mDestinationStarts.data(), mDestinationSizes.data(), static_cast<uint32_t>(mSourceStarts.size()), mSourceStarts.data(), mSourceSizes.data());
+	mDestinationStarts.clear();
+	mDestinationSizes.clear();
+	mSourceStarts.clear();
+	mSourceSizes.clear();
+	mPendingCount = 0;
+}
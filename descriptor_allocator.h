@@ -0,0 +1,174 @@
+#pragma once
+
+#include "fenced_ring.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// the amount of descriptor heap types.
+#define DESCRIPTOR_HEAP_TYPE_COUNT 4
+
+// ============================================================================
+// The types of the descriptor heaps.
+// ============================================================================
+enum class DescriptorHeapType : uint8_t { Resource, Sampler, RenderTarget, DepthStencil };
+
+// ============================================================================
+// A descriptor heap created by a descriptor device.
+//
+// Heap is an opaque handle of the backend (e.g. an ID3D12DescriptorHeap*) and
+// the GPU start is zero for the heaps that are not shader visible.
+// ============================================================================
+struct DescriptorHeapInfo
+{
+	void*		heap;
+	uint64_t	cpuStart;
+	uint64_t	gpuStart;
+	uint32_t	increment;
+	uint32_t	capacity;
+};
+
+// ============================================================================
+// A range of contiguous descriptors within a descriptor heap.
+// ============================================================================
+struct DescriptorRange
+{
+	uint64_t	cpuHandle;
+	uint64_t	gpuHandle;
+	uint32_t	increment;
+	uint32_t	count;
+	uint32_t	heap;
+	uint32_t	index;
+	uint64_t CpuHandle(uint32_t offset) const { return cpuHandle + static_cast<uint64_t>(offset) * increment; }
+	uint64_t GpuHandle(uint32_t offset) const { return gpuHandle + static_cast<uint64_t>(offset) * increment; }
+};
+
+// ============================================================================
+// An interface for the devices that create and copy the descriptors.
+//
+// Copies take the CPU handles of the destination and the source ranges, whose
+// descriptor counts must have the same total, like the D3D12 copy function.
+// ============================================================================
+class DescriptorDevice
+{
+public:
+	virtual ~DescriptorDevice() = default;
+	virtual DescriptorHeapInfo CreateHeap(DescriptorHeapType type, uint32_t capacity, bool shaderVisible) = 0;
+	virtual void DestroyHeap(void* heap) = 0;
+	virtual void CopyDescriptors(DescriptorHeapType type, uint32_t destinationCount, const uint64_t* destinationStarts, const uint32_t* destinationSizes, uint32_t sourceCount, const uint64_t* sourceStarts, const uint32_t* sourceSizes) = 0;
+};
+
+// ============================================================================
+// A descriptor device that keeps the descriptors in system memory.
+//
+// Each descriptor is a block of memory of the increment size, so the copies
+// move the same amount of bytes as the copies of a driver would.
+// ============================================================================
+class SimulatedDescriptorDevice : public DescriptorDevice
+{
+public:
+	explicit SimulatedDescriptorDevice(uint32_t increment);
+	DescriptorHeapInfo CreateHeap(DescriptorHeapType type, uint32_t capacity, bool shaderVisible) override;
+	void DestroyHeap(void* heap) override;
+	void CopyDescriptors(DescriptorHeapType type, uint32_t destinationCount, const uint64_t* destinationStarts, const uint32_t* destinationSizes, uint32_t sourceCount, const uint64_t* sourceStarts, const uint32_t* sourceSizes) override;
+	unsigned HeapCount() const { return static_cast<unsigned>(mHeaps.size()); }
+	unsigned CopyCallCount() const { return mCopyCallCount; }
+	uint64_t CopiedDescriptorCount() const { return mCopiedDescriptorCount; }
+private:
+	uint32_t								mIncrement;
+	std::vector<std::unique_ptr<uint8_t[]>>	mHeaps;
+	unsigned								mCopyCallCount;
+	uint64_t								mCopiedDescriptorCount;
+};
+
+// ============================================================================
+// A free list allocator of descriptors within CPU only descriptor heaps.
+//
+// Heaps are created on demand with a fixed capacity, and each heap keeps its
+// free descriptors as a sorted list of ranges that are merged when freed. The
+// views of the resources are created into these heaps and copied into the
+// shader visible heap when they are bound for drawing.
+// ============================================================================
+class CpuDescriptorAllocator
+{
+public:
+	CpuDescriptorAllocator(DescriptorDevice& device, DescriptorHeapType type, uint32_t heapCapacity);
+	~CpuDescriptorAllocator();
+	DescriptorRange Allocate(uint32_t count = 1);
+	void Free(const DescriptorRange& range);
+	unsigned HeapCount() const { return static_cast<unsigned>(mHeaps.size()); }
+	unsigned AllocatedCount() const { return mAllocatedCount; }
+private:
+	struct FreeRange
+	{
+		uint32_t	index;
+		uint32_t	count;
+	};
+	struct Heap
+	{
+		DescriptorHeapInfo		info;
+		std::vector<FreeRange>	freeRanges;
+	};
+	bool TryAllocate(uint32_t heap, uint32_t count, DescriptorRange& range);
+private:
+	DescriptorDevice&	mDevice;
+	DescriptorHeapType	mType;
+	uint32_t			mHeapCapacity;
+	std::vector<Heap>	mHeaps;
+	unsigned			mAllocatedCount;
+};
+
+// ============================================================================
+// A linear ring allocator of descriptors within a shader visible heap.
+//
+// The descriptor tables of a frame are allocated after the tables of the
+// previous frame. Like the upload ring, the regions of the frames are closed
+// with the fence of the frame and reclaimed when the GPU has completed them,
+// and the allocator only waits when the ring is full.
+// ============================================================================
+class DescriptorRing
+{
+public:
+	DescriptorRing(DescriptorDevice& device, GpuTimeline& timeline, DescriptorHeapType type, uint32_t capacity);
+	~DescriptorRing();
+	DescriptorRange Allocate(uint32_t count);
+	void EndFrame(uint64_t fenceValue) { mRing.EndFrame(fenceValue); }
+	void Reclaim() { mRing.Reclaim(); }
+	void* Heap() const { return mInfo.heap; }
+	uint32_t Capacity() const { return mInfo.capacity; }
+	uint64_t UsedCount() const { return mRing.UsedCount(); }
+	unsigned WaitCount() const { return mRing.WaitCount(); }
+private:
+	static DescriptorHeapInfo CreateHeap(DescriptorDevice& device, DescriptorHeapType type, uint32_t capacity);
+private:
+	DescriptorDevice&		mDevice;
+	DescriptorHeapInfo		mInfo;
+	FencedRing				mRing;
+};
+
+// ============================================================================
+// A batch of descriptor copies that is issued with a single device copy.
+//
+// Copies with the source and the destination continuing the previous copy are
+// merged into the same ranges. The ranges are kept between the flushes, so a
+// batch does not allocate once it has seen its largest amount of ranges.
+// ============================================================================
+class DescriptorCopyBatch
+{
+public:
+	DescriptorCopyBatch(DescriptorDevice& device, DescriptorHeapType type);
+	void Copy(const DescriptorRange& destination, uint32_t offset, const DescriptorRange& source);
+	void Copy(uint64_t destination, uint64_t source, uint32_t count, uint32_t increment);
+	void Flush();
+	unsigned PendingCount() const { return mPendingCount; }
+private:
+	DescriptorDevice&		mDevice;
+	DescriptorHeapType		mType;
+	std::vector<uint64_t>	mDestinationStarts;
+	std::vector<uint32_t>	mDestinationSizes;
+	std::vector<uint64_t>	mSourceStarts;
+	std::vector<uint32_t>	mSourceSizes;
+	uint32_t				mIncrement;
+	unsigned				mPendingCount;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <windows.h>
+
+// a helper utility to throw exception on failure HRESULTs.
+inline void ThrowIfFailed(HRESULT hr) {
+	if (FAILED(hr)) {
+		throw Platform::Exception::CreateException(hr);
+	}
+}
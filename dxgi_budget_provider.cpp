@@ -0,0 +1,13 @@
+#include "dxgi_budget_provider.h"
+#include "dx_helpers.h"
+
+// ============================================================================
+// Query the budget and the usage of a memory segment of the adapter.
+// ============================================================================
+MemoryBudgetInfo DxgiBudgetProvider::Query(MemorySegment segment)
+{
+	DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+	auto group = (segment == MemorySegment::Local) ? DXGI_MEMORY_SEGMENT_GROUP_LOCAL : DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL;
+	ThrowIfFailed(mAdapter->QueryVideoMemoryInfo(0, group, &info));
+	return { info.Budget, info.CurrentUsage };
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "memory_budget.h"
+
+#include <dxgi1_4.h>
+#include <wrl.h>
+
+// ============================================================================
+// A budget provider that queries the video memory info of a DXGI adapter.
+//
+// The budget is the amount of memory the OS lets the process use before it
+// starts to page its memory, so it shrinks when other apps need memory.
+// ============================================================================
+class DxgiBudgetProvider : public MemoryBudgetProvider
+{
+public:
+	explicit DxgiBudgetProvider(IDXGIAdapter3* adapter) : mAdapter(adapter) {}
+	MemoryBudgetInfo Query(MemorySegment segment) override;
+private:
+	Microsoft::WRL::ComPtr<IDXGIAdapter3>	mAdapter;
+};
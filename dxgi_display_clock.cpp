@@ -0,0 +1,54 @@
+#include "dxgi_display_clock.h"
+
+DxgiDisplayClock::DxgiDisplayClock(IDXGISwapChain* swapChain, Clock& clock) : mSwapChain(swapChain), mRefreshNanoseconds(1000000000ull / DISPLAY_DEFAULT_REFRESH_RATE), mSyncRefreshCount(0)
+{
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	mCounterFrequency = frequency.QuadPart;
+	mCounterOrigin = counter.QuadPart;
+	mClockOrigin = clock.Now();
+	mVblank = mClockOrigin;
+}
+
+// ============================================================================
+// Read the latest vertical blank from the frame statistics of the swap chain.
+//
+// Statistics are not available before the first present or while the output
+// is disjoint, in which case the vertical blanks are extrapolated from the
+// previous ones. The refresh period is measured between the updates.
+// ============================================================================
+void DxgiDisplayClock::Update()
+{
+	DXGI_FRAME_STATISTICS statistics = {};
+	if (FAILED(mSwapChain->GetFrameStatistics(&statistics)) || statistics.SyncQPCTime.QuadPart == 0) {
+		return;
+	}
+	auto vblank = CounterToClock(statistics.SyncQPCTime.QuadPart);
+	if (mSyncRefreshCount != 0 && statistics.SyncRefreshCount > mSyncRefreshCount && vblank > mVblank) {
+		mRefreshNanoseconds = (vblank - mVblank) / (statistics.SyncRefreshCount - mSyncRefreshCount);
+	}
+	mSyncRefreshCount = statistics.SyncRefreshCount;
+	mVblank = vblank;
+}
+
+// ============================================================================
+// Get the time of the latest vertical blank at or before the given time.
+// ============================================================================
+uint64_t DxgiDisplayClock::LastVblank(uint64_t now)
+{
+	if (now < mVblank) {
+		return mVblank - ((mVblank - now + mRefreshNanoseconds - 1) / mRefreshNanoseconds) * mRefreshNanoseconds;
+	}
+	return now - (now - mVblank) % mRefreshNanoseconds;
+}
+
+// ============================================================================
+// Convert a performance counter value into the time of the clock.
+// ============================================================================
+uint64_t DxgiDisplayClock::CounterToClock(int64_t counter) const
+{
+	auto elapsed = counter - mCounterOrigin;
+	auto nanoseconds = (elapsed / mCounterFrequency) * 1000000000ll + ((elapsed % mCounterFrequency) * 1000000000ll) / mCounterFrequency;
+	return static_cast<uint64_t>(static_cast<int64_t>(mClockOrigin) + nanoseconds);
+}
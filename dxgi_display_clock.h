@@ -0,0 +1,35 @@
+#pragma once
+
+#include "frame_pacer.h"
+
+#include <dxgi.h>
+#include <wrl.h>
+
+// the refresh rate assumed until the swap chain has reported the vertical blanks.
+#define DISPLAY_DEFAULT_REFRESH_RATE 60
+
+// ============================================================================
+// A display clock that follows the vertical blanks of a swap chain output.
+//
+// The latest vertical blank and the refresh period are read from the frame
+// statistics of the swap chain and converted from the performance counter
+// into the time of the given clock, so the pacer can compare them directly.
+// ============================================================================
+class DxgiDisplayClock : public DisplayClock
+{
+public:
+	DxgiDisplayClock(IDXGISwapChain* swapChain, Clock& clock);
+	void Update();
+	uint64_t RefreshNanoseconds() override { return mRefreshNanoseconds; }
+	uint64_t LastVblank(uint64_t now) override;
+private:
+	uint64_t CounterToClock(int64_t counter) const;
+private:
+	Microsoft::WRL::ComPtr<IDXGISwapChain>	mSwapChain;
+	int64_t									mCounterFrequency;
+	int64_t									mCounterOrigin;
+	uint64_t								mClockOrigin;
+	uint64_t								mRefreshNanoseconds;
+	uint64_t								mVblank;
+	UINT									mSyncRefreshCount;
+};
@@ -0,0 +1,92 @@
+#include "fenced_ring.h"
+
+#include <stdexcept>
+
+FencedRing::FencedRing(GpuTimeline& timeline, uint64_t capacity) : mTimeline(timeline), mCapacity(capacity), mHead(0), mTail(0), mOffset(0), mWaitCount(0)
+{
+	if (capacity == 0) {
+		throw std::invalid_argument("ring capacity must be non-zero");
+	}
+}
+
+// ============================================================================
+// Allocate a block with the given power of two alignment and get its offset.
+//
+// Head and tail are running counters while the offset tracks the ring
+// position of the head. A block that does not fit before the end of the ring
+// is placed at the start and the skipped tail is freed with the frame. An
+// empty ring starts over from the start, so no padding is spent on it.
+// Throws a length error if the block can never fit into the ring.
+// ============================================================================
+uint64_t FencedRing::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		throw std::invalid_argument("ring alignment must be a power of two");
+	}
+	if (size > mCapacity) {
+		throw std::length_error("ring is too small for the allocation");
+	}
+	for (;;) {
+		if (mHead == mTail) {
+			mOffset = 0;
+		}
+		auto offset = mOffset;
+		auto aligned = (offset + alignment - 1) & ~(alignment - 1);
+		if (aligned + size > mCapacity) {
+			aligned = 0;
+		}
+		auto padding = (aligned >= offset) ? aligned - offset : mCapacity - offset;
+		if (mHead + padding + size - mTail <= mCapacity) {
+			mHead += padding + size;
+			mOffset = aligned + size;
+			return aligned;
+		}
+		WaitOldestRegion();
+	}
+}
+
+// ============================================================================
+// Close the region of the current frame with the fence value of the frame.
+// ============================================================================
+void FencedRing::EndFrame(uint64_t fenceValue)
+{
+	if (mRegions.empty() ? mHead != mTail : mHead != mRegions.back().end) {
+		mRegions.push_back({ mHead, fenceValue });
+	}
+}
+
+// ============================================================================
+// Free the regions of the frames the GPU has completed.
+// ============================================================================
+void FencedRing::Reclaim()
+{
+	auto completedValue = mTimeline.CompletedValue();
+	while (!mRegions.empty() && mRegions.front().fenceValue <= completedValue) {
+		mTail = mRegions.front().end;
+		mRegions.pop_front();
+	}
+}
+
+// ============================================================================
+// Free at least one region and wait the GPU for the oldest one if necessary.
+//
+// Throws a length error when there are no closed regions left, i.e. the open
+// frame alone would need more than the ring has.
+// ============================================================================
+void FencedRing::WaitOldestRegion()
+{
+	auto regionCount = mRegions.size();
+	Reclaim();
+	if (mRegions.size() != regionCount) {
+		return;
+	}
+	if (mRegions.empty()) {
+		throw std::length_error("ring is too small for the frame");
+	}
+	if (mTimeline.CompletedValue() < mRegions.front().fenceValue) {
+		mWaitCount++;
+		mTimeline.Wait(mRegions.front().fenceValue);
+	}
+	mTail = mRegions.front().end;
+	mRegions.pop_front();
+}
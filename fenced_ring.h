@@ -0,0 +1,41 @@
+#pragma once
+
+#include "gpu_timeline.h"
+
+#include <cstdint>
+#include <deque>
+
+// ============================================================================
+// The arithmetic of a linear ring whose regions are freed with GPU fences.
+//
+// Each frame allocates a contiguous region after the previous frame. Regions
+// are closed with the fence of the frame and reclaimed when the GPU has
+// completed the fence. The ring only waits when it is full. The units of the
+// ring are left to the owner, e.g. bytes of the upload ring or descriptors.
+// ============================================================================
+class FencedRing
+{
+public:
+	FencedRing(GpuTimeline& timeline, uint64_t capacity);
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	void EndFrame(uint64_t fenceValue);
+	void Reclaim();
+	uint64_t Capacity() const { return mCapacity; }
+	uint64_t UsedCount() const { return mHead - mTail; }
+	unsigned WaitCount() const { return mWaitCount; }
+private:
+	struct Region
+	{
+		uint64_t	end;
+		uint64_t	fenceValue;
+	};
+	void WaitOldestRegion();
+private:
+	GpuTimeline&		mTimeline;
+	uint64_t			mCapacity;
+	uint64_t			mHead;
+	uint64_t			mTail;
+	uint64_t			mOffset;
+	std::deque<Region>	mRegions;
+	unsigned			mWaitCount;
+};
@@ -0,0 +1,50 @@
+#include "file_source.h"
+
+#include <stdexcept>
+#include <thread>
+
+// a helper class to expose the shared contents of a fake file.
+class FakeFileContents : public FileContents
+{
+public:
+	explicit FakeFileContents(std::shared_ptr<std::vector<uint8_t>> data) : mData(std::move(data)) {}
+	const uint8_t* Data() const override { return mData->data(); }
+	uint64_t Size() const override { return mData->size(); }
+private:
+	std::shared_ptr<std::vector<uint8_t>>	mData;
+};
+
+// ============================================================================
+// Add or replace a file of the source.
+// ============================================================================
+void FakeFileSource::Add(const std::string& path, std::vector<uint8_t> data)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFiles[path] = std::make_shared<std::vector<uint8_t>>(std::move(data));
+}
+
+// ============================================================================
+// Open a file after the simulated latency has passed.
+// ============================================================================
+std::unique_ptr<FileContents> FakeFileSource::Open(const std::string& path)
+{
+	if (mLatency.count() > 0) {
+		std::this_thread::sleep_for(mLatency);
+	}
+	std::lock_guard<std::mutex> lock(mMutex);
+	mOpenedPaths.push_back(path);
+	auto file = mFiles.find(path);
+	if (file == mFiles.end()) {
+		throw std::runtime_error("file not found: " + path);
+	}
+	return std::unique_ptr<FileContents>(new FakeFileContents(file->second));
+}
+
+// ============================================================================
+// Get the paths of the opened files in the order they were opened.
+// ============================================================================
+std::vector<std::string> FakeFileSource::OpenedPaths() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mOpenedPaths;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// An interface for the contents of an opened file.
+// ============================================================================
+class FileContents
+{
+public:
+	virtual ~FileContents() = default;
+	virtual const uint8_t* Data() const = 0;
+	virtual uint64_t Size() const = 0;
+};
+
+// ============================================================================
+// An interface for a source that opens files by their paths.
+//
+// Sources may be used from several threads at the same time. Failures to
+// open a file are reported by throwing a std::runtime_error.
+// ============================================================================
+class FileSource
+{
+public:
+	virtual ~FileSource() = default;
+	virtual std::unique_ptr<FileContents> Open(const std::string& path) = 0;
+};
+
+// ============================================================================
+// A file source that serves files from memory with a simulated latency.
+//
+// Source records the order in which the files were opened, so tests can check
+// the scheduling of the reads without touching the file system.
+// ============================================================================
+class FakeFileSource : public FileSource
+{
+public:
+	explicit FakeFileSource(std::chrono::microseconds latency = std::chrono::microseconds(0)) : mLatency(latency) {}
+	void Add(const std::string& path, std::vector<uint8_t> data);
+	std::unique_ptr<FileContents> Open(const std::string& path) override;
+	std::vector<std::string> OpenedPaths() const;
+private:
+	std::chrono::microseconds												mLatency;
+	mutable std::mutex														mMutex;
+	std::unordered_map<std::string, std::shared_ptr<std::vector<uint8_t>>>	mFiles;
+	std::vector<std::string>												mOpenedPaths;
+};
@@ -0,0 +1,49 @@
+#include "fixed_timestep.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+FixedTimestep::FixedTimestep(uint64_t stepNanoseconds, unsigned maxStepsPerAdvance) : mStepNanoseconds(stepNanoseconds), mMaxStepsPerAdvance(maxStepsPerAdvance), mNextStepTime(stepNanoseconds), mStepCount(0), mDroppedStepCount(0)
+{
+	if (stepNanoseconds == 0 || maxStepsPerAdvance == 0) {
+		throw std::invalid_argument("step duration and maximum step count must be non-zero");
+	}
+}
+
+// ============================================================================
+// Restart the schedule so that the first step is due one step after now.
+// ============================================================================
+void FixedTimestep::Reset(uint64_t now)
+{
+	mNextStepTime = now + mStepNanoseconds;
+}
+
+// ============================================================================
+// Get the amount of steps due at the given time and schedule the next step.
+//
+// Steps are due at multiples of the step duration after the reset. If more
+// than the maximum are due, the rest are dropped so a stall after a suspend
+// or a breakpoint does not make the loop spiral trying to catch up.
+// ============================================================================
+unsigned FixedTimestep::Advance(uint64_t now)
+{
+	if (now < mNextStepTime) {
+		return 0;
+	}
+	auto due = (now - mNextStepTime) / mStepNanoseconds + 1;
+	mNextStepTime += due * mStepNanoseconds;
+	auto steps = static_cast<unsigned>(std::min<uint64_t>(due, mMaxStepsPerAdvance));
+	mDroppedStepCount += due - steps;
+	mStepCount += steps;
+	return steps;
+}
+
+// ============================================================================
+// Get the fraction of the step elapsed between the last step and now.
+// ============================================================================
+double FixedTimestep::Alpha(uint64_t now) const
+{
+	auto last = LastStepTime();
+	auto elapsed = (now > last) ? static_cast<double>(now - last) : 0.0;
+	return std::min(elapsed / mStepNanoseconds, 1.0);
+}
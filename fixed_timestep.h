@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================================
+// A scheduler of the fixed timestep updates of an update loop.
+//
+// Scheduler tells how many steps are due at the given time. When the loop
+// falls too far behind, the excess steps are dropped instead of catching up.
+// ============================================================================
+class FixedTimestep
+{
+public:
+	FixedTimestep(uint64_t stepNanoseconds, unsigned maxStepsPerAdvance);
+	void Reset(uint64_t now);
+	unsigned Advance(uint64_t now);
+	double Alpha(uint64_t now) const;
+	uint64_t NextStepTime() const { return mNextStepTime; }
+	uint64_t LastStepTime() const { return mNextStepTime - mStepNanoseconds; }
+	uint64_t StepNanoseconds() const { return mStepNanoseconds; }
+	double StepSeconds() const { return mStepNanoseconds / 1e9; }
+	uint64_t StepCount() const { return mStepCount; }
+	uint64_t DroppedStepCount() const { return mDroppedStepCount; }
+private:
+	uint64_t	mStepNanoseconds;
+	unsigned	mMaxStepsPerAdvance;
+	uint64_t	mNextStepTime;
+	uint64_t	mStepCount;
+	uint64_t	mDroppedStepCount;
+};
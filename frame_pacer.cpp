@@ -0,0 +1,99 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// a helper to get the first vertical blank of a display at or after the given time.
+static uint64_t NextVblank(DisplayClock& display, uint64_t time)
+{
+	auto last = display.LastVblank(time);
+	return (last == time) ? last : last + display.RefreshNanoseconds();
+}
+
+// ============================================================================
+// Get the time of the latest vertical blank at or before the given time.
+// ============================================================================
+uint64_t SimulatedDisplayClock::LastVblank(uint64_t now)
+{
+	if (now < mPhase) {
+		return mPhase - ((mPhase - now + mRefreshNanoseconds - 1) / mRefreshNanoseconds) * mRefreshNanoseconds;
+	}
+	return now - (now - mPhase) % mRefreshNanoseconds;
+}
+
+FramePacer::FramePacer(Clock& clock, DisplayClock& display, const FramePacingDesc& desc) : mClock(clock), mDisplay(display), mDesc(desc), mFrameStart(0), mTargetVblank(0), mFrameCount(0), mMissedFrameCount(0)
+{
+	if (desc.maxLatency == 0 || desc.historyFrames == 0) {
+		throw std::invalid_argument("maximum latency and history size must be non-zero");
+	}
+	mWorkHistory.reserve(desc.historyFrames);
+}
+
+// ============================================================================
+// Wait until the CPU work of the next frame should start.
+//
+// The target is the first vertical blank after the end of the predicted work,
+// but at least one refresh after the previous target and at most the maximum
+// latency of refreshes ahead. Latency waitable frames sleep until the work
+// would end just before the target once there is any work to predict, while
+// vsync frames start right away and queue up, and tearing frames have no
+// target at all.
+// ============================================================================
+uint64_t FramePacer::BeginFrame()
+{
+	auto now = mClock.Now();
+	mFrameStart = now;
+	if (mDesc.mode == PresentMode::Tearing) {
+		mTargetVblank = 0;
+		return mFrameStart;
+	}
+
+	auto refresh = mDisplay.RefreshNanoseconds();
+	auto work = PredictedWork() + mDesc.marginNanoseconds;
+	auto earliest = NextVblank(mDisplay, now + work + 1);
+	auto target = earliest;
+	if (mTargetVblank != 0) {
+		target = std::max(target, NextVblank(mDisplay, mTargetVblank + refresh / 2));
+	}
+	auto latest = std::max(earliest, NextVblank(mDisplay, now + 1) + (mDesc.maxLatency - 1) * refresh);
+	mTargetVblank = std::min(target, latest);
+
+	if (mDesc.mode == PresentMode::LatencyWaitable && !mWorkHistory.empty() && mTargetVblank - work > now) {
+		mFrameStart = mTargetVblank - work;
+		mClock.SleepUntil(mFrameStart);
+	}
+	return mFrameStart;
+}
+
+// ============================================================================
+// Record the duration of the work of the frame from its start to its end.
+//
+// A frame whose work ended after its target vertical blank is counted as a
+// missed frame, as the display shows the previous frame once more. The frame
+// is then shown at a later vertical blank, so the next frames target after it.
+// ============================================================================
+void FramePacer::EndFrame(uint64_t workNanoseconds)
+{
+	if (mWorkHistory.size() < mDesc.historyFrames) {
+		mWorkHistory.push_back(workNanoseconds);
+	} else {
+		mWorkHistory[mFrameCount % mDesc.historyFrames] = workNanoseconds;
+	}
+	if (mDesc.mode != PresentMode::Tearing && mFrameStart + workNanoseconds > mTargetVblank) {
+		mTargetVblank = NextVblank(mDisplay, mFrameStart + workNanoseconds);
+		mMissedFrameCount++;
+	}
+	mFrameCount++;
+}
+
+// ============================================================================
+// Get the predicted work of the next frame as the longest recent work.
+// ============================================================================
+uint64_t FramePacer::PredictedWork() const
+{
+	uint64_t work = 0;
+	for (auto duration : mWorkHistory) {
+		work = std::max(work, duration);
+	}
+	return work;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "clock.h"
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// The ways to present the frames onto the display.
+//
+// Vsync queues the frames and shows each at a vertical blank, which gives the
+// smoothest pacing. Tearing shows a frame right away without waiting for the
+// vertical blank, which gives the lowest latency. Latency waitable shows the
+// frames at the vertical blanks, but starts each frame just in time for the
+// next vertical blank with at most the maximum latency of frames queued.
+// ============================================================================
+enum class PresentMode : uint8_t { Vsync, Tearing, LatencyWaitable };
+
+// ============================================================================
+// The configuration of the frame pacing.
+//
+// The margin is added on top of the predicted frame work, which is the
+// longest work of the frames in the history window.
+// ============================================================================
+struct FramePacingDesc
+{
+	PresentMode	mode;
+	unsigned	maxLatency;
+	uint64_t	marginNanoseconds;
+	unsigned	historyFrames;
+};
+
+// ============================================================================
+// An interface for the timing of the vertical blanks of a display.
+// ============================================================================
+class DisplayClock
+{
+public:
+	virtual ~DisplayClock() = default;
+	virtual uint64_t RefreshNanoseconds() = 0;
+	virtual uint64_t LastVblank(uint64_t now) = 0;
+};
+
+// ============================================================================
+// A display with vertical blanks at a fixed refresh period after a phase.
+// ============================================================================
+class SimulatedDisplayClock : public DisplayClock
+{
+public:
+	SimulatedDisplayClock(uint64_t refreshNanoseconds, uint64_t phase) : mRefreshNanoseconds(refreshNanoseconds), mPhase(phase) {}
+	uint64_t RefreshNanoseconds() override { return mRefreshNanoseconds; }
+	uint64_t LastVblank(uint64_t now) override;
+private:
+	uint64_t	mRefreshNanoseconds;
+	uint64_t	mPhase;
+};
+
+// ============================================================================
+// A scheduler that decides when the CPU work of a frame starts.
+//
+// Frames are started as late as possible, so the input and the simulation
+// are sampled as close to the display as the pacing of the mode allows. The
+// pacer only uses the clocks, so the presentation itself is up to the caller.
+// ============================================================================
+class FramePacer
+{
+public:
+	FramePacer(Clock& clock, DisplayClock& display, const FramePacingDesc& desc);
+	uint64_t BeginFrame();
+	void EndFrame(uint64_t workNanoseconds);
+	uint64_t PredictedWork() const;
+	const FramePacingDesc& Desc() const { return mDesc; }
+	unsigned SyncInterval() const { return (mDesc.mode == PresentMode::Tearing) ? 0 : 1; }
+	uint64_t FrameStart() const { return mFrameStart; }
+	uint64_t TargetVblank() const { return mTargetVblank; }
+	uint64_t FrameCount() const { return mFrameCount; }
+	uint64_t MissedFrameCount() const { return mMissedFrameCount; }
+private:
+	Clock&					mClock;
+	DisplayClock&			mDisplay;
+	FramePacingDesc			mDesc;
+	std::vector<uint64_t>	mWorkHistory;
+	uint64_t				mFrameStart;
+	uint64_t				mTargetVblank;
+	uint64_t				mFrameCount;
+	uint64_t				mMissedFrameCount;
+};
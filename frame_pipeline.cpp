@@ -0,0 +1,57 @@
+#include "frame_pipeline.h"
+
+#include <stdexcept>
+
+FramePipeline::FramePipeline(GpuTimeline& timeline, unsigned frameLatency) : mTimeline(timeline), mFrameFences(frameLatency, 0), mFrameIndex(0), mFrameOpen(false), mLastWaitTime(0)
+{
+	if (frameLatency == 0) {
+		throw std::invalid_argument("frame latency must be at least one frame");
+	}
+}
+
+// ============================================================================
+// Begin a new frame and get the index of the frame slot to be recorded.
+//
+// Function blocks only when the GPU has not yet completed the frame that used
+// the same slot earlier, so the CPU may run ahead by the given frame latency.
+// ============================================================================
+unsigned FramePipeline::BeginFrame()
+{
+	if (mFrameOpen) {
+		throw std::logic_error("frame has already been started");
+	}
+	auto start = std::chrono::steady_clock::now();
+	mTimeline.Wait(mFrameFences[mFrameIndex]);
+	mLastWaitTime = std::chrono::steady_clock::now() - start;
+	mFrameOpen = true;
+	return mFrameIndex;
+}
+
+// ============================================================================
+// End the current frame after its work has been submitted to the GPU.
+//
+// A new signal is queued after the frame work and stored for the frame slot.
+// The pipeline then proceeds to the next slot in a round-robin manner.
+// ============================================================================
+uint64_t FramePipeline::EndFrame()
+{
+	if (!mFrameOpen) {
+		throw std::logic_error("frame has not been started");
+	}
+	auto fence = mTimeline.Signal();
+	mFrameFences[mFrameIndex] = fence;
+	mFrameIndex = (mFrameIndex + 1) % FrameLatency();
+	mFrameOpen = false;
+	return fence;
+}
+
+// ============================================================================
+// Wait until the GPU has completed all work submitted so far.
+//
+// This is necessary before releasing or resizing any resources that may still
+// be referenced by one of the frames in flight (e.g. swap chain buffers).
+// ============================================================================
+void FramePipeline::Flush()
+{
+	mTimeline.Wait(mTimeline.Signal());
+}
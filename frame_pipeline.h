@@ -0,0 +1,31 @@
+#pragma once
+
+#include "gpu_timeline.h"
+
+#include <chrono>
+#include <vector>
+
+// ============================================================================
+// A scheduler to keep multiple frames in flight between the CPU and the GPU.
+//
+// Pipeline stores a fence value for each frame slot and only waits the GPU in
+// case the resources of a slot (e.g. a command allocator) are about to be reused.
+// ============================================================================
+class FramePipeline
+{
+public:
+	FramePipeline(GpuTimeline& timeline, unsigned frameLatency);
+	unsigned BeginFrame();
+	uint64_t EndFrame();
+	void Flush();
+	unsigned FrameLatency() const { return static_cast<unsigned>(mFrameFences.size()); }
+	unsigned FrameIndex() const { return mFrameIndex; }
+	uint64_t FrameFence(unsigned frameIndex) const { return mFrameFences[frameIndex]; }
+	std::chrono::nanoseconds LastWaitTime() const { return mLastWaitTime; }
+private:
+	GpuTimeline&				mTimeline;
+	std::vector<uint64_t>		mFrameFences;
+	unsigned					mFrameIndex;
+	bool						mFrameOpen;
+	std::chrono::nanoseconds	mLastWaitTime;
+};
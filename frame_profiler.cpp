@@ -0,0 +1,239 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// use the time stamp counter of the processor as the clock when available.
+#if defined(_M_X64) || defined(_M_IX86)
+#define PROFILE_USE_TSC
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#define PROFILE_USE_TSC
+#include <x86intrin.h>
+#endif
+
+// the thread identifier used for the events of the GPU timeline.
+#define PROFILE_GPU_THREAD_ID 0
+
+// a per-thread pointer to the ring buffer of the calling thread.
+thread_local ProfileRing* ThreadRingPointer = nullptr;
+
+// a helper to append a string as an escaped JSON string literal.
+static void AppendJsonString(std::string& json, const char* text)
+{
+	json += '"';
+	for (auto c = text; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			json += '\\';
+		}
+		json += *c;
+	}
+	json += '"';
+}
+
+ProfileRing::ProfileRing(unsigned threadId, std::string threadName) : mSlots(new Slot[PROFILE_RING_CAPACITY]), mHead(0), mThreadId(threadId), mThreadName(std::move(threadName))
+{
+}
+
+// ============================================================================
+// Push a new event into the ring buffer.
+//
+// Only the owning thread may push events. Fields are written with relaxed
+// stores after a fence and the event is then published by advancing the head.
+// ============================================================================
+void ProfileRing::Push(const char* name, uint64_t begin, uint64_t end, uint64_t frame)
+{
+	auto head = mHead.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	auto& slot = mSlots[head & (PROFILE_RING_CAPACITY - 1)];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.begin.store(begin, std::memory_order_relaxed);
+	slot.end.store(end, std::memory_order_relaxed);
+	slot.frame.store(frame, std::memory_order_relaxed);
+	mHead.store(head + 1, std::memory_order_release);
+}
+
+// ============================================================================
+// Append a consistent copy of the buffered events into the given vector.
+//
+// The head is read before and after the copy. Any event which the owner may
+// have overwritten in the meantime is dropped from the resulting snapshot.
+// ============================================================================
+void ProfileRing::Snapshot(std::vector<ProfileEvent>& events) const
+{
+	auto head = mHead.load(std::memory_order_acquire);
+	auto first = (head > PROFILE_RING_CAPACITY) ? head - PROFILE_RING_CAPACITY : 0;
+	auto offset = events.size();
+	for (auto i = first; i < head; i++) {
+		auto& slot = mSlots[i & (PROFILE_RING_CAPACITY - 1)];
+		events.push_back({
+			slot.name.load(std::memory_order_relaxed),
+			slot.begin.load(std::memory_order_relaxed),
+			slot.end.load(std::memory_order_relaxed),
+			slot.frame.load(std::memory_order_relaxed)
+		});
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	auto newHead = mHead.load(std::memory_order_relaxed);
+	if (newHead >= first + PROFILE_RING_CAPACITY) {
+		auto overwritten = std::min(newHead - PROFILE_RING_CAPACITY + 1 - first, head - first);
+		events.erase(events.begin() + offset, events.begin() + offset + static_cast<size_t>(overwritten));
+	}
+}
+
+// a helper to read the monotonic system clock in nanoseconds.
+static uint64_t SystemNanoseconds()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+FrameProfiler::FrameProfiler() : mEnabled(true), mFrame(0), mCalibrationTicks(Now()), mCalibrationNanoseconds(SystemNanoseconds()), mGpuRing(PROFILE_GPU_THREAD_ID, "GPU")
+{
+}
+
+// ============================================================================
+// Get the profiler shared by all threads of the application.
+// ============================================================================
+FrameProfiler& FrameProfiler::Instance()
+{
+	static FrameProfiler profiler;
+	return profiler;
+}
+
+// ============================================================================
+// Get the current time of the profiling clock in ticks.
+//
+// Clock uses the processor time stamp counter where available as it is much
+// cheaper to read than the system clock. Ticks are converted on the export.
+// ============================================================================
+uint64_t FrameProfiler::Now()
+{
+#if defined(PROFILE_USE_TSC)
+	return __rdtsc();
+#else
+	return SystemNanoseconds();
+#endif
+}
+
+// ============================================================================
+// Get the amount of system clock nanoseconds per a profiling clock tick.
+//
+// The tick rate is derived from the time elapsed since the profiler creation
+// so the conversion gets more accurate the longer the application runs.
+// ============================================================================
+double FrameProfiler::NanosecondsPerTick() const
+{
+#if defined(PROFILE_USE_TSC)
+	auto elapsedTicks = static_cast<double>(Now() - mCalibrationTicks);
+	auto elapsedNanoseconds = static_cast<double>(SystemNanoseconds() - mCalibrationNanoseconds);
+	return (elapsedTicks > 0.0 && elapsedNanoseconds > 0.0) ? elapsedNanoseconds / elapsedTicks : 1.0;
+#else
+	return 1.0;
+#endif
+}
+
+// ============================================================================
+// Specify the name of the calling thread shown in the exported traces.
+// ============================================================================
+void FrameProfiler::SetThreadName(const char* name)
+{
+	auto& ring = ThreadRing();
+	std::lock_guard<std::mutex> lock(mMutex);
+	ring.SetThreadName(name);
+}
+
+// ============================================================================
+// Record a CPU event into the ring buffer of the calling thread.
+// ============================================================================
+void FrameProfiler::Record(const char* name, uint64_t begin, uint64_t end)
+{
+	ThreadRing().Push(name, begin, end, Frame());
+}
+
+// ============================================================================
+// Record a GPU event with the timestamps in system clock nanoseconds.
+//
+// GPU events are resolved later than the frame which recorded them, so the
+// frame is given explicitly. Events should be recorded from a single thread.
+// ============================================================================
+void FrameProfiler::RecordGpu(const char* name, uint64_t begin, uint64_t end, uint64_t frame)
+{
+	mGpuRing.Push(name, begin, end, frame);
+}
+
+// ============================================================================
+// Export the events of the last frames in the Chrome trace event format.
+//
+// The output can be loaded into chrome://tracing or Perfetto. Each thread is
+// shown as its own track while the GPU events are placed on a separate track.
+// ============================================================================
+std::string FrameProfiler::ExportChromeTrace(unsigned frameCount)
+{
+	auto lastFrame = Frame();
+	auto firstFrame = (lastFrame >= frameCount) ? lastFrame - frameCount + 1 : 0;
+
+	// a helper to convert the CPU timestamps into the system clock.
+	auto rate = NanosecondsPerTick();
+	auto toNanoseconds = [&](uint64_t ticks) {
+		auto offset = (static_cast<double>(ticks) - static_cast<double>(mCalibrationTicks)) * rate;
+		return static_cast<uint64_t>(static_cast<double>(mCalibrationNanoseconds) + offset);
+	};
+
+	std::string json = "{\"traceEvents\":[";
+	auto first = true;
+	std::vector<ProfileEvent> events;
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<const ProfileRing*> rings = { &mGpuRing };
+	for (auto& ring : mRings) {
+		rings.push_back(ring.get());
+	}
+	for (auto ring : rings) {
+		// name the track of the thread.
+		json += first ? "\n" : ",\n";
+		json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(ring->ThreadId()) + ",\"args\":{\"name\":";
+		AppendJsonString(json, ring->ThreadName().c_str());
+		json += "}}";
+		first = false;
+
+		// add the complete events of the requested frames.
+		events.clear();
+		ring->Snapshot(events);
+		for (auto& event : events) {
+			if (event.frame < firstFrame || event.frame > lastFrame) {
+				continue;
+			}
+			if (ring != &mGpuRing) {
+				event.begin = toNanoseconds(event.begin);
+				event.end = toNanoseconds(event.end);
+			}
+			char timing[128];
+			std::snprintf(timing, sizeof(timing), ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%llu}}", event.begin / 1000.0, (event.end - event.begin) / 1000.0, ring->ThreadId(), static_cast<unsigned long long>(event.frame));
+			json += ",\n{\"ph\":\"X\",\"cat\":";
+			json += (ring == &mGpuRing) ? "\"gpu\"" : "\"cpu\"";
+			json += ",\"name\":";
+			AppendJsonString(json, event.name);
+			json += timing;
+		}
+	}
+	json += "\n]}\n";
+	return json;
+}
+
+// ============================================================================
+// Get the ring buffer of the calling thread.
+//
+// The ring is created and registered when the thread records its first event
+// and it is kept alive with the profiler so the events survive the thread.
+// ============================================================================
+ProfileRing& FrameProfiler::ThreadRing()
+{
+	if (ThreadRingPointer == nullptr) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto threadId = static_cast<unsigned>(mRings.size()) + 1;
+		mRings.push_back(std::make_unique<ProfileRing>(threadId, "Thread " + std::to_string(threadId)));
+		ThreadRingPointer = mRings.back().get();
+	}
+	return *ThreadRingPointer;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// the amount of events stored in the ring buffer of each thread.
+#define PROFILE_RING_CAPACITY 8192
+
+// helpers to create unique names for the scope variables.
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// a macro to time the enclosing scope. Note that the name must be a literal.
+#if defined(DISABLE_FRAME_PROFILER)
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+// ============================================================================
+// A recorded profiling event with the timestamps in profiling clock ticks.
+// ============================================================================
+struct ProfileEvent
+{
+	const char*	name;
+	uint64_t	begin;
+	uint64_t	end;
+	uint64_t	frame;
+};
+
+// ============================================================================
+// A lock-free single producer ring buffer of profiling events.
+//
+// The owning thread overwrites the oldest events without any locking. Reader
+// takes a snapshot and drops events that were overwritten during the copy.
+// ============================================================================
+class ProfileRing
+{
+public:
+	ProfileRing(unsigned threadId, std::string threadName);
+	void Push(const char* name, uint64_t begin, uint64_t end, uint64_t frame);
+	void Snapshot(std::vector<ProfileEvent>& events) const;
+	unsigned ThreadId() const { return mThreadId; }
+	const std::string& ThreadName() const { return mThreadName; }
+	void SetThreadName(std::string name) { mThreadName = std::move(name); }
+private:
+	struct Slot
+	{
+		std::atomic<const char*>	name;
+		std::atomic<uint64_t>		begin;
+		std::atomic<uint64_t>		end;
+		std::atomic<uint64_t>		frame;
+	};
+	std::unique_ptr<Slot[]>	mSlots;
+	std::atomic<uint64_t>	mHead;
+	unsigned				mThreadId;
+	std::string				mThreadName;
+};
+
+// ============================================================================
+// A profiler that records timed scopes of the frames on every thread.
+//
+// Each thread writes into its own ring buffer so recording is lock-free. The
+// last frames can be exported in the Chrome trace event JSON format.
+// ============================================================================
+class FrameProfiler
+{
+public:
+	static FrameProfiler& Instance();
+	static uint64_t Now();
+	void SetEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+	bool IsEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+	void BeginFrame() { mFrame.fetch_add(1, std::memory_order_relaxed); }
+	uint64_t Frame() const { return mFrame.load(std::memory_order_relaxed); }
+	void SetThreadName(const char* name);
+	void Record(const char* name, uint64_t begin, uint64_t end);
+	void RecordGpu(const char* name, uint64_t begin, uint64_t end, uint64_t frame);
+	std::string ExportChromeTrace(unsigned frameCount);
+private:
+	FrameProfiler();
+	ProfileRing& ThreadRing();
+	double NanosecondsPerTick() const;
+private:
+	std::atomic<bool>							mEnabled;
+	std::atomic<uint64_t>						mFrame;
+	uint64_t									mCalibrationTicks;
+	uint64_t									mCalibrationNanoseconds;
+	std::mutex									mMutex;
+	std::vector<std::unique_ptr<ProfileRing>>	mRings;
+	ProfileRing									mGpuRing;
+};
+
+// ============================================================================
+// A scoped timer that records its lifetime into the frame profiler.
+// ============================================================================
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : mProfiler(FrameProfiler::Instance()), mName(name), mBegin(mProfiler.IsEnabled() ? FrameProfiler::Now() : 0) {}
+	~ProfileScope() { if (mBegin != 0) mProfiler.Record(mName, mBegin, FrameProfiler::Now()); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	FrameProfiler&	mProfiler;
+	const char*		mName;
+	uint64_t		mBegin;
+};
@@ -0,0 +1,172 @@
+#include "frustum_culling.h"
+
+#include <cmath>
+
+// use the SSE2 kernel on the x86 processors and the AVX2 kernel when it's enabled.
+#if defined(__AVX2__)
+#define FRUSTUM_CULLING_AVX2
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define FRUSTUM_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+// a helper to scale a plane so its normal has a unit length.
+static Plane NormalizePlane(const Plane& plane)
+{
+	auto length = std::sqrt(plane.normal[0] * plane.normal[0] + plane.normal[1] * plane.normal[1] + plane.normal[2] * plane.normal[2]);
+	if (length == 0.f) {
+		return plane;
+	}
+	return { { plane.normal[0] / length, plane.normal[1] / length, plane.normal[2] / length }, plane.distance / length };
+}
+
+// ============================================================================
+// Extract the frustum planes from a view projection matrix.
+//
+// The side planes and the far plane are the sums and the differences of the
+// fourth row with the other rows. The near plane of the D3D clip space is at
+// zero depth, so it's the third row alone.
+// ============================================================================
+Frustum Frustum::FromMatrix(const std::array<float, 16>& m)
+{
+	// a helper to add a scaled row of the matrix into another row.
+	auto combine = [&](int row, float scale, int other) {
+		Plane plane = { { m[row * 4] + scale * m[other * 4], m[row * 4 + 1] + scale * m[other * 4 + 1], m[row * 4 + 2] + scale * m[other * 4 + 2] }, m[row * 4 + 3] + scale * m[other * 4 + 3] };
+		return NormalizePlane(plane);
+	};
+	Frustum frustum;
+	frustum.planes = { { combine(3, 1.f, 0), combine(3, -1.f, 0), combine(3, 1.f, 1), combine(3, -1.f, 1), combine(2, 0.f, 2), combine(3, -1.f, 2) } };
+	return frustum;
+}
+
+// ============================================================================
+// Change the amount of the stored boxes.
+// ============================================================================
+void SoaBounds::Resize(size_t size)
+{
+	mCenterX.resize(size);
+	mCenterY.resize(size);
+	mCenterZ.resize(size);
+	mExtentX.resize(size);
+	mExtentY.resize(size);
+	mExtentZ.resize(size);
+}
+
+// ============================================================================
+// Store a box as its center and its half extents.
+// ============================================================================
+void SoaBounds::Set(size_t index, const Aabb& bounds)
+{
+	mCenterX[index] = (bounds.minimum[0] + bounds.maximum[0]) * 0.5f;
+	mCenterY[index] = (bounds.minimum[1] + bounds.maximum[1]) * 0.5f;
+	mCenterZ[index] = (bounds.minimum[2] + bounds.maximum[2]) * 0.5f;
+	mExtentX[index] = (bounds.maximum[0] - bounds.minimum[0]) * 0.5f;
+	mExtentY[index] = (bounds.maximum[1] - bounds.minimum[1]) * 0.5f;
+	mExtentZ[index] = (bounds.maximum[2] - bounds.minimum[2]) * 0.5f;
+}
+
+// ============================================================================
+// Get a stored box as its minimum and maximum corners.
+// ============================================================================
+Aabb SoaBounds::Get(size_t index) const
+{
+	return {
+		{ mCenterX[index] - mExtentX[index], mCenterY[index] - mExtentY[index], mCenterZ[index] - mExtentZ[index] },
+		{ mCenterX[index] + mExtentX[index], mCenterY[index] + mExtentY[index], mCenterZ[index] + mExtentZ[index] }
+	};
+}
+
+// ============================================================================
+// Test the boxes one by one against the planes of a frustum.
+//
+// A box is outside of a plane when the signed distance of its center plus
+// its projected radius is negative. The vector kernels evaluate the same
+// expressions in the same order so they round exactly the same way.
+// ============================================================================
+size_t CullBoundsScalar(const SoaBounds& bounds, size_t begin, size_t end, const Frustum& frustum, unsigned planeMask, const uint32_t* ids, uint32_t* visible)
+{
+	size_t count = 0;
+	for (auto i = begin; i < end; i++) {
+		auto inside = true;
+		for (auto p = 0; p < 6 && inside; p++) {
+			if ((planeMask & (1u << p)) == 0) {
+				continue;
+			}
+			auto& plane = frustum.planes[p];
+			auto distance = plane.normal[0] * bounds.CenterX()[i] + plane.normal[1] * bounds.CenterY()[i] + plane.normal[2] * bounds.CenterZ()[i] + plane.distance;
+			auto radius = std::fabs(plane.normal[0]) * bounds.ExtentX()[i] + std::fabs(plane.normal[1]) * bounds.ExtentY()[i] + std::fabs(plane.normal[2]) * bounds.ExtentZ()[i];
+			inside = (distance + radius >= 0.f);
+		}
+		if (inside) {
+			visible[count++] = ids ? ids[static_cast<uint32_t>(i)] : static_cast<uint32_t>(i);
+		}
+	}
+	return count;
+}
+
+// a helper to write out the boxes of a vector whose bits are set in the mask.
+static size_t WriteVisible(unsigned mask, size_t first, const uint32_t* ids, uint32_t* visible)
+{
+	size_t count = 0;
+	for (auto lane = 0u; mask != 0; lane++, mask >>= 1) {
+		if (mask & 1) {
+			auto index = static_cast<uint32_t>(first + lane);
+			visible[count++] = ids ? ids[index] : index;
+		}
+	}
+	return count;
+}
+
+// ============================================================================
+// Test the boxes against the planes of a frustum with vector instructions.
+//
+// Each iteration tests a full vector of boxes, accumulates a mask of the
+// boxes outside any plane and writes out the rest. The remaining boxes at
+// the end of the range are tested with the scalar reference.
+// ============================================================================
+size_t CullBounds(const SoaBounds& bounds, size_t begin, size_t end, const Frustum& frustum, unsigned planeMask, const uint32_t* ids, uint32_t* visible)
+{
+	size_t count = 0;
+	auto i = begin;
+#if defined(FRUSTUM_CULLING_AVX2)
+	const size_t width = 8;
+	auto signMask = _mm256_set1_ps(-0.f);
+	for (; i + width <= end; i += width) {
+		auto centerX = _mm256_loadu_ps(bounds.CenterX() + i), centerY = _mm256_loadu_ps(bounds.CenterY() + i), centerZ = _mm256_loadu_ps(bounds.CenterZ() + i);
+		auto extentX = _mm256_loadu_ps(bounds.ExtentX() + i), extentY = _mm256_loadu_ps(bounds.ExtentY() + i), extentZ = _mm256_loadu_ps(bounds.ExtentZ() + i);
+		auto outside = _mm256_setzero_ps();
+		for (auto p = 0; p < 6; p++) {
+			if ((planeMask & (1u << p)) == 0) {
+				continue;
+			}
+			auto& plane = frustum.planes[p];
+			auto normalX = _mm256_set1_ps(plane.normal[0]), normalY = _mm256_set1_ps(plane.normal[1]), normalZ = _mm256_set1_ps(plane.normal[2]);
+			auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX, centerX), _mm256_mul_ps(normalY, centerY)), _mm256_mul_ps(normalZ, centerZ)), _mm256_set1_ps(plane.distance));
+			auto radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, normalX), extentX), _mm256_mul_ps(_mm256_andnot_ps(signMask, normalY), extentY)), _mm256_mul_ps(_mm256_andnot_ps(signMask, normalZ), extentZ));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		count += WriteVisible(~static_cast<unsigned>(_mm256_movemask_ps(outside)) & 0xffu, i, ids, visible + count);
+	}
+#elif defined(FRUSTUM_CULLING_SSE2)
+	const size_t width = 4;
+	auto signMask = _mm_set1_ps(-0.f);
+	for (; i + width <= end; i += width) {
+		auto centerX = _mm_loadu_ps(bounds.CenterX() + i), centerY = _mm_loadu_ps(bounds.CenterY() + i), centerZ = _mm_loadu_ps(bounds.CenterZ() + i);
+		auto extentX = _mm_loadu_ps(bounds.ExtentX() + i), extentY = _mm_loadu_ps(bounds.ExtentY() + i), extentZ = _mm_loadu_ps(bounds.ExtentZ() + i);
+		auto outside = _mm_setzero_ps();
+		for (auto p = 0; p < 6; p++) {
+			if ((planeMask & (1u << p)) == 0) {
+				continue;
+			}
+			auto& plane = frustum.planes[p];
+			auto normalX = _mm_set1_ps(plane.normal[0]), normalY = _mm_set1_ps(plane.normal[1]), normalZ = _mm_set1_ps(plane.normal[2]);
+			auto distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)), _mm_mul_ps(normalZ, centerZ)), _mm_set1_ps(plane.distance));
+			auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, normalX), extentX), _mm_mul_ps(_mm_andnot_ps(signMask, normalY), extentY)), _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+		count += WriteVisible(~static_cast<unsigned>(_mm_movemask_ps(outside)) & 0xfu, i, ids, visible + count);
+	}
+#endif
+	return count + CullBoundsScalar(bounds, i, end, frustum, planeMask, ids, visible + count);
+}
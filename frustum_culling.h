@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// An axis aligned bounding box.
+// ============================================================================
+struct Aabb
+{
+	std::array<float, 3>	minimum;
+	std::array<float, 3>	maximum;
+};
+
+// ============================================================================
+// A plane where the points with a non-negative distance are on the inside.
+// ============================================================================
+struct Plane
+{
+	float	normal[3];
+	float	distance;
+};
+
+// ============================================================================
+// The six planes of a view frustum.
+//
+// The planes are extracted from a row-major view projection matrix, which
+// transforms column vectors into the D3D clip space with a 0 to w depth.
+// ============================================================================
+struct Frustum
+{
+	std::array<Plane, 6>	planes;
+
+	static Frustum FromMatrix(const std::array<float, 16>& viewProjection);
+};
+
+// ============================================================================
+// Bounding boxes stored as separate arrays of centers and extents.
+//
+// The structure of arrays layout allows the culling kernels to test several
+// boxes against a plane with a single vector instruction per component.
+// ============================================================================
+class SoaBounds
+{
+public:
+	size_t Size() const { return mCenterX.size(); }
+	void Resize(size_t size);
+	void Set(size_t index, const Aabb& bounds);
+	Aabb Get(size_t index) const;
+	const float* CenterX() const { return mCenterX.data(); }
+	const float* CenterY() const { return mCenterY.data(); }
+	const float* CenterZ() const { return mCenterZ.data(); }
+	const float* ExtentX() const { return mExtentX.data(); }
+	const float* ExtentY() const { return mExtentY.data(); }
+	const float* ExtentZ() const { return mExtentZ.data(); }
+private:
+	std::vector<float>	mCenterX;
+	std::vector<float>	mCenterY;
+	std::vector<float>	mCenterZ;
+	std::vector<float>	mExtentX;
+	std::vector<float>	mExtentY;
+	std::vector<float>	mExtentZ;
+};
+
+// the mask of all the planes of a frustum.
+#define FRUSTUM_ALL_PLANES 0x3fu
+
+// ============================================================================
+// Test a range of boxes against the planes of a frustum.
+//
+// A box is visible unless it is completely outside of one of the planes in
+// the plane mask. The identifiers of the visible boxes, or their indices when
+// no identifiers are given, are written into the output in order and their
+// amount is returned. The kernels use AVX2 or SSE2 where available and give
+// exactly the same results as the scalar reference.
+// ============================================================================
+size_t CullBounds(const SoaBounds& bounds, size_t begin, size_t end, const Frustum& frustum, unsigned planeMask, const uint32_t* ids, uint32_t* visible);
+size_t CullBoundsScalar(const SoaBounds& bounds, size_t begin, size_t end, const Frustum& frustum, unsigned planeMask, const uint32_t* ids, uint32_t* visible);
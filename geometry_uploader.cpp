@@ -0,0 +1,59 @@
+#include "geometry_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// the alignment of the copies within the staging buffer.
+#define STAGING_ALIGNMENT 16
+
+GeometryUploader::GeometryUploader(CopyQueue& queue, uint64_t batchSize) : mQueue(queue), mStaging(queue.Timeline(), queue.StagingMemory(), 0, queue.StagingSize()), mBatchSize(batchSize), mBatchBytes(0), mLastFence(0), mBatchCount(0)
+{
+	// a batch may wrap around the end of the ring, so it can take twice its size.
+	if (batchSize == 0 || 2 * (batchSize + STAGING_ALIGNMENT) > queue.StagingSize()) {
+		throw std::invalid_argument("batch size must fit twice into the staging buffer");
+	}
+}
+
+// ============================================================================
+// Queue data to be copied into the destination buffer.
+//
+// Data larger than the batch size is split into several copies. The current
+// batch is submitted whenever the next copy would make it exceed the batch
+// size, so the staging buffer is never asked for more than it can hold.
+// ============================================================================
+void GeometryUploader::Upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (uint64_t offset = 0; offset < size;) {
+		if (mBatchBytes >= mBatchSize) {
+			Flush();
+		}
+		auto chunkSize = std::min(size - offset, mBatchSize - mBatchBytes);
+		auto staging = mStaging.Allocate(chunkSize, STAGING_ALIGNMENT);
+		std::memcpy(staging.cpuAddress, bytes + offset, static_cast<size_t>(chunkSize));
+		mCopies.push_back({ destination, destinationOffset + offset, staging.offset, chunkSize });
+		mBatchBytes += (chunkSize + STAGING_ALIGNMENT - 1) & ~static_cast<uint64_t>(STAGING_ALIGNMENT - 1);
+		offset += chunkSize;
+	}
+}
+
+// ============================================================================
+// Submit the pending copies as a single batch into the copy queue.
+//
+// Returns the fence value after which all the data uploaded so far is on the
+// GPU. Staging memory of the batch is reused once the copy queue passes it.
+// ============================================================================
+uint64_t GeometryUploader::Flush()
+{
+	if (mCopies.empty()) {
+		return mLastFence;
+	}
+	mStaging.Reclaim();
+	mLastFence = mQueue.Submit(mCopies);
+	mStaging.EndFrame(mLastFence);
+	mCopies.clear();
+	mBatchBytes = 0;
+	mBatchCount++;
+	return mLastFence;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "copy_queue.h"
+#include "upload_ring.h"
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// An uploader that copies static geometry to the GPU through a copy queue.
+//
+// Data is written into the staging buffer of the queue right away, while the
+// copies are collected into batches that are submitted together. Consumers
+// wait the fence of the last batch on the GPU instead of blocking the CPU.
+// ============================================================================
+class GeometryUploader
+{
+public:
+	GeometryUploader(CopyQueue& queue, uint64_t batchSize);
+	void Upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t size);
+	uint64_t Flush();
+	uint64_t LastFence() const { return mLastFence; }
+	unsigned BatchCount() const { return mBatchCount; }
+private:
+	CopyQueue&					mQueue;
+	UploadRing					mStaging;
+	uint64_t					mBatchSize;
+	uint64_t					mBatchBytes;
+	std::vector<CopyCommand>	mCopies;
+	uint64_t					mLastFence;
+	unsigned					mBatchCount;
+};
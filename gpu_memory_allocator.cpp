@@ -0,0 +1,221 @@
+#include "gpu_memory_allocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+GpuMemoryAllocator::GpuMemoryAllocator(GpuHeapFactory& factory, uint64_t blockSize) : mFactory(factory), mBlockSize(blockSize)
+{
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+	for (auto& pool : mPools) {
+		for (auto& block : pool) {
+			if (block.heap != nullptr) {
+				mFactory.DestroyHeap(block.heap);
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Reserve a range for a placed resource with the given size and alignment.
+//
+// The existing blocks of the pool are tried in order before a new block is
+// created. Released blocks keep their slot, so the block index of the live
+// allocations never changes. Heap creation errors are thrown by the factory.
+// ============================================================================
+GpuAllocation GpuMemoryAllocator::Allocate(HeapType heapType, ResourceClass resourceClass, uint64_t size, uint64_t alignment)
+{
+	auto& pool = PoolOf(heapType, resourceClass);
+	GpuAllocation allocation = { nullptr, 0, 0, heapType, resourceClass, 0 };
+	for (uint32_t block = 0; block < pool.size(); block++) {
+		if (TryAllocate(pool, block, size, alignment, allocation)) {
+			return allocation;
+		}
+	}
+
+	// reserve a new block, which is larger than the block size for large allocations. The size
+	// is rounded to the allocation granularity of the block allocator, so the allocation fits.
+	auto granularity = std::max<uint64_t>(alignment, TLSF_MIN_BLOCK_SIZE);
+	auto blockSize = (std::max(mBlockSize, size) + granularity - 1) & ~(granularity - 1);
+	auto slot = std::find_if(pool.begin(), pool.end(), [](const Block& block) { return block.heap == nullptr; });
+	if (slot == pool.end()) {
+		slot = pool.insert(pool.end(), Block());
+	}
+	slot->allocator = std::make_unique<TlsfAllocator>(blockSize);
+	slot->heap = mFactory.CreateHeap(heapType, resourceClass, blockSize);
+	if (!TryAllocate(pool, static_cast<uint32_t>(slot - pool.begin()), size, alignment, allocation)) {
+		throw std::bad_alloc();
+	}
+	return allocation;
+}
+
+// ============================================================================
+// Free a range of a placed resource that has been released.
+//
+// The block is kept even if it becomes empty. Empty blocks are released with
+// the ReleaseEmptyBlocks() at a suitable moment, e.g. when over the budget.
+// ============================================================================
+void GpuMemoryAllocator::Free(const GpuAllocation& allocation)
+{
+	auto& pool = PoolOf(allocation.heapType, allocation.resourceClass);
+	pool[allocation.block].allocator->Free(allocation.offset);
+}
+
+// ============================================================================
+// Move allocations out of the least used blocks into the more used blocks.
+//
+// The callback gets the old and the new range of each move. It should create
+// the placed resource into the new range, record a copy out of the old range
+// and update its own references, or return false to reject the move. The old
+// ranges are retired with the fence value the caller signals after the copies
+// and freed by ReleaseRetired() once the GPU has completed it, so the copies
+// never read a range that has been handed out again. Moves stop when the given
+// amount of bytes has been moved. Returns the amount of moves.
+// ============================================================================
+unsigned GpuMemoryAllocator::Defragment(HeapType heapType, ResourceClass resourceClass, uint64_t maxBytes, uint64_t fenceValue, const MoveCallback& move)
+{
+	// order the blocks so that the least used blocks are evacuated first.
+	auto& pool = PoolOf(heapType, resourceClass);
+	std::vector<uint32_t> order;
+	for (uint32_t block = 0; block < pool.size(); block++) {
+		if (pool[block].heap != nullptr && pool[block].allocator->AllocationCount() != 0) {
+			order.push_back(block);
+		}
+	}
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return pool[a].allocator->UsedBytes() < pool[b].allocator->UsedBytes(); });
+
+	// move the allocations of the less used half into the more used blocks. The ranges that
+	// are already retired by an earlier pass stay where they are until their fence completes.
+	unsigned moveCount = 0;
+	uint64_t movedBytes = 0;
+	for (size_t source = 0; source < order.size() / 2; source++) {
+		auto& sourceBlock = pool[order[source]];
+		for (auto& range : sourceBlock.allocator->Allocations()) {
+			GpuAllocation from = { sourceBlock.heap, range.offset, range.size, heapType, resourceClass, order[source] };
+			if (IsRetired(from)) {
+				continue;
+			}
+			if (movedBytes + range.size > maxBytes) {
+				return moveCount;
+			}
+			GpuAllocation to = {};
+			auto found = false;
+			for (auto target = order.size() - 1; target > source && !found; target--) {
+				found = TryAllocate(pool, order[target], range.size, range.alignment, to);
+			}
+			if (!found) {
+				continue;
+			}
+			if (move(from, to)) {
+				mRetired.push_back({ fenceValue, from });
+				moveCount++;
+				movedBytes += range.size;
+			} else {
+				Free(to);
+			}
+		}
+	}
+	return moveCount;
+}
+
+// ============================================================================
+// Free the ranges moved away by Defragment() whose copies the GPU completed.
+//
+// The fence values of the passes are expected to increase like the frames.
+// ============================================================================
+void GpuMemoryAllocator::ReleaseRetired(uint64_t completedValue)
+{
+	while (!mRetired.empty() && mRetired.front().fenceValue <= completedValue) {
+		Free(mRetired.front().allocation);
+		mRetired.pop_front();
+	}
+}
+
+// ============================================================================
+// Release the heaps of the blocks that have no allocations.
+// ============================================================================
+void GpuMemoryAllocator::ReleaseEmptyBlocks()
+{
+	for (auto& pool : mPools) {
+		for (auto& block : pool) {
+			if (block.heap != nullptr && block.allocator->AllocationCount() == 0) {
+				mFactory.DestroyHeap(block.heap);
+				block.heap = nullptr;
+				block.allocator = nullptr;
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Get the usage statistics of all the blocks of the given heap type.
+// ============================================================================
+HeapStatistics GpuMemoryAllocator::Statistics(HeapType heapType) const
+{
+	HeapStatistics statistics = {};
+	for (auto resourceClass = 0; resourceClass < RESOURCE_CLASS_COUNT; resourceClass++) {
+		for (auto& block : mPools[static_cast<int>(heapType) * RESOURCE_CLASS_COUNT + resourceClass]) {
+			if (block.heap == nullptr) {
+				continue;
+			}
+			statistics.blockCount++;
+			statistics.allocationCount += block.allocator->AllocationCount();
+			statistics.reservedBytes += block.allocator->Size();
+			statistics.usedBytes += block.allocator->UsedBytes();
+			statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, block.allocator->LargestFreeBlock());
+		}
+	}
+	return statistics;
+}
+
+// ============================================================================
+// Get the pool of the blocks for a heap type and a resource class.
+// ============================================================================
+GpuMemoryAllocator::Pool& GpuMemoryAllocator::PoolOf(HeapType heapType, ResourceClass resourceClass)
+{
+	return mPools[static_cast<int>(heapType) * RESOURCE_CLASS_COUNT + static_cast<int>(resourceClass)];
+}
+
+// ============================================================================
+// Try to allocate a range from the given block of a pool.
+// ============================================================================
+bool GpuMemoryAllocator::TryAllocate(Pool& pool, uint32_t block, uint64_t size, uint64_t alignment, GpuAllocation& allocation)
+{
+	uint64_t offset = 0;
+	if (pool[block].heap == nullptr || !pool[block].allocator->Allocate(size, alignment, offset)) {
+		return false;
+	}
+	auto poolIndex = static_cast<int>(&pool - &mPools[0]);
+	auto heapType = static_cast<HeapType>(poolIndex / RESOURCE_CLASS_COUNT);
+	auto resourceClass = static_cast<ResourceClass>(poolIndex % RESOURCE_CLASS_COUNT);
+	allocation = { pool[block].heap, offset, size, heapType, resourceClass, block };
+	return true;
+}
+
+// ============================================================================
+// Check whether a range waits for the fence of its copy to be freed.
+// ============================================================================
+bool GpuMemoryAllocator::IsRetired(const GpuAllocation& allocation) const
+{
+	return std::any_of(mRetired.begin(), mRetired.end(), [&](const RetiredAllocation& retired) {
+		return retired.allocation.heapType == allocation.heapType && retired.allocation.resourceClass == allocation.resourceClass &&
+			retired.allocation.block == allocation.block && retired.allocation.offset == allocation.offset;
+	});
+}
+
+// ============================================================================
+// Get the heaps of all the blocks, e.g. to evict them from the video memory.
+// ============================================================================
+void GpuMemoryAllocator::Heaps(std::vector<void*>& heaps) const
+{
+	heaps.clear();
+	for (auto& pool : mPools) {
+		for (auto& block : pool) {
+			if (block.heap != nullptr) {
+				heaps.push_back(block.heap);
+			}
+		}
+	}
+}
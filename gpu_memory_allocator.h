@@ -0,0 +1,104 @@
+#pragma once
+
+#include "tlsf_allocator.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// the amount of heap types and resource classes the allocator keeps apart.
+#define HEAP_TYPE_COUNT 3
+#define RESOURCE_CLASS_COUNT 3
+
+// ============================================================================
+// The memory types of the GPU heaps.
+// ============================================================================
+enum class HeapType : uint8_t { Default, Upload, Readback };
+
+// ============================================================================
+// The classes of resources that may not share a heap on every hardware tier.
+// ============================================================================
+enum class ResourceClass : uint8_t { Buffer, Texture, RenderTarget };
+
+// ============================================================================
+// A range of a GPU heap reserved for a placed resource.
+//
+// Heap is an opaque handle of the backend (e.g. an ID3D12Heap*).
+// ============================================================================
+struct GpuAllocation
+{
+	void*			heap;
+	uint64_t		offset;
+	uint64_t		size;
+	HeapType		heapType;
+	ResourceClass	resourceClass;
+	uint32_t		block;
+};
+
+// ============================================================================
+// Usage statistics of the heaps of a single heap type.
+// ============================================================================
+struct HeapStatistics
+{
+	unsigned	blockCount;
+	unsigned	allocationCount;
+	uint64_t	reservedBytes;
+	uint64_t	usedBytes;
+	uint64_t	largestFreeBlock;
+};
+
+// ============================================================================
+// An interface for the devices that create the heaps for the allocator.
+// ============================================================================
+class GpuHeapFactory
+{
+public:
+	virtual ~GpuHeapFactory() = default;
+	virtual void* CreateHeap(HeapType heapType, ResourceClass resourceClass, uint64_t size) = 0;
+	virtual void DestroyHeap(void* heap) = 0;
+};
+
+// ============================================================================
+// A sub-allocator of placed resources within large GPU heap blocks.
+//
+// Blocks are reserved per heap type and resource class and each block is
+// sub-allocated with a TLSF allocator. Allocations that do not fit into a
+// block size get a dedicated block of their own. Ranges that are moved away
+// are retired with a fence and freed once the GPU has completed the fence.
+// ============================================================================
+class GpuMemoryAllocator
+{
+public:
+	typedef std::function<bool(const GpuAllocation& from, const GpuAllocation& to)> MoveCallback;
+	GpuMemoryAllocator(GpuHeapFactory& factory, uint64_t blockSize);
+	~GpuMemoryAllocator();
+	GpuAllocation Allocate(HeapType heapType, ResourceClass resourceClass, uint64_t size, uint64_t alignment);
+	void Free(const GpuAllocation& allocation);
+	unsigned Defragment(HeapType heapType, ResourceClass resourceClass, uint64_t maxBytes, uint64_t fenceValue, const MoveCallback& move);
+	void ReleaseRetired(uint64_t completedValue);
+	void ReleaseEmptyBlocks();
+	HeapStatistics Statistics(HeapType heapType) const;
+	void Heaps(std::vector<void*>& heaps) const;
+private:
+	struct Block
+	{
+		void*							heap;
+		std::unique_ptr<TlsfAllocator>	allocator;
+	};
+	struct RetiredAllocation
+	{
+		uint64_t		fenceValue;
+		GpuAllocation	allocation;
+	};
+	typedef std::vector<Block> Pool;
+	Pool& PoolOf(HeapType heapType, ResourceClass resourceClass);
+	bool TryAllocate(Pool& pool, uint32_t block, uint64_t size, uint64_t alignment, GpuAllocation& allocation);
+	bool IsRetired(const GpuAllocation& allocation) const;
+private:
+	GpuHeapFactory&					mFactory;
+	uint64_t						mBlockSize;
+	Pool							mPools[HEAP_TYPE_COUNT * RESOURCE_CLASS_COUNT];
+	std::deque<RetiredAllocation>	mRetired;
+};
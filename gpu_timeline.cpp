@@ -0,0 +1,58 @@
+#include "gpu_timeline.h"
+
+#include <stdexcept>
+
+SimulatedTimeline::SimulatedTimeline() : mSignaledValue(0), mCompletedValue(0), mStallCount(0)
+{
+}
+
+// ============================================================================
+// Queue a new signal at the end of the simulated GPU queue.
+//
+// The returned value becomes completed when the simulated GPU reaches it. All
+// values are strictly increasing so they can be compared like real fences.
+// ============================================================================
+uint64_t SimulatedTimeline::Signal()
+{
+	mPending.push_back(++mSignaledValue);
+	return mSignaledValue;
+}
+
+// ============================================================================
+// Get the last value the simulated GPU has completed.
+// ============================================================================
+uint64_t SimulatedTimeline::CompletedValue()
+{
+	return mCompletedValue;
+}
+
+// ============================================================================
+// Block until the simulated GPU has completed the given value.
+//
+// As there is no real GPU behind the timeline, blocking simply completes the
+// pending signals up to the given value and counts the event as a CPU stall.
+// ============================================================================
+void SimulatedTimeline::Wait(uint64_t value)
+{
+	if (value > mSignaledValue) {
+		throw std::logic_error("waiting for a value that has not been signaled");
+	}
+	if (mCompletedValue >= value) {
+		return;
+	}
+	mStallCount++;
+	while (mCompletedValue < value) {
+		Advance();
+	}
+}
+
+// ============================================================================
+// Let the simulated GPU complete the given amount of pending signals.
+// ============================================================================
+void SimulatedTimeline::Advance(unsigned count)
+{
+	for (auto i = 0u; i < count && !mPending.empty(); i++) {
+		mCompletedValue = mPending.front();
+		mPending.pop_front();
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// ============================================================================
+// An interface for a monotonic CPU<->GPU synchronization timeline.
+//
+// Timeline abstracts a fence that the GPU signals after the submitted work. It
+// allows frame pacing logic to be used and tested without any graphics API.
+// ============================================================================
+class GpuTimeline
+{
+public:
+	virtual ~GpuTimeline() = default;
+	virtual uint64_t Signal() = 0;
+	virtual uint64_t CompletedValue() = 0;
+	virtual void Wait(uint64_t value) = 0;
+};
+
+// ============================================================================
+// A timeline that simulates the progress of an asynchronous GPU queue.
+//
+// Signals are queued in submission order and completed only when explicitly
+// advanced or when the CPU blocks on them, which is then counted as a stall.
+// ============================================================================
+class SimulatedTimeline : public GpuTimeline
+{
+public:
+	SimulatedTimeline();
+	uint64_t Signal() override;
+	uint64_t CompletedValue() override;
+	void Wait(uint64_t value) override;
+	void Advance(unsigned count = 1);
+	std::size_t PendingCount() const { return mPending.size(); }
+	uint64_t SignaledValue() const { return mSignaledValue; }
+	unsigned StallCount() const { return mStallCount; }
+private:
+	std::deque<uint64_t>	mPending;
+	uint64_t				mSignaledValue;
+	uint64_t				mCompletedValue;
+	unsigned				mStallCount;
+};
@@ -0,0 +1,140 @@
+#include "instance_batcher.h"
+
+#include <cstring>
+#include <stdexcept>
+
+// the amount of bits sorted by a single pass of the radix sort.
+const unsigned RadixBits = 8;
+const unsigned RadixPassCount = (BATCH_PIPELINE_BITS + BATCH_GEOMETRY_BITS + RadixBits - 1) / RadixBits;
+
+InstanceBatcher::InstanceBatcher() : mPipelineChangeCount(0), mGeometryChangeCount(0)
+{
+}
+
+// ============================================================================
+// Get the sort key of a pipeline and geometry pair.
+// ============================================================================
+uint32_t InstanceBatcher::SortKey(uint32_t pipeline, uint32_t geometry)
+{
+	if (pipeline >= (1u << BATCH_PIPELINE_BITS) || geometry >= (1u << BATCH_GEOMETRY_BITS)) {
+		throw std::out_of_range("pipeline or geometry identifier does not fit into the batch sort key");
+	}
+	return (pipeline << BATCH_GEOMETRY_BITS) | geometry;
+}
+
+// ============================================================================
+// Remove the submissions and the batches of the previous frame.
+// ============================================================================
+void InstanceBatcher::Reset()
+{
+	mKeys.clear();
+	for (auto& stream : mSubmitted) {
+		stream.clear();
+	}
+	mBatches.clear();
+	mPipelineChangeCount = 0;
+	mGeometryChangeCount = 0;
+}
+
+// ============================================================================
+// Reserve the memory for the given amount of submissions.
+// ============================================================================
+void InstanceBatcher::Reserve(size_t instanceCount)
+{
+	mKeys.reserve(instanceCount);
+	mSortedKeys.reserve(instanceCount);
+	for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+		mSubmitted[i].reserve(instanceCount);
+		mPacked[i].reserve(instanceCount);
+	}
+}
+
+// ============================================================================
+// Submit an instance of a geometry drawn with a pipeline.
+//
+// The key holds the sort key in the high bits and the submission index in
+// the low bits, which is where the instance data is stored until the build.
+// ============================================================================
+void InstanceBatcher::Submit(uint32_t pipeline, uint32_t geometry, const InstanceData& instance)
+{
+	auto index = static_cast<uint64_t>(mKeys.size());
+	mKeys.push_back((static_cast<uint64_t>(SortKey(pipeline, geometry)) << 32) | index);
+	uint32_t values[INSTANCE_STREAM_COUNT];
+	std::memcpy(&values[0], &instance.offset[0], sizeof(float));
+	std::memcpy(&values[1], &instance.offset[1], sizeof(float));
+	std::memcpy(&values[2], &instance.scale, sizeof(float));
+	std::memcpy(&values[3], &instance.rotation, sizeof(float));
+	values[4] = instance.color;
+	for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+		mSubmitted[i].push_back(values[i]);
+	}
+}
+
+// ============================================================================
+// Sort the submissions, pack the instance data and build the batches.
+// ============================================================================
+void InstanceBatcher::Build()
+{
+	SortKeys();
+
+	// gather the instance data of each stream in the sorted order.
+	auto count = mKeys.size();
+	for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+		auto source = mSubmitted[i].data();
+		mPacked[i].resize(count);
+		auto destination = mPacked[i].data();
+		for (size_t j = 0; j < count; j++) {
+			destination[j] = source[static_cast<uint32_t>(mKeys[j])];
+		}
+	}
+
+	// start a new batch whenever the sort key changes.
+	mBatches.clear();
+	for (size_t i = 0; i < count; i++) {
+		auto key = static_cast<uint32_t>(mKeys[i] >> 32);
+		if (i == 0 || key != static_cast<uint32_t>(mKeys[i - 1] >> 32)) {
+			InstanceBatch batch = { key >> BATCH_GEOMETRY_BITS, key & ((1u << BATCH_GEOMETRY_BITS) - 1), static_cast<uint32_t>(i), 0 };
+			mPipelineChangeCount += (mBatches.empty() || mBatches.back().pipeline != batch.pipeline) ? 1 : 0;
+			mGeometryChangeCount += (mBatches.empty() || mBatches.back().geometry != batch.geometry) ? 1 : 0;
+			mBatches.push_back(batch);
+		}
+		mBatches.back().instanceCount++;
+	}
+}
+
+// ============================================================================
+// Sort the keys by the sort key with a stable LSD radix sort.
+//
+// The histograms of all the passes are counted in a single pass over the
+// keys. Passes where every key has the same digit are skipped, which is the
+// common case for the high digits with only a few pipelines in use.
+// ============================================================================
+void InstanceBatcher::SortKeys()
+{
+	auto count = mKeys.size();
+	uint32_t histograms[RadixPassCount][1 << RadixBits] = {};
+	for (auto key : mKeys) {
+		auto sortKey = static_cast<uint32_t>(key >> 32);
+		for (auto pass = 0u; pass < RadixPassCount; pass++) {
+			histograms[pass][(sortKey >> (pass * RadixBits)) & ((1 << RadixBits) - 1)]++;
+		}
+	}
+	mSortedKeys.resize(count);
+	for (auto pass = 0u; pass < RadixPassCount; pass++) {
+		auto& histogram = histograms[pass];
+		auto shift = 32 + pass * RadixBits;
+		if (count == 0 || histogram[(mKeys[0] >> shift) & ((1 << RadixBits) - 1)] == count) {
+			continue;
+		}
+		uint32_t offsets[1 << RadixBits];
+		uint32_t offset = 0;
+		for (auto digit = 0u; digit < (1u << RadixBits); digit++) {
+			offsets[digit] = offset;
+			offset += histogram[digit];
+		}
+		for (auto key : mKeys) {
+			mSortedKeys[offsets[(key >> shift) & ((1 << RadixBits) - 1)]++] = key;
+		}
+		mKeys.swap(mSortedKeys);
+	}
+}
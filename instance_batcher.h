@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the amount of bits of the pipeline and the geometry identifiers in the sort key.
+#define BATCH_PIPELINE_BITS 12
+#define BATCH_GEOMETRY_BITS 20
+
+// the amount of the packed per-instance data streams.
+#define INSTANCE_STREAM_COUNT 5
+
+// ============================================================================
+// The per-instance data of a submitted draw.
+//
+// The offset, scale and rotation place the geometry in the view, and the
+// color is an RGBA8 tint multiplied with the vertex colors.
+// ============================================================================
+struct InstanceData
+{
+	float		offset[2];
+	float		scale;
+	float		rotation;
+	uint32_t	color;
+};
+
+// ============================================================================
+// The streams of the packed instance data, each with 32 bits per instance.
+// ============================================================================
+enum class InstanceStream : unsigned
+{
+	OffsetX,
+	OffsetY,
+	Scale,
+	Rotation,
+	Color
+};
+
+// ============================================================================
+// A range of the packed instances drawn with a single instanced draw.
+// ============================================================================
+struct InstanceBatch
+{
+	uint32_t	pipeline;
+	uint32_t	geometry;
+	uint32_t	firstInstance;
+	uint32_t	instanceCount;
+};
+
+// ============================================================================
+// A batcher that merges the draw submissions into instanced draws.
+//
+// Submissions are sorted by a key with the pipeline in the highest bits and
+// the geometry below it, so the pipeline changes least often and then the
+// geometry. Sorting is a stable radix sort, which keeps the submission order
+// within a batch. The instance data is then gathered in the sorted order into
+// separate streams, so each batch is a contiguous range of every stream.
+// ============================================================================
+class InstanceBatcher
+{
+public:
+	InstanceBatcher();
+	static uint32_t SortKey(uint32_t pipeline, uint32_t geometry);
+	void Reset();
+	void Reserve(size_t instanceCount);
+	void Submit(uint32_t pipeline, uint32_t geometry, const InstanceData& instance);
+	void Build();
+	size_t InstanceCount() const { return mKeys.size(); }
+	const std::vector<InstanceBatch>& Batches() const { return mBatches; }
+	const uint32_t* Stream(InstanceStream stream) const { return mPacked[static_cast<unsigned>(stream)].data(); }
+	unsigned PipelineChangeCount() const { return mPipelineChangeCount; }
+	unsigned GeometryChangeCount() const { return mGeometryChangeCount; }
+private:
+	void SortKeys();
+private:
+	std::vector<uint64_t>										mKeys;
+	std::vector<uint64_t>										mSortedKeys;
+	std::array<std::vector<uint32_t>, INSTANCE_STREAM_COUNT>	mSubmitted;
+	std::array<std::vector<uint32_t>, INSTANCE_STREAM_COUNT>	mPacked;
+	std::vector<InstanceBatch>									mBatches;
+	unsigned													mPipelineChangeCount;
+	unsigned													mGeometryChangeCount;
+};
@@ -0,0 +1,341 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+// ============================================================================
+// A job with the counter that is decremented when the job has finished.
+// ============================================================================
+struct Job
+{
+	JobSystem::JobFunction	function;
+	JobCounter*				counter;
+};
+
+// ============================================================================
+// The job system and the thread index of the calling thread.
+// ============================================================================
+struct JobThread
+{
+	const JobSystem*	system;
+	unsigned			index;
+	uint32_t			random;
+};
+
+// a per-thread identity used to find the deque of the calling thread.
+thread_local JobThread CurrentJobThread = { nullptr, JOB_NO_THREAD, 0 };
+
+JobDeque::JobDeque() : mJobs(new std::atomic<Job*>[JOB_DEQUE_CAPACITY]), mTop(0), mBottom(0)
+{
+}
+
+// ============================================================================
+// Push a job at the bottom of the deque. Only the owner may push jobs.
+//
+// Function returns false without pushing the job when the deque is full.
+// ============================================================================
+bool JobDeque::Push(Job* job)
+{
+	auto bottom = mBottom.load(std::memory_order_relaxed);
+	auto top = mTop.load(std::memory_order_acquire);
+	if (bottom - top >= JOB_DEQUE_CAPACITY) {
+		return false;
+	}
+	mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	mBottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+// ============================================================================
+// Pop the newest job from the bottom of the deque. Only the owner may pop.
+//
+// The bottom is reserved before the top is read, so a thief and the owner can
+// only race on the last job, which is then resolved by a compare-and-swap.
+// ============================================================================
+Job* JobDeque::Pop()
+{
+	auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+	mBottom.store(bottom, std::memory_order_seq_cst);
+	auto top = mTop.load(std::memory_order_seq_cst);
+	if (top > bottom) {
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	auto job = mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (top == bottom) {
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+// ============================================================================
+// Steal the oldest job from the top of the deque. Any thread may steal.
+//
+// Function returns null when the deque is empty or another thread took the
+// job first, in which case the thief should simply look elsewhere.
+// ============================================================================
+Job* JobDeque::Steal()
+{
+	auto top = mTop.load(std::memory_order_seq_cst);
+	auto bottom = mBottom.load(std::memory_order_seq_cst);
+	if (top >= bottom) {
+		return nullptr;
+	}
+	auto job = mJobs[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return job;
+}
+
+JobSystem::JobSystem(unsigned threadCount) : mSharedCount(0), mQueuedCount(0), mSleepingCount(0), mStealCount(0), mExit(false)
+{
+	threadCount = std::max(threadCount, 1u);
+	for (auto i = 0u; i < threadCount; i++) {
+		mDeques.push_back(std::make_unique<JobDeque>());
+	}
+
+	// the creating thread takes the first deque and the workers take the rest.
+	CurrentJobThread = { this, 0, 1 };
+	for (auto i = 1u; i < threadCount; i++) {
+		mThreads.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mExit = true;
+	}
+	mWakeup.notify_all();
+	for (auto& thread : mThreads) {
+		thread.join();
+	}
+
+	// release the jobs that were never run.
+	for (auto& deque : mDeques) {
+		while (auto job = deque->Pop()) {
+			delete job;
+		}
+	}
+	for (auto job : mSharedJobs) {
+		delete job;
+	}
+	if (CurrentJobThread.system == this) {
+		CurrentJobThread = { nullptr, JOB_NO_THREAD, 0 };
+	}
+}
+
+// ============================================================================
+// Start a job that decrements the given counter when it has finished.
+// ============================================================================
+void JobSystem::Run(JobFunction function, JobCounter* counter)
+{
+	if (counter != nullptr) {
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+	}
+	Push(new Job{ std::move(function), counter });
+}
+
+// ============================================================================
+// Start a job once all jobs of the dependency counter have finished.
+//
+// The job is parked on the dependency and it is pushed by the thread which
+// finishes the last job of the dependency, so no thread waits for it.
+// ============================================================================
+void JobSystem::RunAfter(JobCounter& dependency, JobFunction function, JobCounter* counter)
+{
+	if (counter != nullptr) {
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+	}
+	auto job = new Job{ std::move(function), counter };
+	{
+		std::lock_guard<std::mutex> lock(dependency.mMutex);
+		if (dependency.mValue.load(std::memory_order_acquire) != 0) {
+			dependency.mContinuations.push_back(job);
+			return;
+		}
+	}
+	Push(job);
+}
+
+// ============================================================================
+// Run the given function for the range [0, count) split into chunks.
+//
+// Function returns after all chunks have been processed. The calling thread
+// runs chunks as well while it is waiting for the others to finish.
+// ============================================================================
+void JobSystem::ParallelFor(unsigned count, unsigned grainSize, const RangeFunction& function)
+{
+	grainSize = std::max(grainSize, 1u);
+	if (count <= grainSize) {
+		function(0, count);
+		return;
+	}
+	JobCounter counter;
+	for (auto begin = 0u; begin < count; begin += grainSize) {
+		auto end = std::min(count - begin, grainSize) + begin;
+		Run([&function, begin, end] { function(begin, end); }, &counter);
+	}
+	Wait(counter);
+}
+
+// ============================================================================
+// Wait until all jobs of the counter have finished.
+//
+// The calling thread runs other jobs in the meantime, so jobs may wait for
+// the jobs they have started without blocking a worker of the system. A
+// counter must not be destroyed before a wait for it has returned.
+// ============================================================================
+void JobSystem::Wait(JobCounter& counter)
+{
+	auto index = ThreadIndex();
+	while (!counter.IsDone()) {
+		if (auto job = FindJob(index)) {
+			Execute(job);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	// wait for the thread that finished the last job to release the counter.
+	std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+// ============================================================================
+// Get the index of the calling thread within the job system.
+// ============================================================================
+unsigned JobSystem::ThreadIndex() const
+{
+	return (CurrentJobThread.system == this) ? CurrentJobThread.index : JOB_NO_THREAD;
+}
+
+// ============================================================================
+// The main loop of a worker thread.
+//
+// Worker runs the jobs it finds and spins for a while before it goes to sleep
+// until new jobs are queued. Workers only exit when the system is destroyed.
+// ============================================================================
+void JobSystem::WorkerMain(unsigned index)
+{
+	CurrentJobThread = { this, index, index * 2654435761u + 1 };
+	auto failures = 0u;
+	while (!mExit.load(std::memory_order_acquire)) {
+		if (auto job = FindJob(index)) {
+			Execute(job);
+			failures = 0;
+		} else if (++failures < JOB_SPIN_COUNT) {
+			std::this_thread::yield();
+		} else {
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mSleepingCount.fetch_add(1, std::memory_order_seq_cst);
+			mWakeup.wait(lock, [this] { return mExit.load(std::memory_order_acquire) || mQueuedCount.load(std::memory_order_seq_cst) > 0; });
+			mSleepingCount.fetch_sub(1, std::memory_order_relaxed);
+			failures = 0;
+		}
+	}
+}
+
+// ============================================================================
+// Queue a job into the deque of the calling thread.
+//
+// Threads outside the system and threads with a full deque use the shared
+// queue instead. A sleeping worker is woken up to take the job.
+// ============================================================================
+void JobSystem::Push(Job* job)
+{
+	mQueuedCount.fetch_add(1, std::memory_order_seq_cst);
+	auto index = ThreadIndex();
+	if (index == JOB_NO_THREAD || !mDeques[index]->Push(job)) {
+		std::lock_guard<std::mutex> lock(mSharedMutex);
+		mSharedJobs.push_back(job);
+		mSharedCount.fetch_add(1, std::memory_order_release);
+	}
+	if (mSleepingCount.load(std::memory_order_seq_cst) > 0) {
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mWakeup.notify_one();
+	}
+}
+
+// ============================================================================
+// Find a job for a thread to run.
+//
+// Thread first takes the newest job of its own deque, then the oldest job of
+// the shared queue and finally tries to steal from the other threads starting
+// from a random one.
+// ============================================================================
+Job* JobSystem::FindJob(unsigned index)
+{
+	Job* job = nullptr;
+	if (index != JOB_NO_THREAD) {
+		job = mDeques[index]->Pop();
+	}
+	if (job == nullptr && mSharedCount.load(std::memory_order_acquire) > 0) {
+		std::lock_guard<std::mutex> lock(mSharedMutex);
+		if (!mSharedJobs.empty()) {
+			job = mSharedJobs.front();
+			mSharedJobs.pop_front();
+			mSharedCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+	if (job == nullptr && mQueuedCount.load(std::memory_order_relaxed) > 0) {
+		auto& random = CurrentJobThread.random;
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		auto count = ThreadCount();
+		for (auto i = 0u, victim = random % count; i < count && job == nullptr; i++, victim = (victim + 1) % count) {
+			if (victim != index) {
+				job = mDeques[victim]->Steal();
+			}
+		}
+		if (job != nullptr) {
+			mStealCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	if (job != nullptr) {
+		mQueuedCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+// ============================================================================
+// Run a job and finish it on its counter.
+// ============================================================================
+void JobSystem::Execute(Job* job)
+{
+	job->function();
+	if (job->counter != nullptr) {
+		Finish(*job->counter);
+	}
+	delete job;
+}
+
+// ============================================================================
+// Decrement a counter and push the jobs that waited for it to hit zero.
+//
+// The last decrement is done while holding the lock of the counter, which a
+// waiter takes before returning, so the counter outlives this function.
+// ============================================================================
+void JobSystem::Finish(JobCounter& counter)
+{
+	auto value = counter.mValue.load(std::memory_order_relaxed);
+	while (value > 1) {
+		if (counter.mValue.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			return;
+		}
+	}
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.mMutex);
+		if (counter.mValue.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			continuations.swap(counter.mContinuations);
+		}
+	}
+	for (auto job : continuations) {
+		Push(job);
+	}
+}
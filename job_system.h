@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the amount of jobs a deque of a single thread can hold. Must be a power of two.
+#define JOB_DEQUE_CAPACITY 4096
+
+// the amount of failed attempts to find a job before a worker goes to sleep.
+#define JOB_SPIN_COUNT 64
+
+// a thread index for the threads that do not belong to a job system.
+#define JOB_NO_THREAD UINT32_MAX
+
+struct Job;
+
+// ============================================================================
+// A counter of the unfinished jobs used to wait for jobs and to chain them.
+//
+// A counter is incremented for each job started with it and decremented as
+// the jobs finish. Jobs may be set to start only after a counter hits zero.
+// ============================================================================
+class JobCounter
+{
+public:
+	JobCounter() : mValue(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+	bool IsDone() const { return mValue.load(std::memory_order_acquire) == 0; }
+	unsigned Value() const { return mValue.load(std::memory_order_acquire); }
+private:
+	friend class JobSystem;
+	std::atomic<unsigned>	mValue;
+	std::mutex				mMutex;
+	std::vector<Job*>		mContinuations;
+};
+
+// ============================================================================
+// A lock-free work-stealing deque of the jobs of a single thread.
+//
+// The owning thread pushes and pops jobs at the bottom in the LIFO order while
+// the other threads steal the oldest jobs from the top (Chase-Lev deque).
+// ============================================================================
+class JobDeque
+{
+public:
+	JobDeque();
+	bool Push(Job* job);
+	Job* Pop();
+	Job* Steal();
+private:
+	std::unique_ptr<std::atomic<Job*>[]>	mJobs;
+	std::atomic<int64_t>					mTop;
+	std::atomic<int64_t>					mBottom;
+};
+
+// ============================================================================
+// A work-stealing job scheduler with a deque for each thread.
+//
+// Thread that creates the system is its first thread and it only runs jobs
+// while it waits. Idle workers steal jobs from the other threads and sleep
+// when there is no work left. Any thread may start jobs and wait for them.
+// ============================================================================
+class JobSystem
+{
+public:
+	typedef std::function<void()> JobFunction;
+	typedef std::function<void(unsigned begin, unsigned end)> RangeFunction;
+	explicit JobSystem(unsigned threadCount);
+	~JobSystem();
+	void Run(JobFunction function, JobCounter* counter = nullptr);
+	void RunAfter(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+	void ParallelFor(unsigned count, unsigned grainSize, const RangeFunction& function);
+	void Wait(JobCounter& counter);
+	unsigned ThreadCount() const { return static_cast<unsigned>(mDeques.size()); }
+	unsigned ThreadIndex() const;
+	uint64_t StealCount() const { return mStealCount.load(std::memory_order_relaxed); }
+private:
+	void WorkerMain(unsigned index);
+	void Push(Job* job);
+	Job* FindJob(unsigned index);
+	void Execute(Job* job);
+	void Finish(JobCounter& counter);
+private:
+	std::vector<std::unique_ptr<JobDeque>>	mDeques;
+	std::vector<std::thread>				mThreads;
+	std::mutex								mSharedMutex;
+	std::deque<Job*>						mSharedJobs;
+	std::atomic<unsigned>					mSharedCount;
+	std::mutex								mSleepMutex;
+	std::condition_variable					mWakeup;
+	std::atomic<unsigned>					mQueuedCount;
+	std::atomic<unsigned>					mSleepingCount;
+	std::atomic<uint64_t>					mStealCount;
+	std::atomic<bool>						mExit;
+};
@@ -0,0 +1,106 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path) : MappedFile(std::wstring(path.begin(), path.end()))
+{
+}
+
+// ============================================================================
+// Map the file with the file mapping functions available to the apps.
+// ============================================================================
+MappedFile::MappedFile(const std::wstring& path) : mData(nullptr), mSize(0), mMapping(nullptr)
+{
+	auto file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("failed to open the file");
+	}
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw std::runtime_error("failed to get the size of the file");
+	}
+	mSize = static_cast<uint64_t>(size.QuadPart);
+	if (mSize != 0) {
+		mMapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+		if (mMapping != nullptr) {
+			mData = static_cast<const uint8_t*>(MapViewOfFileFromApp(mMapping, FILE_MAP_READ, 0, 0));
+		}
+	}
+	CloseHandle(file);
+	if (mSize != 0 && mData == nullptr) {
+		if (mMapping != nullptr) {
+			CloseHandle(mMapping);
+		}
+		throw std::runtime_error("failed to map the file");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr) {
+		UnmapViewOfFile(mData);
+		CloseHandle(mMapping);
+	}
+}
+
+#else
+
+// ============================================================================
+// Map the file with mmap.
+// ============================================================================
+MappedFile::MappedFile(const std::string& path) : mData(nullptr), mSize(0)
+{
+	auto file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("failed to open the file");
+	}
+	struct stat status = {};
+	if (fstat(file, &status) != 0) {
+		close(file);
+		throw std::runtime_error("failed to get the size of the file");
+	}
+	mSize = static_cast<uint64_t>(status.st_size);
+	if (mSize != 0) {
+		auto data = mmap(nullptr, static_cast<size_t>(mSize), PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED) {
+			close(file);
+			throw std::runtime_error("failed to map the file");
+		}
+		mData = static_cast<const uint8_t*>(data);
+	}
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr) {
+		munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+	}
+}
+
+#endif
+
+// ============================================================================
+// Map a file with the path relative to the root directory of the source.
+// ============================================================================
+std::unique_ptr<FileContents> MappedFileSource::Open(const std::string& path)
+{
+#if defined(_WIN32)
+	auto fullPath = mRoot + L"\\" + std::wstring(path.begin(), path.end());
+#else
+	auto fullPath = mRoot + "/" + path;
+#endif
+	return std::unique_ptr<FileContents>(new MappedFile(fullPath));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "file_source.h"
+
+#include <cstdint>
+#include <string>
+
+// ============================================================================
+// A read-only memory mapping of a whole file.
+//
+// Pages of the file are loaded by the operating system on the first access,
+// so the contents can be copied from the mapping without reading them into
+// an intermediate buffer. The mapping is released with the object.
+// ============================================================================
+class MappedFile : public FileContents
+{
+public:
+	explicit MappedFile(const std::string& path);
+#if defined(_WIN32)
+	explicit MappedFile(const std::wstring& path);
+#endif
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	const uint8_t* Data() const override { return mData; }
+	uint64_t Size() const override { return mSize; }
+private:
+	const uint8_t*	mData;
+	uint64_t		mSize;
+#if defined(_WIN32)
+	void*			mMapping;
+#endif
+};
+
+// ============================================================================
+// A file source that memory maps the files under a root directory.
+// ============================================================================
+class MappedFileSource : public FileSource
+{
+public:
+#if defined(_WIN32)
+	explicit MappedFileSource(std::wstring root) : mRoot(std::move(root)) {}
+#else
+	explicit MappedFileSource(std::string root) : mRoot(std::move(root)) {}
+#endif
+	std::unique_ptr<FileContents> Open(const std::string& path) override;
+private:
+#if defined(_WIN32)
+	std::wstring	mRoot;
+#else
+	std::string		mRoot;
+#endif
+};
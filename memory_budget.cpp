@@ -0,0 +1,219 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+// the names of the memory segments and categories in the exported statistics.
+const char* const SegmentNames[MEMORY_SEGMENT_COUNT] = { "local", "nonLocal" };
+const char* const CategoryNames[MEMORY_CATEGORY_COUNT] = { "geometry", "renderTargets", "upload" };
+
+// ============================================================================
+// Get the budget and the usage of a segment and count the query.
+// ============================================================================
+MemoryBudgetInfo SimulatedBudgetProvider::Query(MemorySegment segment)
+{
+	mQueryCount++;
+	return mInfo[static_cast<unsigned>(segment)];
+}
+
+MemoryBudget::MemoryBudget(MemoryBudgetProvider& provider, const MemoryBudgetDesc& desc) : mProvider(provider), mDesc(desc), mStatistics(), mTrackedAtPoll(), mFramesToPoll(0), mFramesToTrim()
+{
+	if (desc.trimTarget > desc.trimThreshold) {
+		throw std::invalid_argument("memory trim target must not exceed the trim threshold");
+	}
+}
+
+// ============================================================================
+// Register a trimmer that releases memory of the given segment.
+//
+// A trimmer gets the amount of bytes that should be freed and returns the
+// amount it freed. Trimmers registered first are run first, so the memory
+// that is the cheapest to restore should be registered first. A background
+// only trimmer runs just when the app moves into the background.
+// ============================================================================
+void MemoryBudget::AddTrimmer(MemorySegment segment, const char* name, const Trimmer& trimmer, bool backgroundOnly)
+{
+	mTrimmers.push_back({ segment, name, trimmer, backgroundOnly, 0 });
+}
+
+// ============================================================================
+// Account an allocation of the renderer into a category.
+// ============================================================================
+void MemoryBudget::Allocate(MemoryCategory category, MemorySegment segment, uint64_t size)
+{
+	mStatistics.categories[static_cast<unsigned>(segment)][static_cast<unsigned>(category)] += size;
+}
+
+// ============================================================================
+// Remove a released allocation of the renderer from a category.
+// ============================================================================
+void MemoryBudget::Free(MemoryCategory category, MemorySegment segment, uint64_t size)
+{
+	auto& used = mStatistics.categories[static_cast<unsigned>(segment)][static_cast<unsigned>(category)];
+	if (size > used) {
+		throw std::invalid_argument("memory category would be freed more than allocated");
+	}
+	used -= size;
+}
+
+// ============================================================================
+// Apply the budget policy once per frame.
+//
+// The budget is polled at the configured interval and the segments above the
+// trim threshold are trimmed towards the trim target. A segment the trimmers
+// cannot bring under the threshold, e.g. due to the untracked memory, is not
+// trimmed again before the next poll of the interval, while the other
+// segments are still trimmed. Moving into the background polls right away
+// and trims everything, while the policy is idle until the application is
+// visible again.
+// ============================================================================
+void MemoryBudget::Update(bool background)
+{
+	if (background) {
+		if (!mStatistics.background) {
+			mStatistics.background = true;
+			Poll();
+			for (auto segment = 0u; segment < MEMORY_SEGMENT_COUNT; segment++) {
+				Trim(static_cast<MemorySegment>(segment), UINT64_MAX, true);
+			}
+		}
+		return;
+	}
+	if (mStatistics.background) {
+		mStatistics.background = false;
+		mFramesToPoll = 0;
+		for (auto& frames : mFramesToTrim) {
+			frames = 0;
+		}
+	}
+	for (auto& frames : mFramesToTrim) {
+		if (frames != 0) {
+			frames--;
+		}
+	}
+	if (mFramesToPoll != 0) {
+		mFramesToPoll--;
+
+		// poll early when the own allocations since the last poll may have grown a segment over the threshold.
+		auto grown = false;
+		for (auto segment = 0u; segment < MEMORY_SEGMENT_COUNT; segment++) {
+			auto& info = mStatistics.segments[segment];
+			auto growth = Tracked(segment) - std::min(mTrackedAtPoll[segment], Tracked(segment));
+			grown |= (growth != 0 && !OverBudget(static_cast<MemorySegment>(segment)) && info.usage + growth > info.budget * mDesc.trimThreshold);
+		}
+		if (!grown) {
+			return;
+		}
+	}
+	mFramesToPoll = std::max(mDesc.pollFrames, 1u) - 1;
+	Poll();
+	for (auto segment = 0u; segment < MEMORY_SEGMENT_COUNT; segment++) {
+		if (mFramesToTrim[segment] == 0 && OverBudget(static_cast<MemorySegment>(segment))) {
+			auto& info = mStatistics.segments[segment];
+			auto target = static_cast<uint64_t>(info.budget * mDesc.trimTarget);
+			mStatistics.overBudgetPolls++;
+			Trim(static_cast<MemorySegment>(segment), info.usage - std::min(target, info.usage), false);
+
+			// the trimmers could not free enough, so running them again before the next poll would not help.
+			if (OverBudget(static_cast<MemorySegment>(segment))) {
+				mFramesToTrim[segment] = std::max(mDesc.pollFrames, 1u);
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Check whether the usage of a segment exceeds the trim threshold.
+// ============================================================================
+bool MemoryBudget::OverBudget(MemorySegment segment) const
+{
+	auto& info = mStatistics.segments[static_cast<unsigned>(segment)];
+	return info.usage > info.budget * mDesc.trimThreshold;
+}
+
+// ============================================================================
+// Export the statistics and the trimmed memory of each trimmer as JSON.
+// ============================================================================
+std::string MemoryBudget::ExportJson() const
+{
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "{\"background\": %s, \"trimmedBytes\": %llu, \"trimCount\": %u, \"overBudgetPolls\": %u, \"segments\": [",
+		mStatistics.background ? "true" : "false", static_cast<unsigned long long>(mStatistics.trimmedBytes), mStatistics.trimCount, mStatistics.overBudgetPolls);
+	std::string json = buffer;
+	for (auto segment = 0u; segment < MEMORY_SEGMENT_COUNT; segment++) {
+		auto& info = mStatistics.segments[segment];
+		std::snprintf(buffer, sizeof(buffer), "%s\n    {\"segment\": \"%s\", \"budget\": %llu, \"usage\": %llu, \"untracked\": %llu, \"categories\": {", (segment == 0) ? "" : ",",
+			SegmentNames[segment], static_cast<unsigned long long>(info.budget), static_cast<unsigned long long>(info.usage), static_cast<unsigned long long>(mStatistics.untracked[segment]));
+		json += buffer;
+		for (auto category = 0u; category < MEMORY_CATEGORY_COUNT; category++) {
+			std::snprintf(buffer, sizeof(buffer), "%s\"%s\": %llu", (category == 0) ? "" : ", ", CategoryNames[category], static_cast<unsigned long long>(mStatistics.categories[segment][category]));
+			json += buffer;
+		}
+		json += "}}";
+	}
+	json += "\n], \"trimmers\": [";
+	for (size_t i = 0; i < mTrimmers.size(); i++) {
+		auto& trimmer = mTrimmers[i];
+		std::snprintf(buffer, sizeof(buffer), "%s\n    {\"name\": \"%s\", \"segment\": \"%s\", \"trimmedBytes\": %llu}", (i == 0) ? "" : ",",
+			trimmer.name, SegmentNames[static_cast<unsigned>(trimmer.segment)], static_cast<unsigned long long>(trimmer.trimmedBytes));
+		json += buffer;
+	}
+	json += "\n]}\n";
+	return json;
+}
+
+// ============================================================================
+// Query the budget of each segment and derive the untracked memory.
+// ============================================================================
+void MemoryBudget::Poll()
+{
+	for (auto segment = 0u; segment < MEMORY_SEGMENT_COUNT; segment++) {
+		auto& info = mStatistics.segments[segment];
+		info = mProvider.Query(static_cast<MemorySegment>(segment));
+		auto tracked = Tracked(segment);
+		mStatistics.untracked[segment] = info.usage - std::min(tracked, info.usage);
+		mTrackedAtPoll[segment] = tracked;
+	}
+}
+
+// ============================================================================
+// Get the memory of all the categories of a segment.
+// ============================================================================
+uint64_t MemoryBudget::Tracked(unsigned segment) const
+{
+	uint64_t tracked = 0;
+	for (auto size : mStatistics.categories[segment]) {
+		tracked += size;
+	}
+	return tracked;
+}
+
+// ============================================================================
+// Run the trimmers of a segment until the given amount of bytes is freed.
+//
+// The background only trimmers are skipped while the app is visible. The
+// usage is lowered by the freed memory right away, so the statistics are
+// current until the next poll gets the usage the OS has seen.
+// ============================================================================
+uint64_t MemoryBudget::Trim(MemorySegment segment, uint64_t bytes, bool background)
+{
+	uint64_t freed = 0;
+	for (auto& trimmer : mTrimmers) {
+		if (freed >= bytes) {
+			break;
+		}
+		if (trimmer.segment == segment && (background || !trimmer.backgroundOnly)) {
+			auto trimmed = trimmer.trimmer(bytes - freed);
+			trimmer.trimmedBytes += trimmed;
+			freed += trimmed;
+		}
+	}
+	if (freed != 0) {
+		auto& info = mStatistics.segments[static_cast<unsigned>(segment)];
+		info.usage -= std::min(freed, info.usage);
+		mStatistics.trimmedBytes += freed;
+		mStatistics.trimCount++;
+	}
+	return freed;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// the amount of memory segments and memory categories the budget keeps apart.
+#define MEMORY_SEGMENT_COUNT 2
+#define MEMORY_CATEGORY_COUNT 3
+
+// ============================================================================
+// The memory segments of the adapter.
+//
+// Local is the video memory of the adapter and non-local the system memory
+// the adapter can access, like the DXGI memory segment groups.
+// ============================================================================
+enum class MemorySegment : uint8_t { Local, NonLocal };
+
+// ============================================================================
+// The categories of the memory the renderer allocates.
+// ============================================================================
+enum class MemoryCategory : uint8_t { Geometry, RenderTargets, Upload };
+
+// ============================================================================
+// The budget the OS gives to the application and the usage of the application.
+// ============================================================================
+struct MemoryBudgetInfo
+{
+	uint64_t	budget;
+	uint64_t	usage;
+};
+
+// ============================================================================
+// The configuration of the memory budget policy.
+//
+// Trimming starts when the usage of a segment exceeds the trim threshold and
+// frees memory until the usage is at the trim target, both as fractions of
+// the budget. The budget is queried at every given amount of frames, or
+// sooner when the allocations since the last query may exceed the threshold.
+// Trimmers that cannot free enough are not run again within the interval.
+// ============================================================================
+struct MemoryBudgetDesc
+{
+	double		trimThreshold;
+	double		trimTarget;
+	unsigned	pollFrames;
+};
+
+// ============================================================================
+// An interface for the sources of the memory budget of the application.
+// ============================================================================
+class MemoryBudgetProvider
+{
+public:
+	virtual ~MemoryBudgetProvider() = default;
+	virtual MemoryBudgetInfo Query(MemorySegment segment) = 0;
+};
+
+// ============================================================================
+// A budget provider with the budget and the usage set by the caller.
+// ============================================================================
+class SimulatedBudgetProvider : public MemoryBudgetProvider
+{
+public:
+	SimulatedBudgetProvider() : mInfo(), mQueryCount(0) {}
+	MemoryBudgetInfo Query(MemorySegment segment) override;
+	void Set(MemorySegment segment, uint64_t budget, uint64_t usage) { mInfo[static_cast<unsigned>(segment)] = { budget, usage }; }
+	unsigned QueryCount() const { return mQueryCount; }
+private:
+	MemoryBudgetInfo	mInfo[MEMORY_SEGMENT_COUNT];
+	unsigned			mQueryCount;
+};
+
+// ============================================================================
+// The memory statistics of the application.
+//
+// Untracked memory is the usage the categories do not explain, e.g. the swap
+// chain, the pipelines and the memory of the driver itself.
+// ============================================================================
+struct MemoryStatistics
+{
+	MemoryBudgetInfo	segments[MEMORY_SEGMENT_COUNT];
+	uint64_t			categories[MEMORY_SEGMENT_COUNT][MEMORY_CATEGORY_COUNT];
+	uint64_t			untracked[MEMORY_SEGMENT_COUNT];
+	uint64_t			trimmedBytes;
+	unsigned			trimCount;
+	unsigned			overBudgetPolls;
+	bool				background;
+};
+
+// ============================================================================
+// A telemetry of the memory usage with a policy to stay within the budget.
+//
+// The renderer reports its allocations by category and registers trimmers
+// that release the memory it can live without, e.g. the empty heap blocks.
+// The budget is polled from the provider, and a segment over the budget runs
+// the trimmers of the segment in their registration order until enough is
+// freed. Moving into the background runs every trimmer to free all it can,
+// including the trimmers too costly to run while the app is visible.
+// ============================================================================
+class MemoryBudget
+{
+public:
+	typedef std::function<uint64_t(uint64_t bytes)> Trimmer;
+	MemoryBudget(MemoryBudgetProvider& provider, const MemoryBudgetDesc& desc);
+	void AddTrimmer(MemorySegment segment, const char* name, const Trimmer& trimmer, bool backgroundOnly = false);
+	void Allocate(MemoryCategory category, MemorySegment segment, uint64_t size);
+	void Free(MemoryCategory category, MemorySegment segment, uint64_t size);
+	void Update(bool background);
+	bool OverBudget(MemorySegment segment) const;
+	const MemoryStatistics& Statistics() const { return mStatistics; }
+	std::string ExportJson() const;
+private:
+	struct TrimmerEntry
+	{
+		MemorySegment	segment;
+		const char*		name;
+		Trimmer			trimmer;
+		bool			backgroundOnly;
+		uint64_t		trimmedBytes;
+	};
+	void Poll();
+	uint64_t Trim(MemorySegment segment, uint64_t bytes, bool background);
+	uint64_t Tracked(unsigned segment) const;
+private:
+	MemoryBudgetProvider&		mProvider;
+	MemoryBudgetDesc			mDesc;
+	std::vector<TrimmerEntry>	mTrimmers;
+	MemoryStatistics			mStatistics;
+	uint64_t					mTrackedAtPoll[MEMORY_SEGMENT_COUNT];
+	unsigned					mFramesToPoll;
+	unsigned					mFramesToTrim[MEMORY_SEGMENT_COUNT];
+};
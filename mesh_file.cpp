@@ -0,0 +1,234 @@
+#include "mesh_file.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// a helper to round a file offset up to the stream alignment.
+static uint64_t AlignStream(uint64_t offset)
+{
+	return (offset + MESH_STREAM_ALIGNMENT - 1) & ~static_cast<uint64_t>(MESH_STREAM_ALIGNMENT - 1);
+}
+
+// ============================================================================
+// Write the mesh into a mesh file.
+//
+// Indices are stored as 16-bit values when all of them fit, which halves the
+// index stream of the smaller meshes. Streams are padded to their alignment.
+// ============================================================================
+void WriteMesh(std::ostream& output, const MeshDesc& desc)
+{
+	if (desc.elementCount == 0 || desc.elementCount > MESH_MAX_ELEMENTS) {
+		throw std::invalid_argument("invalid amount of vertex elements");
+	}
+
+	// pick the smallest index format which can address all the vertices.
+	MeshFileHeader header = {};
+	auto indexFormat = (desc.indexCount == 0) ? MeshIndexFormat::None : (desc.vertexCount <= 0x10000) ? MeshIndexFormat::UInt16 : MeshIndexFormat::UInt32;
+	auto indexSize = (indexFormat == MeshIndexFormat::UInt16) ? 2u : 4u;
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.vertexStride = desc.vertexStride;
+	header.vertexCount = desc.vertexCount;
+	header.indexFormat = static_cast<uint32_t>(indexFormat);
+	header.indexCount = desc.indexCount;
+	for (auto i = 0; i < 3; i++) {
+		header.boundsMin[i] = desc.bounds.minimum[i];
+		header.boundsMax[i] = desc.bounds.maximum[i];
+	}
+	header.positionScale = desc.positionScale;
+	header.elementCount = desc.elementCount;
+	for (auto i = 0u; i < desc.elementCount; i++) {
+		auto& element = desc.elements[i];
+		if (std::strlen(element.semantic) >= MESH_SEMANTIC_LENGTH) {
+			throw std::invalid_argument("vertex element semantic is too long");
+		}
+		std::strncpy(header.elements[i].semantic, element.semantic, MESH_SEMANTIC_LENGTH - 1);
+		header.elements[i].semanticIndex = element.semanticIndex;
+		header.elements[i].format = static_cast<uint32_t>(element.format);
+		header.elements[i].offset = element.offset;
+	}
+	header.vertices.offset = AlignStream(sizeof(MeshFileHeader));
+	header.vertices.size = static_cast<uint64_t>(desc.vertexStride) * desc.vertexCount;
+	header.indices.offset = AlignStream(header.vertices.offset + header.vertices.size);
+	header.indices.size = (indexFormat == MeshIndexFormat::None) ? 0 : static_cast<uint64_t>(indexSize) * desc.indexCount;
+	header.fileSize = header.indices.offset + header.indices.size;
+
+	// write the header and the streams with the padding between them.
+	const char padding[MESH_STREAM_ALIGNMENT] = {};
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(padding, static_cast<std::streamsize>(header.vertices.offset - sizeof(header)));
+	output.write(static_cast<const char*>(desc.vertices), static_cast<std::streamsize>(header.vertices.size));
+	output.write(padding, static_cast<std::streamsize>(header.indices.offset - header.vertices.offset - header.vertices.size));
+	if (indexFormat == MeshIndexFormat::UInt16) {
+		std::vector<uint16_t> indices(desc.indices, desc.indices + desc.indexCount);
+		output.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(header.indices.size));
+	} else {
+		output.write(reinterpret_cast<const char*>(desc.indices), static_cast<std::streamsize>(header.indices.size));
+	}
+	if (!output) {
+		throw std::runtime_error("failed to write the mesh file");
+	}
+}
+
+MeshFile::MeshFile(std::unique_ptr<FileContents> contents) : mContents(std::move(contents)), mHeader(nullptr)
+{
+	Validate();
+}
+
+MeshFile::MeshFile(const std::string& path) : MeshFile(std::unique_ptr<FileContents>(new MappedFile(path)))
+{
+}
+
+#if defined(_WIN32)
+MeshFile::MeshFile(const std::wstring& path) : MeshFile(std::unique_ptr<FileContents>(new MappedFile(path)))
+{
+}
+#endif
+
+// ============================================================================
+// Get the size of a single index in bytes.
+// ============================================================================
+uint32_t MeshFile::IndexSize() const
+{
+	switch (static_cast<MeshIndexFormat>(mHeader->indexFormat)) {
+	case MeshIndexFormat::UInt16:
+		return 2;
+	case MeshIndexFormat::UInt32:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+// ============================================================================
+// Queue copies of the streams of the mesh into the given buffers.
+//
+// Streams are copied by the uploader from the mapping into the staging memory
+// of the copy queue. The index buffer is not used when there are no indices.
+// ============================================================================
+void MeshFile::Upload(GeometryUploader& uploader, void* vertexBuffer, void* indexBuffer) const
+{
+	uploader.Upload(vertexBuffer, 0, VertexData(), mHeader->vertices.size);
+	if (mHeader->indices.size != 0) {
+		uploader.Upload(indexBuffer, 0, IndexData(), mHeader->indices.size);
+	}
+}
+
+// ============================================================================
+// Read the streams of the mesh and check that every index addresses a vertex.
+//
+// This faults in every page of the streams, so it should be done off the
+// render thread to keep the later copies from the mapping waiting for I/O.
+// ============================================================================
+void MeshFile::ValidateStreams() const
+{
+	auto vertices = static_cast<const volatile uint8_t*>(VertexData());
+	for (uint64_t offset = 0; offset < mHeader->vertices.size; offset += MESH_PAGE_SIZE) {
+		static_cast<void>(vertices[offset]);
+	}
+	auto valid = true;
+	if (IndexSize() == sizeof(uint16_t)) {
+		auto indices = reinterpret_cast<const uint16_t*>(IndexData());
+		for (auto i = 0u; i < mHeader->indexCount; i++) {
+			valid &= indices[i] < mHeader->vertexCount;
+		}
+	} else if (IndexSize() == sizeof(uint32_t)) {
+		auto indices = reinterpret_cast<const uint32_t*>(IndexData());
+		for (auto i = 0u; i < mHeader->indexCount; i++) {
+			valid &= indices[i] < mHeader->vertexCount;
+		}
+	}
+	if (!valid) {
+		throw std::runtime_error("index out of range in mesh file");
+	}
+}
+
+// ============================================================================
+// Compare the vertex layout of the mesh with the given layout.
+// ============================================================================
+bool MeshFile::MatchesLayout(const VertexElement* elements, size_t elementCount, unsigned vertexStride) const
+{
+	if (mHeader->vertexStride != vertexStride || mHeader->elementCount != elementCount) {
+		return false;
+	}
+	for (size_t i = 0; i < elementCount; i++) {
+		auto& element = mHeader->elements[i];
+		if (std::strcmp(element.semantic, elements[i].semantic) != 0
+			|| element.semanticIndex != elements[i].semanticIndex
+			|| element.format != static_cast<uint32_t>(elements[i].format)
+			|| element.offset != elements[i].offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// ============================================================================
+// Validate the header of the mapped file.
+//
+// Every size and offset is checked against the mapping before the streams
+// are used, so a truncated or corrupted file can never read past the end.
+// ============================================================================
+void MeshFile::Validate()
+{
+	if (mContents->Size() < sizeof(MeshFileHeader)) {
+		throw std::runtime_error("mesh file is too small");
+	}
+	if (reinterpret_cast<uintptr_t>(mContents->Data()) % alignof(MeshFileHeader) != 0) {
+		throw std::invalid_argument("mesh file contents must be aligned");
+	}
+	mHeader = reinterpret_cast<const MeshFileHeader*>(mContents->Data());
+	if (mHeader->magic != MESH_FILE_MAGIC) {
+		throw std::runtime_error("not a mesh file");
+	}
+	if (mHeader->version != MESH_FILE_VERSION) {
+		throw std::runtime_error("unsupported mesh file version");
+	}
+	if (mHeader->fileSize != mContents->Size()) {
+		throw std::runtime_error("mesh file is truncated");
+	}
+	if (mHeader->elementCount == 0 || mHeader->elementCount > MESH_MAX_ELEMENTS || mHeader->vertexStride == 0) {
+		throw std::runtime_error("invalid vertex layout in mesh file");
+	}
+	for (auto i = 0u; i < mHeader->elementCount; i++) {
+		auto& element = mHeader->elements[i];
+		if (std::memchr(element.semantic, '\0', MESH_SEMANTIC_LENGTH) == nullptr
+			|| element.format > static_cast<uint32_t>(VertexElementFormat::Unorm8x4)
+			|| static_cast<uint64_t>(element.offset) + VertexElementSize(static_cast<VertexElementFormat>(element.format)) > mHeader->vertexStride) {
+			throw std::runtime_error("invalid vertex layout in mesh file");
+		}
+	}
+	if (mHeader->indexFormat > static_cast<uint32_t>(MeshIndexFormat::UInt32)
+		|| (mHeader->indexFormat == static_cast<uint32_t>(MeshIndexFormat::None) && mHeader->indexCount != 0)) {
+		throw std::runtime_error("invalid index format in mesh file");
+	}
+	if (mHeader->vertexCount == 0) {
+		throw std::runtime_error("mesh file has no vertices");
+	}
+
+	// a helper to check that a stream is aligned, has the expected size and lies within the file.
+	auto isValidStream = [&](const MeshFileStream& stream, uint64_t expectedSize) {
+		return stream.offset % MESH_STREAM_ALIGNMENT == 0
+			&& stream.size == expectedSize
+			&& stream.offset >= sizeof(MeshFileHeader)
+			&& stream.offset <= mContents->Size()
+			&& stream.size <= mContents->Size() - stream.offset;
+	};
+	if (!isValidStream(mHeader->vertices, static_cast<uint64_t>(mHeader->vertexStride) * mHeader->vertexCount)
+		|| !isValidStream(mHeader->indices, static_cast<uint64_t>(IndexSize()) * mHeader->indexCount)) {
+		throw std::runtime_error("invalid stream in mesh file");
+	}
+}
+
+// ============================================================================
+// Decode the contents of a streamed file into a mesh asset.
+//
+// Decoding validates the header and the streams on the streaming thread, and
+// the streams are then copied later from the file contents straight into the
+// staging memory on the render thread.
+// ============================================================================
+std::unique_ptr<Asset> DecodeMesh(std::unique_ptr<FileContents> contents)
+{
+	return std::unique_ptr<Asset>(new MeshAsset(std::move(contents)));
+}
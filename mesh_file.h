@@ -0,0 +1,184 @@
+#pragma once
+
+#include "asset_streamer.h"
+#include "geometry_uploader.h"
+#include "mapped_file.h"
+#include "vertex_format.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// the magic number at the start of a mesh file ("MESH").
+#define MESH_FILE_MAGIC 0x4853454du
+
+// the version of the mesh file format. Files with another version are rejected.
+#define MESH_FILE_VERSION 1
+
+// the alignment of the vertex and index streams within a mesh file.
+#define MESH_STREAM_ALIGNMENT 256
+
+// the maximum amount of elements in the vertex layout of a mesh file.
+#define MESH_MAX_ELEMENTS 8
+
+// the maximum length of an element semantic including the terminator.
+#define MESH_SEMANTIC_LENGTH 16
+
+// the distance between the bytes read to fault in the pages of the streams.
+#define MESH_PAGE_SIZE 4096
+
+// ============================================================================
+// The formats of the index stream of a mesh file.
+// ============================================================================
+enum class MeshIndexFormat : uint32_t
+{
+	None,
+	UInt16,
+	UInt32
+};
+
+// ============================================================================
+// An element of the vertex layout as stored in a mesh file.
+// ============================================================================
+struct MeshFileElement
+{
+	char		semantic[MESH_SEMANTIC_LENGTH];
+	uint32_t	semanticIndex;
+	uint32_t	format;
+	uint32_t	offset;
+	uint32_t	reserved;
+};
+
+// ============================================================================
+// The location of a stream within a mesh file.
+// ============================================================================
+struct MeshFileStream
+{
+	uint64_t	offset;
+	uint64_t	size;
+};
+
+// ============================================================================
+// The header at the start of a mesh file.
+//
+// Header describes the vertex layout, the bounds and the streams, which are
+// stored after the header at aligned offsets so they can be copied as is.
+// Decoded positions are divided by the position scale to get model units.
+// ============================================================================
+struct MeshFileHeader
+{
+	uint32_t		magic;
+	uint32_t		version;
+	uint64_t		fileSize;
+	uint32_t		vertexStride;
+	uint32_t		vertexCount;
+	uint32_t		indexFormat;
+	uint32_t		indexCount;
+	float			boundsMin[3];
+	float			boundsMax[3];
+	float			positionScale;
+	uint32_t		elementCount;
+	MeshFileElement	elements[MESH_MAX_ELEMENTS];
+	MeshFileStream	vertices;
+	MeshFileStream	indices;
+};
+
+static_assert(sizeof(MeshFileHeader) == 352, "the size of the mesh file header must not change");
+
+// ============================================================================
+// The axis aligned bounds of a mesh in model units.
+// ============================================================================
+struct MeshBounds
+{
+	std::array<float, 3>	minimum;
+	std::array<float, 3>	maximum;
+};
+
+// ============================================================================
+// A description of the mesh data written into a mesh file.
+// ============================================================================
+struct MeshDesc
+{
+	const VertexElement*	elements;
+	unsigned				elementCount;
+	unsigned				vertexStride;
+	const void*				vertices;
+	uint32_t				vertexCount;
+	const uint32_t*			indices;
+	uint32_t				indexCount;
+	MeshBounds				bounds;
+	float					positionScale;
+};
+
+void WriteMesh(std::ostream& output, const MeshDesc& desc);
+
+// ============================================================================
+// Write a mesh with the vertices of a type with a vertex layout.
+// ============================================================================
+template <typename T>
+void WriteMesh(std::ostream& output, const T* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const MeshBounds& bounds, float positionScale = 1.f)
+{
+	static_assert(IsValidVertexLayout<T>(), "vertex layout does not match the vertex type");
+	const auto elements = VertexLayout<T>::Elements();
+	WriteMesh(output, { elements.data(), static_cast<unsigned>(elements.size()), sizeof(T), vertices, vertexCount, indices, indexCount, bounds, positionScale });
+}
+
+// ============================================================================
+// A mesh file loaded by memory mapping.
+//
+// The header is validated when the file is opened and the streams are then
+// accessed directly in the mapping. Uploading copies the streams straight
+// from the mapped pages into the staging memory without any parsing.
+// ============================================================================
+class MeshFile
+{
+public:
+	explicit MeshFile(std::unique_ptr<FileContents> contents);
+	explicit MeshFile(const std::string& path);
+#if defined(_WIN32)
+	explicit MeshFile(const std::wstring& path);
+#endif
+	const MeshFileHeader& Header() const { return *mHeader; }
+	const uint8_t* VertexData() const { return mContents->Data() + mHeader->vertices.offset; }
+	const uint8_t* IndexData() const { return mContents->Data() + mHeader->indices.offset; }
+	uint32_t IndexSize() const;
+	template <typename T> bool HasLayout() const;
+	void ValidateStreams() const;
+	void Upload(GeometryUploader& uploader, void* vertexBuffer, void* indexBuffer) const;
+private:
+	bool MatchesLayout(const VertexElement* elements, size_t elementCount, unsigned vertexStride) const;
+	void Validate();
+private:
+	std::unique_ptr<FileContents>	mContents;
+	const MeshFileHeader*			mHeader;
+};
+
+// ============================================================================
+// Check whether the vertices of the mesh have the layout of the given type.
+// ============================================================================
+template <typename T>
+bool MeshFile::HasLayout() const
+{
+	const auto elements = VertexLayout<T>::Elements();
+	return MatchesLayout(elements.data(), elements.size(), sizeof(T));
+}
+
+// ============================================================================
+// A mesh file loaded by the asset streamer.
+//
+// The streams are read and validated when the asset is decoded, so they are
+// resident by the time the render thread copies them.
+// ============================================================================
+class MeshAsset : public Asset
+{
+public:
+	explicit MeshAsset(std::unique_ptr<FileContents> contents) : mMesh(std::move(contents)) { mMesh.ValidateStreams(); }
+	uint64_t UploadSize() const override { return mMesh.Header().vertices.size + mMesh.Header().indices.size; }
+	const MeshFile& Mesh() const { return mMesh; }
+private:
+	MeshFile	mMesh;
+};
+
+std::unique_ptr<Asset> DecodeMesh(std::unique_ptr<FileContents> contents);
@@ -0,0 +1,496 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+// the value of an unassigned entry in the vertex remap tables.
+const uint32_t UnusedVertex = 0xffffffffu;
+
+// the size of the LRU cache modelled by the vertex cache optimization.
+const int ForsythCacheSize = 32;
+
+// the score of the vertices of the last emitted triangle.
+const float ForsythLastTriangleScore = 0.75f;
+
+// the power of the decay of the score with the position in the cache.
+const float ForsythCacheDecayPower = 1.5f;
+
+// the scale and the power of the bonus for vertices with few remaining triangles.
+const float ForsythValenceBoostScale = 2.f;
+const float ForsythValenceBoostPower = 0.5f;
+
+// ============================================================================
+// Simulate a FIFO post-transform cache over the triangles of an index list.
+//
+// Each vertex remembers when it was inserted, so a vertex is found in the
+// cache when less than the cache size of vertices were inserted since then.
+// ============================================================================
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize)
+{
+	std::vector<uint64_t> insertTimes(vertexCount, 0);
+	uint64_t time = cacheSize + 1;
+	for (auto index : indices) {
+		if (time - insertTimes[index] > cacheSize) {
+			insertTimes[index] = time++;
+		}
+	}
+	VertexCacheStatistics statistics = {};
+	statistics.transformedCount = time - cacheSize - 1;
+	statistics.acmr = indices.empty() ? 0.f : static_cast<float>(statistics.transformedCount) / static_cast<float>(indices.size() / 3);
+	statistics.atvr = (vertexCount == 0) ? 0.f : static_cast<float>(statistics.transformedCount) / static_cast<float>(vertexCount);
+	return statistics;
+}
+
+// ============================================================================
+// Rasterize the triangles in their order and count the shaded pixels.
+//
+// The mesh is drawn from the six axis directions with orthographic views and
+// a depth test. Triangles whose normal faces away from the view are culled,
+// where the normal follows the winding of the triangle in a right handed way.
+// A pixel is shaded whenever a triangle passes the depth test at the pixel.
+// ============================================================================
+OverdrawStatistics AnalyzeOverdraw(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount)
+{
+	OverdrawStatistics statistics = {};
+	if (vertexCount == 0 || indices.size() < 3) {
+		return statistics;
+	}
+	auto bytes = reinterpret_cast<const uint8_t*>(positions);
+	auto position = [&](uint32_t vertex) {
+		return reinterpret_cast<const float*>(bytes + vertex * positionStride);
+	};
+
+	// scale the bounds of the mesh into the views.
+	float minimum[3], maximum[3];
+	for (auto k = 0; k < 3; k++) {
+		minimum[k] = maximum[k] = position(0)[k];
+	}
+	for (size_t i = 1; i < vertexCount; i++) {
+		for (auto k = 0; k < 3; k++) {
+			minimum[k] = std::min(minimum[k], position(static_cast<uint32_t>(i))[k]);
+			maximum[k] = std::max(maximum[k], position(static_cast<uint32_t>(i))[k]);
+		}
+	}
+	auto extent = std::max({ maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] });
+	auto scale = (extent > 0.f) ? (MESH_OVERDRAW_RESOLUTION - 1) / extent : 0.f;
+
+	std::vector<float> depths(MESH_OVERDRAW_RESOLUTION * MESH_OVERDRAW_RESOLUTION);
+	for (auto view = 0; view < 6; view++) {
+		auto axis = view / 2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+		auto direction = (view % 2 == 0) ? 1.f : -1.f;
+		std::fill(depths.begin(), depths.end(), INFINITY);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			const float* corners[3] = { position(indices[i]), position(indices[i + 1]), position(indices[i + 2]) };
+
+			// cull the triangles facing away from the view.
+			float x[3], y[3], z[3];
+			for (auto j = 0; j < 3; j++) {
+				x[j] = (corners[j][u] - minimum[u]) * scale;
+				y[j] = (corners[j][v] - minimum[v]) * scale;
+				z[j] = corners[j][axis] * direction;
+			}
+			auto area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			if (area * direction >= 0.f) {
+				continue;
+			}
+
+			// test the pixel centers within the bounds against the edge functions.
+			auto minX = std::max(static_cast<int>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)), 0);
+			auto maxX = std::min(static_cast<int>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)), MESH_OVERDRAW_RESOLUTION - 1);
+			auto minY = std::max(static_cast<int>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)), 0);
+			auto maxY = std::min(static_cast<int>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)), MESH_OVERDRAW_RESOLUTION - 1);
+			for (auto py = minY; py <= maxY; py++) {
+				for (auto px = minX; px <= maxX; px++) {
+					auto cx = px + 0.5f, cy = py + 0.5f;
+					auto w0 = ((x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1])) / area;
+					auto w1 = ((x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2])) / area;
+					auto w2 = 1.f - w0 - w1;
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+						continue;
+					}
+					auto depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+					auto& stored = depths[py * MESH_OVERDRAW_RESOLUTION + px];
+					if (depth < stored) {
+						stored = depth;
+						statistics.shadedPixels++;
+					}
+				}
+			}
+		}
+		statistics.coveredPixels += std::count_if(depths.begin(), depths.end(), [](float depth) { return depth != INFINITY; });
+	}
+	statistics.overdraw = (statistics.coveredPixels == 0) ? 0.f : static_cast<float>(statistics.shadedPixels) / static_cast<float>(statistics.coveredPixels);
+	return statistics;
+}
+
+// ============================================================================
+// Get the size of the streams of a mesh file in bytes.
+//
+// Indices are stored with 16 bits when all the vertices can be addressed by
+// them, which is the same rule the mesh file writer uses for the streams.
+// ============================================================================
+uint64_t MeshStreamSize(size_t vertexCount, unsigned vertexStride, size_t indexCount)
+{
+	auto indexSize = (vertexCount <= 0x10000) ? sizeof(uint16_t) : sizeof(uint32_t);
+	return static_cast<uint64_t>(vertexCount) * vertexStride + static_cast<uint64_t>(indexCount) * indexSize;
+}
+
+// a helper to hash the bytes of a vertex with the FNV-1a hash.
+static uint32_t HashVertex(const uint8_t* vertex, size_t vertexStride)
+{
+	auto hash = 2166136261u;
+	for (size_t i = 0; i < vertexStride; i++) {
+		hash = (hash ^ vertex[i]) * 16777619u;
+	}
+	return hash;
+}
+
+// ============================================================================
+// Build a remap table which maps the duplicate vertices into a single one.
+//
+// Vertices are inserted into an open addressing hash table. The unique ones
+// get new indices in the order they are first seen, so a mesh without any
+// duplicates maps each vertex into itself.
+// ============================================================================
+size_t DeduplicateVertices(const void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& remap)
+{
+	auto bytes = static_cast<const uint8_t*>(vertices);
+	size_t tableSize = 1;
+	while (tableSize < vertexCount + vertexCount / 2) {
+		tableSize *= 2;
+	}
+	std::vector<uint32_t> table(tableSize, UnusedVertex);
+	remap.assign(vertexCount, UnusedVertex);
+	size_t uniqueCount = 0;
+	for (size_t i = 0; i < vertexCount; i++) {
+		auto vertex = bytes + i * vertexStride;
+		auto slot = HashVertex(vertex, vertexStride) & (tableSize - 1);
+		while (table[slot] != UnusedVertex && std::memcmp(bytes + table[slot] * vertexStride, vertex, vertexStride) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == UnusedVertex) {
+			table[slot] = static_cast<uint32_t>(i);
+			remap[i] = static_cast<uint32_t>(uniqueCount++);
+		} else {
+			remap[i] = remap[table[slot]];
+		}
+	}
+	return uniqueCount;
+}
+
+// ============================================================================
+// Copy the vertices into their remapped places in the output.
+//
+// Vertices which are mapped into the same place must be equal, so it does not
+// matter which of them is copied. Unused vertices are skipped.
+// ============================================================================
+void RemapVertices(const void* vertices, size_t vertexCount, size_t vertexStride, const std::vector<uint32_t>& remap, void* output)
+{
+	auto source = static_cast<const uint8_t*>(vertices);
+	auto destination = static_cast<uint8_t*>(output);
+	for (size_t i = 0; i < vertexCount; i++) {
+		if (remap[i] != UnusedVertex) {
+			std::memcpy(destination + remap[i] * vertexStride, source + i * vertexStride, vertexStride);
+		}
+	}
+}
+
+// ============================================================================
+// Replace the indices with their remapped vertices.
+// ============================================================================
+void RemapIndices(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap)
+{
+	for (auto& index : indices) {
+		index = remap[index];
+	}
+}
+
+// ============================================================================
+// Reorder the triangles for the post-transform cache as proposed by Forsyth.
+//
+// Vertices are scored by their position in a simulated LRU cache and by the
+// amount of triangles that still use them. The triangle with the best score
+// among the triangles of the cached vertices is emitted next, and when none
+// is left the next triangle in the original order is emitted instead.
+// ============================================================================
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	auto triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// build the lists of the triangles using each vertex.
+	std::vector<uint32_t> valences(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(triangleCount * 3);
+	for (auto index : indices) {
+		valences[index]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		offsets[i + 1] = offsets[i] + valences[i];
+	}
+	std::fill(valences.begin(), valences.end(), 0);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		auto vertex = indices[i];
+		adjacency[offsets[vertex] + valences[vertex]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	// a helper to score a vertex by the cache position and the remaining triangles.
+	float cacheScores[ForsythCacheSize];
+	for (auto i = 0; i < ForsythCacheSize; i++) {
+		cacheScores[i] = (i < 3) ? ForsythLastTriangleScore : std::pow(1.f - static_cast<float>(i - 3) / (ForsythCacheSize - 3), ForsythCacheDecayPower);
+	}
+	auto scoreVertex = [&](int cachePosition, uint32_t valence) {
+		if (valence == 0) {
+			return 0.f;
+		}
+		auto score = (cachePosition >= 0) ? cacheScores[cachePosition] : 0.f;
+		return score + ForsythValenceBoostScale * std::pow(static_cast<float>(valence), -ForsythValenceBoostPower);
+	};
+
+	// score the vertices and the triangles without anything in the cache.
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount), triangleScores(triangleCount, 0.f);
+	for (size_t i = 0; i < vertexCount; i++) {
+		vertexScores[i] = scoreVertex(-1, valences[i]);
+	}
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		triangleScores[i / 3] += vertexScores[indices[i]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output, cache, newCache;
+	output.reserve(indices.size());
+	cache.reserve(ForsythCacheSize + 3);
+	newCache.reserve(ForsythCacheSize + 3);
+	size_t nextTriangle = 0;
+	auto best = UnusedVertex;
+	for (size_t i = 0; i < triangleCount; i++) {
+		// continue with the next triangle in the input order when nothing is cached.
+		if (best == UnusedVertex) {
+			while (emitted[nextTriangle]) {
+				nextTriangle++;
+			}
+			best = static_cast<uint32_t>(nextTriangle);
+		}
+
+		// emit the triangle and remove it from the lists of its vertices.
+		emitted[best] = true;
+		auto triangle = &indices[best * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+		for (auto j = 0; j < 3; j++) {
+			auto vertex = triangle[j];
+			auto first = adjacency.begin() + offsets[vertex];
+			auto last = first + valences[vertex];
+			std::iter_swap(std::find(first, last, best), last - 1);
+			valences[vertex]--;
+		}
+
+		// move the vertices of the triangle to the front of the cache.
+		newCache.assign(triangle, triangle + 3);
+		for (auto vertex : cache) {
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+				newCache.push_back(vertex);
+			}
+		}
+		std::swap(cache, newCache);
+
+		// rescore the cached and the evicted vertices and pick the best triangle among their triangles.
+		auto bestScore = -1.f;
+		best = UnusedVertex;
+		for (size_t j = 0; j < cache.size(); j++) {
+			auto vertex = cache[j];
+			auto position = (j < ForsythCacheSize) ? static_cast<int>(j) : -1;
+			cachePositions[vertex] = position;
+			auto score = scoreVertex(position, valences[vertex]);
+			auto delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			for (auto k = offsets[vertex]; k < offsets[vertex] + valences[vertex]; k++) {
+				auto adjacent = adjacency[k];
+				triangleScores[adjacent] += delta;
+				if (position >= 0 && triangleScores[adjacent] > bestScore) {
+					bestScore = triangleScores[adjacent];
+					best = adjacent;
+				}
+			}
+		}
+		if (cache.size() > ForsythCacheSize) {
+			cache.resize(ForsythCacheSize);
+		}
+	}
+	indices.swap(output);
+}
+
+// ============================================================================
+// Reorder the clusters of the triangles so the outer ones are drawn first.
+//
+// The cache optimized order is split into clusters at the points where the
+// simulated cache starts over, and again wherever the ACMR of the cluster so
+// far stays within the threshold of the ACMR of the whole mesh. Clusters are
+// then sorted by how far they face away from the center of the mesh, so the
+// triangles which are likely in front are drawn before the ones they cover.
+// ============================================================================
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount, float threshold)
+{
+	auto triangleCount = indices.size() / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+	auto bytes = reinterpret_cast<const uint8_t*>(positions);
+	auto position = [&](uint32_t vertex) {
+		return reinterpret_cast<const float*>(bytes + vertex * positionStride);
+	};
+
+	// split the triangles into clusters with the simulated cache starting cold for each cluster.
+	auto targetAcmr = AnalyzeVertexCache(indices, vertexCount).acmr * threshold;
+	std::vector<uint64_t> insertTimes(vertexCount, 0);
+	std::vector<size_t> clusters;
+	uint64_t time = MESH_VERTEX_CACHE_SIZE + 1, clusterTime = time;
+	size_t clusterStart = 0, clusterMisses = 0;
+	for (size_t i = 0; i < triangleCount; i++) {
+		auto misses = 0;
+		for (auto j = 0; j < 3; j++) {
+			auto vertex = indices[i * 3 + j];
+			if (time - insertTimes[vertex] > MESH_VERTEX_CACHE_SIZE || insertTimes[vertex] < clusterTime) {
+				insertTimes[vertex] = time++;
+				misses++;
+			}
+		}
+		if (i == clusterStart || misses == 3) {
+			clusters.push_back(i);
+			clusterStart = i;
+			clusterTime = time - misses;
+			clusterMisses = 0;
+		}
+		clusterMisses += misses;
+		if (static_cast<float>(clusterMisses) <= targetAcmr * static_cast<float>(i - clusterStart + 1)) {
+			clusterStart = i + 1;
+			clusterTime = time;
+		}
+	}
+
+	// compute the area weighted center of the mesh and the centers and the normals of the clusters.
+	struct Cluster
+	{
+		size_t	begin;
+		size_t	end;
+		float	center[3];
+		float	normal[3];
+		float	area;
+		float	sortKey;
+	};
+	std::vector<Cluster> sorted(clusters.size());
+	float meshCenter[3] = {}, meshArea = 0.f;
+	for (size_t i = 0; i < clusters.size(); i++) {
+		auto& cluster = sorted[i];
+		cluster = { clusters[i], (i + 1 < clusters.size()) ? clusters[i + 1] : triangleCount, {}, {}, 0.f, 0.f };
+		for (auto j = cluster.begin; j < cluster.end; j++) {
+			auto a = position(indices[j * 3]), b = position(indices[j * 3 + 1]), c = position(indices[j * 3 + 2]);
+			float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float normal[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+			auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (auto k = 0; k < 3; k++) {
+				cluster.center[k] += (a[k] + b[k] + c[k]) / 3.f * area;
+				cluster.normal[k] += normal[k];
+			}
+			cluster.area += area;
+		}
+		for (auto k = 0; k < 3; k++) {
+			meshCenter[k] += cluster.center[k];
+			cluster.center[k] = (cluster.area > 0.f) ? cluster.center[k] / cluster.area : 0.f;
+		}
+		meshArea += cluster.area;
+	}
+	for (auto k = 0; k < 3; k++) {
+		meshCenter[k] = (meshArea > 0.f) ? meshCenter[k] / meshArea : 0.f;
+	}
+
+	// sort the clusters that face away from the center the most to the front.
+	for (auto& cluster : sorted) {
+		auto length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+		auto key = 0.f;
+		for (auto k = 0; k < 3; k++) {
+			key += (cluster.center[k] - meshCenter[k]) * cluster.normal[k];
+		}
+		cluster.sortKey = (length > 0.f) ? key / length : 0.f;
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (auto& cluster : sorted) {
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	}
+	indices.swap(output);
+}
+
+// ============================================================================
+// Reorder the vertices into the order they are first used by the indices.
+//
+// Vertex fetches then walk through the vertex buffer mostly sequentially.
+// Vertices that no triangle uses are dropped, and the new vertex count is
+// returned, which may be smaller than the given count.
+// ============================================================================
+size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertexCount, UnusedVertex);
+	uint32_t usedCount = 0;
+	for (auto index : indices) {
+		if (remap[index] == UnusedVertex) {
+			remap[index] = usedCount++;
+		}
+	}
+	std::vector<uint8_t> source(static_cast<uint8_t*>(vertices), static_cast<uint8_t*>(vertices) + vertexCount * vertexStride);
+	RemapVertices(source.data(), vertexCount, vertexStride, remap, vertices);
+	RemapIndices(indices, remap);
+	return usedCount;
+}
+
+// ============================================================================
+// Run all the optimization stages on the authoring vertices of a mesh.
+// ============================================================================
+MeshOptimizationReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, unsigned vertexStride, float overdrawThreshold)
+{
+	MeshOptimizationReport report = {};
+	report.vertexCountBefore = vertices.size();
+	report.bytesBefore = MeshStreamSize(vertices.size(), vertexStride, indices.size());
+	if (indices.empty()) {
+		indices.resize(vertices.size() - vertices.size() % 3);
+		std::iota(indices.begin(), indices.end(), 0u);
+	}
+
+	// a mesh without a triangle is left as it is, as the stages need the position of a vertex.
+	if (vertices.empty() || indices.empty()) {
+		report.vertexCountAfter = vertices.size();
+		report.indexCount = indices.size();
+		report.bytesAfter = report.bytesBefore;
+		return report;
+	}
+	auto before = AnalyzeVertexCache(indices, vertices.size());
+	report.acmrBefore = before.acmr;
+	report.atvrBefore = before.atvr;
+	report.overdrawBefore = AnalyzeOverdraw(indices, vertices[0].position.data(), sizeof(Vertex), vertices.size()).overdraw;
+
+	// merge the duplicate vertices.
+	std::vector<uint32_t> remap;
+	auto uniqueCount = DeduplicateVertices(vertices.data(), vertices.size(), sizeof(Vertex), remap);
+	std::vector<Vertex> unique(uniqueCount);
+	RemapVertices(vertices.data(), vertices.size(), sizeof(Vertex), remap, unique.data());
+	RemapIndices(indices, remap);
+	vertices.swap(unique);
+
+	// reorder the triangles and then the vertices in the order of the triangles.
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeOverdraw(indices, vertices[0].position.data(), sizeof(Vertex), vertices.size(), overdrawThreshold);
+	vertices.resize(OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices));
+
+	auto after = AnalyzeVertexCache(indices, vertices.size());
+	report.vertexCountAfter = vertices.size();
+	report.indexCount = indices.size();
+	report.acmrAfter = after.acmr;
+	report.atvrAfter = after.atvr;
+	report.overdrawAfter = AnalyzeOverdraw(indices, vertices[0].position.data(), sizeof(Vertex), vertices.size()).overdraw;
+	report.bytesAfter = MeshStreamSize(vertices.size(), vertexStride, indices.size());
+	return report;
+}
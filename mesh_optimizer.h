@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the size of the FIFO post-transform vertex cache simulated by the reports.
+#define MESH_VERTEX_CACHE_SIZE 16
+
+// the resolution of the views rasterized by the overdraw analysis.
+#define MESH_OVERDRAW_RESOLUTION 256
+
+// the allowed growth of the ACMR when the triangles are reordered for overdraw.
+#define MESH_OVERDRAW_THRESHOLD 1.05f
+
+// ============================================================================
+// The efficiency of a triangle order with a simulated post-transform cache.
+//
+// ACMR is the average amount of vertex shader invocations per triangle and
+// ATVR the average amount of invocations per vertex, where one is optimal.
+// ============================================================================
+struct VertexCacheStatistics
+{
+	uint64_t	transformedCount;
+	float		acmr;
+	float		atvr;
+};
+
+// ============================================================================
+// The amount of pixel shader invocations of a triangle order.
+//
+// Overdraw is the ratio of the shaded pixels to the covered pixels, where
+// one means that no covered pixel was shaded more than once.
+// ============================================================================
+struct OverdrawStatistics
+{
+	uint64_t	coveredPixels;
+	uint64_t	shadedPixels;
+	float		overdraw;
+};
+
+// ============================================================================
+// The effect of the mesh optimization with the sizes of the stored streams.
+// ============================================================================
+struct MeshOptimizationReport
+{
+	size_t		vertexCountBefore;
+	size_t		vertexCountAfter;
+	size_t		indexCount;
+	float		acmrBefore;
+	float		acmrAfter;
+	float		atvrBefore;
+	float		atvrAfter;
+	float		overdrawBefore;
+	float		overdrawAfter;
+	uint64_t	bytesBefore;
+	uint64_t	bytesAfter;
+};
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize = MESH_VERTEX_CACHE_SIZE);
+OverdrawStatistics AnalyzeOverdraw(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount);
+uint64_t MeshStreamSize(size_t vertexCount, unsigned vertexStride, size_t indexCount);
+
+// ============================================================================
+// The stages of the mesh optimization.
+//
+// Deduplication maps bitwise equal vertices into the first one and returns
+// the amount of unique vertices. The triangle orders are optimized for the
+// post-transform cache with the algorithm of Forsyth and then clustered and
+// sorted for overdraw as in Tipsify. Vertex fetch optimization places the
+// vertices in the order of their first use and drops the unused vertices.
+// ============================================================================
+size_t DeduplicateVertices(const void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& remap);
+void RemapVertices(const void* vertices, size_t vertexCount, size_t vertexStride, const std::vector<uint32_t>& remap, void* output);
+void RemapIndices(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap);
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount, float threshold = MESH_OVERDRAW_THRESHOLD);
+size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& indices);
+
+// ============================================================================
+// Run all the optimization stages on the authoring vertices of a mesh.
+//
+// Triangles without indices are indexed first. The report sizes the streams
+// with the given stride, which is the stride of the vertices in the file.
+// ============================================================================
+MeshOptimizationReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, unsigned vertexStride, float overdrawThreshold = MESH_OVERDRAW_THRESHOLD);
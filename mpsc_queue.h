@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// ============================================================================
+// A lock-free unbounded queue with many producers and a single consumer.
+//
+// Producers link a new node with a single atomic exchange and never wait. A
+// push that is still being linked is not yet visible to the consumer, which
+// then sees the queue as empty until the producer has finished the push.
+// ============================================================================
+template <typename T>
+class MpscQueue
+{
+public:
+	MpscQueue() : mHead(&mStub), mTail(&mStub) { mStub.next.store(nullptr, std::memory_order_relaxed); }
+	~MpscQueue();
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+	void Push(T value);
+	bool Pop(T& value);
+private:
+	struct Node
+	{
+		T					value;
+		std::atomic<Node*>	next;
+	};
+	Node				mStub;
+	std::atomic<Node*>	mHead;
+	Node*				mTail;
+};
+
+template <typename T>
+MpscQueue<T>::~MpscQueue()
+{
+	T value;
+	while (Pop(value)) {
+	}
+	if (mTail != &mStub) {
+		delete mTail;
+	}
+}
+
+// ============================================================================
+// Push a value into the queue. This may be called from any thread.
+// ============================================================================
+template <typename T>
+void MpscQueue<T>::Push(T value)
+{
+	auto node = new Node{ std::move(value), { nullptr } };
+	auto previous = mHead.exchange(node, std::memory_order_acq_rel);
+	previous->next.store(node, std::memory_order_release);
+}
+
+// ============================================================================
+// Pop the oldest value from the queue. Only the consumer thread may pop.
+//
+// The tail node is always a node whose value was already taken. Popping moves
+// the value out of the next node, which then becomes the new tail node.
+// ============================================================================
+template <typename T>
+bool MpscQueue<T>::Pop(T& value)
+{
+	auto tail = mTail;
+	auto next = tail->next.load(std::memory_order_acquire);
+	if (next == nullptr) {
+		return false;
+	}
+	value = std::move(next->value);
+	mTail = next;
+	if (tail != &mStub) {
+		delete tail;
+	}
+	return true;
+}
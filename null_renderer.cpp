@@ -0,0 +1,50 @@
+#include "null_renderer.h"
+
+#include <thread>
+
+NullRenderer::NullRenderer(unsigned frameLatency, std::chrono::microseconds gpuFrameTime) : mGpuFrameTime(gpuFrameTime), mFramePipeline(mQueue, frameLatency)
+{
+}
+
+// ============================================================================
+// Specify the size of the frame buffers.
+//
+// There are no frame buffers to be resized, but just like other backends the
+// function waits until the frames in flight have been completed.
+// ============================================================================
+void NullRenderer::SetWindow(unsigned, unsigned)
+{
+	WaitForGPU();
+}
+
+// ============================================================================
+// Specify the triangle list to be drawn in the following frames.
+// ============================================================================
+void NullRenderer::SetGeometry(const std::vector<Vertex>& vertices)
+{
+	mVertices = vertices;
+}
+
+// ============================================================================
+// Render a frame.
+//
+// Function goes through the frame pacing and submits a work item that simply
+// occupies the queue for the simulated GPU frame time, if any was specified.
+// ============================================================================
+void NullRenderer::Render()
+{
+	mFramePipeline.BeginFrame();
+	if (mGpuFrameTime.count() > 0) {
+		auto gpuFrameTime = mGpuFrameTime;
+		mQueue.Submit([gpuFrameTime] { std::this_thread::sleep_for(gpuFrameTime); });
+	}
+	mFramePipeline.EndFrame();
+}
+
+// ============================================================================
+// Wait for the queue to complete all rendered frames.
+// ============================================================================
+void NullRenderer::WaitForGPU()
+{
+	mFramePipeline.Flush();
+}
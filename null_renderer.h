@@ -0,0 +1,30 @@
+#pragma once
+
+#include "cpu_queue.h"
+#include "frame_pipeline.h"
+#include "render_backend.h"
+
+#include <chrono>
+#include <vector>
+
+// ============================================================================
+// A headless renderer that submits frames without drawing anything.
+//
+// Renderer only runs the frame pacing and submission path. Each frame can be
+// given a simulated GPU cost to measure how frames in flight hide latency.
+// ============================================================================
+class NullRenderer : public RenderBackend
+{
+public:
+	NullRenderer(unsigned frameLatency, std::chrono::microseconds gpuFrameTime);
+	void SetWindow(unsigned width, unsigned height) override;
+	void SetGeometry(const std::vector<Vertex>& vertices) override;
+	void Render() override;
+	void WaitForGPU() override;
+	const FramePipeline& Pipeline() const override { return mFramePipeline; }
+private:
+	std::vector<Vertex>			mVertices;
+	std::chrono::microseconds	mGpuFrameTime;
+	CpuQueue					mQueue;
+	FramePipeline				mFramePipeline;
+};
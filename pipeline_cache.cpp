@@ -0,0 +1,273 @@
+#include "pipeline_cache.h"
+#include "binary_stream.h"
+
+#include <stdexcept>
+
+// the identifier and the version of the pipeline cache file format.
+#define PIPELINE_CACHE_MAGIC 0x434F5350u
+#define PIPELINE_CACHE_VERSION 1u
+
+// ============================================================================
+// Pack the pipeline state description into a 64-bit key.
+//
+// Shader program and input layout take 16 bits each, the fill, cull and blend
+// modes take a byte each, and the render target format and the topology share
+// the last byte with 4 bits each. The key is unique for each description.
+// ============================================================================
+uint64_t PipelineStateDesc::Key() const
+{
+	return static_cast<uint64_t>(shaderProgram)
+		| static_cast<uint64_t>(inputLayout) << 16
+		| static_cast<uint64_t>(fillMode) << 32
+		| static_cast<uint64_t>(cullMode) << 40
+		| static_cast<uint64_t>(blendMode) << 48
+		| static_cast<uint64_t>(renderTargetFormat) << 56
+		| static_cast<uint64_t>(topology) << 60;
+}
+
+// ============================================================================
+// Unpack a pipeline state description from a 64-bit key.
+// ============================================================================
+PipelineStateDesc PipelineStateDesc::FromKey(uint64_t key)
+{
+	PipelineStateDesc desc;
+	desc.shaderProgram = static_cast<uint16_t>(key);
+	desc.inputLayout = static_cast<uint16_t>(key >> 16);
+	desc.fillMode = static_cast<FillMode>((key >> 32) & 0xff);
+	desc.cullMode = static_cast<CullMode>((key >> 40) & 0xff);
+	desc.blendMode = static_cast<BlendMode>((key >> 48) & 0xff);
+	desc.renderTargetFormat = static_cast<RenderTargetFormat>((key >> 56) & 0xf);
+	desc.topology = static_cast<PrimitiveTopology>((key >> 60) & 0xf);
+	return desc;
+}
+
+// ============================================================================
+// Hash a packed key for the map of the cache entries.
+//
+// The packed fields are mostly small numbers in fixed bit positions, so they
+// are mixed with the splitmix64 finalizer to spread them over all the bits.
+// ============================================================================
+size_t PipelineCache::KeyHash::operator()(uint64_t key) const
+{
+	key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+	key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+	return static_cast<size_t>(key ^ (key >> 31));
+}
+
+PipelineCache::PipelineCache(PipelineFactory& factory, unsigned workerCount) : mFactory(factory), mRequestCount(0), mCompileCount(0), mActiveCount(0), mExit(false)
+{
+	for (auto i = 0u; i < workerCount; i++) {
+		mWorkers.emplace_back(&PipelineCache::WorkerMain, this);
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWorkAvailable.notify_all();
+	for (auto& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+// ============================================================================
+// Get a pipeline or the fallback pipeline if it is not ready yet.
+//
+// A missing pipeline is queued for the workers. Fallback is not compiled on
+// demand, so it should be created at startup e.g. with the GetBlocking().
+// Function returns null when neither of the pipelines are available.
+// ============================================================================
+std::shared_ptr<PipelineObject> PipelineCache::Get(const PipelineStateDesc& desc, const PipelineStateDesc& fallback)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	auto& entry = Enqueue(desc);
+	if (entry.state == EntryState::Ready) {
+		return entry.pipeline;
+	}
+	auto fallbackEntry = mEntries.find(fallback.Key());
+	if (fallbackEntry != mEntries.end() && fallbackEntry->second.state == EntryState::Ready) {
+		return fallbackEntry->second.pipeline;
+	}
+	return nullptr;
+}
+
+// ============================================================================
+// Get a pipeline and build it on the calling thread if it is not ready yet.
+//
+// A pipeline which is already being built by a worker is waited for. Throws a
+// runtime error if the factory has failed to create the pipeline.
+// ============================================================================
+std::shared_ptr<PipelineObject> PipelineCache::GetBlocking(const PipelineStateDesc& desc)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	auto key = desc.Key();
+	auto& entry = Enqueue(desc);
+	if (entry.state == EntryState::Pending) {
+		Compile(key, lock);
+	}
+	mEntryCompleted.wait(lock, [&] { return mEntries[key].state != EntryState::Compiling; });
+	if (mEntries[key].state == EntryState::Failed) {
+		throw std::runtime_error("failed to create a pipeline state");
+	}
+	return mEntries[key].pipeline;
+}
+
+// ============================================================================
+// Queue a pipeline to be built in the background without using it yet.
+// ============================================================================
+void PipelineCache::Prewarm(const PipelineStateDesc& desc)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Enqueue(desc);
+}
+
+// ============================================================================
+// Block until the workers have built all the queued pipelines.
+// ============================================================================
+void PipelineCache::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mWorkers.empty()) {
+		while (!mQueue.empty()) {
+			auto key = mQueue.front();
+			mQueue.pop_front();
+			if (mEntries[key].state == EntryState::Pending) {
+				Compile(key, lock);
+			}
+		}
+	}
+	mEntryCompleted.wait(lock, [this] { return mQueue.empty() && mActiveCount == 0; });
+}
+
+// ============================================================================
+// Load the pipeline library and the keys of the used pipelines from a stream.
+//
+// The library is handed to the factory and the listed pipelines are queued
+// so they are ready soon after startup. Should be called before any request.
+// Function returns false if the data is invalid, which includes counts and
+// sizes beyond the end of the stream, so a corrupt cache is discarded.
+// ============================================================================
+bool PipelineCache::Load(std::istream& stream)
+{
+	uint32_t magic = 0, version = 0, count = 0;
+	if (!ReadValue(stream, magic) || !ReadValue(stream, version) || !ReadValue(stream, count)) {
+		return false;
+	}
+	if (magic != PIPELINE_CACHE_MAGIC || version != PIPELINE_CACHE_VERSION) {
+		return false;
+	}
+	auto remaining = RemainingSize(stream);
+	auto keysSize = static_cast<uint64_t>(count) * sizeof(uint64_t);
+	if (keysSize + sizeof(uint64_t) > remaining) {
+		return false;
+	}
+	std::vector<uint64_t> keys(count);
+	uint64_t size = 0;
+	if (!stream.read(reinterpret_cast<char*>(keys.data()), keysSize) || !ReadValue(stream, size)) {
+		return false;
+	}
+	if (size != remaining - keysSize - sizeof(uint64_t)) {
+		return false;
+	}
+	std::vector<uint8_t> library(static_cast<size_t>(size));
+	if (!stream.read(reinterpret_cast<char*>(library.data()), library.size())) {
+		return false;
+	}
+	mFactory.LoadPipelineLibrary(library);
+	for (auto key : keys) {
+		Prewarm(PipelineStateDesc::FromKey(key));
+	}
+	return true;
+}
+
+// ============================================================================
+// Save the keys of the built pipelines and the pipeline library into a stream.
+// ============================================================================
+void PipelineCache::Save(std::ostream& stream)
+{
+	std::vector<uint64_t> keys;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& entry : mEntries) {
+			if (entry.second.state == EntryState::Ready) {
+				keys.push_back(entry.first);
+			}
+		}
+	}
+	auto library = mFactory.SerializePipelineLibrary();
+	WriteValue(stream, PIPELINE_CACHE_MAGIC);
+	WriteValue(stream, PIPELINE_CACHE_VERSION);
+	WriteValue(stream, static_cast<uint32_t>(keys.size()));
+	stream.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(uint64_t));
+	WriteValue(stream, static_cast<uint64_t>(library.size()));
+	stream.write(reinterpret_cast<const char*>(library.data()), library.size());
+}
+
+// ============================================================================
+// Find the entry of a pipeline and queue it for the workers if it is new.
+//
+// This is where the requests are deduplicated. Must be called with the lock.
+// ============================================================================
+PipelineCache::Entry& PipelineCache::Enqueue(const PipelineStateDesc& desc)
+{
+	mRequestCount++;
+	auto key = desc.Key();
+	auto result = mEntries.emplace(key, Entry{ EntryState::Pending, nullptr });
+	if (result.second) {
+		mQueue.push_back(key);
+		mWorkAvailable.notify_one();
+	}
+	return result.first->second;
+}
+
+// ============================================================================
+// Build a pending pipeline with the factory.
+//
+// The lock is released for the duration of the build so other threads are
+// able to use the cache. Failures are stored so they are not retried.
+// ============================================================================
+void PipelineCache::Compile(uint64_t key, std::unique_lock<std::mutex>& lock)
+{
+	mEntries[key].state = EntryState::Compiling;
+	mCompileCount++;
+	lock.unlock();
+	std::shared_ptr<PipelineObject> pipeline;
+	try {
+		pipeline = mFactory.Create(PipelineStateDesc::FromKey(key));
+	} catch (...) {
+		pipeline = nullptr;
+	}
+	lock.lock();
+	auto& entry = mEntries[key];
+	entry.state = pipeline ? EntryState::Ready : EntryState::Failed;
+	entry.pipeline = std::move(pipeline);
+	mEntryCompleted.notify_all();
+}
+
+// ============================================================================
+// The main loop of a worker thread.
+//
+// Workers pop the queued keys in request order. Keys which were built by the
+// GetBlocking() in the meantime are no longer pending and they are skipped.
+// ============================================================================
+void PipelineCache::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;) {
+		mWorkAvailable.wait(lock, [this] { return mExit || !mQueue.empty(); });
+		if (mExit) {
+			return;
+		}
+		auto key = mQueue.front();
+		mQueue.pop_front();
+		if (mEntries[key].state == EntryState::Pending) {
+			mActiveCount++;
+			Compile(key, lock);
+			mActiveCount--;
+			mEntryCompleted.notify_all();
+		}
+	}
+}
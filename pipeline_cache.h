@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// Enumerations of the configurable pipeline states.
+// ============================================================================
+enum class FillMode : uint8_t { Solid, Wireframe };
+enum class CullMode : uint8_t { None, Front, Back };
+enum class BlendMode : uint8_t { Opaque, Alpha, Additive };
+enum class RenderTargetFormat : uint8_t { RGBA8, BGRA8, RGBA16F };
+enum class PrimitiveTopology : uint8_t { Triangle, Line, Point };
+
+// ============================================================================
+// A compact description of a graphics pipeline state permutation.
+//
+// Shader programs and input layouts are referred with the identifiers given
+// by the application. The whole description packs into a single 64-bit key.
+// ============================================================================
+struct PipelineStateDesc
+{
+	uint16_t			shaderProgram;
+	uint16_t			inputLayout;
+	FillMode			fillMode;
+	CullMode			cullMode;
+	BlendMode			blendMode;
+	RenderTargetFormat	renderTargetFormat;
+	PrimitiveTopology	topology;
+
+	uint64_t Key() const;
+	static PipelineStateDesc FromKey(uint64_t key);
+};
+
+// ============================================================================
+// A base class for the platform specific pipeline state objects.
+// ============================================================================
+class PipelineObject
+{
+public:
+	virtual ~PipelineObject() = default;
+};
+
+// ============================================================================
+// An interface for the devices that create the pipeline state objects.
+//
+// Factory is called from the worker threads of the cache so it must be thread
+// safe. It may also keep a serializable library of the created pipelines.
+// ============================================================================
+class PipelineFactory
+{
+public:
+	virtual ~PipelineFactory() = default;
+	virtual std::shared_ptr<PipelineObject> Create(const PipelineStateDesc& desc) = 0;
+	virtual void LoadPipelineLibrary(const std::vector<uint8_t>& data) = 0;
+	virtual std::vector<uint8_t> SerializePipelineLibrary() = 0;
+};
+
+// ============================================================================
+// A cache of pipeline state objects with background compilation.
+//
+// Requests are deduplicated by the state key. Missing permutations are built
+// on worker threads while the caller is handed back a fallback pipeline.
+// ============================================================================
+class PipelineCache
+{
+public:
+	PipelineCache(PipelineFactory& factory, unsigned workerCount);
+	~PipelineCache();
+	std::shared_ptr<PipelineObject> Get(const PipelineStateDesc& desc, const PipelineStateDesc& fallback);
+	std::shared_ptr<PipelineObject> GetBlocking(const PipelineStateDesc& desc);
+	void Prewarm(const PipelineStateDesc& desc);
+	void WaitIdle();
+	bool Load(std::istream& stream);
+	void Save(std::ostream& stream);
+	unsigned RequestCount() const { return mRequestCount; }
+	unsigned CompileCount() const { return mCompileCount; }
+private:
+	enum class EntryState { Pending, Compiling, Ready, Failed };
+	struct Entry
+	{
+		EntryState						state;
+		std::shared_ptr<PipelineObject>	pipeline;
+	};
+	struct KeyHash
+	{
+		size_t operator()(uint64_t key) const;
+	};
+	Entry& Enqueue(const PipelineStateDesc& desc);
+	void Compile(uint64_t key, std::unique_lock<std::mutex>& lock);
+	void WorkerMain();
+private:
+	PipelineFactory&							mFactory;
+	std::unordered_map<uint64_t, Entry, KeyHash>	mEntries;
+	std::deque<uint64_t>						mQueue;
+	std::mutex									mMutex;
+	std::condition_variable						mWorkAvailable;
+	std::condition_variable						mEntryCompleted;
+	std::vector<std::thread>					mWorkers;
+	unsigned									mRequestCount;
+	unsigned									mCompileCount;
+	unsigned									mActiveCount;
+	bool										mExit;
+};
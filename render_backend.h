@@ -0,0 +1,23 @@
+#pragma once
+
+#include "frame_pipeline.h"
+#include "vertex.h"
+
+#include <vector>
+
+// ============================================================================
+// An interface for the platform-neutral rendering backends.
+//
+// Backend mirrors the surface of the D3D12 renderer, but without any platform
+// specific window type, so it can drive headless renderings e.g. on Linux.
+// ============================================================================
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+	virtual void SetWindow(unsigned width, unsigned height) = 0;
+	virtual void SetGeometry(const std::vector<Vertex>& vertices) = 0;
+	virtual void Render() = 0;
+	virtual void WaitForGPU() = 0;
+	virtual const FramePipeline& Pipeline() const = 0;
+};
@@ -0,0 +1,348 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// a helper to align an offset up to the given power of two alignment.
+static uint64_t AlignUp(uint64_t offset, uint64_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+RenderGraph::RenderGraph(RenderGraphBackend& backend) : mBackend(backend), mTransientSize(0), mCompiled(false), mStatistics()
+{
+}
+
+// ============================================================================
+// Remove all passes and textures to start declaring the graph of a new frame.
+// ============================================================================
+void RenderGraph::Reset()
+{
+	mPasses.clear();
+	mTextures.clear();
+	mSchedule.clear();
+	mPlacementOrder.clear();
+	mTransientSize = 0;
+	mCompiled = false;
+}
+
+// ============================================================================
+// Import an externally owned texture such as a back buffer into the graph.
+//
+// Imported textures are the outputs of the graph, so the passes writing them
+// are never culled. The texture is left in the final state after execution.
+// ============================================================================
+uint32_t RenderGraph::ImportTexture(const char* name, void* texture, ResourceState finalState)
+{
+	if (texture == nullptr) {
+		throw std::invalid_argument("importing a null texture into the render graph");
+	}
+	mTextures.push_back({ name, {}, texture, true, finalState, {}, 0, RENDER_GRAPH_NONE, RENDER_GRAPH_NONE, 0, 0, 0, false });
+	mCompiled = false;
+	return static_cast<uint32_t>(mTextures.size() - 1);
+}
+
+// ============================================================================
+// Declare a transient texture whose memory is provided by the render graph.
+// ============================================================================
+uint32_t RenderGraph::CreateTexture(const char* name, const TextureDesc& desc)
+{
+	if (desc.width == 0 || desc.height == 0) {
+		throw std::invalid_argument("creating an empty texture in the render graph");
+	}
+	mTextures.push_back({ name, desc, nullptr, false, ResourceState::Common, {}, 0, RENDER_GRAPH_NONE, RENDER_GRAPH_NONE, 0, 0, 0, false });
+	mCompiled = false;
+	return static_cast<uint32_t>(mTextures.size() - 1);
+}
+
+// ============================================================================
+// Add a pass with a callback that records its commands on the execution.
+// ============================================================================
+uint32_t RenderGraph::AddPass(const char* name, ExecuteCallback execute)
+{
+	mPasses.push_back({ name, std::move(execute), {}, false, 0 });
+	mCompiled = false;
+	return static_cast<uint32_t>(mPasses.size() - 1);
+}
+
+// ============================================================================
+// Declare that a pass reads a texture in the given state.
+// ============================================================================
+void RenderGraph::Read(uint32_t pass, uint32_t texture, ResourceState state)
+{
+	mTextures.at(texture);
+	mPasses.at(pass).accesses.push_back({ texture, state, false });
+	mCompiled = false;
+}
+
+// ============================================================================
+// Declare that a pass writes a texture in the given state.
+// ============================================================================
+void RenderGraph::Write(uint32_t pass, uint32_t texture, ResourceState state)
+{
+	mTextures.at(texture).writers.push_back(pass);
+	mPasses.at(pass).accesses.push_back({ texture, state, true });
+	mCompiled = false;
+}
+
+// ============================================================================
+// Prevent a pass with side effects outside the graph from being culled.
+// ============================================================================
+void RenderGraph::KeepAlive(uint32_t pass)
+{
+	mPasses.at(pass).keepAlive = true;
+	mCompiled = false;
+}
+
+// ============================================================================
+// Compile the declared passes into a schedule for the execution.
+//
+// Unused passes are culled first and the remaining passes keep the order of
+// the declaration. Transient textures are then placed into memory according
+// to their lifetimes within the schedule.
+// ============================================================================
+void RenderGraph::Compile()
+{
+	for (uint32_t i = 0; i < mPasses.size(); i++) {
+		for (auto& access : mPasses[i].accesses) {
+			auto& writers = mTextures[access.texture].writers;
+			if (!access.write && !mTextures[access.texture].imported && std::none_of(writers.begin(), writers.end(), [&](uint32_t writer) { return writer < i; })) {
+				throw std::logic_error("reading a transient texture before it is written");
+			}
+		}
+	}
+
+	CullPasses();
+	mSchedule.clear();
+	for (uint32_t i = 0; i < mPasses.size(); i++) {
+		if (mPasses[i].references > 0) {
+			mSchedule.push_back(i);
+		}
+	}
+	PlaceTransientTextures();
+
+	mStatistics = {};
+	mStatistics.passCount = static_cast<unsigned>(mPasses.size());
+	mStatistics.culledPassCount = static_cast<unsigned>(mPasses.size() - mSchedule.size());
+	mStatistics.transientTextureCount = static_cast<unsigned>(mPlacementOrder.size());
+	for (auto texture : mPlacementOrder) {
+		mStatistics.transientBytes += mTextures[texture].size;
+	}
+	mStatistics.aliasedBytes = mTransientSize;
+	mCompiled = true;
+}
+
+// ============================================================================
+// Cull the passes whose outputs are not used by the graph.
+//
+// Each pass is referenced by the textures it writes and each texture by the
+// passes that read it. A texture without references releases its writers,
+// which in turn release the textures they read until nothing changes.
+// ============================================================================
+void RenderGraph::CullPasses()
+{
+	for (auto& texture : mTextures) {
+		texture.references = texture.imported ? 1 : 0;
+	}
+	for (auto& pass : mPasses) {
+		pass.references = pass.keepAlive ? 1 : 0;
+		for (auto& access : pass.accesses) {
+			if (access.write) {
+				pass.references++;
+			} else {
+				mTextures[access.texture].references++;
+			}
+		}
+	}
+
+	mCulledTextures.clear();
+	for (uint32_t i = 0; i < mTextures.size(); i++) {
+		if (mTextures[i].references == 0) {
+			mCulledTextures.push_back(i);
+		}
+	}
+	while (!mCulledTextures.empty()) {
+		auto texture = mCulledTextures.back();
+		mCulledTextures.pop_back();
+		for (auto writer : mTextures[texture].writers) {
+			auto& pass = mPasses[writer];
+			if (pass.references == 0 || --pass.references > 0) {
+				continue;
+			}
+			for (auto& access : pass.accesses) {
+				if (!access.write && --mTextures[access.texture].references == 0) {
+					mCulledTextures.push_back(access.texture);
+				}
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Place the transient textures into a shared memory range.
+//
+// Textures are placed in the order of their first use at the lowest offset
+// which does not overlap a texture that is still alive. Textures may then
+// share memory, so they are activated on their first use on the execution.
+// ============================================================================
+void RenderGraph::PlaceTransientTextures()
+{
+	for (auto& texture : mTextures) {
+		texture.firstUse = texture.lastUse = RENDER_GRAPH_NONE;
+	}
+	mPlacementOrder.clear();
+	for (uint32_t i = 0; i < mSchedule.size(); i++) {
+		for (auto& access : mPasses[mSchedule[i]].accesses) {
+			auto& texture = mTextures[access.texture];
+			if (texture.imported) {
+				continue;
+			}
+			if (texture.firstUse == RENDER_GRAPH_NONE) {
+				texture.firstUse = i;
+				mBackend.TextureAllocationInfo(texture.desc, texture.size, texture.alignment);
+				mPlacementOrder.push_back(access.texture);
+			}
+			texture.lastUse = i;
+		}
+	}
+
+	mTransientSize = 0;
+	mLiveTextures.clear();
+	for (auto index : mPlacementOrder) {
+		auto& texture = mTextures[index];
+		mLiveTextures.erase(std::remove_if(mLiveTextures.begin(), mLiveTextures.end(), [&](uint32_t live) { return mTextures[live].lastUse < texture.firstUse; }), mLiveTextures.end());
+
+		// find the first gap between the live textures that fits the texture.
+		auto offset = AlignUp(0, texture.alignment);
+		auto position = mLiveTextures.begin();
+		for (; position != mLiveTextures.end(); ++position) {
+			auto& live = mTextures[*position];
+			if (offset + texture.size <= live.offset) {
+				break;
+			}
+			offset = std::max(offset, AlignUp(live.offset + live.size, texture.alignment));
+		}
+		texture.offset = offset;
+		mLiveTextures.insert(position, index);
+		mTransientSize = std::max(mTransientSize, offset + texture.size);
+	}
+}
+
+// ============================================================================
+// Execute the compiled passes and record the barriers they need.
+//
+// Barriers of each pass are inferred from its accesses with the tracker and
+// submitted as a single batch before the pass is executed. Imported textures
+// are finally moved into their final states.
+// ============================================================================
+void RenderGraph::Execute(ResourceStateTracker& tracker)
+{
+	if (!mCompiled) {
+		throw std::logic_error("executing a render graph that is not compiled");
+	}
+	mStatistics.barrierCount = 0;
+	mStatistics.barrierBatchCount = 0;
+
+	// acquire the transient textures and track the ones the graph has not seen before.
+	mBackend.ReserveTransientMemory(mTransientSize);
+	std::sort(mPreviousHandles.begin(), mPreviousHandles.end());
+	mTransientHandles.clear();
+	for (auto index : mPlacementOrder) {
+		auto& texture = mTextures[index];
+		texture.created = false;
+		texture.handle = mBackend.AcquireTransientTexture(texture.desc, texture.offset, texture.created);
+		if (texture.created || !std::binary_search(mPreviousHandles.begin(), mPreviousHandles.end(), texture.handle)) {
+			tracker.Register(texture.handle, 1, ResourceState::Common);
+		}
+		mTransientHandles.push_back(texture.handle);
+	}
+	std::sort(mTransientHandles.begin(), mTransientHandles.end());
+	for (auto handle : mPreviousHandles) {
+		if (!std::binary_search(mTransientHandles.begin(), mTransientHandles.end(), handle)) {
+			tracker.Unregister(handle);
+		}
+	}
+	std::swap(mPreviousHandles, mTransientHandles);
+
+	// transition the textures of each pass before executing it.
+	for (uint32_t i = 0; i < mSchedule.size(); i++) {
+		auto& pass = mPasses[mSchedule[i]];
+		mBarriers.clear();
+		for (auto& access : pass.accesses) {
+			auto& texture = mTextures[access.texture];
+			auto activated = !texture.imported && texture.firstUse == i && ActivateTexture(texture);
+			if (activated && std::none_of(mBarriers.begin(), mBarriers.end(), [&](const ResourceBarrier& barrier) { return barrier.resource == texture.handle; })) {
+				mBarriers.push_back({ ResourceBarrier::Type::Aliasing, texture.handle, ALL_SUBRESOURCES, ResourceState::Common, ResourceState::Common });
+			}
+			tracker.Transition(texture.handle, access.state);
+		}
+		SubmitBarriers(tracker);
+		if (pass.execute) {
+			pass.execute(*this);
+		}
+	}
+
+	// leave the imported textures in the states their owners expect.
+	mBarriers.clear();
+	for (auto& texture : mTextures) {
+		if (texture.imported) {
+			tracker.Transition(texture.handle, texture.finalState);
+		}
+	}
+	SubmitBarriers(tracker);
+}
+
+// ============================================================================
+// Get the texture of the backend for a texture of the graph.
+//
+// Transient textures are only available while the graph is being executed.
+// ============================================================================
+void* RenderGraph::Texture(uint32_t texture) const
+{
+	return mTextures.at(texture).handle;
+}
+
+// ============================================================================
+// Make a transient texture the active user of its memory range.
+//
+// The ranges of the memory are kept with the texture that used them last,
+// also over the frames. Function returns true if a different texture or an
+// earlier texture that has been created again used any part of the range,
+// in which case the texture needs an aliasing barrier before it is used.
+// ============================================================================
+bool RenderGraph::ActivateTexture(const TextureNode& texture)
+{
+	auto begin = texture.offset, end = texture.offset + texture.size;
+	auto aliased = false;
+	mSplitRanges.clear();
+	for (auto& range : mActiveRanges) {
+		if (range.end <= begin || end <= range.begin) {
+			mSplitRanges.push_back(range);
+			continue;
+		}
+		aliased |= texture.created || range.handle != texture.handle;
+		if (range.begin < begin) {
+			mSplitRanges.push_back({ range.begin, begin, range.handle });
+		}
+		if (end < range.end) {
+			mSplitRanges.push_back({ end, range.end, range.handle });
+		}
+	}
+	mSplitRanges.push_back({ begin, end, texture.handle });
+	std::swap(mActiveRanges, mSplitRanges);
+	return aliased;
+}
+
+// ============================================================================
+// Submit the queued barriers together with the tracked ones as a batch.
+// ============================================================================
+void RenderGraph::SubmitBarriers(ResourceStateTracker& tracker)
+{
+	tracker.Flush(mBarriers);
+	if (mBarriers.empty()) {
+		return;
+	}
+	mBackend.ResourceBarriers(mBarriers);
+	mStatistics.barrierCount += static_cast<unsigned>(mBarriers.size());
+	mStatistics.barrierBatchCount++;
+}
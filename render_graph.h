@@ -0,0 +1,142 @@
+#pragma once
+
+#include "resource_state_tracker.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// an identifier that refers to no pass or resource of a render graph.
+#define RENDER_GRAPH_NONE UINT32_MAX
+
+// ============================================================================
+// The formats of the textures created by the render graph.
+// ============================================================================
+enum class TextureFormat : uint8_t { RGBA8, BGRA8, RGBA16F, D32 };
+
+// ============================================================================
+// A description of a transient texture that lives within a single frame.
+// ============================================================================
+struct TextureDesc
+{
+	uint32_t		width;
+	uint32_t		height;
+	TextureFormat	format;
+};
+
+// ============================================================================
+// An interface for the devices that provide the textures for a render graph.
+//
+// Transient textures are placed into a single memory range which the backend
+// reserves. Backend may keep the textures over the frames, but it reports a
+// newly created texture so that the graph can track its state from scratch.
+// ============================================================================
+class RenderGraphBackend
+{
+public:
+	virtual ~RenderGraphBackend() = default;
+	virtual void TextureAllocationInfo(const TextureDesc& desc, uint64_t& size, uint64_t& alignment) = 0;
+	virtual void ReserveTransientMemory(uint64_t size) = 0;
+	virtual void* AcquireTransientTexture(const TextureDesc& desc, uint64_t offset, bool& created) = 0;
+	virtual void ResourceBarriers(const std::vector<ResourceBarrier>& barriers) = 0;
+};
+
+// ============================================================================
+// The statistics of the last compiled and executed render graph.
+// ============================================================================
+struct RenderGraphStatistics
+{
+	unsigned	passCount;
+	unsigned	culledPassCount;
+	unsigned	transientTextureCount;
+	uint64_t	transientBytes;
+	uint64_t	aliasedBytes;
+	unsigned	barrierCount;
+	unsigned	barrierBatchCount;
+};
+
+// ============================================================================
+// A graph of the render passes of a frame and the textures they access.
+//
+// Passes declare which textures they read and write and the graph compiles
+// them into a schedule in the declaration order. Passes that do not lead to
+// an imported texture are culled, and transient textures whose lifetimes do
+// not overlap share the same memory. Barriers are inferred on the execution.
+// ============================================================================
+class RenderGraph
+{
+public:
+	typedef std::function<void(const RenderGraph& graph)> ExecuteCallback;
+	explicit RenderGraph(RenderGraphBackend& backend);
+	void Reset();
+	uint32_t ImportTexture(const char* name, void* texture, ResourceState finalState);
+	uint32_t CreateTexture(const char* name, const TextureDesc& desc);
+	uint32_t AddPass(const char* name, ExecuteCallback execute);
+	void Read(uint32_t pass, uint32_t texture, ResourceState state);
+	void Write(uint32_t pass, uint32_t texture, ResourceState state);
+	void KeepAlive(uint32_t pass);
+	void Compile();
+	void Execute(ResourceStateTracker& tracker);
+	void* Texture(uint32_t texture) const;
+	bool IsCulled(uint32_t pass) const { return mPasses.at(pass).references == 0; }
+	uint64_t TransientOffset(uint32_t texture) const { return mTextures.at(texture).offset; }
+	const std::vector<uint32_t>& Schedule() const { return mSchedule; }
+	const RenderGraphStatistics& Statistics() const { return mStatistics; }
+private:
+	struct Access
+	{
+		uint32_t		texture;
+		ResourceState	state;
+		bool			write;
+	};
+	struct Pass
+	{
+		const char*			name;
+		ExecuteCallback		execute;
+		std::vector<Access>	accesses;
+		bool				keepAlive;
+		unsigned			references;
+	};
+	struct TextureNode
+	{
+		const char*		name;
+		TextureDesc		desc;
+		void*			handle;
+		bool			imported;
+		ResourceState	finalState;
+		std::vector<uint32_t>	writers;
+		unsigned		references;
+		uint32_t		firstUse;
+		uint32_t		lastUse;
+		uint64_t		size;
+		uint64_t		alignment;
+		uint64_t		offset;
+		bool			created;
+	};
+	struct ActiveRange
+	{
+		uint64_t	begin;
+		uint64_t	end;
+		void*		handle;
+	};
+	void CullPasses();
+	void PlaceTransientTextures();
+	bool ActivateTexture(const TextureNode& texture);
+	void SubmitBarriers(ResourceStateTracker& tracker);
+private:
+	RenderGraphBackend&			mBackend;
+	std::vector<Pass>			mPasses;
+	std::vector<TextureNode>	mTextures;
+	std::vector<uint32_t>		mSchedule;
+	std::vector<uint32_t>		mPlacementOrder;
+	std::vector<uint32_t>		mLiveTextures;
+	std::vector<uint32_t>		mCulledTextures;
+	std::vector<void*>			mTransientHandles;
+	std::vector<void*>			mPreviousHandles;
+	std::vector<ResourceBarrier>	mBarriers;
+	std::vector<ActiveRange>	mActiveRanges;
+	std::vector<ActiveRange>	mSplitRanges;
+	uint64_t					mTransientSize;
+	bool						mCompiled;
+	RenderGraphStatistics		mStatistics;
+};
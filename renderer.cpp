@@ -1,7 +1,19 @@
 #include "renderer.h"
+#include "d3d_shader_compiler.h"
+#include "d3d12_vertex_format.h"
+#include "dx_helpers.h"
+#include "frame_profiler.h"
+#include "vertex_packing.h"
 
 #include <array>
-#include <d3dcompiler.h>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+// include the shader blobs generated with the shader_embed tool when requested.
+#if defined(EMBEDDED_SHADERS)
+#include "embedded_shaders.h"
+#endif
 
 // undefine min macro and use the std::min from the <algorithm>
 #if defined(min)
@@ -14,33 +26,128 @@
 #endif
 
 using namespace Windows::Graphics::Display;
+using namespace Windows::Storage;
 using namespace Microsoft::WRL;
 
 // a constant for black color
 const float BlackColor[] = { 0.f, 0.f, 0.f, 1.f };
 
-// vertex structure
-struct Vertex
-{
-	std::array<float, 3> position;
-	std::array<float, 4> color;
+// identifiers of the shader programs and input layouts used in the pipelines.
+const uint16_t ColorShaderProgram = 0;
+const uint16_t UpscaleShaderProgram = 1;
+const uint16_t VertexInputLayout = 0;
+const uint16_t EmptyInputLayout = 1;
+
+// identifiers of the pipeline and the geometry of the loaded mesh in the instance batches.
+const uint32_t MeshPipeline = 0;
+const uint32_t MeshGeometry = 0;
+
+// the identifier of the loaded mesh object in the visibility hierarchy.
+const uint32_t MeshObject = 0;
+
+// the input elements of the instance streams, each bound into its own slot after the vertices.
+const D3D12_INPUT_ELEMENT_DESC InstanceInputElements[INSTANCE_STREAM_COUNT] = {
+	{ "INSTANCE", 0, DXGI_FORMAT_R32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE", 1, DXGI_FORMAT_R32_FLOAT, 2, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE", 2, DXGI_FORMAT_R32_FLOAT, 3, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE", 3, DXGI_FORMAT_R32_FLOAT, 4, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE", 4, DXGI_FORMAT_R8G8B8A8_UNORM, 5, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
 };
 
-// a helper macro to allow writing shader code as a multiline string.
-#define SHADER(CODE) #CODE
+// the pipeline state used to draw the triangle and as the fallback pipeline.
+const PipelineStateDesc DefaultPipeline = {
+	ColorShaderProgram,
+	VertexInputLayout,
+	FillMode::Solid,
+	CullMode::Back,
+	BlendMode::Opaque,
+	RenderTargetFormat::RGBA8,
+	PrimitiveTopology::Triangle
+};
+
+// the pipeline state used to upscale the scene into the back buffer with a full screen triangle.
+const PipelineStateDesc UpscalePipeline = {
+	UpscaleShaderProgram,
+	EmptyInputLayout,
+	FillMode::Solid,
+	CullMode::None,
+	BlendMode::Opaque,
+	RenderTargetFormat::RGBA8,
+	PrimitiveTopology::Triangle
+};
+
+// a helper to get the tuning of the dynamic resolution, which drops the scale fast and restores it slowly.
+static ResolutionControllerDesc DynamicResolution(unsigned frameLatency)
+{
+	return { RESOLUTION_BUDGET_MILLISECONDS, RESOLUTION_MINIMUM_SCALE, 1.f, 0.05f, 0.75, 1.0, 30, 2, frameLatency };
+}
+
+// a helper to get the bounds of a box rotated around the z axis as the vertex shader rotates the mesh.
+static Aabb RotateBounds(const Aabb& bounds, float angle)
+{
+	auto sine = std::sin(angle), cosine = std::cos(angle);
+	Aabb rotated = { { INFINITY, INFINITY, bounds.minimum[2] }, { -INFINITY, -INFINITY, bounds.maximum[2] } };
+	for (auto corner = 0; corner < 4; corner++) {
+		auto x = (corner & 1) ? bounds.maximum[0] : bounds.minimum[0];
+		auto y = (corner & 2) ? bounds.maximum[1] : bounds.minimum[1];
+		float placed[2] = { cosine * x - sine * y, sine * x + cosine * y };
+		for (auto axis = 0; axis < 2; axis++) {
+			rotated.minimum[axis] = std::min(rotated.minimum[axis], placed[axis]);
+			rotated.maximum[axis] = std::max(rotated.maximum[axis], placed[axis]);
+		}
+	}
+	return rotated;
+}
 
-// a helper utility to throw exception on failure HRESULTs.
-inline void ThrowIfFailed(HRESULT hr) {
-	if (FAILED(hr)) {
-		throw Platform::Exception::CreateException(hr);
+// a helper to get the bounds of the authoring vertices, e.g. of the triangle drawn before a mesh is loaded.
+static Aabb VertexBounds(const std::vector<Vertex>& vertices)
+{
+	Aabb bounds = { { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY } };
+	for (auto& vertex : vertices) {
+		for (auto axis = 0; axis < 3; axis++) {
+			bounds.minimum[axis] = std::min(bounds.minimum[axis], vertex.position[axis]);
+			bounds.maximum[axis] = std::max(bounds.maximum[axis], vertex.position[axis]);
+		}
 	}
+	return bounds;
 }
 
-Renderer::Renderer() : mRTVDescriptorSize(0), mScissors{0, 0, LONG_MAX, LONG_MAX}, mBufferIndex(0)
+// a helper to get the path of the pipeline cache file in the local cache folder.
+static std::wstring PipelineCachePath()
+{
+	return std::wstring(ApplicationData::Current->LocalCacheFolder->Path->Data()) + L"\\pipelines.bin";
+}
+
+// the constants of a frame bound as a root constant buffer view.
+struct FrameConstants
+{
+	std::array<float, 16> transform;
+};
+
+// a helper macro to allow writing shader code as a multiline string.
+#define SHADER(CODE) #CODE
+
+Renderer::Renderer(unsigned frameLatency, const FramePacingDesc& pacing, JobSystem& jobSystem) : mBackBufferViews(), mSceneTargetView(), mSceneTextureView(), mFrameListCount(0), mGeometryFence(0), mIndexCount(0), mCapture(CAPTURE_RESIDENT_SIZE, CAPTURE_FRAME_SIZE), mCaptureVertexBuffer(CAPTURE_NO_BUFFER), mCaptureIndexBuffer(CAPTURE_NO_BUFFER), mPacingDesc(pacing), mSwapChainFlags(0), mFrameLatencyWaitable(nullptr), mBackBufferBytes(0), mTransientBytes(0), mScissors{0, 0, LONG_MAX, LONG_MAX}, mResolutionController(DynamicResolution(frameLatency)), mScene{0.f}, mBufferIndex(0)
 {
 	// create a factory or DXGI item instances.
 	ThrowIfFailed(CreateDXGIFactory2(0u, IID_PPV_ARGS(&mDXGIFactory)));
 
+	// fall back to vsync when the display does not support tearing.
+	if (mPacingDesc.mode == PresentMode::Tearing) {
+		ComPtr<IDXGIFactory5> factory;
+		BOOL allowTearing = FALSE;
+		if (FAILED(mDXGIFactory.As(&factory)) || FAILED(factory->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing))) || !allowTearing) {
+			mPacingDesc.mode = PresentMode::Vsync;
+		}
+	}
+
+	// select the swap chain flags of the present mode.
+	if (mPacingDesc.mode == PresentMode::Tearing) {
+		mSwapChainFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+	} else if (mPacingDesc.mode == PresentMode::LatencyWaitable) {
+		mSwapChainFlags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+	}
+
 	// find the first suitable graphics adapter for D3D12.
 	ComPtr<IDXGIAdapter1> adapter;
 	for (auto i = 0u; !mDXGIAdapter && mDXGIFactory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
@@ -75,44 +182,91 @@ Renderer::Renderer() : mRTVDescriptorSize(0), mScissors{0, 0, LONG_MAX, LONG_MAX
 	queueDescriptor.NodeMask = 0;
 	ThrowIfFailed(mDevice->CreateCommandQueue(&queueDescriptor, IID_PPV_ARGS(&mCommandQueue)));
 
-	// create a heap descriptor for the render target view (RTV).
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDescriptor = {};
-	rtvHeapDescriptor.NumDescriptors = BUFFER_COUNT;
-	rtvHeapDescriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	ThrowIfFailed(mDevice->CreateDescriptorHeap(&rtvHeapDescriptor, IID_PPV_ARGS(&mRTVHeap)));
-
-	// store the render target view descriptor size for further usage.
-	mRTVDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-	// create a command allocator for each buffer.
-	for (auto i = 0u; i < BUFFER_COUNT; i++) {
-		ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mCommandAllocators[i])));
-	}
+	// create the CPU descriptor heaps and allocate the render target views (RTV) of the back buffers and the scene target.
+	mDescriptorDevice = std::make_unique<D3D12DescriptorDevice>(mDevice.Get());
+	mRTVAllocator = std::make_unique<CpuDescriptorAllocator>(*mDescriptorDevice, DescriptorHeapType::RenderTarget, DESCRIPTOR_HEAP_CAPACITY);
+	mViewAllocator = std::make_unique<CpuDescriptorAllocator>(*mDescriptorDevice, DescriptorHeapType::Resource, DESCRIPTOR_HEAP_CAPACITY);
+	mBackBufferViews = mRTVAllocator->Allocate(BUFFER_COUNT);
+	mSceneTargetView = mRTVAllocator->Allocate();
+
+	// the shader resource view (SRV) of the scene target is written into a CPU heap and copied into the ring for drawing.
+	mSceneTextureView = mViewAllocator->Allocate();
+
+	// create a fence timeline to keep the requested amount of frames in flight.
+	mTimeline = std::make_unique<D3D12Timeline>(mDevice.Get(), mCommandQueue.Get());
+
+	// create the shader visible descriptor ring whose tables are reclaimed with the frames.
+	mDescriptorRing = std::make_unique<DescriptorRing>(*mDescriptorDevice, *mTimeline, DescriptorHeapType::Resource, DESCRIPTOR_RING_CAPACITY);
+	mDescriptorCopies = std::make_unique<DescriptorCopyBatch>(*mDescriptorDevice, DescriptorHeapType::Resource);
+	mFramePipeline = std::make_unique<FramePipeline>(*mTimeline, frameLatency);
+
+	// create timestamp queries to measure the GPU time of each frame.
+	mGpuProfiler = std::make_unique<D3D12GpuProfiler>(mDevice.Get(), mCommandQueue.Get(), frameLatency);
+
+	// define a root constant buffer view for the per-frame constants.
+	D3D12_ROOT_PARAMETER rootParameters[2] = {};
+	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootParameters[0].Descriptor.ShaderRegister = 0;
+	rootParameters[0].Descriptor.RegisterSpace = 0;
+	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+
+	// define a descriptor table with the scene texture read by the upscale pass.
+	D3D12_DESCRIPTOR_RANGE textureRange = {};
+	textureRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	textureRange.NumDescriptors = 1;
+	textureRange.BaseShaderRegister = 0;
+	textureRange.RegisterSpace = 0;
+	textureRange.OffsetInDescriptorsFromTableStart = 0;
+	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rootParameters[1].DescriptorTable.NumDescriptorRanges = 1;
+	rootParameters[1].DescriptorTable.pDescriptorRanges = &textureRange;
+	rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	// define a bilinear sampler for the upscale pass.
+	D3D12_STATIC_SAMPLER_DESC samplerDescriptor = {};
+	samplerDescriptor.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDescriptor.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDescriptor.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDescriptor.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDescriptor.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+	samplerDescriptor.MaxLOD = D3D12_FLOAT32_MAX;
+	samplerDescriptor.ShaderRegister = 0;
+	samplerDescriptor.RegisterSpace = 0;
+	samplerDescriptor.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
 	// create a new root signature.
 	ComPtr<ID3DBlob> signature, error;
 	D3D12_ROOT_SIGNATURE_DESC signatureDesc = {};
-	signatureDesc.NumParameters = 0;
-	signatureDesc.pParameters = nullptr;
-	signatureDesc.NumStaticSamplers = 0;
-	signatureDesc.pStaticSamplers = nullptr;
+	signatureDesc.NumParameters = 2;
+	signatureDesc.pParameters = rootParameters;
+	signatureDesc.NumStaticSamplers = 1;
+	signatureDesc.pStaticSamplers = &samplerDescriptor;
 	signatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 	ThrowIfFailed(D3D12SerializeRootSignature(&signatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
 	ThrowIfFailed(mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
 
-	// compile vertex and pixel shader.
+	// define the source code for the vertex and pixel shader.
 	auto shaderSrc = SHADER(
+		cbuffer FrameConstants : register(b0)
+		{
+			row_major float4x4 transform;
+		};
+
 		struct PSInput
 		{
 			float4 position : SV_POSITION;
 			float4 color : COLOR;
 		};
 
-		PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+		PSInput VSMain(float4 position : POSITION, float4 color : COLOR, float offsetX : INSTANCE0, float offsetY : INSTANCE1, float scale : INSTANCE2, float rotation : INSTANCE3, float4 tint : INSTANCE4)
 		{
+			float sine;
+			float cosine;
+			sincos(rotation, sine, cosine);
+			float2 placed = float2(cosine * position.x - sine * position.y, sine * position.x + cosine * position.y) * scale + float2(offsetX, offsetY);
 			PSInput result;
-			result.position = position;
-			result.color = color;
+			result.position = mul(transform, float4(placed, position.z, position.w));
+			result.color = color * tint;
 			return result;
 		}
 
@@ -120,103 +274,125 @@ Renderer::Renderer() : mRTVDescriptorSize(0), mScissors{0, 0, LONG_MAX, LONG_MAX
 		{
 		  return input.color;
 		}
+
+		Texture2D sceneTexture : register(t0);
+		SamplerState linearSampler : register(s0);
+
+		struct UpscaleInput
+		{
+			float4 position : SV_POSITION;
+			float2 uv : TEXCOORD;
+		};
+
+		UpscaleInput UpscaleVSMain(uint vertexId : SV_VertexID)
+		{
+			UpscaleInput result;
+			result.uv = float2((vertexId << 1) & 2, vertexId & 2);
+			result.position = float4(result.uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+			return result;
+		}
+
+		float4 UpscalePSMain(UpscaleInput input) : SV_TARGET
+		{
+		  return sceneTexture.Sample(linearSampler, input.uv);
+		}
 	);
-	ThrowIfFailed(D3DCompile(shaderSrc, strlen(shaderSrc), "", nullptr, nullptr, "VSMain", "vs_5_0", 0, 0, &mVertexShader, &error));
-	ThrowIfFailed(D3DCompile(shaderSrc, strlen(shaderSrc), "", nullptr, nullptr, "PSMain", "ps_5_0", 0, 0, &mPixelShader, &error));
-
-	// define the layout for the input vertex data.
-	std::vector<D3D12_INPUT_ELEMENT_DESC> inputDescriptor = {
-	  {
-		"POSITION",
-		0,
-		DXGI_FORMAT_R32G32B32_FLOAT,
-		0,
-		0,
-		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-		0
-	  },
-	  {
-		"COLOR",
-		0,
-		DXGI_FORMAT_R32G32B32A32_FLOAT,
-		0,
-		12,
-		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA
-	  }
-	};
-
-	// create a descriptor for the rasterizer state (derived from CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT))
-	D3D12_RASTERIZER_DESC rasterizerDescriptor = {};
-	rasterizerDescriptor.FillMode = D3D12_FILL_MODE_SOLID;
-	rasterizerDescriptor.CullMode = D3D12_CULL_MODE_BACK;
-	rasterizerDescriptor.FrontCounterClockwise = false;
-	rasterizerDescriptor.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
-	rasterizerDescriptor.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
-	rasterizerDescriptor.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
-	rasterizerDescriptor.DepthClipEnable = true;
-	rasterizerDescriptor.MultisampleEnable = false;
-	rasterizerDescriptor.AntialiasedLineEnable = false;
-	rasterizerDescriptor.ForcedSampleCount = 0;
-	rasterizerDescriptor.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-
-	// create a descriptor for the blend state (derived from CD3DX12_BLEND_DESC(CD3DX12_DEFAULT))
-	D3D12_BLEND_DESC blendDescriptor = {};
-	blendDescriptor.AlphaToCoverageEnable = false;
-	blendDescriptor.IndependentBlendEnable = false;
-	blendDescriptor.RenderTarget[0].BlendEnable = false;
-	blendDescriptor.RenderTarget[0].LogicOpEnable = false;
-	blendDescriptor.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
-	blendDescriptor.RenderTarget[0].DestBlend = D3D12_BLEND_ZERO;
-	blendDescriptor.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
-	blendDescriptor.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
-	blendDescriptor.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
-	blendDescriptor.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
-	blendDescriptor.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
-	blendDescriptor.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-
-	// create a desciptor for the pipeline state object.
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStatedescriptor = {};
-	pipelineStatedescriptor.InputLayout = { &inputDescriptor[0], (UINT)inputDescriptor.size() };
-	pipelineStatedescriptor.pRootSignature = mRootSignature.Get();
-	pipelineStatedescriptor.VS = { reinterpret_cast<UINT8*>(mVertexShader->GetBufferPointer()), mVertexShader->GetBufferSize() };
-	pipelineStatedescriptor.PS = { reinterpret_cast<UINT8*>(mPixelShader->GetBufferPointer()), mPixelShader->GetBufferSize() };
-	pipelineStatedescriptor.RasterizerState = rasterizerDescriptor;
-	pipelineStatedescriptor.BlendState = blendDescriptor;
-	pipelineStatedescriptor.DepthStencilState.DepthEnable = false;
-	pipelineStatedescriptor.DepthStencilState.StencilEnable = false;
-	pipelineStatedescriptor.SampleMask = UINT_MAX;
-	pipelineStatedescriptor.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	pipelineStatedescriptor.NumRenderTargets = 1;
-	pipelineStatedescriptor.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-	pipelineStatedescriptor.SampleDesc.Count = 1;
-
-	// create a new graphics pipeline state with the above descriptors.
-	ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&pipelineStatedescriptor, IID_PPV_ARGS(&mPipelineState)));
-
-	// create a command list and ensure that it's closed to stop immediate command recording.
-	ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mCommandAllocators[0].Get(), mPipelineState.Get(), IID_PPV_ARGS(&mCommandList)));
-	ThrowIfFailed(mCommandList->Close());
-
-	// construct the required vertices for a simple triangle.
-	std::vector<Vertex> vertices = {
-	  {{  0.0f,  0.5f, 0.0f }, { 1.f, 0.f, 0.f, 1.f }},
-	  {{  0.5f, -0.5f, 0.0f }, { 0.f, 1.f, 0.f, 1.f }},
-	  {{ -0.5f, -0.5f, 0.0f }, { 0.f, 0.f, 1.f, 1.f }}
-	};
-
-	// construct properties for the upload heap.
-	D3D12_HEAP_PROPERTIES heapProperties = {};
-	heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
-	heapProperties.CreationNodeMask = 1;
-	heapProperties.VisibleNodeMask = 1;
-	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
 
-	// construct a descriptor for a vertex buffer (derived from CD3DX12_RESOURCE_DESC).
+	// load the shader bytecode from the cache and compile only on cache misses.
+	D3DShaderCompiler shaderCompiler;
+	ShaderCache shaderCache(shaderCompiler);
+#if defined(EMBEDDED_SHADERS)
+	shaderCache.AddEmbedded(EmbeddedShaders, EmbeddedShaderCount);
+#endif
+	auto shaderCachePath = std::wstring(ApplicationData::Current->LocalCacheFolder->Path->Data()) + L"\\shaders.bin";
+	std::ifstream shaderCacheInput(shaderCachePath, std::ios::binary);
+	if (shaderCacheInput) {
+		shaderCache.Load(shaderCacheInput);
+	}
+	mVertexShader = shaderCache.GetOrCompile({ shaderSrc, "VSMain", "vs_5_0", 0 });
+	mPixelShader = shaderCache.GetOrCompile({ shaderSrc, "PSMain", "ps_5_0", 0 });
+	mUpscaleVertexShader = shaderCache.GetOrCompile({ shaderSrc, "UpscaleVSMain", "vs_5_0", 0 });
+	mUpscalePixelShader = shaderCache.GetOrCompile({ shaderSrc, "UpscalePSMain", "ps_5_0", 0 });
+	if (shaderCache.IsDirty()) {
+		std::ofstream shaderCacheOutput(shaderCachePath, std::ios::binary | std::ios::trunc);
+		shaderCache.Save(shaderCacheOutput);
+	}
+
+	// generate the layout for the input vertex data from the quantized vertex format and append the instance streams.
+	auto inputLayout = D3D12InputLayout<HalfVertex>();
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputDescriptor(inputLayout.begin(), inputLayout.end());
+	inputDescriptor.insert(inputDescriptor.end(), std::begin(InstanceInputElements), std::end(InstanceInputElements));
+
+	// create a pipeline cache that builds the pipeline state permutations in the background.
+	mPipelineFactory = std::make_unique<D3D12PipelineFactory>(mDevice.Get(), mRootSignature.Get());
+	mPipelineFactory->AddShaderProgram(ColorShaderProgram, mVertexShader, mPixelShader);
+	mPipelineFactory->AddShaderProgram(UpscaleShaderProgram, mUpscaleVertexShader, mUpscalePixelShader);
+	mPipelineFactory->AddInputLayout(VertexInputLayout, inputDescriptor);
+	mPipelineFactory->AddInputLayout(EmptyInputLayout, {});
+	mPipelineCache = std::make_unique<PipelineCache>(*mPipelineFactory, PIPELINE_BUILD_THREADS);
+	std::ifstream pipelineCacheInput(PipelineCachePath(), std::ios::binary);
+	if (pipelineCacheInput) {
+		mPipelineCache->Load(pipelineCacheInput);
+	}
+
+	// build the default pipeline right away as it's the fallback for the other permutations, and the upscale pipeline used by every frame.
+	mPipelineDesc = DefaultPipeline;
+	mPipelineCache->GetBlocking(DefaultPipeline);
+	mUpscalePipeline = mPipelineCache->GetBlocking(UpscalePipeline);
+
+	// create the command lists with an allocator for each frame in flight. The draws are recorded as
+	// jobs into the lists between the first list and the last list which wrap the frame.
+	mCommandRecorder = std::make_unique<D3D12CommandRecorder>(mDevice.Get(), mCommandQueue.Get(), frameLatency, jobSystem.ThreadCount() + 2);
+	mParallelRecorder = std::make_unique<ParallelRecorder>(jobSystem, *mCommandRecorder, RECORDING_CHUNK_SIZE);
+
+	// create an allocator that places the resources into large heap blocks.
+	mHeapFactory = std::make_unique<D3D12HeapFactory>(mDevice.Get());
+	mMemoryAllocator = std::make_unique<GpuMemoryAllocator>(*mHeapFactory, GPU_HEAP_BLOCK_SIZE);
+
+	// create a render graph that records the passes of the frames into the command lists.
+	mRenderGraphBackend = std::make_unique<D3D12RenderGraphBackend>(mDevice.Get(), *mMemoryAllocator, *mTimeline);
+	mRenderGraph = std::make_unique<RenderGraph>(*mRenderGraphBackend);
+
+	// track the memory of the renderer against the budget of the adapter the device was created on.
+	ComPtr<IDXGIAdapter3> budgetAdapter;
+	ThrowIfFailed(mDXGIFactory->EnumAdapterByLuid(mDevice->GetAdapterLuid(), IID_PPV_ARGS(&budgetAdapter)));
+	mBudgetProvider = std::make_unique<DxgiBudgetProvider>(budgetAdapter.Get());
+	mMemoryBudget = std::make_unique<MemoryBudget>(*mBudgetProvider, MemoryBudgetDesc{ MEMORY_TRIM_THRESHOLD, MEMORY_TRIM_TARGET, MEMORY_POLL_FRAMES });
+
+	// release the empty heap blocks when over the budget. Releasing the transient textures waits the GPU
+	// and the next frame creates them again, so they are released only when the view is hidden.
+	mMemoryBudget->AddTrimmer(MemorySegment::Local, "EmptyHeapBlocks", [this](uint64_t) { return ReleaseEmptyHeapBlocks(); });
+	mMemoryBudget->AddTrimmer(MemorySegment::Local, "TransientTextures", [this](uint64_t) {
+		mRenderGraphBackend->ReleaseTransientMemory();
+		TrackTransientMemory();
+		return ReleaseEmptyHeapBlocks();
+	}, true);
+
+	// create a copy queue with a staging buffer to upload the static geometry.
+	mCopyQueue = std::make_unique<D3D12CopyQueue>(mDevice.Get(), STAGING_BUFFER_SIZE);
+	mMemoryBudget->Allocate(MemoryCategory::Upload, MemorySegment::NonLocal, STAGING_BUFFER_SIZE);
+	mGeometryUploader = std::make_unique<GeometryUploader>(*mCopyQueue, UPLOAD_BATCH_SIZE);
+
+	// construct the required vertices for a simple triangle and pack them into the quantized format.
+	auto authoringVertices = TriangleVertices();
+	std::vector<HalfVertex> vertices(authoringVertices.size());
+	PackVertices(authoringVertices.data(), authoringVertices.size(), vertices.data());
+
+	// create the vertex buffer and copy the vertices into it with the copy queue.
+	CreateVertexBuffer(sizeof(HalfVertex) * vertices.size(), sizeof(HalfVertex));
+	mGeometryUploader->Upload(mVertexBuffer.Get(), 0, &vertices[0], sizeof(HalfVertex) * vertices.size());
+	mCapture.UploadBuffer(mCaptureVertexBuffer, 0, &vertices[0], sizeof(HalfVertex) * vertices.size());
+	mGeometryFence = mGeometryUploader->Flush();
+
+	// the triangle is the only object of the scene until a mesh replaces it, e.g. if the mesh fails to stream.
+	mMeshBounds = VertexBounds(authoringVertices);
+	mVisibility.Build({ mMeshBounds });
+
+	// construct a descriptor for the upload buffer (derived from CD3DX12_RESOURCE_DESC).
 	D3D12_RESOURCE_DESC resourceDescriptor = {};
 	resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
 	resourceDescriptor.Alignment = 0;
-	resourceDescriptor.Width = sizeof(Vertex) * vertices.size();
+	resourceDescriptor.Width = UPLOAD_RING_SIZE;
 	resourceDescriptor.Height = 1;
 	resourceDescriptor.DepthOrArraySize = 1;
 	resourceDescriptor.MipLevels = 1;
@@ -226,23 +402,53 @@ Renderer::Renderer() : mRTVDescriptorSize(0), mScissors{0, 0, LONG_MAX, LONG_MAX
 	resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 	resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-	// create the vertex buffer resource and assign vertices into the buffer.unsigned char* data(0);
+	// create a persistently mapped upload buffer for the per-frame dynamic data.
+	D3D12_HEAP_PROPERTIES heapProperties = {};
+	heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+	heapProperties.CreationNodeMask = 1;
+	heapProperties.VisibleNodeMask = 1;
+	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
 	unsigned char* data(0);
 	D3D12_RANGE range = {};
-	ThrowIfFailed(mDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDescriptor, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mVertexBuffer)));
-	ThrowIfFailed(mVertexBuffer->Map(0, &range, reinterpret_cast<void**>(&data)));
-	memcpy(data, &vertices[0], sizeof(Vertex)* vertices.size());
-	mVertexBuffer->Unmap(0, nullptr);
-
-	// wait until the provided vertices have been uploaded to GPU.
-	ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
-	mFenceEvent = CreateEvent(nullptr, false, false, nullptr);
-	WaitForGPU();
+	ThrowIfFailed(mDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDescriptor, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mUploadBuffer)));
+	ThrowIfFailed(mUploadBuffer->Map(0, &range, reinterpret_cast<void**>(&data)));
+	mUploadRing = std::make_unique<UploadRing>(*mTimeline, data, mUploadBuffer->GetGPUVirtualAddress(), UPLOAD_RING_SIZE);
+	mMemoryBudget->Allocate(MemoryCategory::Upload, MemorySegment::NonLocal, UPLOAD_RING_SIZE);
+}
 
-	// create a vertex buffer view from the vertex buffer definitions.
-	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
-	mVertexBufferView.StrideInBytes = sizeof(Vertex);
-	mVertexBufferView.SizeInBytes = sizeof(Vertex) * 3;
+Renderer::~Renderer()
+{
+	if (mFrameLatencyWaitable != nullptr) {
+		CloseHandle(mFrameLatencyWaitable);
+	}
+}
+
+// ============================================================================
+// Replace the drawn geometry with the geometry of a mesh file.
+//
+// The streams are copied from the file contents straight into staging memory
+// of the copy queue, which then uploads them into new vertex and index buffers.
+// The vertices must be in the quantized format used by the pipelines.
+// ============================================================================
+void Renderer::LoadMesh(const MeshFile& mesh)
+{
+	if (!mesh.HasLayout<HalfVertex>()) {
+		throw std::invalid_argument("mesh vertices do not have the vertex layout of the renderer");
+	}
+	auto& header = mesh.Header();
+	CreateVertexBuffer(header.vertices.size, header.vertexStride);
+	CreateIndexBuffer(header.indices.size, (mesh.IndexSize() == sizeof(uint16_t)) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, header.indexCount);
+	mesh.Upload(*mGeometryUploader, mVertexBuffer.Get(), mIndexBuffer.Get());
+	mGeometryFence = mGeometryUploader->Flush();
+	mCapture.UploadBuffer(mCaptureVertexBuffer, 0, mesh.VertexData(), header.vertices.size);
+	if (header.indexCount != 0) {
+		mCapture.UploadBuffer(mCaptureIndexBuffer, 0, mesh.IndexData(), header.indices.size);
+	}
+
+	// the mesh replaces the triangle as the only object of the scene, so the hierarchy only holds its bounds.
+	mMeshBounds = { { header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] }, { header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] } };
+	mVisibility.Build({ mMeshBounds });
 }
 
 // ============================================================================
@@ -257,6 +463,34 @@ void Renderer::SetWindow(Windows::UI::Core::CoreWindow^ window)
 	CreateSizeDependentResources();
 }
 
+// ============================================================================
+// Specify the interpolated scene state drawn by the next rendered frame.
+// ============================================================================
+void Renderer::SetScene(const SceneState& scene)
+{
+	mScene = scene;
+}
+
+// ============================================================================
+// Wait until the CPU work of the next frame should start.
+//
+// Latency waitable swap chains first wait until there is room for the frame
+// in the present queue, after which the pacer waits until the frame would
+// just make its vertical blank. Call this right before the input is sampled.
+// ============================================================================
+void Renderer::WaitForFrameStart()
+{
+	if (!mFramePacer) {
+		return;
+	}
+	PROFILE_SCOPE("WaitForFrameStart");
+	if (mFrameLatencyWaitable != nullptr) {
+		WaitForSingleObjectEx(mFrameLatencyWaitable, 1000, TRUE);
+	}
+	mDisplayClock->Update();
+	mFramePacer->BeginFrame();
+}
+
 // ============================================================================
 // Render and present a frame.
 //
@@ -265,38 +499,236 @@ void Renderer::SetWindow(Windows::UI::Core::CoreWindow^ window)
 // ============================================================================
 void Renderer::Render()
 {
-	// reset the memory associated with the command allocator.
-	ThrowIfFailed(mCommandAllocators[mBufferIndex]->Reset());
+	PROFILE_SCOPE("Render");
+
+	// wait until the allocator of this frame slot is no longer used by the GPU.
+	unsigned frameIndex;
+	{
+		PROFILE_SCOPE("WaitForFrame");
+		frameIndex = mFramePipeline->BeginFrame();
+	}
+	mGpuProfiler->BeginFrame(frameIndex);
+
+	// adjust the render resolution with the GPU time of the frame that was completed in this slot.
+	mResolutionController.Update(mGpuProfiler->FrameMilliseconds());
+	unsigned renderWidth, renderHeight;
+	mResolutionController.RenderSize(static_cast<unsigned>(mViewport.Width), static_cast<unsigned>(mViewport.Height), renderWidth, renderHeight);
+	D3D12_VIEWPORT sceneViewport = { 0.f, 0.f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), D3D12_MIN_DEPTH, D3D12_MAX_DEPTH };
+	D3D12_RECT sceneScissors = { 0, 0, static_cast<LONG>(renderWidth), static_cast<LONG>(renderHeight) };
+
+	// free the upload memory of the frames the GPU has completed.
+	mUploadRing->Reclaim();
+	mDescriptorRing->Reclaim();
+
+	// release the retired buffers the GPU no longer uses.
+	auto completedValue = mTimeline->CompletedValue();
+	auto copyCompletedValue = mCopyQueue->Timeline().CompletedValue();
+	for (auto i = mRetiredBuffers.size(); i-- > 0;) {
+		if (mRetiredBuffers[i].fenceValue <= completedValue && mRetiredBuffers[i].copyFenceValue <= copyCompletedValue) {
+			mMemoryAllocator->Free(mRetiredBuffers[i].allocation);
+			mMemoryBudget->Free(MemoryCategory::Geometry, MemorySegment::Local, mRetiredBuffers[i].allocation.size);
+			mRetiredBuffers.erase(mRetiredBuffers.begin() + i);
+		}
+	}
+
+	// poll the memory budget and trim the memory when the renderer is over it.
+	mMemoryBudget->Update(false);
+
+	// use the command allocators of this frame slot for the recording.
+	mCommandRecorder->BeginFrame(frameIndex);
+
+	// pick the back buffer the swap chain expects us to render next.
+	mBufferIndex = mSwapchain->GetCurrentBackBufferIndex();
 
 	// get the render target view for the current frame.
 	auto renderTargetView = RenderTargetView();
 
-	// reset and build the pipeline command list for the rendering.
-	ThrowIfFailed(mCommandList->Reset(mCommandAllocators[mBufferIndex].Get(), mPipelineState.Get()));
-	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
-	mCommandList->RSSetViewports(1, &mViewport);
-	mCommandList->RSSetScissorRects(1, &mScissors);
-	mCommandList->ResourceBarrier(1, &RTVBarrier(D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-	mCommandList->ClearRenderTargetView(renderTargetView, BlackColor, 0, nullptr);
-	mCommandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
-	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	mCommandList->IASetVertexBuffers(0, 1, &mVertexBufferView);
-	mCommandList->DrawInstanced(3, 1, 0, 0);
-	mCommandList->ResourceBarrier(1, &RTVBarrier(D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-	ThrowIfFailed(mCommandList->Close());
-
-	// submit the command list into the command queue for the execution.
-	std::vector<ID3D12CommandList*> const commandList = { mCommandList.Get() };
-	mCommandQueue->ExecuteCommandLists(1, &commandList[0]);
+	// write the constants of this frame into the upload ring.
+	FrameConstants constants = { {
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, 1.f, 0.f,
+		0.f, 0.f, 0.f, 1.f
+	} };
+	auto constantBuffer = mUploadRing->Allocate(sizeof(constants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	memcpy(constantBuffer.cpuAddress, &constants, sizeof(constants));
+
+	// refit the moved objects and find the objects visible with the frame transform.
+	{
+		PROFILE_SCOPE("Cull");
+		mVisibility.Update(MeshObject, RotateBounds(mMeshBounds, mScene.rotation));
+		mVisibility.Refit();
+		mVisibility.Cull(Frustum::FromMatrix(constants.transform), mVisibleObjects);
+	}
+
+	// submit the visible objects of the scene and merge them into instanced draws.
+	{
+		PROFILE_SCOPE("BuildBatches");
+		mInstanceBatcher.Reset();
+		for (auto object : mVisibleObjects) {
+			if (object == MeshObject) {
+				mInstanceBatcher.Submit(MeshPipeline, MeshGeometry, { { 0.f, 0.f }, 1.f, mScene.rotation, 0xffffffffu });
+			}
+		}
+		mInstanceBatcher.Build();
+	}
+
+	// record the state and the draws of the scene into the capture when one is running.
+	if (mCapture.Capturing()) {
+		PROFILE_SCOPE("Capture");
+		std::array<const uint32_t*, INSTANCE_STREAM_COUNT> streams;
+		for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+			streams[i] = mInstanceBatcher.Stream(static_cast<InstanceStream>(i));
+		}
+		mCapture.BeginFrame(renderWidth, renderHeight);
+		mCapture.SetTransform(constants.transform.data());
+		mCapture.SetPipeline(mPipelineDesc);
+		mCapture.SetInstances(streams.data(), INSTANCE_STREAM_COUNT, static_cast<uint32_t>(mInstanceBatcher.InstanceCount()));
+		auto count = (mIndexCount != 0) ? mIndexCount : mVertexBufferView.SizeInBytes / mVertexBufferView.StrideInBytes;
+		for (auto& batch : mInstanceBatcher.Batches()) {
+			mCapture.Draw({ mCaptureVertexBuffer, mCaptureIndexBuffer, count, batch.instanceCount, 0, 0, batch.firstInstance, 0 });
+		}
+		mCapture.EndFrame();
+	}
+
+	// copy the packed instance streams into the upload ring and create views for them.
+	std::array<D3D12_VERTEX_BUFFER_VIEW, INSTANCE_STREAM_COUNT> instanceViews;
+	auto instanceCount = static_cast<unsigned>(mInstanceBatcher.InstanceCount());
+	for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+		auto streamSize = sizeof(uint32_t) * instanceCount;
+		auto stream = mUploadRing->Allocate(streamSize, sizeof(uint32_t));
+		if (instanceCount != 0) {
+			memcpy(stream.cpuAddress, mInstanceBatcher.Stream(static_cast<InstanceStream>(i)), streamSize);
+		}
+		instanceViews[i].BufferLocation = stream.gpuAddress;
+		instanceViews[i].StrideInBytes = sizeof(uint32_t);
+		instanceViews[i].SizeInBytes = static_cast<UINT>(streamSize);
+	}
+
+	// use the default pipeline until the requested pipeline has been built.
+	auto pipeline = mPipelineCache->Get(mPipelineDesc, DefaultPipeline);
+
+	// declare the passes of this frame and compile them into a schedule.
+	{
+		PROFILE_SCOPE("CompileRenderGraph");
+		mRenderGraph->Reset();
+		auto backBuffer = mRenderGraph->ImportTexture("BackBuffer", mRenderTargets[mBufferIndex].Get(), ResourceState::Present);
+		auto sceneColor = mRenderGraph->CreateTexture("SceneColor", { renderWidth, renderHeight, TextureFormat::RGBA8 });
+		auto scenePass = mRenderGraph->AddPass("Scene", [=](const RenderGraph& graph) {
+			// the scene target may be a new texture after a resolution change, so its view is written every frame.
+			D3D12_CPU_DESCRIPTOR_HANDLE sceneTargetView = { static_cast<SIZE_T>(mSceneTargetView.cpuHandle) };
+			mDevice->CreateRenderTargetView(static_cast<ID3D12Resource*>(graph.Texture(sceneColor)), nullptr, sceneTargetView);
+			mRenderGraphBackend->CommandList()->ClearRenderTargetView(sceneTargetView, BlackColor, 0, nullptr);
+
+			// record the batches in parallel into the lists that follow the current list.
+			auto pipelineState = static_cast<D3D12Pipeline*>(pipeline.get())->State();
+			auto vertexCount = mVertexBufferView.SizeInBytes / mVertexBufferView.StrideInBytes;
+			auto& batches = mInstanceBatcher.Batches();
+			auto drawListCount = mParallelRecorder->Record(1, static_cast<unsigned>(batches.size()), [=, &batches](CommandContext& context, unsigned begin, unsigned end) {
+				auto commandList = static_cast<D3D12CommandContext&>(context).CommandList();
+				commandList->SetPipelineState(pipelineState);
+				commandList->SetGraphicsRootSignature(mRootSignature.Get());
+				commandList->SetGraphicsRootConstantBufferView(0, constantBuffer.gpuAddress);
+				commandList->RSSetViewports(1, &sceneViewport);
+				commandList->RSSetScissorRects(1, &sceneScissors);
+				commandList->OMSetRenderTargets(1, &sceneTargetView, false, nullptr);
+				commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+				commandList->IASetVertexBuffers(0, 1, &mVertexBufferView);
+				commandList->IASetVertexBuffers(1, INSTANCE_STREAM_COUNT, instanceViews.data());
+				if (mIndexCount != 0) {
+					commandList->IASetIndexBuffer(&mIndexBufferView);
+				}
+
+				// the mesh is the only pipeline and geometry, so each batch only needs its draw.
+				for (auto i = begin; i < end; i++) {
+					auto& batch = batches[i];
+					if (mIndexCount != 0) {
+						context.DrawIndexed(mIndexCount, batch.instanceCount, 0, 0, batch.firstInstance);
+					} else {
+						context.Draw(vertexCount, batch.instanceCount, 0, batch.firstInstance);
+					}
+				}
+			});
+
+			// continue the rest of the frame in the list after the draw lists.
+			mFrameListCount = drawListCount + 2;
+			mCommandRecorder->BeginList(mFrameListCount - 1);
+			mRenderGraphBackend->SetCommandList(mCommandRecorder->CommandList(mFrameListCount - 1));
+		});
+		mRenderGraph->Write(scenePass, sceneColor, ResourceState::RenderTarget);
+
+		// upscale the scene target into the back buffer with a bilinear filter.
+		auto upscalePass = mRenderGraph->AddPass("Upscale", [=](const RenderGraph& graph) {
+			// write the view of the scene target and copy it into a table of the descriptor ring.
+			D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = { static_cast<SIZE_T>(mSceneTextureView.cpuHandle) };
+			mDevice->CreateShaderResourceView(static_cast<ID3D12Resource*>(graph.Texture(sceneColor)), nullptr, srvHandle);
+			auto srvTable = mDescriptorRing->Allocate(1);
+			mDescriptorCopies->Copy(srvTable, 0, mSceneTextureView);
+			mDescriptorCopies->Flush();
+
+			auto commandList = mRenderGraphBackend->CommandList();
+			ID3D12DescriptorHeap* heaps[] = { static_cast<ID3D12DescriptorHeap*>(mDescriptorRing->Heap()) };
+			commandList->SetDescriptorHeaps(1, heaps);
+			commandList->SetPipelineState(static_cast<D3D12Pipeline*>(mUpscalePipeline.get())->State());
+			commandList->SetGraphicsRootSignature(mRootSignature.Get());
+			commandList->SetGraphicsRootDescriptorTable(1, { srvTable.gpuHandle });
+			commandList->RSSetViewports(1, &mViewport);
+			commandList->RSSetScissorRects(1, &mScissors);
+			commandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
+			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			commandList->DrawInstanced(3, 1, 0, 0);
+		});
+		mRenderGraph->Read(upscalePass, sceneColor, ResourceState::ShaderResource);
+		mRenderGraph->Write(upscalePass, backBuffer, ResourceState::RenderTarget);
+		mRenderGraph->Compile();
+	}
+
+	// record the command lists of the frame, the first list begins and the last list ends the frame.
+	{
+		PROFILE_SCOPE("RecordCommands");
+		mCommandRecorder->BeginList(0);
+		mFrameListCount = 1;
+		auto gpuFrameScope = mGpuProfiler->BeginScope(mCommandRecorder->CommandList(0), "Frame");
+		mRenderGraphBackend->SetCommandList(mCommandRecorder->CommandList(0));
+		mRenderGraph->Execute(mStateTracker);
+		auto lastList = mFrameListCount - 1;
+		mGpuProfiler->EndScope(mCommandRecorder->CommandList(lastList), gpuFrameScope);
+		mGpuProfiler->EndFrame(mCommandRecorder->CommandList(lastList));
+		mCommandRecorder->EndList(0);
+		if (lastList != 0) {
+			mCommandRecorder->EndList(lastList);
+		}
+	}
+
+	// submit the command lists into the command queue with a single call in their recording order.
+	{
+		PROFILE_SCOPE("ExecuteCommandLists");
+
+		// let the GPU wait for the pending geometry copies without blocking the CPU.
+		if (mGeometryFence != 0) {
+			ThrowIfFailed(mCommandQueue->Wait(mCopyQueue->Fence(), mGeometryFence));
+			mGeometryFence = 0;
+		}
+
+		mCommandRecorder->Submit(mFrameListCount);
+	}
+
+	// record the work of the frame as the CPU time so far and the GPU time of the latest completed frame.
+	auto gpuNanoseconds = static_cast<uint64_t>(mGpuProfiler->FrameMilliseconds() * 1e6);
+	mFramePacer->EndFrame(mPacingClock.Now() - mFramePacer->FrameStart() + gpuNanoseconds);
 
 	// present the current back buffer onto screen.
-	ThrowIfFailed(mSwapchain->Present(1, 0));
-	
-	// wait until the GPU has completed rendering.
-	WaitForGPU();
+	{
+		PROFILE_SCOPE("Present");
+		ThrowIfFailed(mSwapchain->Present(mFramePacer->SyncInterval(), (mPacingDesc.mode == PresentMode::Tearing) ? DXGI_PRESENT_ALLOW_TEARING : 0));
+	}
 
-	// proceed to next buffer in a round-robin manner.
-	mBufferIndex = (mBufferIndex + 1) % BUFFER_COUNT;
+	// mark the end of the frame so its slot, upload memory and transient textures can be reused once GPU completes it.
+	auto fenceValue = mFramePipeline->EndFrame();
+	mUploadRing->EndFrame(fenceValue);
+	mDescriptorRing->EndFrame(fenceValue);
+	mRenderGraphBackend->EndFrame(fenceValue);
+	TrackTransientMemory();
 }
 
 // ============================================================================
@@ -307,33 +739,187 @@ void Renderer::Render()
 // ============================================================================
 void Renderer::WaitForGPU()
 {
-	// add a signal command to the command queue.
-	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mFenceValue)); // values?
+	// signal the command queue and wait until all frames in flight are done.
+	PROFILE_SCOPE("WaitForGPU");
+	mFramePipeline->Flush();
+}
+
+// ============================================================================
+// Save the built pipelines for the following runs of the application.
+//
+// The pipeline library is written into the local cache folder of the app, so
+// the next run can load the pipelines instead of compiling them again.
+// ============================================================================
+void Renderer::SavePipelineCache()
+{
+	std::ofstream pipelineCacheOutput(PipelineCachePath(), std::ios::binary | std::ios::trunc);
+	mPipelineCache->Save(pipelineCacheOutput);
+}
 
-	// wait for fence to receive a signal from the GPU.
-	ThrowIfFailed(mFence->SetEventOnCompletion(mFenceValue, mFenceEvent)); // values?
-	WaitForSingleObjectEx(mFenceEvent, INFINITE, false);
+// ============================================================================
+// Start capturing the commands of the next frames.
+//
+// The capture records the scene pass of the frames, while the upscale pass is
+// derived from the render size and it's not part of the capture.
+// ============================================================================
+void Renderer::StartCapture(unsigned frameCount)
+{
+	mCapture.Start(frameCount);
+}
+
+// ============================================================================
+// Check whether the started capture has recorded all of its frames.
+// ============================================================================
+bool Renderer::CaptureComplete()
+{
+	return mCapture.Complete();
+}
 
-	// increment the fence value.
-	mFenceValue++;
+// ============================================================================
+// Write the completed capture and release it for the next capture.
+// ============================================================================
+void Renderer::SaveCapture(std::ostream& output)
+{
+	mCapture.Write(output);
+	mCapture.Start(0);
 }
 
 // ============================================================================
-// Create a state transition resource barrier for the current render target.
+// Release and evict the memory of the renderer while the view is hidden.
 //
-// Function creates a new barrier definition for the currently used rendering 
-// target. Using a barrier is necessary when building the draw command list.
+// The app may be suspended or its memory may be given to the foreground app
+// while the view is hidden, so the memory the renderer can live without is
+// released and the heaps are evicted until the view is visible again.
 // ============================================================================
-D3D12_RESOURCE_BARRIER Renderer::RTVBarrier(D3D12_RESOURCE_STATES from, D3D12_RESOURCE_STATES to)
+void Renderer::SetVisible(bool visible)
 {
-	D3D12_RESOURCE_BARRIER barrier = {};
-	barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	barrier.Transition.pResource = mRenderTargets[mBufferIndex].Get();
-	barrier.Transition.StateBefore = from;
-	barrier.Transition.StateAfter = to;
-	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	return barrier;
+	if (!visible && mEvictedHeaps.empty()) {
+		WaitForGPU();
+		mMemoryBudget->Update(true);
+		std::vector<void*> heaps;
+		mMemoryAllocator->Heaps(heaps);
+		for (auto heap : heaps) {
+			mEvictedHeaps.push_back(static_cast<ID3D12Heap*>(heap));
+		}
+		if (!mEvictedHeaps.empty()) {
+			ThrowIfFailed(mDevice->Evict(static_cast<UINT>(mEvictedHeaps.size()), mEvictedHeaps.data()));
+		}
+	} else if (visible && !mEvictedHeaps.empty()) {
+		ThrowIfFailed(mDevice->MakeResident(static_cast<UINT>(mEvictedHeaps.size()), mEvictedHeaps.data()));
+		mEvictedHeaps.clear();
+	}
+}
+
+// ============================================================================
+// Export the memory budget, the usage of each category and the trims as JSON.
+// ============================================================================
+std::string Renderer::ExportMemoryStatistics()
+{
+	return mMemoryBudget->ExportJson();
+}
+
+// ============================================================================
+// Create a geometry buffer as a placed resource.
+//
+// The previous buffer may still be used by the frames in flight and by the
+// pending copies, so it's retired with the fences of both queues and it is
+// released when the GPU has passed both of them.
+// ============================================================================
+void Renderer::CreateGeometryBuffer(uint64_t size, Microsoft::WRL::ComPtr<ID3D12Resource>& buffer, GpuAllocation& allocation)
+{
+	if (buffer) {
+		mRetiredBuffers.push_back({ buffer, allocation, mTimeline->Signal(), mGeometryUploader->LastFence() });
+		buffer.Reset();
+	}
+
+	// construct a descriptor for a geometry buffer (derived from CD3DX12_RESOURCE_DESC).
+	D3D12_RESOURCE_DESC resourceDescriptor = {};
+	resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resourceDescriptor.Alignment = 0;
+	resourceDescriptor.Width = size;
+	resourceDescriptor.Height = 1;
+	resourceDescriptor.DepthOrArraySize = 1;
+	resourceDescriptor.MipLevels = 1;
+	resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
+	resourceDescriptor.SampleDesc.Count = 1;
+	resourceDescriptor.SampleDesc.Quality = 0;
+	resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	// place the buffer into a heap block of the memory allocator.
+	auto allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &resourceDescriptor);
+	allocation = mMemoryAllocator->Allocate(HeapType::Default, ResourceClass::Buffer, allocationInfo.SizeInBytes, allocationInfo.Alignment);
+	mMemoryBudget->Allocate(MemoryCategory::Geometry, MemorySegment::Local, allocation.size);
+	auto heap = static_cast<ID3D12Heap*>(allocation.heap);
+	ThrowIfFailed(mDevice->CreatePlacedResource(heap, allocation.offset, &resourceDescriptor, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer)));
+}
+
+// ============================================================================
+// Create a vertex buffer and a view for it.
+// ============================================================================
+void Renderer::CreateVertexBuffer(uint64_t size, unsigned stride)
+{
+	if (mCaptureVertexBuffer != CAPTURE_NO_BUFFER) {
+		mCapture.DestroyBuffer(mCaptureVertexBuffer);
+	}
+	mCaptureVertexBuffer = mCapture.CreateBuffer(CaptureBufferKind::Vertex, CaptureVertexFormat::Half, stride, size);
+	CreateGeometryBuffer(size, mVertexBuffer, mVertexBufferAllocation);
+	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
+	mVertexBufferView.StrideInBytes = stride;
+	mVertexBufferView.SizeInBytes = static_cast<UINT>(size);
+}
+
+// ============================================================================
+// Create an index buffer and a view for it.
+//
+// Geometry without indices releases the previous index buffer, after which
+// the vertices are drawn as a non-indexed triangle list.
+// ============================================================================
+void Renderer::CreateIndexBuffer(uint64_t size, DXGI_FORMAT format, unsigned indexCount)
+{
+	mIndexCount = indexCount;
+	if (mCaptureIndexBuffer != CAPTURE_NO_BUFFER) {
+		mCapture.DestroyBuffer(mCaptureIndexBuffer);
+		mCaptureIndexBuffer = CAPTURE_NO_BUFFER;
+	}
+	if (indexCount == 0) {
+		if (mIndexBuffer) {
+			mRetiredBuffers.push_back({ mIndexBuffer, mIndexBufferAllocation, mTimeline->Signal(), mGeometryUploader->LastFence() });
+			mIndexBuffer.Reset();
+		}
+		return;
+	}
+	mCaptureIndexBuffer = mCapture.CreateBuffer(CaptureBufferKind::Index, CaptureVertexFormat::Half, (format == DXGI_FORMAT_R16_UINT) ? 2 : 4, size);
+	CreateGeometryBuffer(size, mIndexBuffer, mIndexBufferAllocation);
+	mIndexBufferView.BufferLocation = mIndexBuffer->GetGPUVirtualAddress();
+	mIndexBufferView.Format = format;
+	mIndexBufferView.SizeInBytes = static_cast<UINT>(size);
+}
+
+// ============================================================================
+// Release the empty heap blocks of the memory allocator and get the bytes.
+// ============================================================================
+uint64_t Renderer::ReleaseEmptyHeapBlocks()
+{
+	auto reservedBytes = mMemoryAllocator->Statistics(HeapType::Default).reservedBytes;
+	mMemoryAllocator->ReleaseEmptyBlocks();
+	return reservedBytes - mMemoryAllocator->Statistics(HeapType::Default).reservedBytes;
+}
+
+// ============================================================================
+// Account the transient memory of the render graph in the memory budget.
+//
+// The transient memory follows the size of the scene target and it may be
+// released by the memory budget, so it's synchronized after the changes.
+// ============================================================================
+void Renderer::TrackTransientMemory()
+{
+	auto transientBytes = mRenderGraphBackend->TransientMemorySize();
+	if (transientBytes != mTransientBytes) {
+		mMemoryBudget->Free(MemoryCategory::RenderTargets, MemorySegment::Local, mTransientBytes);
+		mMemoryBudget->Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, transientBytes);
+		mTransientBytes = transientBytes;
+	}
 }
 
 // ============================================================================
@@ -344,9 +930,7 @@ D3D12_RESOURCE_BARRIER Renderer::RTVBarrier(D3D12_RESOURCE_STATES from, D3D12_RE
 // ============================================================================
 D3D12_CPU_DESCRIPTOR_HANDLE Renderer::RenderTargetView()
 {
-	auto rtvHeap = mRTVHeap->GetCPUDescriptorHandleForHeapStart();
-	rtvHeap.ptr += mBufferIndex * mRTVDescriptorSize;
-	return rtvHeap;
+	return { static_cast<SIZE_T>(mBackBufferViews.CpuHandle(mBufferIndex)) };
 }
 
 // ============================================================================
@@ -362,6 +946,7 @@ void Renderer::CreateSizeDependentResources()
 
 	// release old render targets if any exists.
 	for (auto rtv : mRenderTargets) {
+		mStateTracker.Unregister(rtv.Get());
 		rtv->Release();
 	}
 
@@ -369,7 +954,7 @@ void Renderer::CreateSizeDependentResources()
 	auto width = (UINT)mWindow->Bounds.Width;
 	auto height = (UINT)mWindow->Bounds.Height;
 	if (mSwapchain != nullptr) {
-		ThrowIfFailed(mSwapchain->ResizeBuffers(BUFFER_COUNT, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0));
+		ThrowIfFailed(mSwapchain->ResizeBuffers(BUFFER_COUNT, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, mSwapChainFlags));
 	} else {
 		ComPtr<IDXGISwapChain1> swapChain;
 		DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -383,9 +968,19 @@ void Renderer::CreateSizeDependentResources()
 		swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
 		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
 		swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-		swapChainDesc.Flags = 0;
+		swapChainDesc.Flags = mSwapChainFlags;
 		ThrowIfFailed(mDXGIFactory->CreateSwapChainForCoreWindow(mCommandQueue.Get(), reinterpret_cast<IUnknown*>(mWindow.Get()), &swapChainDesc, nullptr, &swapChain));
 		ThrowIfFailed(swapChain.As(&mSwapchain));
+
+		// limit the queued presents and get the object signaled when there is room for the next one.
+		if (mPacingDesc.mode == PresentMode::LatencyWaitable) {
+			ThrowIfFailed(mSwapchain->SetMaximumFrameLatency(mPacingDesc.maxLatency));
+			mFrameLatencyWaitable = mSwapchain->GetFrameLatencyWaitableObject();
+		}
+
+		// pace the frames with the vertical blanks of the swap chain output.
+		mDisplayClock = std::make_unique<DxgiDisplayClock>(mSwapchain.Get(), mPacingClock);
+		mFramePacer = std::make_unique<FramePacer>(mPacingClock, *mDisplayClock, mPacingDesc);
 	}
 
 	// resize viewport to match with the window size.
@@ -404,16 +999,18 @@ void Renderer::CreateSizeDependentResources()
 	mScissors.right = static_cast<LONG>(mViewport.Width);
 	mScissors.bottom = static_cast<LONG>(mViewport.Height);
 
-	// get the position where heap starts.
-	auto rtvHeap = mRTVHeap->GetCPUDescriptorHandleForHeapStart();
-
 	// construct a new render target view for each rendering buffer.
 	mRenderTargets.clear();
+	mMemoryBudget->Free(MemoryCategory::RenderTargets, MemorySegment::Local, mBackBufferBytes);
+	mBackBufferBytes = 0;
 	for (auto i = 0; i < BUFFER_COUNT; i++) {
 		ComPtr<ID3D12Resource> buffer;
 		ThrowIfFailed(mSwapchain->GetBuffer(i, IID_PPV_ARGS(&buffer)));
-		mDevice->CreateRenderTargetView(buffer.Get(), nullptr, rtvHeap);
+		auto bufferDescriptor = buffer->GetDesc();
+		mBackBufferBytes += mDevice->GetResourceAllocationInfo(0, 1, &bufferDescriptor).SizeInBytes;
+		mDevice->CreateRenderTargetView(buffer.Get(), nullptr, { static_cast<SIZE_T>(mBackBufferViews.CpuHandle(i)) });
+		mStateTracker.Register(buffer.Get(), 1, ResourceState::Present);
 		mRenderTargets.push_back(buffer);
-		rtvHeap.ptr += mRTVDescriptorSize;
 	}
+	mMemoryBudget->Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, mBackBufferBytes);
 }
\ No newline at end of file
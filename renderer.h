@@ -1,13 +1,94 @@
 #pragma once
 
+#include "bounding_volume_hierarchy.h"
+#include "command_capture.h"
+#include "d3d12_command_recorder.h"
+#include "d3d12_copy_queue.h"
+#include "d3d12_descriptor_device.h"
+#include "d3d12_gpu_profiler.h"
+#include "d3d12_heap_factory.h"
+#include "d3d12_pipeline_factory.h"
+#include "d3d12_render_graph_backend.h"
+#include "d3d12_timeline.h"
+#include "dxgi_budget_provider.h"
+#include "dxgi_display_clock.h"
+#include "shader_cache.h"
+#include "upload_ring.h"
+#include "frame_pacer.h"
+#include "frame_pipeline.h"
+#include "geometry_uploader.h"
+#include "instance_batcher.h"
+#include "mesh_file.h"
+#include "resolution_controller.h"
+#include "simulation.h"
+
 #include <agile.h>
 #include <dxgi1_6.h>
 #include <d3d12.h>
+#include <memory>
 #include <vector>
 #include <wrl.h>
 
 #define BUFFER_COUNT 2
 
+// the default amount of frames the CPU may record ahead of the GPU.
+#define FRAME_LATENCY 2
+
+// the default present mode, the maximum amount of queued presents and the safety margin of the frame pacing.
+#define PRESENT_MODE PresentMode::LatencyWaitable
+#define PRESENT_MAX_LATENCY 1
+#define PRESENT_MARGIN_NANOSECONDS 1000000ull
+
+// the amount of frames whose work is used to predict the work of the next frame.
+#define PRESENT_HISTORY_FRAMES 16
+
+// the fractions of the memory budget where the trimming starts and where it stops, and the frames between the budget queries.
+#define MEMORY_TRIM_THRESHOLD 0.95
+#define MEMORY_TRIM_TARGET 0.85
+#define MEMORY_POLL_FRAMES 30
+
+// the amount of threads that build the pipeline states in the background.
+#define PIPELINE_BUILD_THREADS 1
+
+// the size of the upload ring for the per-frame dynamic data in bytes.
+#define UPLOAD_RING_SIZE (1024 * 1024)
+
+// the size of the staging buffer and a single copy batch for the static geometry.
+#define STAGING_BUFFER_SIZE (8 * 1024 * 1024)
+#define UPLOAD_BATCH_SIZE (2 * 1024 * 1024)
+
+// the capacity of the CPU descriptor heaps and of the shader visible descriptor ring.
+#define DESCRIPTOR_HEAP_CAPACITY 256
+#define DESCRIPTOR_RING_CAPACITY 4096
+
+// the size of the heap blocks the placed resources are allocated from.
+#define GPU_HEAP_BLOCK_SIZE (64 * 1024 * 1024)
+
+// the minimum amount of draws recorded into a single command list.
+#define RECORDING_CHUNK_SIZE 256
+
+// the memory reserved for the buffers and for the frames of a command capture.
+#define CAPTURE_RESIDENT_SIZE (16 * 1024 * 1024)
+#define CAPTURE_FRAME_SIZE (8 * 1024 * 1024)
+
+// the GPU frame time budget of the dynamic resolution and the smallest render scale.
+#define RESOLUTION_BUDGET_MILLISECONDS 15.0
+#define RESOLUTION_MINIMUM_SCALE 0.5f
+
+// ============================================================================
+// A buffer which is released once the GPU has passed the given fence values.
+//
+// The copy queue may still write into the buffer, so the buffer waits for the
+// last copy submitted before it was retired as well as for the frames.
+// ============================================================================
+struct RetiredBuffer
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource>	buffer;
+	GpuAllocation							allocation;
+	uint64_t								fenceValue;
+	uint64_t								copyFenceValue;
+};
+
 // ============================================================================
 // A renderer object to draw stuff on the screen.
 //
@@ -17,37 +98,83 @@
 ref class Renderer sealed
 {
 public:
-	Renderer();
+	Renderer(unsigned frameLatency, const FramePacingDesc& pacing, JobSystem& jobSystem);
+	virtual ~Renderer();
 	void SetWindow(Windows::UI::Core::CoreWindow^ window);
+	void LoadMesh(const MeshFile& mesh);
+	void SetScene(const SceneState& scene);
+	void WaitForFrameStart();
 	void Render();
 	void WaitForGPU();
+	void SavePipelineCache();
+	void StartCapture(unsigned frameCount);
+	bool CaptureComplete();
+	void SaveCapture(std::ostream& output);
+	void SetVisible(bool visible);
+	std::string ExportMemoryStatistics();
 private:
-	D3D12_RESOURCE_BARRIER RTVBarrier(D3D12_RESOURCE_STATES from, D3D12_RESOURCE_STATES to);
 	D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView();
 	void CreateSizeDependentResources();
+	void CreateGeometryBuffer(uint64_t size, Microsoft::WRL::ComPtr<ID3D12Resource>& buffer, GpuAllocation& allocation);
+	void CreateVertexBuffer(uint64_t size, unsigned stride);
+	void CreateIndexBuffer(uint64_t size, DXGI_FORMAT format, unsigned indexCount);
+	uint64_t ReleaseEmptyHeapBlocks();
+	void TrackTransientMemory();
 private:
 	Microsoft::WRL::ComPtr<IDXGIFactory4>				mDXGIFactory;
 	Microsoft::WRL::ComPtr<IDXGIAdapter4>				mDXGIAdapter;
 	Microsoft::WRL::ComPtr<ID3D12Device2>				mDevice;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue>			mCommandQueue;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		mRTVHeap;
-	UINT												mRTVDescriptorSize;
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator>		mCommandAllocators[BUFFER_COUNT];
+	std::unique_ptr<D3D12DescriptorDevice>				mDescriptorDevice;
+	std::unique_ptr<CpuDescriptorAllocator>				mRTVAllocator;
+	std::unique_ptr<CpuDescriptorAllocator>				mViewAllocator;
+	std::unique_ptr<DescriptorRing>						mDescriptorRing;
+	std::unique_ptr<DescriptorCopyBatch>				mDescriptorCopies;
+	DescriptorRange										mBackBufferViews;
+	DescriptorRange										mSceneTargetView;
+	DescriptorRange										mSceneTextureView;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature>			mRootSignature;
-	Microsoft::WRL::ComPtr<ID3DBlob>					mVertexShader;
-	Microsoft::WRL::ComPtr<ID3DBlob>					mPixelShader;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mPipelineState;
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	mCommandList;
+	ShaderBytecode										mVertexShader;
+	ShaderBytecode										mPixelShader;
+	ShaderBytecode										mUpscaleVertexShader;
+	ShaderBytecode										mUpscalePixelShader;
+	std::unique_ptr<D3D12PipelineFactory>				mPipelineFactory;
+	std::unique_ptr<PipelineCache>						mPipelineCache;
+	PipelineStateDesc									mPipelineDesc;
+	std::shared_ptr<PipelineObject>						mUpscalePipeline;
+	std::unique_ptr<D3D12CommandRecorder>				mCommandRecorder;
+	std::unique_ptr<ParallelRecorder>					mParallelRecorder;
+	unsigned											mFrameListCount;
+	std::unique_ptr<D3D12HeapFactory>					mHeapFactory;
+	std::unique_ptr<GpuMemoryAllocator>					mMemoryAllocator;
+	std::unique_ptr<D3D12CopyQueue>						mCopyQueue;
+	std::unique_ptr<GeometryUploader>					mGeometryUploader;
+	uint64_t											mGeometryFence;
+	GpuAllocation										mVertexBufferAllocation;
 	Microsoft::WRL::ComPtr<ID3D12Resource>				mVertexBuffer;
 	D3D12_VERTEX_BUFFER_VIEW							mVertexBufferView;
+	GpuAllocation										mIndexBufferAllocation;
+	Microsoft::WRL::ComPtr<ID3D12Resource>				mIndexBuffer;
+	D3D12_INDEX_BUFFER_VIEW								mIndexBufferView;
+	unsigned											mIndexCount;
+	Aabb												mMeshBounds;
+	BoundingVolumeHierarchy								mVisibility;
+	std::vector<uint32_t>								mVisibleObjects;
+	InstanceBatcher										mInstanceBatcher;
+	std::vector<RetiredBuffer>							mRetiredBuffers;
+	Microsoft::WRL::ComPtr<ID3D12Resource>				mUploadBuffer;
+	std::unique_ptr<UploadRing>							mUploadRing;
+	CaptureWriter										mCapture;
+	uint32_t											mCaptureVertexBuffer;
+	uint32_t											mCaptureIndexBuffer;
 
 	// ===================================
 	// CPU<->GPU synchronization resources
 	// ===================================
 
-	Microsoft::WRL::ComPtr<ID3D12Fence>	mFence;
-	HANDLE								mFenceEvent;
-	uint64_t							mFenceValue;
+	std::unique_ptr<D3D12Timeline>	mTimeline;
+	std::unique_ptr<FramePipeline>	mFramePipeline;
+	std::unique_ptr<D3D12GpuProfiler>	mGpuProfiler;
 
 	// ==========================
 	// window dependent resources
@@ -56,8 +183,39 @@ private:
 	Platform::Agile<Windows::UI::Core::CoreWindow>		mWindow;
 	Microsoft::WRL::ComPtr<IDXGISwapChain4>				mSwapchain;
 	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>	mRenderTargets;
+	ResourceStateTracker								mStateTracker;
+
+	// ======================
+	// frame pacing resources
+	// ======================
+
+	FramePacingDesc						mPacingDesc;
+	UINT								mSwapChainFlags;
+	HANDLE								mFrameLatencyWaitable;
+	SteadyClock							mPacingClock;
+	std::unique_ptr<DxgiDisplayClock>	mDisplayClock;
+	std::unique_ptr<FramePacer>			mFramePacer;
+
+	// =======================
+	// memory budget resources
+	// =======================
+
+	std::unique_ptr<DxgiBudgetProvider>	mBudgetProvider;
+	std::unique_ptr<MemoryBudget>		mMemoryBudget;
+	std::vector<ID3D12Pageable*>		mEvictedHeaps;
+	uint64_t							mBackBufferBytes;
+	uint64_t							mTransientBytes;
+
+	// =====================
+	// frame graph resources
+	// =====================
+
+	std::unique_ptr<D3D12RenderGraphBackend>	mRenderGraphBackend;
+	std::unique_ptr<RenderGraph>				mRenderGraph;
 	D3D12_VIEWPORT										mViewport;
 	D3D12_RECT											mScissors;
+	ResolutionController								mResolutionController;
+	SceneState											mScene;
 
 	unsigned int mBufferIndex;
 };
@@ -0,0 +1,89 @@
+#include "resolution_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ResolutionController::ResolutionController(const ResolutionControllerDesc& desc) : mDesc(desc), mScale(desc.maximumScale), mOverBudgetFrames(0), mUnderBudgetFrames(0), mSettleFrames(0), mChangeCount(0)
+{
+	if (!(desc.budgetMilliseconds > 0.0) || !(desc.scaleStep > 0.f) || !(desc.minimumScale > 0.f) || desc.minimumScale > desc.maximumScale) {
+		throw std::invalid_argument("frame time budget, scale step and scale range must be positive");
+	}
+	if (!(desc.lowerThreshold < desc.upperThreshold) || desc.increaseDelay == 0 || desc.decreaseDelay == 0) {
+		throw std::invalid_argument("lower threshold must be below the upper threshold and delays must be non-zero");
+	}
+}
+
+// ============================================================================
+// Return to the maximum scale and forget the measured frames.
+// ============================================================================
+void ResolutionController::Reset()
+{
+	mScale = mDesc.maximumScale;
+	mOverBudgetFrames = 0;
+	mUnderBudgetFrames = 0;
+	mSettleFrames = 0;
+}
+
+// ============================================================================
+// Feed the measured time of a frame and get the scale for the next frame.
+//
+// Frames without a measurement i.e. with a zero time are ignored. A frame
+// within the band between the thresholds resets both of the delays.
+// ============================================================================
+float ResolutionController::Update(double frameMilliseconds)
+{
+	if (!(frameMilliseconds > 0.0)) {
+		return mScale;
+	}
+	if (mSettleFrames > 0) {
+		mSettleFrames--;
+		return mScale;
+	}
+
+	auto load = frameMilliseconds / mDesc.budgetMilliseconds;
+	auto scale = mScale;
+	auto target = (mDesc.lowerThreshold + mDesc.upperThreshold) * 0.5;
+	auto fitted = static_cast<float>(mScale * std::sqrt(target / load));
+	if (load > mDesc.upperThreshold) {
+		mUnderBudgetFrames = 0;
+		if (++mOverBudgetFrames >= mDesc.decreaseDelay) {
+			scale = std::min(QuantizeScale(fitted), QuantizeScale(mScale - mDesc.scaleStep));
+		}
+	} else if (load < mDesc.lowerThreshold) {
+		mOverBudgetFrames = 0;
+		if (++mUnderBudgetFrames >= mDesc.increaseDelay) {
+			scale = std::max(QuantizeScale(fitted), QuantizeScale(mScale + mDesc.scaleStep));
+		}
+	} else {
+		mOverBudgetFrames = 0;
+		mUnderBudgetFrames = 0;
+	}
+
+	if (scale != mScale) {
+		mScale = scale;
+		mOverBudgetFrames = 0;
+		mUnderBudgetFrames = 0;
+		mSettleFrames = mDesc.settleFrames;
+		mChangeCount++;
+	}
+	return mScale;
+}
+
+// ============================================================================
+// Get the render resolution for a window size at the current scale.
+// ============================================================================
+void ResolutionController::RenderSize(unsigned width, unsigned height, unsigned& renderWidth, unsigned& renderHeight) const
+{
+	renderWidth = std::max(static_cast<unsigned>(width * mScale + 0.5f), 1u);
+	renderHeight = std::max(static_cast<unsigned>(height * mScale + 0.5f), 1u);
+}
+
+// ============================================================================
+// Round a scale down to a multiple of the step within the scale range.
+// ============================================================================
+float ResolutionController::QuantizeScale(float scale) const
+{
+	auto steps = std::floor(scale / mDesc.scaleStep + 1e-3f);
+	return std::min(std::max(steps * mDesc.scaleStep, mDesc.minimumScale), mDesc.maximumScale);
+}
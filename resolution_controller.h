@@ -0,0 +1,51 @@
+#pragma once
+
+// ============================================================================
+// The tuning of a dynamic resolution controller.
+//
+// The thresholds are fractions of the frame time budget. The scale shrinks
+// after the frame time has stayed above the upper threshold and grows after
+// it has stayed below the lower threshold, so the band between them and the
+// delays form the hysteresis that keeps the resolution from oscillating.
+// ============================================================================
+struct ResolutionControllerDesc
+{
+	double		budgetMilliseconds;
+	float		minimumScale;
+	float		maximumScale;
+	float		scaleStep;
+	double		lowerThreshold;
+	double		upperThreshold;
+	unsigned	increaseDelay;
+	unsigned	decreaseDelay;
+	unsigned	settleFrames;
+};
+
+// ============================================================================
+// A controller that scales the render resolution to fit a frame time budget.
+//
+// Frame time is assumed to scale with the pixel count i.e. the square of the
+// scale, so a change aims the frame time at the middle of the hysteresis band
+// and rounds the scale down to a multiple of the step. The measurements right
+// after a change still come from the frames in flight at the old scale, so
+// they are ignored for the given amount of settle frames.
+// ============================================================================
+class ResolutionController
+{
+public:
+	explicit ResolutionController(const ResolutionControllerDesc& desc);
+	void Reset();
+	float Update(double frameMilliseconds);
+	void RenderSize(unsigned width, unsigned height, unsigned& renderWidth, unsigned& renderHeight) const;
+	float Scale() const { return mScale; }
+	unsigned ChangeCount() const { return mChangeCount; }
+private:
+	float QuantizeScale(float scale) const;
+private:
+	ResolutionControllerDesc	mDesc;
+	float						mScale;
+	unsigned					mOverBudgetFrames;
+	unsigned					mUnderBudgetFrames;
+	unsigned					mSettleFrames;
+	unsigned					mChangeCount;
+};
@@ -0,0 +1,132 @@
+#include "resource_state_tracker.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// the states in which the GPU only reads a resource.
+const ResourceState ReadOnlyStates = ResourceState::VertexBuffer | ResourceState::IndexBuffer | ResourceState::ConstantBuffer | ResourceState::ShaderResource | ResourceState::CopySource | ResourceState::DepthRead | ResourceState::IndirectArgument;
+
+// ============================================================================
+// Start tracking a resource with the given amount of subresources.
+// ============================================================================
+void ResourceStateTracker::Register(void* resource, uint32_t subresourceCount, ResourceState state)
+{
+	mResources[resource] = { std::vector<ResourceState>(std::max(subresourceCount, 1u), state), true };
+}
+
+// ============================================================================
+// Stop tracking a resource and drop its queued barriers.
+// ============================================================================
+void ResourceStateTracker::Unregister(void* resource)
+{
+	mResources.erase(resource);
+	mPending.erase(std::remove_if(mPending.begin(), mPending.end(), [&](const ResourceBarrier& barrier) { return barrier.resource == resource; }), mPending.end());
+}
+
+// ============================================================================
+// Declare that a resource or one of its subresources is used in a state.
+//
+// A whole resource in a uniform state is transitioned with a single barrier,
+// otherwise each subresource which is not yet in the state gets its own one.
+// ============================================================================
+void ResourceStateTracker::Transition(void* resource, ResourceState state, uint32_t subresource)
+{
+	auto tracked = mResources.find(resource);
+	if (tracked == mResources.end()) {
+		throw std::invalid_argument("transitioning a resource that is not registered");
+	}
+	auto& states = tracked->second.states;
+	if (subresource == ALL_SUBRESOURCES && tracked->second.uniform) {
+		auto current = states[0];
+		TransitionSubresource(resource, ALL_SUBRESOURCES, current, state);
+		std::fill(states.begin(), states.end(), current);
+		return;
+	}
+	if (subresource == ALL_SUBRESOURCES) {
+		for (uint32_t i = 0; i < states.size(); i++) {
+			TransitionSubresource(resource, i, states[i], state);
+		}
+	} else {
+		TransitionSubresource(resource, subresource, states.at(subresource), state);
+	}
+	tracked->second.uniform = std::all_of(states.begin(), states.end(), [&](ResourceState s) { return s == states[0]; });
+}
+
+// ============================================================================
+// Queue an unordered access barrier between two writes of a resource.
+// ============================================================================
+void ResourceStateTracker::UnorderedAccessBarrier(void* resource)
+{
+	mPending.push_back({ ResourceBarrier::Type::UnorderedAccess, resource, ALL_SUBRESOURCES, ResourceState::UnorderedAccess, ResourceState::UnorderedAccess });
+}
+
+// ============================================================================
+// Get the tracked state of a subresource.
+// ============================================================================
+ResourceState ResourceStateTracker::State(void* resource, uint32_t subresource) const
+{
+	return mResources.at(resource).states.at(subresource);
+}
+
+// ============================================================================
+// Move the queued barriers into the given vector as a single batch.
+// ============================================================================
+void ResourceStateTracker::Flush(std::vector<ResourceBarrier>& barriers)
+{
+	barriers.insert(barriers.end(), mPending.begin(), mPending.end());
+	mPending.clear();
+}
+
+// ============================================================================
+// Check whether the GPU only reads a resource in the given state.
+// ============================================================================
+bool ResourceStateTracker::IsReadOnly(ResourceState state)
+{
+	return state != ResourceState::Common && (state & ReadOnlyStates) == state;
+}
+
+// ============================================================================
+// Infer the barrier to move a subresource from its current state to a state.
+//
+// A subresource already in a read-only state that covers the new read-only
+// state needs no barrier. Other read-only states are combined with it, so a
+// resource that is read in several ways only needs a single transition.
+// ============================================================================
+void ResourceStateTracker::TransitionSubresource(void* resource, uint32_t subresource, ResourceState& current, ResourceState state)
+{
+	if (current == state && state == ResourceState::UnorderedAccess) {
+		UnorderedAccessBarrier(resource);
+		return;
+	}
+	if (current == state || (IsReadOnly(current) && IsReadOnly(state) && (current & state) == state)) {
+		return;
+	}
+	auto after = (IsReadOnly(current) && IsReadOnly(state)) ? current | state : state;
+	Queue({ ResourceBarrier::Type::Transition, resource, subresource, current, after });
+	current = after;
+}
+
+// ============================================================================
+// Queue a transition or merge it with a queued transition of the subresource.
+//
+// Two transitions of the same subresource collapse into one from the first
+// state to the last state, and they are dropped if these states are equal.
+// ============================================================================
+void ResourceStateTracker::Queue(const ResourceBarrier& barrier)
+{
+	for (auto pending = mPending.rbegin(); pending != mPending.rend(); ++pending) {
+		if (pending->resource != barrier.resource) {
+			continue;
+		}
+		if (pending->type != ResourceBarrier::Type::Transition || pending->subresource != barrier.subresource) {
+			break;
+		}
+		if (pending->before == barrier.after) {
+			mPending.erase(std::next(pending).base());
+		} else {
+			pending->after = barrier.after;
+		}
+		return;
+	}
+	mPending.push_back(barrier);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// a subresource index that refers to all subresources of a resource.
+#define ALL_SUBRESOURCES UINT32_MAX
+
+// ============================================================================
+// The usage states of a GPU resource.
+//
+// States are bit flags so that read-only states can be combined, which lets
+// a resource be e.g. sampled and copied from without barriers in between.
+// Present is the common state like in D3D12, so that the tracker does not see
+// a change where the GPU would not have one.
+// ============================================================================
+enum class ResourceState : uint32_t
+{
+	Common				= 0,
+	VertexBuffer		= 1 << 0,
+	IndexBuffer			= 1 << 1,
+	ConstantBuffer		= 1 << 2,
+	ShaderResource		= 1 << 3,
+	CopySource			= 1 << 4,
+	DepthRead			= 1 << 5,
+	IndirectArgument	= 1 << 6,
+	RenderTarget		= 1 << 7,
+	UnorderedAccess		= 1 << 8,
+	DepthWrite			= 1 << 9,
+	CopyDest			= 1 << 10,
+	Present				= Common
+};
+
+// helpers to combine and test the resource state flags.
+inline ResourceState operator|(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+inline ResourceState operator&(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); }
+
+// ============================================================================
+// A barrier inferred by the resource state tracker.
+//
+// A transition changes the state of a subresource, while an unordered access
+// barrier only orders the accesses of two passes writing the same resource.
+// An aliasing barrier activates a resource that shares memory with others.
+// ============================================================================
+struct ResourceBarrier
+{
+	enum class Type : uint8_t { Transition, UnorderedAccess, Aliasing };
+	Type			type;
+	void*			resource;
+	uint32_t		subresource;
+	ResourceState	before;
+	ResourceState	after;
+};
+
+// ============================================================================
+// A tracker of the resource states that infers the barriers from the usage.
+//
+// Users declare the state a resource is about to be used in and the tracker
+// queues the barriers needed to get there. Queued barriers are merged, and
+// transitions that cancel each other are dropped before they are flushed as
+// a single batch. Resources are opaque handles of the backend.
+// ============================================================================
+class ResourceStateTracker
+{
+public:
+	void Register(void* resource, uint32_t subresourceCount, ResourceState state);
+	void Unregister(void* resource);
+	void Transition(void* resource, ResourceState state, uint32_t subresource = ALL_SUBRESOURCES);
+	void UnorderedAccessBarrier(void* resource);
+	ResourceState State(void* resource, uint32_t subresource = 0) const;
+	void Flush(std::vector<ResourceBarrier>& barriers);
+	bool HasPendingBarriers() const { return !mPending.empty(); }
+	static bool IsReadOnly(ResourceState state);
+private:
+	struct TrackedResource
+	{
+		std::vector<ResourceState>	states;
+		bool						uniform;
+	};
+	void TransitionSubresource(void* resource, uint32_t subresource, ResourceState& current, ResourceState state);
+	void Queue(const ResourceBarrier& barrier);
+private:
+	std::unordered_map<void*, TrackedResource>	mResources;
+	std::vector<ResourceBarrier>				mPending;
+};
@@ -0,0 +1,156 @@
+#include "shader_cache.h"
+#include "binary_stream.h"
+
+// the identifier and the version of the shader cache file format.
+#define SHADER_CACHE_MAGIC 0x43444853u
+#define SHADER_CACHE_VERSION 1u
+
+// constants of the 64-bit and 32-bit FNV-1a hash functions.
+const uint64_t FnvOffset64 = 14695981039346656037ull;
+const uint64_t FnvPrime64 = 1099511628211ull;
+const uint32_t FnvOffset32 = 2166136261u;
+const uint32_t FnvPrime32 = 16777619u;
+
+// a helper to feed bytes into a 64-bit FNV-1a hash.
+static uint64_t Fnv64(uint64_t hash, const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * FnvPrime64;
+	}
+	return hash;
+}
+
+// a helper to feed a length prefixed string into a 64-bit FNV-1a hash.
+static uint64_t Fnv64(uint64_t hash, const std::string& text)
+{
+	auto size = static_cast<uint64_t>(text.size());
+	hash = Fnv64(hash, &size, sizeof(size));
+	return Fnv64(hash, text.data(), text.size());
+}
+
+// a helper to calculate a 32-bit FNV-1a checksum of a byte sequence.
+static uint32_t Checksum(const ShaderBytecode& bytecode)
+{
+	auto hash = FnvOffset32;
+	for (auto byte : bytecode) {
+		hash = (hash ^ byte) * FnvPrime32;
+	}
+	return hash;
+}
+
+ShaderCache::ShaderCache(ShaderCompiler& compiler) : mCompiler(compiler), mDirty(false), mHitCount(0), mMissCount(0)
+{
+}
+
+// ============================================================================
+// Calculate the content address of a shader program.
+//
+// Each field is hashed with a length prefix so that moving characters from a
+// field to another (e.g. from the entry point to the target) changes the key.
+// ============================================================================
+uint64_t ShaderCache::Key(const ShaderSource& source)
+{
+	auto hash = FnvOffset64;
+	hash = Fnv64(hash, source.source);
+	hash = Fnv64(hash, source.entryPoint);
+	hash = Fnv64(hash, source.target);
+	return Fnv64(hash, &source.flags, sizeof(source.flags));
+}
+
+// ============================================================================
+// Add shader blobs that were precompiled and embedded at build time.
+//
+// Embedded blobs are used like the loaded ones, but they are never written to
+// the cache file because they are always available within the executable.
+// ============================================================================
+void ShaderCache::AddEmbedded(const EmbeddedShader* shaders, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		mEmbedded[shaders[i].key].assign(shaders[i].data, shaders[i].data + shaders[i].size);
+	}
+}
+
+// ============================================================================
+// Load cached shaders from a binary stream.
+//
+// The file consists of a header and a sequence of entries with the key, size,
+// checksum and the bytecode. Function returns false if the data is invalid,
+// which includes sizes beyond the end of the stream, so a corrupt or a cut
+// file is treated like a cache miss instead of allocating what it claims.
+// ============================================================================
+bool ShaderCache::Load(std::istream& stream)
+{
+	uint32_t magic = 0, version = 0, count = 0;
+	if (!ReadValue(stream, magic) || !ReadValue(stream, version) || !ReadValue(stream, count)) {
+		return false;
+	}
+	if (magic != SHADER_CACHE_MAGIC || version != SHADER_CACHE_VERSION) {
+		return false;
+	}
+
+	// read all entries before accepting any of them.
+	std::unordered_map<uint64_t, ShaderBytecode> entries;
+	auto remaining = RemainingSize(stream);
+	for (auto i = 0u; i < count; i++) {
+		uint64_t key = 0;
+		uint32_t size = 0, checksum = 0;
+		if (!ReadValue(stream, key) || !ReadValue(stream, size) || !ReadValue(stream, checksum)) {
+			return false;
+		}
+		auto entrySize = sizeof(key) + sizeof(size) + sizeof(checksum) + static_cast<uint64_t>(size);
+		if (entrySize > remaining) {
+			return false;
+		}
+		remaining -= entrySize;
+		ShaderBytecode bytecode(size);
+		if (!stream.read(reinterpret_cast<char*>(bytecode.data()), size) || Checksum(bytecode) != checksum) {
+			return false;
+		}
+		entries[key] = std::move(bytecode);
+	}
+	for (auto& entry : entries) {
+		mEntries.insert(std::move(entry));
+	}
+	return true;
+}
+
+// ============================================================================
+// Save all cached shaders into a binary stream.
+// ============================================================================
+void ShaderCache::Save(std::ostream& stream) const
+{
+	WriteValue(stream, SHADER_CACHE_MAGIC);
+	WriteValue(stream, SHADER_CACHE_VERSION);
+	WriteValue(stream, static_cast<uint32_t>(mEntries.size()));
+	for (auto& entry : mEntries) {
+		WriteValue(stream, entry.first);
+		WriteValue(stream, static_cast<uint32_t>(entry.second.size()));
+		WriteValue(stream, Checksum(entry.second));
+		stream.write(reinterpret_cast<const char*>(entry.second.data()), entry.second.size());
+	}
+}
+
+// ============================================================================
+// Get the bytecode of a shader program and compile it on a cache miss.
+//
+// A cache miss marks the cache as dirty so the caller knows that it should be
+// saved for the following runs. Compilation errors are thrown as is.
+// ============================================================================
+const ShaderBytecode& ShaderCache::GetOrCompile(const ShaderSource& source)
+{
+	auto key = Key(source);
+	auto embedded = mEmbedded.find(key);
+	if (embedded != mEmbedded.end()) {
+		mHitCount++;
+		return embedded->second;
+	}
+	auto entry = mEntries.find(key);
+	if (entry != mEntries.end()) {
+		mHitCount++;
+		return entry->second;
+	}
+	mMissCount++;
+	mDirty = true;
+	return mEntries[key] = mCompiler.Compile(source);
+}
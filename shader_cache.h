@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// a byte sequence of a compiled shader program.
+typedef std::vector<uint8_t> ShaderBytecode;
+
+// ============================================================================
+// A description of a shader program to be compiled.
+// ============================================================================
+struct ShaderSource
+{
+	std::string	source;
+	std::string	entryPoint;
+	std::string	target;
+	uint32_t	flags;
+};
+
+// ============================================================================
+// A precompiled shader blob embedded into the executable at build time.
+// ============================================================================
+struct EmbeddedShader
+{
+	uint64_t		key;
+	const uint8_t*	data;
+	size_t			size;
+};
+
+// ============================================================================
+// An interface for the shader compilers used on cache misses.
+// ============================================================================
+class ShaderCompiler
+{
+public:
+	virtual ~ShaderCompiler() = default;
+	virtual ShaderBytecode Compile(const ShaderSource& source) = 0;
+};
+
+// ============================================================================
+// A content-addressed cache of compiled shader bytecode.
+//
+// Shaders are addressed with a hash of the source, entry point, target and
+// flags. The compiler is only invoked when the bytecode is not yet cached.
+// ============================================================================
+class ShaderCache
+{
+public:
+	explicit ShaderCache(ShaderCompiler& compiler);
+	static uint64_t Key(const ShaderSource& source);
+	void AddEmbedded(const EmbeddedShader* shaders, size_t count);
+	bool Load(std::istream& stream);
+	void Save(std::ostream& stream) const;
+	const ShaderBytecode& GetOrCompile(const ShaderSource& source);
+	const std::unordered_map<uint64_t, ShaderBytecode>& Entries() const { return mEntries; }
+	bool IsDirty() const { return mDirty; }
+	unsigned HitCount() const { return mHitCount; }
+	unsigned MissCount() const { return mMissCount; }
+private:
+	ShaderCompiler&									mCompiler;
+	std::unordered_map<uint64_t, ShaderBytecode>	mEmbedded;
+	std::unordered_map<uint64_t, ShaderBytecode>	mEntries;
+	bool											mDirty;
+	unsigned										mHitCount;
+	unsigned										mMissCount;
+};
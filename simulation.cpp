@@ -0,0 +1,123 @@
+#include "simulation.h"
+
+#include "frame_profiler.h"
+
+#include <algorithm>
+
+// the full angle of a rotation in radians.
+const float FullRotation = 6.28318531f;
+
+// ============================================================================
+// Interpolate the scene state of the snapshot for the given time.
+//
+// The scene is presented one step behind the simulation, so the states are
+// blended with the fraction of the step elapsed since the last step time.
+// Rotation is blended along the shorter arc to handle the wrap around.
+// ============================================================================
+SceneState Interpolate(const SceneSnapshot& snapshot, uint64_t now, uint64_t stepNanoseconds)
+{
+	auto elapsed = (now > snapshot.time) ? static_cast<double>(now - snapshot.time) : 0.0;
+	auto alpha = static_cast<float>(std::min(elapsed / stepNanoseconds, 1.0));
+	auto delta = snapshot.current.rotation - snapshot.previous.rotation;
+	if (delta > FullRotation / 2.f) {
+		delta -= FullRotation;
+	} else if (delta < -FullRotation / 2.f) {
+		delta += FullRotation;
+	}
+	SceneState state = snapshot.current;
+	state.rotation = snapshot.previous.rotation + delta * alpha;
+	if (state.rotation >= FullRotation) {
+		state.rotation -= FullRotation;
+	} else if (state.rotation < 0.f) {
+		state.rotation += FullRotation;
+	}
+	return state;
+}
+
+Simulation::Simulation(Clock& clock, uint64_t stepNanoseconds, unsigned maxStepsPerTick, const SceneState& initialState, UpdateFunction update) : mClock(clock), mTimestep(stepNanoseconds, maxStepsPerTick), mUpdate(std::move(update)), mPrevious(initialState), mCurrent(initialState), mPublishedStep(0), mStopping(false)
+{
+	mTimestep.Reset(mClock.Now());
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+// ============================================================================
+// Start running the update loop on a dedicated thread.
+// ============================================================================
+void Simulation::Start()
+{
+	if (!mThread.joinable()) {
+		mStopping.store(false, std::memory_order_relaxed);
+		mTimestep.Reset(mClock.Now());
+		mThread = std::thread([this] { Main(); });
+	}
+}
+
+// ============================================================================
+// Stop the update loop and wait until its thread has exited.
+// ============================================================================
+void Simulation::Stop()
+{
+	if (mThread.joinable()) {
+		mStopping.store(true, std::memory_order_relaxed);
+		mThread.join();
+	}
+}
+
+// ============================================================================
+// Run the steps due at the current time and publish the resulting snapshot.
+//
+// This is called by the loop thread, but it can be called directly as well
+// to drive a stopped simulation step by step with a simulated clock.
+// ============================================================================
+unsigned Simulation::Tick()
+{
+	auto steps = mTimestep.Advance(mClock.Now());
+	if (steps == 0) {
+		return 0;
+	}
+	PROFILE_SCOPE("Simulation::Tick");
+	for (auto i = 0u; i < steps; i++) {
+		mPrevious = mCurrent;
+		mUpdate(mCurrent, mTimestep.StepSeconds());
+	}
+	auto& snapshot = mSnapshots.Back();
+	snapshot.previous = mPrevious;
+	snapshot.current = mCurrent;
+	snapshot.time = mTimestep.LastStepTime();
+	snapshot.step = mTimestep.StepCount();
+	mSnapshots.Publish();
+	mPublishedStep.store(snapshot.step, std::memory_order_release);
+	return steps;
+}
+
+// ============================================================================
+// Get the latest published snapshot if the simulation has published any.
+//
+// Only a single thread may read the snapshots. The snapshot stays valid for
+// the reader until the next call, even if the simulation publishes more.
+// ============================================================================
+bool Simulation::Latest(SceneSnapshot& snapshot)
+{
+	if (mPublishedStep.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+	mSnapshots.Update();
+	snapshot = mSnapshots.Front();
+	return true;
+}
+
+// ============================================================================
+// The main function of the loop thread.
+// ============================================================================
+void Simulation::Main()
+{
+	FrameProfiler::Instance().SetThreadName("Simulation");
+	while (!mStopping.load(std::memory_order_relaxed)) {
+		Tick();
+		mClock.SleepUntil(mTimestep.NextStepTime());
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "clock.h"
+#include "fixed_timestep.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+// ============================================================================
+// The state of the scene updated by the simulation.
+// ============================================================================
+struct SceneState
+{
+	float	rotation;
+};
+
+// ============================================================================
+// A snapshot of the scene published by the simulation to the render thread.
+//
+// Snapshot carries the states after the last two steps, so the reader can
+// interpolate between them without keeping any history of its own.
+// ============================================================================
+struct SceneSnapshot
+{
+	SceneState	previous;
+	SceneState	current;
+	uint64_t	time;
+	uint64_t	step;
+};
+
+SceneState Interpolate(const SceneSnapshot& snapshot, uint64_t now, uint64_t stepNanoseconds);
+
+// ============================================================================
+// A fixed timestep update loop that runs the simulation on its own thread.
+//
+// Loop updates the scene at a fixed rate independently of the rendering and
+// publishes a snapshot after every batch of steps through a triple buffer, so
+// neither a slow frame nor a vsync wait ever blocks the simulation.
+// ============================================================================
+class Simulation
+{
+public:
+	typedef std::function<void(SceneState& state, double deltaSeconds)> UpdateFunction;
+	Simulation(Clock& clock, uint64_t stepNanoseconds, unsigned maxStepsPerTick, const SceneState& initialState, UpdateFunction update);
+	~Simulation();
+	void Start();
+	void Stop();
+	unsigned Tick();
+	bool Latest(SceneSnapshot& snapshot);
+	const FixedTimestep& Timestep() const { return mTimestep; }
+	uint64_t PublishedStep() const { return mPublishedStep.load(std::memory_order_acquire); }
+private:
+	void Main();
+private:
+	Clock&						mClock;
+	FixedTimestep				mTimestep;
+	UpdateFunction				mUpdate;
+	SceneState					mPrevious;
+	SceneState					mCurrent;
+	TripleBuffer<SceneSnapshot>	mSnapshots;
+	std::atomic<uint64_t>		mPublishedStep;
+	std::atomic<bool>			mStopping;
+	std::thread					mThread;
+};
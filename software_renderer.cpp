@@ -0,0 +1,352 @@
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// use the SSE2 code path whenever the target architecture guarantees SSE2.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+// the amount of sub-pixel bits used in the fixed point vertex positions.
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_SCALE (1 << SUBPIXEL_BITS)
+
+// the limit for the vertex coordinates in NDC as there is no clipping stage.
+#define GUARD_BAND 2.f
+
+// a packed RGBA8 value for the black clear color.
+const uint32_t ClearColor = 0xff000000u;
+
+// a helper to perform a division that rounds towards negative infinity.
+inline int64_t FloorDiv(int64_t value, int64_t divisor)
+{
+	return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+SoftwareRenderer::SoftwareRenderer(unsigned threadCount, unsigned frameLatency) :
+	mFrames(frameLatency),
+	mWidth(0),
+	mHeight(0),
+	mPitch(0),
+	mTilesX(0),
+	mTilesY(0),
+	mLastFrameIndex(0),
+	mWorkerPool(std::max(threadCount, 1u)),
+	mFramePipeline(mQueue, frameLatency)
+{
+}
+
+// ============================================================================
+// Specify the size of the frame buffers.
+//
+// This function waits until the previous frames have been completed and then
+// (re)creates the frame buffers and the screen tile grid for the new size.
+// ============================================================================
+void SoftwareRenderer::SetWindow(unsigned width, unsigned height)
+{
+	WaitForGPU();
+	mWidth = width;
+	mHeight = height;
+	mPitch = ((width + 3) & ~3u) * 4;
+	mTilesX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	mTilesY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	for (auto& frame : mFrames) {
+		frame.pixels.assign(static_cast<size_t>(mPitch) * height, 0);
+		frame.bins.assign(static_cast<size_t>(mTilesX) * mTilesY, {});
+	}
+}
+
+// ============================================================================
+// Specify the triangle list to be drawn in the following frames.
+//
+// Vertices are copied and set up into each frame when the frame is rendered,
+// so the geometry can be changed while previous frames are still in flight.
+// ============================================================================
+void SoftwareRenderer::SetGeometry(const std::vector<Vertex>& vertices)
+{
+	mVertices = vertices;
+}
+
+// ============================================================================
+// Render a frame.
+//
+// Triangle setup and binning is done on the calling thread while the tiles of
+// the previous frames may still be rasterized by the queue and its workers.
+// ============================================================================
+void SoftwareRenderer::Render()
+{
+	// wait until the frame slot is no longer being rasterized.
+	auto frameIndex = mFramePipeline.BeginFrame();
+	auto& frame = mFrames[frameIndex];
+
+	// set up the triangles and bin them into the screen tiles.
+	frame.triangles.clear();
+	for (size_t i = 0; i + 2 < mVertices.size(); i += 3) {
+		Triangle triangle;
+		if (SetupTriangle(mVertices[i], mVertices[i + 1], mVertices[i + 2], triangle)) {
+			frame.triangles.push_back(triangle);
+		}
+	}
+	BinTriangles(frame);
+
+	// submit the tiles to be rasterized in parallel on the queue.
+	auto tileCount = mTilesX * mTilesY;
+	mQueue.Submit([this, &frame, tileCount] {
+		mWorkerPool.ParallelFor(tileCount, [this, &frame](unsigned tile) { RasterizeTile(frame, tile); });
+	});
+	mFramePipeline.EndFrame();
+	mLastFrameIndex = frameIndex;
+}
+
+// ============================================================================
+// Wait for the queue to complete all rendered frames.
+// ============================================================================
+void SoftwareRenderer::WaitForGPU()
+{
+	mFramePipeline.Flush();
+}
+
+// ============================================================================
+// Get the pixels of the most recently rendered frame.
+//
+// Rows are stored from top to bottom with the pitch given by Pitch(). Note that
+// the frame must be completed with WaitForGPU() before reading the pixels.
+// ============================================================================
+const std::vector<uint8_t>& SoftwareRenderer::Framebuffer() const
+{
+	return mFrames[mLastFrameIndex].pixels;
+}
+
+// ============================================================================
+// Set up the edge functions and color gradients for a triangle.
+//
+// Vertices are snapped to sub-pixel precision. Function returns false if the
+// triangle is back facing, degenerate, outside the screen or the guard band.
+// ============================================================================
+bool SoftwareRenderer::SetupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, Triangle& triangle) const
+{
+	const Vertex* vertices[] = { &v0, &v1, &v2 };
+
+	// snap the vertices to fixed point screen space coordinates.
+	int64_t x[3], y[3];
+	for (auto i = 0; i < 3; i++) {
+		auto& position = vertices[i]->position;
+		if (!(std::fabs(position[0]) <= GUARD_BAND && std::fabs(position[1]) <= GUARD_BAND)) {
+			return false;
+		}
+		x[i] = std::lround((position[0] * 0.5f + 0.5f) * mWidth * SUBPIXEL_SCALE);
+		y[i] = std::lround((0.5f - position[1] * 0.5f) * mHeight * SUBPIXEL_SCALE);
+	}
+
+	// cull counter-clockwise (back facing) and degenerate triangles.
+	auto area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area <= 0) {
+		return false;
+	}
+
+	// find the pixels whose centers are within the triangle bounds.
+	auto half = SUBPIXEL_SCALE / 2;
+	auto minX = FloorDiv(std::min({ x[0], x[1], x[2] }) - half + SUBPIXEL_SCALE - 1, SUBPIXEL_SCALE);
+	auto minY = FloorDiv(std::min({ y[0], y[1], y[2] }) - half + SUBPIXEL_SCALE - 1, SUBPIXEL_SCALE);
+	auto maxX = FloorDiv(std::max({ x[0], x[1], x[2] }) - half, SUBPIXEL_SCALE);
+	auto maxY = FloorDiv(std::max({ y[0], y[1], y[2] }) - half, SUBPIXEL_SCALE);
+	triangle.minX = static_cast<int32_t>(std::max<int64_t>(minX, 0));
+	triangle.minY = static_cast<int32_t>(std::max<int64_t>(minY, 0));
+	triangle.maxX = static_cast<int32_t>(std::min<int64_t>(maxX, static_cast<int64_t>(mWidth) - 1));
+	triangle.maxY = static_cast<int32_t>(std::min<int64_t>(maxY, static_cast<int64_t>(mHeight) - 1));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+		return false;
+	}
+
+	// set up edge functions so that edge i is the weight of the vertex i.
+	double colorA[4] = {}, colorB[4] = {}, colorC[4] = {};
+	auto originX = static_cast<int64_t>(triangle.minX) * SUBPIXEL_SCALE + half;
+	auto originY = static_cast<int64_t>(triangle.minY) * SUBPIXEL_SCALE + half;
+	for (auto i = 0; i < 3; i++) {
+		auto a = (i + 1) % 3, b = (i + 2) % 3;
+		auto dx = x[b] - x[a];
+		auto dy = y[b] - y[a];
+		triangle.edgeA[i] = -dy;
+		triangle.edgeB[i] = dx;
+		triangle.edgeC[i] = dy * x[a] - dx * y[a];
+
+		// accumulate the color plane relative to the first covered pixel.
+		auto weight = static_cast<double>(triangle.edgeA[i] * originX + triangle.edgeB[i] * originY + triangle.edgeC[i]);
+		for (auto c = 0; c < 4; c++) {
+			auto color = static_cast<double>(vertices[i]->color[c]);
+			colorA[c] += static_cast<double>(triangle.edgeA[i] * SUBPIXEL_SCALE) * color;
+			colorB[c] += static_cast<double>(triangle.edgeB[i] * SUBPIXEL_SCALE) * color;
+			colorC[c] += weight * color;
+		}
+
+		// apply the top-left fill rule by excluding pixels on other edges.
+		auto topLeft = (dy == 0 && dx > 0) || dy < 0;
+		if (!topLeft) {
+			triangle.edgeC[i] -= 1;
+		}
+	}
+	for (auto c = 0; c < 4; c++) {
+		triangle.colorA[c] = static_cast<float>(colorA[c] / area);
+		triangle.colorB[c] = static_cast<float>(colorB[c] / area);
+		triangle.colorC[c] = static_cast<float>(colorC[c] / area);
+	}
+	return true;
+}
+
+// ============================================================================
+// Distribute the triangles of a frame into the screen tiles they overlap.
+//
+// Each tile keeps the triangles in submission order so that the output stays
+// deterministic no matter which thread ends up rasterizing the tile.
+// ============================================================================
+void SoftwareRenderer::BinTriangles(Frame& frame) const
+{
+	for (auto& bin : frame.bins) {
+		bin.clear();
+	}
+	for (size_t i = 0; i < frame.triangles.size(); i++) {
+		auto& triangle = frame.triangles[i];
+		for (auto ty = triangle.minY / SOFTWARE_TILE_SIZE; ty <= triangle.maxY / SOFTWARE_TILE_SIZE; ty++) {
+			for (auto tx = triangle.minX / SOFTWARE_TILE_SIZE; tx <= triangle.maxX / SOFTWARE_TILE_SIZE; tx++) {
+				frame.bins[ty * mTilesX + tx].push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Clear a screen tile and rasterize all triangles binned into it.
+//
+// Edges fully covering the tile are skipped while the partially covering ones
+// are stepped in 32-bit integers four pixels at a time with SSE2 if available.
+// ============================================================================
+void SoftwareRenderer::RasterizeTile(Frame& frame, unsigned tile) const
+{
+	auto tileX0 = static_cast<int32_t>((tile % mTilesX) * SOFTWARE_TILE_SIZE);
+	auto tileY0 = static_cast<int32_t>((tile / mTilesX) * SOFTWARE_TILE_SIZE);
+	auto tileX1 = std::min(tileX0 + SOFTWARE_TILE_SIZE, static_cast<int32_t>(mWidth)) - 1;
+	auto tileY1 = std::min(tileY0 + SOFTWARE_TILE_SIZE, static_cast<int32_t>(mHeight)) - 1;
+
+	// clear the tile with the clear color.
+	for (auto y = tileY0; y <= tileY1; y++) {
+		auto row = &frame.pixels[static_cast<size_t>(y) * mPitch];
+		for (auto x = tileX0; x <= tileX1; x++) {
+			std::memcpy(row + x * 4, &ClearColor, 4);
+		}
+	}
+
+	for (auto index : frame.bins[tile]) {
+		auto& triangle = frame.triangles[index];
+
+		// intersect the triangle bounds with the tile.
+		auto x0 = std::max(triangle.minX, tileX0);
+		auto y0 = std::max(triangle.minY, tileY0);
+		auto x1 = std::min(triangle.maxX, tileX1);
+		auto y1 = std::min(triangle.maxY, tileY1);
+		if (x0 > x1 || y0 > y1) {
+			continue;
+		}
+
+		// classify the edges against the covered rectangle.
+		int32_t edgeStart[3], edgeStepX[3], edgeStepY[3];
+		auto rejected = false;
+		for (auto i = 0; i < 3 && !rejected; i++) {
+			auto stepX = triangle.edgeA[i] * SUBPIXEL_SCALE;
+			auto stepY = triangle.edgeB[i] * SUBPIXEL_SCALE;
+			auto start = triangle.edgeA[i] * (x0 * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) + triangle.edgeB[i] * (y0 * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) + triangle.edgeC[i];
+			auto minimum = start + std::min<int64_t>(0, stepX * (x1 - x0)) + std::min<int64_t>(0, stepY * (y1 - y0));
+			auto maximum = start + std::max<int64_t>(0, stepX * (x1 - x0)) + std::max<int64_t>(0, stepY * (y1 - y0));
+			if (maximum < 0) {
+				rejected = true;
+			} else if (minimum >= 0) {
+				edgeStart[i] = 0;
+				edgeStepX[i] = 0;
+				edgeStepY[i] = 0;
+			} else {
+				edgeStart[i] = static_cast<int32_t>(start);
+				edgeStepX[i] = static_cast<int32_t>(stepX);
+				edgeStepY[i] = static_cast<int32_t>(stepY);
+			}
+		}
+		if (rejected) {
+			continue;
+		}
+
+#if defined(SOFTWARE_RENDERER_SSE2)
+		// precompute the edge offsets of the four pixel lanes.
+		__m128i laneOffsets[3];
+		for (auto i = 0; i < 3; i++) {
+			laneOffsets[i] = _mm_setr_epi32(0, edgeStepX[i], edgeStepX[i] * 2, edgeStepX[i] * 3);
+		}
+#endif
+
+		for (auto y = y0; y <= y1; y++) {
+			auto row = &frame.pixels[static_cast<size_t>(y) * mPitch];
+			int32_t rowEdge[3];
+			float rowColor[4];
+			for (auto i = 0; i < 3; i++) {
+				rowEdge[i] = edgeStart[i] + edgeStepY[i] * (y - y0);
+			}
+			for (auto c = 0; c < 4; c++) {
+				rowColor[c] = triangle.colorB[c] * static_cast<float>(y - triangle.minY) + triangle.colorC[c];
+			}
+
+#if defined(SOFTWARE_RENDERER_SSE2)
+			const auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+			const auto zero = _mm_setzero_si128();
+			const auto scale = _mm_set1_ps(255.f);
+			const auto one = _mm_set1_ps(1.f);
+			const auto zerof = _mm_setzero_ps();
+			for (auto x = x0 & ~3; x <= x1; x += 4) {
+				// evaluate the edge functions for four pixels.
+				auto pixelX = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+				auto inside = _mm_and_si128(_mm_cmpgt_epi32(pixelX, _mm_set1_epi32(x0 - 1)), _mm_cmplt_epi32(pixelX, _mm_set1_epi32(x1 + 1)));
+				auto sign = zero;
+				for (auto i = 0; i < 3; i++) {
+					auto base = _mm_set1_epi32(rowEdge[i] + edgeStepX[i] * (x - x0));
+					sign = _mm_or_si128(sign, _mm_add_epi32(base, laneOffsets[i]));
+				}
+				inside = _mm_and_si128(inside, _mm_cmpeq_epi32(_mm_srai_epi32(sign, 31), zero));
+				if (_mm_movemask_epi8(inside) == 0) {
+					continue;
+				}
+
+				// interpolate the colors and pack them into RGBA8 pixels.
+				auto fx = _mm_cvtepi32_ps(_mm_sub_epi32(pixelX, _mm_set1_epi32(triangle.minX)));
+				auto packed = zero;
+				for (auto c = 0; c < 4; c++) {
+					auto value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.colorA[c]), fx), _mm_set1_ps(rowColor[c]));
+					value = _mm_mul_ps(_mm_min_ps(_mm_max_ps(value, zerof), one), scale);
+					packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(value), c * 8));
+				}
+
+				// blend the covered pixels into the frame buffer.
+				auto target = reinterpret_cast<__m128i*>(row + x * 4);
+				auto previous = _mm_loadu_si128(target);
+				_mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(inside, packed), _mm_andnot_si128(inside, previous)));
+			}
+#else
+			for (auto x = x0; x <= x1; x++) {
+				// evaluate the edge functions for a single pixel.
+				auto sign = 0;
+				for (auto i = 0; i < 3; i++) {
+					sign |= rowEdge[i] + edgeStepX[i] * (x - x0);
+				}
+				if (sign < 0) {
+					continue;
+				}
+
+				// interpolate the colors and store them as a RGBA8 pixel.
+				auto fx = static_cast<float>(x - triangle.minX);
+				for (auto c = 0; c < 4; c++) {
+					auto value = std::min(std::max(triangle.colorA[c] * fx + rowColor[c], 0.f), 1.f) * 255.f;
+					row[x * 4 + c] = static_cast<uint8_t>(std::nearbyint(value));
+				}
+			}
+#endif
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cpu_queue.h"
+#include "frame_pipeline.h"
+#include "render_backend.h"
+#include "worker_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+// the width and height of a screen tile in pixels.
+#define SOFTWARE_TILE_SIZE 64
+
+// ============================================================================
+// A headless renderer that rasterizes triangles on the CPU.
+//
+// Renderer draws the triangles into in-memory RGBA8 frame buffers with tiled
+// edge function rasterization. Output is identical with any thread count.
+// ============================================================================
+class SoftwareRenderer : public RenderBackend
+{
+public:
+	SoftwareRenderer(unsigned threadCount, unsigned frameLatency);
+	void SetWindow(unsigned width, unsigned height) override;
+	void SetGeometry(const std::vector<Vertex>& vertices) override;
+	void Render() override;
+	void WaitForGPU() override;
+	const FramePipeline& Pipeline() const override { return mFramePipeline; }
+	const std::vector<uint8_t>& Framebuffer() const;
+	unsigned Width() const { return mWidth; }
+	unsigned Height() const { return mHeight; }
+	unsigned Pitch() const { return mPitch; }
+private:
+	struct Triangle
+	{
+		int32_t		minX, minY, maxX, maxY;
+		int64_t		edgeA[3];
+		int64_t		edgeB[3];
+		int64_t		edgeC[3];
+		float		colorA[4];
+		float		colorB[4];
+		float		colorC[4];
+	};
+	struct Frame
+	{
+		std::vector<Triangle>				triangles;
+		std::vector<std::vector<uint32_t>>	bins;
+		std::vector<uint8_t>				pixels;
+	};
+	bool SetupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, Triangle& triangle) const;
+	void BinTriangles(Frame& frame) const;
+	void RasterizeTile(Frame& frame, unsigned tile) const;
+private:
+	std::vector<Vertex>		mVertices;
+	std::vector<Frame>		mFrames;
+	unsigned				mWidth;
+	unsigned				mHeight;
+	unsigned				mPitch;
+	unsigned				mTilesX;
+	unsigned				mTilesY;
+	unsigned				mLastFrameIndex;
+	WorkerPool				mWorkerPool;
+	CpuQueue				mQueue;
+	FramePipeline			mFramePipeline;
+};
@@ -0,0 +1,172 @@
+#include "asset_streamer.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+#include <vector>
+
+// ============================================================================
+// An asset which takes the size of its file as the upload size.
+// ============================================================================
+class SizedAsset : public Asset
+{
+public:
+	explicit SizedAsset(uint64_t size) : mSize(size) {}
+	uint64_t UploadSize() const override { return mSize; }
+private:
+	uint64_t	mSize;
+};
+
+// a helper to decode file contents into an asset of the file size.
+std::unique_ptr<Asset> DecodeSized(std::unique_ptr<FileContents> contents)
+{
+	return std::unique_ptr<Asset>(new SizedAsset(contents->Size()));
+}
+
+// ============================================================================
+// Requests are read by priority and then in the order of the requests.
+// ============================================================================
+void TestPriorities()
+{
+	FakeFileSource source;
+	for (auto name : { "a", "b", "c", "d" }) {
+		source.Add(name, std::vector<uint8_t>(10));
+	}
+	AssetStreamer streamer(source, 0);
+	CancellationToken token;
+	streamer.Request("a", 0, token, DecodeSized);
+	streamer.Request("b", 5, token, DecodeSized);
+	streamer.Request("c", 5, token, DecodeSized);
+	streamer.Request("d", 1, token, DecodeSized);
+	CHECK(streamer.PendingRequestCount() == 4);
+	while (streamer.ProcessRequest()) {
+	}
+	CHECK(streamer.PendingRequestCount() == 0);
+	CHECK(source.OpenedPaths() == std::vector<std::string>({ "b", "c", "d", "a" }));
+
+	// the completions are handed out by priority as well.
+	std::vector<int> priorities;
+	streamer.Update(1000, [&](AssetCompletion& completion) { priorities.push_back(completion.priority); });
+	CHECK(priorities == std::vector<int>({ 5, 5, 1, 0 }));
+	CHECK(streamer.Statistics().loadedCount == 4 && streamer.Statistics().uploadedBytes == 40);
+}
+
+// ============================================================================
+// Loaded assets are handed out within the byte budget of each update.
+// ============================================================================
+void TestBudget()
+{
+	FakeFileSource source;
+	source.Add("large", std::vector<uint8_t>(300));
+	source.Add("medium", std::vector<uint8_t>(60));
+	source.Add("small", std::vector<uint8_t>(30));
+	AssetStreamer streamer(source, 0);
+	CancellationToken token;
+	auto large = streamer.Request("large", 3, token, DecodeSized);
+	auto medium = streamer.Request("medium", 2, token, DecodeSized);
+	auto small = streamer.Request("small", 1, token, DecodeSized);
+	streamer.Request("missing", 0, token, DecodeSized);
+	while (streamer.ProcessRequest()) {
+	}
+
+	// the first asset is handed out even when it is larger than the budget.
+	std::vector<uint64_t> ids;
+	auto collect = [&](AssetCompletion& completion) { ids.push_back(completion.id); };
+	CHECK(streamer.Update(100, collect) == 300);
+	CHECK(ids == std::vector<uint64_t>({ large }));
+	CHECK(streamer.ReadyCount() == 3 && streamer.Statistics().deferredCount == 3);
+	CHECK(streamer.Update(80, collect) == 60);
+	CHECK(streamer.Update(100, collect) == 30);
+	CHECK(ids == std::vector<uint64_t>({ large, medium, small, small + 1 }));
+	CHECK(streamer.ReadyCount() == 0);
+
+	// a failed request does not use any budget and reports its error.
+	auto& statistics = streamer.Statistics();
+	CHECK(statistics.loadedCount == 3 && statistics.failedCount == 1 && statistics.uploadedBytes == 390);
+}
+
+// ============================================================================
+// Cancelled and failed requests complete without an asset.
+// ============================================================================
+void TestCancellation()
+{
+	FakeFileSource source;
+	source.Add("before", std::vector<uint8_t>(10));
+	source.Add("after", std::vector<uint8_t>(20));
+	source.Add("broken", std::vector<uint8_t>(30));
+	AssetStreamer streamer(source, 0);
+	CancellationToken before, after, kept;
+	auto decodes = 0u;
+	auto decode = [&](std::unique_ptr<FileContents> contents) {
+		decodes++;
+		return DecodeSized(std::move(contents));
+	};
+	streamer.Request("before", 0, before, decode);
+	streamer.Request("after", 0, after, decode);
+	streamer.Request("broken", 0, kept, [](std::unique_ptr<FileContents>) -> std::unique_ptr<Asset> { throw std::runtime_error("corrupt"); });
+
+	// a request cancelled before it is started is never read.
+	before.Cancel();
+	while (streamer.ProcessRequest()) {
+	}
+	CHECK(source.OpenedPaths() == std::vector<std::string>({ "after", "broken" }));
+	CHECK(decodes == 1);
+
+	// a loaded asset cancelled before it is handed out is dropped.
+	after.Cancel();
+	std::vector<AssetStatus> statuses;
+	std::string error;
+	auto bytes = streamer.Update(1000, [&](AssetCompletion& completion) {
+		statuses.push_back(completion.status);
+		if (completion.status != AssetStatus::Loaded) {
+			CHECK(completion.asset == nullptr);
+		}
+		if (completion.status == AssetStatus::Failed) {
+			error = completion.error;
+		}
+	});
+	CHECK(bytes == 0);
+	CHECK(statuses == std::vector<AssetStatus>({ AssetStatus::Cancelled, AssetStatus::Cancelled, AssetStatus::Failed }));
+	CHECK(error == "corrupt");
+	CHECK(streamer.Statistics().cancelledCount == 2 && streamer.Statistics().failedCount == 1);
+}
+
+// ============================================================================
+// The background threads load every request exactly once.
+// ============================================================================
+void TestThreads()
+{
+	FakeFileSource source(std::chrono::microseconds(50));
+	const auto count = 200u;
+	for (auto i = 0u; i < count; i++) {
+		source.Add(std::to_string(i), std::vector<uint8_t>(i + 1));
+	}
+	AssetStreamer streamer(source, 4);
+	CancellationToken token;
+	for (auto i = 0u; i < count; i++) {
+		streamer.Request(std::to_string(i), static_cast<int>(i % 7), token, DecodeSized);
+	}
+	std::vector<unsigned> completions(count + 1);
+	auto completed = 0u;
+	while (completed < count) {
+		streamer.Update(2000, [&](AssetCompletion& completion) {
+			completions[completion.id]++;
+			completed++;
+		});
+	}
+	auto once = 0u;
+	for (auto i = 1u; i <= count; i++) {
+		once += completions[i] == 1;
+	}
+	CHECK(once == count);
+	CHECK(streamer.Statistics().loadedCount == count);
+	CHECK(streamer.Statistics().uploadedBytes == count * (count + 1) / 2);
+}
+
+int main()
+{
+	TestPriorities();
+	TestBudget();
+	TestCancellation();
+	TestThreads();
+	return TestResult("asset_streamer_test");
+}
@@ -0,0 +1,200 @@
+#include "capture_replay.h"
+#include "instance_batcher.h"
+#include "null_renderer.h"
+#include "software_renderer.h"
+#include "test_utils.h"
+#include "vertex.h"
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// the amount of frames in the test capture.
+const unsigned CaptureFrameCount = 3;
+
+// the pipeline state the renderer draws the scene with.
+const PipelineStateDesc ScenePipeline = { 1, 1, FillMode::Solid, CullMode::Back, BlendMode::Opaque, RenderTargetFormat::RGBA8, PrimitiveTopology::Triangle };
+
+// ============================================================================
+// Get the triangle of the application packed into the format of the renderer.
+// ============================================================================
+std::vector<HalfVertex> PackedTriangle(float scale)
+{
+	auto vertices = TriangleVertices();
+	for (auto& vertex : vertices) {
+		vertex.position[0] *= scale;
+		vertex.position[1] *= scale;
+	}
+	std::vector<HalfVertex> packed(vertices.size());
+	PackVertices(vertices.data(), vertices.size(), packed.data());
+	return packed;
+}
+
+// ============================================================================
+// Record a capture in memory the way the renderer records its frames.
+//
+// The buffers are created and filled before the capture starts, so they end
+// up in the resident section, while the second frame uploads new vertices
+// into the frame section. Each frame rotates two instances of the triangle,
+// and the last frame has another render size.
+// ============================================================================
+std::vector<uint8_t> RecordCapture()
+{
+	CaptureWriter writer(64 << 10, 1 << 20);
+	auto triangle = PackedTriangle(1.f);
+	auto vertexBuffer = writer.CreateBuffer(CaptureBufferKind::Vertex, CaptureVertexFormat::Half, sizeof(HalfVertex), sizeof(HalfVertex) * triangle.size());
+	writer.UploadBuffer(vertexBuffer, 0, triangle.data(), sizeof(HalfVertex) * triangle.size());
+	uint16_t indices[] = { 0, 1, 2 };
+	auto indexBuffer = writer.CreateBuffer(CaptureBufferKind::Index, CaptureVertexFormat::Half, sizeof(uint16_t), sizeof(indices));
+	writer.UploadBuffer(indexBuffer, 0, indices, sizeof(indices));
+
+	writer.Start(CaptureFrameCount);
+	InstanceBatcher batcher;
+	for (auto frame = 0u; frame < CaptureFrameCount; frame++) {
+		if (frame == 1) {
+			auto smaller = PackedTriangle(0.75f);
+			writer.UploadBuffer(vertexBuffer, 0, smaller.data(), sizeof(HalfVertex) * smaller.size());
+		}
+		batcher.Reset();
+		batcher.Submit(0, 0, { { -0.4f, 0.f }, 0.8f, 0.3f * frame, 0xffffffffu });
+		batcher.Submit(0, 0, { { 0.4f, 0.2f }, 0.5f, -0.5f * frame, 0xff4080c0u });
+		batcher.Build();
+		const uint32_t* streams[INSTANCE_STREAM_COUNT];
+		for (auto i = 0u; i < INSTANCE_STREAM_COUNT; i++) {
+			streams[i] = batcher.Stream(static_cast<InstanceStream>(i));
+		}
+		float transform[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+		writer.BeginFrame((frame == 2) ? 96 : 160, (frame == 2) ? 64 : 120);
+		writer.SetTransform(transform);
+		writer.SetPipeline(ScenePipeline);
+		writer.SetInstances(streams, INSTANCE_STREAM_COUNT, static_cast<uint32_t>(batcher.InstanceCount()));
+		for (auto& batch : batcher.Batches()) {
+			writer.Draw({ vertexBuffer, indexBuffer, 3, batch.instanceCount, 0, 0, batch.firstInstance, 0 });
+		}
+		writer.EndFrame();
+	}
+	std::ostringstream output;
+	writer.Write(output);
+	auto bytes = output.str();
+	return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+// ============================================================================
+// Get the 64-bit FNV-1a hash of the frame buffer of the software renderer.
+// ============================================================================
+uint64_t FramebufferHash(const SoftwareRenderer& renderer)
+{
+	auto hash = 14695981039346656037ull;
+	for (auto byte : renderer.Framebuffer()) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// ============================================================================
+// Replay a capture on the software renderer with a frame buffer hash.
+// ============================================================================
+std::vector<CaptureFrameStats> ReplaySoftware(const std::vector<uint8_t>& capture, unsigned threadCount, unsigned frameLatency)
+{
+	SoftwareRenderer renderer(threadCount, frameLatency);
+	SteadyClock clock;
+	CaptureReplayer replayer(renderer, clock);
+	return replayer.Replay(capture.data(), capture.size(), [&renderer] { return FramebufferHash(renderer); });
+}
+
+// ============================================================================
+// The recorded capture reads back with its sections and commands.
+// ============================================================================
+void TestReadBack()
+{
+	auto capture = RecordCapture();
+	CaptureReader reader(capture.data(), capture.size());
+	CHECK(reader.Header().magic == CAPTURE_FILE_MAGIC && reader.Header().version == CAPTURE_FILE_VERSION);
+	CHECK(reader.Header().frameCount == CaptureFrameCount && reader.Header().flags == 0);
+	CHECK(sizeof(CaptureFileHeader) + reader.Header().residentSize + reader.Header().frameSize == capture.size());
+
+	unsigned counts[static_cast<unsigned>(CaptureCommand::EndFrame) + 1] = {};
+	CaptureRecord record;
+	while (reader.Next(record)) {
+		counts[static_cast<unsigned>(record.command)]++;
+	}
+	CHECK(counts[static_cast<unsigned>(CaptureCommand::CreateBuffer)] == 2);
+	CHECK(counts[static_cast<unsigned>(CaptureCommand::UploadBuffer)] == 3);
+	CHECK(counts[static_cast<unsigned>(CaptureCommand::BeginFrame)] == CaptureFrameCount);
+	CHECK(counts[static_cast<unsigned>(CaptureCommand::Draw)] == CaptureFrameCount);
+	CHECK(counts[static_cast<unsigned>(CaptureCommand::EndFrame)] == CaptureFrameCount);
+}
+
+// ============================================================================
+// Replays hash the same output regardless of the run, threads and backend.
+// ============================================================================
+void TestStableReplay()
+{
+	auto capture = RecordCapture();
+	auto reference = ReplaySoftware(capture, 1, 1);
+	CHECK(reference.size() == CaptureFrameCount);
+	if (reference.size() != CaptureFrameCount) {
+		return;
+	}
+	for (auto& frame : reference) {
+		CHECK(frame.drawCount == 1 && frame.triangleCount == 2);
+	}
+	CHECK(reference[0].outputHash != reference[1].outputHash && reference[1].outputHash != reference[2].outputHash);
+	CHECK(reference[0].geometryHash != reference[1].geometryHash);
+
+	// the same replayer replays the capture again, e.g. for the repeats of the replay tool.
+	SoftwareRenderer renderer(4, 2);
+	SteadyClock clock;
+	CaptureReplayer replayer(renderer, clock);
+	for (auto run = 0; run < 3; run++) {
+		auto frames = replayer.Replay(capture.data(), capture.size(), [&renderer] { return FramebufferHash(renderer); });
+		auto mismatched = (frames.size() != reference.size()) ? 1u : 0u;
+		for (size_t i = 0; i < std::min(frames.size(), reference.size()); i++) {
+			mismatched += (frames[i].outputHash != reference[i].outputHash || frames[i].geometryHash != reference[i].geometryHash) ? 1 : 0;
+		}
+		CHECK(mismatched == 0);
+	}
+
+	// more threads and a deeper pipeline render the same frames.
+	auto threaded = ReplaySoftware(capture, 8, 3);
+	auto mismatched = 0u;
+	for (size_t i = 0; i < std::min(threaded.size(), reference.size()); i++) {
+		mismatched += (threaded[i].outputHash != reference[i].outputHash) ? 1 : 0;
+	}
+	CHECK(threaded.size() == reference.size() && mismatched == 0);
+
+	// the geometry does not depend on the backend.
+	NullRenderer null(2, std::chrono::microseconds(0));
+	SteadyClock nullClock;
+	auto geometry = CaptureReplayer(null, nullClock).Replay(capture.data(), capture.size());
+	mismatched = 0;
+	for (size_t i = 0; i < std::min(geometry.size(), reference.size()); i++) {
+		mismatched += (geometry[i].geometryHash != reference[i].geometryHash || geometry[i].outputHash != 0) ? 1 : 0;
+	}
+	CHECK(geometry.size() == reference.size() && mismatched == 0);
+}
+
+// ============================================================================
+// Truncated and corrupted captures are rejected.
+// ============================================================================
+void TestCorruptCapture()
+{
+	auto capture = RecordCapture();
+	NullRenderer renderer(1, std::chrono::microseconds(0));
+	SteadyClock clock;
+	CaptureReplayer replayer(renderer, clock);
+	CHECK_THROWS(replayer.Replay(capture.data(), capture.size() - 8), std::runtime_error);
+	CHECK_THROWS(replayer.Replay(capture.data(), sizeof(CaptureFileHeader) - 1), std::runtime_error);
+	auto corrupt = capture;
+	reinterpret_cast<CaptureFileHeader*>(corrupt.data())->flags = CAPTURE_FLAG_MISSING_BUFFERS;
+	CHECK_THROWS(replayer.Replay(corrupt.data(), corrupt.size()), std::runtime_error);
+}
+
+int main()
+{
+	TestReadBack();
+	TestStableReplay();
+	TestCorruptCapture();
+	return TestResult("capture_replay_test");
+}
@@ -0,0 +1,183 @@
+#include "descriptor_allocator.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+#include <vector>
+
+// ============================================================================
+// Free ranges are reused first fit and merged with their neighbours.
+// ============================================================================
+void TestCpuAllocator()
+{
+	SimulatedDescriptorDevice device(32);
+	CHECK_THROWS(CpuDescriptorAllocator(device, DescriptorHeapType::Resource, 0), std::invalid_argument);
+	CpuDescriptorAllocator allocator(device, DescriptorHeapType::Resource, 16);
+	CHECK_THROWS(allocator.Allocate(0), std::length_error);
+	CHECK_THROWS(allocator.Allocate(17), std::length_error);
+	auto a = allocator.Allocate(4);
+	auto b = allocator.Allocate(4);
+	auto c = allocator.Allocate(8);
+	CHECK(a.index == 0 && b.index == 4 && c.index == 8);
+	CHECK(b.cpuHandle == a.CpuHandle(4) && a.gpuHandle == 0);
+	CHECK(allocator.HeapCount() == 1 && allocator.AllocatedCount() == 16);
+
+	// a full heap creates another heap.
+	auto d = allocator.Allocate(1);
+	CHECK(d.heap == 1 && d.index == 0 && allocator.HeapCount() == 2 && device.HeapCount() == 2);
+
+	// freeing both neighbours of a range merges the three into one.
+	allocator.Free(a);
+	allocator.Free(c);
+	CHECK_THROWS(allocator.Free(a), std::invalid_argument);
+	allocator.Free(b);
+	CHECK(allocator.AllocatedCount() == 1);
+	auto whole = allocator.Allocate(16);
+	CHECK(whole.heap == 0 && whole.index == 0);
+	CHECK(allocator.HeapCount() == 2);
+}
+
+// ============================================================================
+// Tables wrap to the start of the ring by waiting the oldest frame.
+// ============================================================================
+void TestRingWraparound()
+{
+	SimulatedDescriptorDevice device(32);
+	SimulatedTimeline timeline;
+	CHECK_THROWS(DescriptorRing(device, timeline, DescriptorHeapType::Resource, 0), std::invalid_argument);
+	CHECK_THROWS(DescriptorRing(device, timeline, DescriptorHeapType::RenderTarget, 16), std::invalid_argument);
+	CHECK(device.HeapCount() == 0);
+	DescriptorRing ring(device, timeline, DescriptorHeapType::Resource, 100);
+	auto first = ring.Allocate(30);
+	CHECK(first.index == 0 && first.gpuHandle == first.cpuHandle && first.increment == 32);
+	ring.EndFrame(timeline.Signal());
+	CHECK(ring.Allocate(60).index == 30);
+	ring.EndFrame(timeline.Signal());
+
+	// the table does not fit the end, so the skipped end is spent and the first frame waited.
+	auto wrapped = ring.Allocate(20);
+	CHECK(wrapped.index == 0 && wrapped.cpuHandle == first.cpuHandle);
+	CHECK(ring.WaitCount() == 1 && timeline.StallCount() == 1);
+	CHECK(ring.UsedCount() == 60 + 10 + 20);
+	ring.EndFrame(timeline.Signal());
+
+	// completed frames are reclaimed without waiting.
+	timeline.Advance(2);
+	ring.Reclaim();
+	CHECK(ring.UsedCount() == 0);
+	CHECK(ring.WaitCount() == 1);
+
+	// a single frame needing more than the ring can never be satisfied.
+	CHECK_THROWS(ring.Allocate(101), std::length_error);
+	ring.Allocate(80);
+	CHECK_THROWS(ring.Allocate(80), std::length_error);
+}
+
+// ============================================================================
+// An empty ring uses its whole capacity wherever the previous frame ended.
+// ============================================================================
+void TestEmptyRingRestarts()
+{
+	SimulatedDescriptorDevice device(32);
+	SimulatedTimeline timeline;
+	DescriptorRing ring(device, timeline, DescriptorHeapType::Resource, 100);
+	ring.Allocate(50);
+	ring.EndFrame(timeline.Signal());
+	timeline.Advance();
+	ring.Reclaim();
+	CHECK(ring.UsedCount() == 0);
+	CHECK(ring.Allocate(60).index == 0);
+	CHECK(ring.WaitCount() == 0);
+}
+
+// ============================================================================
+// A table never overlaps the tables of the frames still on the GPU.
+// ============================================================================
+void TestRingFenceReclaim()
+{
+	struct Live
+	{
+		uint32_t	index;
+		uint32_t	count;
+		uint64_t	fenceValue;
+	};
+	SimulatedDescriptorDevice device(8);
+	SimulatedTimeline timeline;
+	DescriptorRing ring(device, timeline, DescriptorHeapType::Sampler, 32);
+	std::vector<Live> live, frame;
+	auto overlaps = 0u;
+	for (auto i = 0u; i < 2000; i++) {
+		for (auto j = 0u; j < 1 + i % 3; j++) {
+			auto table = ring.Allocate(1 + (i * 7 + j * 5) % 9);
+			overlaps += (table.index + table.count > 32) ? 1 : 0;
+			for (auto& other : live) {
+				if (other.fenceValue > timeline.CompletedValue() && table.index < other.index + other.count && other.index < table.index + table.count) {
+					overlaps++;
+				}
+			}
+			for (auto& other : frame) {
+				if (table.index < other.index + other.count && other.index < table.index + table.count) {
+					overlaps++;
+				}
+			}
+			frame.push_back({ table.index, table.count, 0 });
+		}
+		auto fenceValue = timeline.Signal();
+		ring.EndFrame(fenceValue);
+		for (auto& table : frame) {
+			table.fenceValue = fenceValue;
+			live.push_back(table);
+		}
+		frame.clear();
+		if (timeline.PendingCount() > 2) {
+			timeline.Advance();
+		}
+		ring.Reclaim();
+		if (live.size() > 64) {
+			live.erase(live.begin(), live.begin() + 32);
+		}
+	}
+	CHECK(overlaps == 0);
+	CHECK(ring.WaitCount() > 0);
+}
+
+// ============================================================================
+// Copies that continue each other are merged into a single device copy.
+// ============================================================================
+void TestCopyBatch()
+{
+	SimulatedDescriptorDevice device(4);
+	SimulatedTimeline timeline;
+	CpuDescriptorAllocator allocator(device, DescriptorHeapType::Resource, 16);
+	DescriptorRing ring(device, timeline, DescriptorHeapType::Resource, 16);
+	auto views = allocator.Allocate(4);
+	for (auto i = 0u; i < 16; i++) {
+		reinterpret_cast<uint8_t*>(views.cpuHandle)[i] = static_cast<uint8_t>(i + 1);
+	}
+	DescriptorCopyBatch batch(device, DescriptorHeapType::Resource);
+	auto table = ring.Allocate(4);
+	for (auto i = 0u; i < 4; i++) {
+		DescriptorRange view = { views.CpuHandle(i), 0, views.increment, 1, 0, i };
+		batch.Copy(table, i, view);
+	}
+	CHECK_THROWS(batch.Copy(table, 4, views), std::invalid_argument);
+	CHECK(batch.PendingCount() == 4);
+	batch.Flush();
+	CHECK(device.CopyCallCount() == 1 && device.CopiedDescriptorCount() == 4);
+	auto copied = true;
+	for (auto i = 0u; i < 16; i++) {
+		copied &= reinterpret_cast<const uint8_t*>(table.cpuHandle)[i] == i + 1;
+	}
+	CHECK(copied);
+	batch.Flush();
+	CHECK(device.CopyCallCount() == 1);
+}
+
+int main()
+{
+	TestCpuAllocator();
+	TestRingWraparound();
+	TestEmptyRingRestarts();
+	TestRingFenceReclaim();
+	TestCopyBatch();
+	return TestResult("descriptor_allocator_test");
+}
@@ -0,0 +1,200 @@
+#include "frame_pacer.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+// the refresh period of a 60 Hz display in nanoseconds.
+const uint64_t Refresh = 16666667;
+
+// the amount of nanoseconds in a millisecond.
+const uint64_t Millisecond = 1000000;
+
+// ============================================================================
+// A simulated presentation of the frames onto a display.
+//
+// Frames with vertical sync are shown in order, one per vertical blank, and
+// tearing frames as soon as their work is done. A frame waits while the
+// maximum latency of frames are not yet shown, as the blocking present or
+// the latency waitable object does.
+// ============================================================================
+class Presentation
+{
+public:
+	Presentation(SimulatedClock& clock, DisplayClock& display, FramePacer& pacer) : mClock(clock), mDisplay(display), mPacer(pacer), mLastShown(0), mRepeatedVblanks(0) {}
+	uint64_t RunFrame(uint64_t work);
+	uint64_t LastShown() const { return mLastShown; }
+	unsigned RepeatedVblanks() const { return mRepeatedVblanks; }
+private:
+	SimulatedClock&			mClock;
+	DisplayClock&			mDisplay;
+	FramePacer&				mPacer;
+	std::deque<uint64_t>	mQueued;
+	uint64_t				mLastShown;
+	unsigned				mRepeatedVblanks;
+};
+
+// ============================================================================
+// Run a frame of the given work and get the time from its start to its display.
+// ============================================================================
+uint64_t Presentation::RunFrame(uint64_t work)
+{
+	auto maxLatency = mPacer.Desc().maxLatency;
+	while (!mQueued.empty() && mQueued.front() <= mClock.Now()) {
+		mQueued.pop_front();
+	}
+	if (mQueued.size() >= maxLatency) {
+		mClock.SleepUntil(mQueued[mQueued.size() - maxLatency]);
+	}
+	auto start = mPacer.BeginFrame();
+	mClock.SleepUntil(start + work);
+	auto end = mClock.Now();
+	auto shown = end;
+	if (mPacer.Desc().mode != PresentMode::Tearing) {
+		auto vblank = mDisplay.LastVblank(end);
+		shown = std::max((vblank == end) ? vblank : vblank + mDisplay.RefreshNanoseconds(), mLastShown + mDisplay.RefreshNanoseconds());
+		if (mLastShown != 0) {
+			mRepeatedVblanks += static_cast<unsigned>((shown - mLastShown) / mDisplay.RefreshNanoseconds() - 1);
+		}
+	}
+	mQueued.push_back(shown);
+	mLastShown = shown;
+	mPacer.EndFrame(end - start);
+	return shown - start;
+}
+
+// ============================================================================
+// The vertical blanks of a display follow its phase, also before the phase.
+// ============================================================================
+void TestDisplayClock()
+{
+	SimulatedDisplayClock display(100, 250);
+	CHECK(display.RefreshNanoseconds() == 100);
+	CHECK(display.LastVblank(250) == 250);
+	CHECK(display.LastVblank(349) == 250);
+	CHECK(display.LastVblank(350) == 350);
+	CHECK(display.LastVblank(249) == 150);
+	CHECK(display.LastVblank(150) == 150);
+	CHECK(display.LastVblank(60) == 50);
+}
+
+// ============================================================================
+// Tearing frames start right away and are shown when their work is done.
+// ============================================================================
+void TestTearing()
+{
+	SimulatedClock clock(1000);
+	SimulatedDisplayClock display(Refresh, 0);
+	CHECK_THROWS(FramePacer(clock, display, { PresentMode::Tearing, 0, 0, 4 }), std::invalid_argument);
+	CHECK_THROWS(FramePacer(clock, display, { PresentMode::Tearing, 1, 0, 0 }), std::invalid_argument);
+	FramePacer pacer(clock, display, { PresentMode::Tearing, 1, 0, 4 });
+	Presentation presentation(clock, display, pacer);
+	CHECK(pacer.SyncInterval() == 0);
+	for (auto i = 0; i < 10; i++) {
+		auto now = clock.Now();
+		CHECK(presentation.RunFrame(30 * Millisecond) == 30 * Millisecond);
+		CHECK(pacer.FrameStart() == now && pacer.TargetVblank() == 0);
+	}
+	CHECK(pacer.MissedFrameCount() == 0 && pacer.FrameCount() == 10);
+}
+
+// ============================================================================
+// Latency waitable frames start just in time for the next vertical blank.
+// ============================================================================
+void TestLatencyWaitable()
+{
+	SimulatedClock clock(5 * Millisecond);
+	SimulatedDisplayClock display(Refresh, 0);
+	const uint64_t margin = Millisecond, work = 4 * Millisecond;
+	FramePacer pacer(clock, display, { PresentMode::LatencyWaitable, 1, margin, 8 });
+	Presentation presentation(clock, display, pacer);
+	CHECK(pacer.SyncInterval() == 1);
+
+	// the first frame has no work to predict, so it starts right away and targets the next vertical blank.
+	CHECK(presentation.RunFrame(work) == Refresh - 5 * Millisecond);
+	CHECK(pacer.FrameStart() == 5 * Millisecond && pacer.TargetVblank() == Refresh);
+	auto justInTime = 0u;
+	for (auto i = 0; i < 100; i++) {
+		auto latency = presentation.RunFrame(work);
+		justInTime += latency == work + margin && pacer.TargetVblank() == presentation.LastShown();
+	}
+	CHECK(justInTime == 100);
+	CHECK(presentation.RepeatedVblanks() == 0);
+	CHECK(pacer.MissedFrameCount() == 0);
+	CHECK(pacer.PredictedWork() == work);
+}
+
+// ============================================================================
+// Vsync frames start right away and queue up to the maximum latency.
+// ============================================================================
+void TestVsyncLatency()
+{
+	SimulatedClock clock;
+	SimulatedDisplayClock display(Refresh, 0);
+	FramePacer pacer(clock, display, { PresentMode::Vsync, 3, 0, 4 });
+	Presentation presentation(clock, display, pacer);
+	uint64_t latency = 0;
+	auto onTarget = 0u;
+	for (auto i = 0; i < 50; i++) {
+		latency = presentation.RunFrame(Millisecond);
+		onTarget += pacer.TargetVblank() == presentation.LastShown();
+	}
+
+	// the queue is full, so every frame waits for the display and is shown three refreshes later.
+	CHECK(latency > 2 * Refresh && latency <= 3 * Refresh);
+	CHECK(onTarget == 50);
+	CHECK(presentation.RepeatedVblanks() == 0);
+	CHECK(pacer.MissedFrameCount() == 0);
+}
+
+// ============================================================================
+// A frame that misses its vertical blank pushes the next frames after it.
+//
+// The long work is predicted for the frames of the history window, after
+// which the frames start just in time again.
+// ============================================================================
+void TestMissedFrame()
+{
+	SimulatedClock clock;
+	SimulatedDisplayClock display(Refresh, 0);
+	const uint64_t margin = Millisecond, work = 4 * Millisecond;
+	FramePacer pacer(clock, display, { PresentMode::LatencyWaitable, 2, margin, 4 });
+	Presentation presentation(clock, display, pacer);
+	for (auto i = 0; i < 10; i++) {
+		presentation.RunFrame(work);
+	}
+	CHECK(pacer.MissedFrameCount() == 0);
+
+	// the display shows the previous frame once more and the late frame at the next vertical blank.
+	presentation.RunFrame(20 * Millisecond);
+	CHECK(pacer.MissedFrameCount() == 1);
+	CHECK(presentation.RepeatedVblanks() == 1);
+	CHECK(pacer.TargetVblank() == presentation.LastShown());
+
+	// the next frame targets after the late frame, and the longer predicted work starts it early.
+	auto lateShown = presentation.LastShown();
+	presentation.RunFrame(work);
+	CHECK(pacer.PredictedWork() == 20 * Millisecond);
+	CHECK(pacer.TargetVblank() > lateShown);
+	CHECK(presentation.LastShown() == lateShown + Refresh);
+
+	// the spike leaves the history window and the frames start just in time again.
+	for (auto i = 0; i < 3; i++) {
+		presentation.RunFrame(work);
+	}
+	CHECK(pacer.PredictedWork() == work);
+	CHECK(presentation.RunFrame(work) == work + margin);
+	CHECK(pacer.MissedFrameCount() == 1);
+	CHECK(presentation.RepeatedVblanks() == 1);
+}
+
+int main()
+{
+	TestDisplayClock();
+	TestTearing();
+	TestLatencyWaitable();
+	TestVsyncLatency();
+	TestMissedFrame();
+	return TestResult("frame_pacer_test");
+}
@@ -0,0 +1,80 @@
+#include "frame_pipeline.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+
+// ============================================================================
+// The CPU runs ahead of the GPU by the frame latency without any stalls.
+// ============================================================================
+void TestFramesOverlap()
+{
+	SimulatedTimeline timeline;
+	FramePipeline pipeline(timeline, 3);
+	for (auto frame = 0u; frame < 3; frame++) {
+		CHECK(pipeline.BeginFrame() == frame);
+		CHECK(pipeline.EndFrame() == frame + 1);
+	}
+	CHECK(timeline.StallCount() == 0);
+	CHECK(timeline.PendingCount() == 3);
+	CHECK(timeline.CompletedValue() == 0);
+}
+
+// ============================================================================
+// A slot is reused only after the GPU has completed the frame that used it.
+// ============================================================================
+void TestAllocatorReuse()
+{
+	SimulatedTimeline timeline;
+	FramePipeline pipeline(timeline, 2);
+	pipeline.BeginFrame();
+	pipeline.EndFrame();
+	pipeline.BeginFrame();
+	pipeline.EndFrame();
+
+	// the first slot is reused while both frames are in flight.
+	CHECK(pipeline.BeginFrame() == 0);
+	CHECK(timeline.StallCount() == 1);
+	CHECK(timeline.CompletedValue() >= pipeline.FrameFence(0));
+	CHECK(timeline.CompletedValue() < pipeline.FrameFence(1));
+	pipeline.EndFrame();
+
+	// the GPU has caught up, so the second slot is reused without a stall.
+	timeline.Advance(2);
+	CHECK(pipeline.BeginFrame() == 1);
+	CHECK(timeline.StallCount() == 1);
+	pipeline.EndFrame();
+
+	// a steady GPU completing a frame per frame never stalls the CPU.
+	for (auto frame = 0u; frame < 100; frame++) {
+		auto slot = pipeline.BeginFrame();
+		CHECK(timeline.CompletedValue() >= pipeline.FrameFence(slot));
+		pipeline.EndFrame();
+		timeline.Advance();
+	}
+	CHECK(timeline.StallCount() == 1);
+}
+
+// ============================================================================
+// Flush completes all the frames and frames must be begun and ended in pairs.
+// ============================================================================
+void TestFlushAndMisuse()
+{
+	SimulatedTimeline timeline;
+	CHECK_THROWS(FramePipeline(timeline, 0), std::invalid_argument);
+	FramePipeline pipeline(timeline, 2);
+	CHECK_THROWS(pipeline.EndFrame(), std::logic_error);
+	pipeline.BeginFrame();
+	CHECK_THROWS(pipeline.BeginFrame(), std::logic_error);
+	pipeline.EndFrame();
+	pipeline.Flush();
+	CHECK(timeline.PendingCount() == 0);
+	CHECK(timeline.CompletedValue() == timeline.SignaledValue());
+}
+
+int main()
+{
+	TestFramesOverlap();
+	TestAllocatorReuse();
+	TestFlushAndMisuse();
+	return TestResult("frame_pipeline_test");
+}
@@ -0,0 +1,97 @@
+#include "frame_profiler.h"
+#include "test_utils.h"
+
+#include <thread>
+
+// ============================================================================
+// Count the occurrences of a text within a string.
+// ============================================================================
+unsigned CountOf(const std::string& text, const std::string& pattern)
+{
+	unsigned count = 0;
+	for (auto position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+		count++;
+	}
+	return count;
+}
+
+// ============================================================================
+// The ring keeps the latest events in order and drops the overwritten ones.
+// ============================================================================
+void TestRingOverwrite()
+{
+	ProfileRing ring(1, "Test");
+	std::vector<ProfileEvent> events;
+	ring.Snapshot(events);
+	CHECK(events.empty());
+
+	for (auto i = 0u; i < 10; i++) {
+		ring.Push("event", i, i + 1, i);
+	}
+	ring.Snapshot(events);
+	CHECK(events.size() == 10);
+	CHECK(events.front().begin == 0 && events.back().begin == 9);
+
+	events.clear();
+	auto total = PROFILE_RING_CAPACITY + 100u;
+	for (auto i = 10u; i < total; i++) {
+		ring.Push("event", i, i + 1, i);
+	}
+	ring.Snapshot(events);
+
+	// the oldest event of a full ring is dropped as the owner may be writing it.
+	CHECK(events.size() == PROFILE_RING_CAPACITY - 1);
+	CHECK(events.front().begin == total - PROFILE_RING_CAPACITY + 1);
+	CHECK(events.back().begin == total - 1);
+	auto ordered = true;
+	for (size_t i = 1; i < events.size(); i++) {
+		ordered &= (events[i].begin == events[i - 1].begin + 1);
+	}
+	CHECK(ordered);
+}
+
+// ============================================================================
+// The export contains the scopes of the requested frames of every thread.
+// ============================================================================
+void TestChromeTraceExport()
+{
+	auto& profiler = FrameProfiler::Instance();
+	profiler.SetThreadName("Main");
+	for (auto frame = 0u; frame < 5; frame++) {
+		profiler.BeginFrame();
+		PROFILE_SCOPE("Frame");
+	}
+	std::thread worker([&] {
+		profiler.SetThreadName("Worker");
+		PROFILE_SCOPE("Work");
+	});
+	worker.join();
+	profiler.RecordGpu("Gpu", 1000, 3000, profiler.Frame());
+
+	// scopes are not recorded while the profiler is disabled.
+	profiler.SetEnabled(false);
+	{
+		PROFILE_SCOPE("Disabled");
+	}
+	profiler.SetEnabled(true);
+
+	auto json = profiler.ExportChromeTrace(2);
+	CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+	CHECK(CountOf(json, "\"name\":\"Frame\"") == 2);
+	CHECK(CountOf(json, "\"name\":\"Work\"") == 1);
+	CHECK(CountOf(json, "\"name\":\"Disabled\"") == 0);
+	CHECK(CountOf(json, "{\"name\":\"Main\"}") == 1);
+	CHECK(CountOf(json, "{\"name\":\"Worker\"}") == 1);
+	CHECK(CountOf(json, "\"cat\":\"gpu\",\"name\":\"Gpu\",\"ts\":1.000,\"dur\":2.000") == 1);
+
+	// all the recorded frames are exported when more frames are requested.
+	json = profiler.ExportChromeTrace(100);
+	CHECK(CountOf(json, "\"name\":\"Frame\"") == 5);
+}
+
+int main()
+{
+	TestRingOverwrite();
+	TestChromeTraceExport();
+	return TestResult("frame_profiler_test");
+}
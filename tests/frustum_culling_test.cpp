@@ -0,0 +1,182 @@
+#include "bounding_volume_hierarchy.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+// ============================================================================
+// Build a perspective view projection looking along the z axis rotated by yaw.
+// ============================================================================
+std::array<float, 16> ViewProjection(float yaw)
+{
+	const float nearZ = 0.1f, farZ = 400.f;
+	auto c = std::cos(yaw), s = std::sin(yaw), depth = farZ / (farZ - nearZ);
+	return { {
+		c, 0.f, -s, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		s * depth, 0.f, c * depth, -nearZ * depth,
+		s, 0.f, c, 0.f
+	} };
+}
+
+// ============================================================================
+// Generate random object boxes scattered around the camera.
+// ============================================================================
+std::vector<Aabb> GenerateObjects(unsigned count, std::mt19937& random)
+{
+	std::vector<Aabb> objects(count);
+	std::uniform_real_distribution<float> position(-500.f, 500.f), extent(0.5f, 20.f);
+	for (auto& object : objects) {
+		for (auto axis = 0; axis < 3; axis++) {
+			auto center = position(random), halfSize = extent(random);
+			object.minimum[axis] = center - halfSize;
+			object.maximum[axis] = center + halfSize;
+		}
+	}
+	return objects;
+}
+
+// a helper to get the sorted identifiers of the boxes visible with the scalar reference.
+std::vector<uint32_t> ReferenceCull(const std::vector<Aabb>& objects, const Frustum& frustum)
+{
+	SoaBounds bounds;
+	bounds.Resize(objects.size());
+	for (size_t i = 0; i < objects.size(); i++) {
+		bounds.Set(i, objects[i]);
+	}
+	std::vector<uint32_t> visible(objects.size());
+	visible.resize(CullBoundsScalar(bounds, 0, objects.size(), frustum, FRUSTUM_ALL_PLANES, nullptr, visible.data()));
+	return visible;
+}
+
+// ============================================================================
+// The planes of a frustum face into the volume seen by the camera.
+// ============================================================================
+void TestFrustumPlanes()
+{
+	auto frustum = Frustum::FromMatrix(ViewProjection(0.f));
+	auto outsidePlanes = [&](float x, float y, float z) {
+		auto mask = 0u;
+		for (auto p = 0; p < 6; p++) {
+			auto& plane = frustum.planes[p];
+			auto length = std::sqrt(plane.normal[0] * plane.normal[0] + plane.normal[1] * plane.normal[1] + plane.normal[2] * plane.normal[2]);
+			CHECK(std::fabs(length - 1.f) < 1e-5f);
+			mask |= (plane.normal[0] * x + plane.normal[1] * y + plane.normal[2] * z + plane.distance < 0.f) ? 1u << p : 0u;
+		}
+		return mask;
+	};
+	CHECK(outsidePlanes(0.f, 0.f, 10.f) == 0);
+	CHECK(outsidePlanes(9.f, -9.f, 10.f) == 0);
+	CHECK(outsidePlanes(-11.f, 0.f, 10.f) == 1u << 0);
+	CHECK(outsidePlanes(11.f, 0.f, 10.f) == 1u << 1);
+	CHECK(outsidePlanes(0.f, -11.f, 10.f) == 1u << 2);
+	CHECK(outsidePlanes(0.f, 11.f, 10.f) == 1u << 3);
+	CHECK(outsidePlanes(0.f, 0.f, 0.05f) == 1u << 4);
+	CHECK(outsidePlanes(0.f, 0.f, 401.f) == 1u << 5);
+}
+
+// ============================================================================
+// The vector kernel gives exactly the results of the scalar reference.
+//
+// Ranges start and end at every offset within a vector, so the scalar tails
+// and the unaligned loads are covered, with and without identifiers.
+// ============================================================================
+void TestKernelMatchesScalar()
+{
+	std::mt19937 random(20);
+	auto objects = GenerateObjects(1000, random);
+	SoaBounds bounds;
+	bounds.Resize(objects.size());
+	std::vector<uint32_t> ids(objects.size());
+	for (size_t i = 0; i < objects.size(); i++) {
+		bounds.Set(i, objects[i]);
+		ids[i] = static_cast<uint32_t>(i * 7 + 3);
+	}
+	std::vector<uint32_t> visible(objects.size()), reference(objects.size());
+	auto mismatches = 0u, visibleTotal = 0u;
+	for (auto yaw = 0.f; yaw < 6.28f; yaw += 0.5f) {
+		auto frustum = Frustum::FromMatrix(ViewProjection(yaw));
+		for (auto begin = 0u; begin < 9; begin++) {
+			for (auto end = objects.size() - 9; end <= objects.size(); end++) {
+				for (auto planeMask : { FRUSTUM_ALL_PLANES, 0x15u, 0u }) {
+					auto idList = (begin % 2 == 0) ? ids.data() : nullptr;
+					auto count = CullBounds(bounds, begin, end, frustum, planeMask, idList, visible.data());
+					auto referenceCount = CullBoundsScalar(bounds, begin, end, frustum, planeMask, idList, reference.data());
+					mismatches += count != referenceCount || !std::equal(visible.begin(), visible.begin() + count, reference.begin());
+					visibleTotal += static_cast<unsigned>(count);
+				}
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(visibleTotal > 0);
+	CHECK(CullBounds(bounds, 5, 5, Frustum::FromMatrix(ViewProjection(0.f)), FRUSTUM_ALL_PLANES, nullptr, visible.data()) == 0);
+}
+
+// ============================================================================
+// The hierarchy finds the same objects as testing every object on its own.
+// ============================================================================
+void TestHierarchyMatchesReference()
+{
+	std::mt19937 random(21);
+	auto objects = GenerateObjects(5000, random);
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(objects);
+	CHECK(hierarchy.ObjectCount() == objects.size());
+	CHECK(hierarchy.NodeCount() > objects.size() / BVH_LEAF_SIZE);
+	CHECK_THROWS(hierarchy.Update(static_cast<uint32_t>(objects.size()), objects[0]), std::out_of_range);
+
+	std::uniform_real_distribution<float> offset(-30.f, 30.f);
+	std::vector<uint32_t> visible;
+	auto mismatches = 0u;
+	for (auto frame = 0; frame < 20; frame++) {
+		auto frustum = Frustum::FromMatrix(ViewProjection(frame * 0.4f));
+		visible.clear();
+		hierarchy.Cull(frustum, visible);
+		std::sort(visible.begin(), visible.end());
+		mismatches += visible != ReferenceCull(objects, frustum);
+
+		// move some of the objects, or most of them every few frames, and refit the hierarchy.
+		auto movingCount = (frame % 5 == 4) ? objects.size() : objects.size() / 20;
+		for (auto i = 0u; i < movingCount; i++) {
+			auto id = static_cast<uint32_t>(random() % objects.size());
+			for (auto axis = 0; axis < 3; axis++) {
+				auto move = offset(random);
+				objects[id].minimum[axis] += move;
+				objects[id].maximum[axis] += move;
+			}
+			hierarchy.Update(id, objects[id]);
+		}
+		hierarchy.Refit();
+	}
+	CHECK(mismatches == 0);
+
+	// the root encloses every object after the refits.
+	auto root = hierarchy.NodeBounds(0);
+	auto enclosed = 0u;
+	for (auto id = 0u; id < objects.size(); id++) {
+		auto bounds = hierarchy.Bounds(id);
+		auto inside = true;
+		for (auto axis = 0; axis < 3; axis++) {
+			inside &= root.minimum[axis] <= bounds.minimum[axis] && bounds.maximum[axis] <= root.maximum[axis];
+		}
+		enclosed += inside;
+	}
+	CHECK(enclosed == objects.size());
+
+	// an empty hierarchy has nothing to cull.
+	hierarchy.Build({});
+	visible.clear();
+	hierarchy.Cull(Frustum::FromMatrix(ViewProjection(0.f)), visible);
+	CHECK(visible.empty() && hierarchy.ObjectCount() == 0);
+}
+
+int main()
+{
+	TestFrustumPlanes();
+	TestKernelMatchesScalar();
+	TestHierarchyMatchesReference();
+	return TestResult("frustum_culling_test");
+}
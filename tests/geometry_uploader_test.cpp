@@ -0,0 +1,97 @@
+#include "geometry_uploader.h"
+#include "test_utils.h"
+
+#include <random>
+#include <stdexcept>
+
+// ============================================================================
+// Small uploads share a batch and large uploads are split by the batch size.
+// ============================================================================
+void TestBatching()
+{
+	SimulatedCopyQueue queue(4096);
+	CHECK_THROWS(GeometryUploader(queue, 0), std::invalid_argument);
+	CHECK_THROWS(GeometryUploader(queue, 2048), std::invalid_argument);
+	GeometryUploader uploader(queue, 1024);
+	std::vector<uint8_t> destination(4000), data(3000, 7);
+	uploader.Upload(destination.data(), 0, data.data(), 100);
+	uploader.Upload(destination.data(), 100, data.data(), 200);
+	CHECK(queue.Batches().empty());
+	auto fence = uploader.Flush();
+	CHECK(queue.Batches().size() == 1 && queue.Batches()[0].size() == 2);
+	CHECK(fence == uploader.LastFence() && fence == queue.Simulation().SignaledValue());
+	CHECK(uploader.Flush() == fence);
+	CHECK(uploader.BatchCount() == 1);
+
+	// a large upload is submitted in batches of at most the batch size.
+	uploader.Upload(destination.data(), 1000, data.data(), 3000);
+	uploader.Flush();
+	CHECK(queue.Batches().size() == 4);
+	for (auto& batch : queue.Batches()) {
+		uint64_t size = 0;
+		for (auto& copy : batch) {
+			size += copy.size;
+		}
+		CHECK(size <= 1024);
+	}
+	CHECK(destination[3999] == 7);
+}
+
+// ============================================================================
+// Random uploads end up in the destination in the order they were made.
+// ============================================================================
+void TestOrdering()
+{
+	SimulatedCopyQueue queue(4096);
+	GeometryUploader uploader(queue, 1024);
+	std::vector<uint8_t> destination(100000), expected(100000);
+	std::mt19937 random(1);
+	for (auto i = 0u; i < 2000; i++) {
+		uint64_t size = random() % 3000 + 1, offset = random() % (destination.size() - size);
+		std::vector<uint8_t> data(static_cast<size_t>(size));
+		for (auto& byte : data) {
+			byte = static_cast<uint8_t>(random());
+		}
+		uploader.Upload(destination.data(), offset, data.data(), size);
+		std::copy(data.begin(), data.end(), expected.begin() + offset);
+		if (random() % 4 == 0) {
+			uploader.Flush();
+		}
+		if (random() % 3 == 0) {
+			queue.Simulation().Advance();
+		}
+	}
+	uploader.Flush();
+	CHECK(destination == expected);
+}
+
+// ============================================================================
+// The staging memory is reused without waiting once the batches complete.
+// ============================================================================
+void TestStagingReuse()
+{
+	SimulatedCopyQueue queue(4096);
+	GeometryUploader uploader(queue, 1024);
+	std::vector<uint8_t> destination(1024), data(1024);
+	for (auto i = 0u; i < 100; i++) {
+		uploader.Upload(destination.data(), 0, data.data(), 1024);
+		uploader.Flush();
+		queue.Simulation().Advance();
+	}
+	CHECK(queue.Simulation().StallCount() == 0);
+
+	// batches the copy queue has not completed are waited once the staging buffer is full.
+	for (auto i = 0u; i < 8; i++) {
+		uploader.Upload(destination.data(), 0, data.data(), 1024);
+		uploader.Flush();
+	}
+	CHECK(queue.Simulation().StallCount() > 0);
+}
+
+int main()
+{
+	TestBatching();
+	TestOrdering();
+	TestStagingReuse();
+	return TestResult("geometry_uploader_test");
+}
@@ -0,0 +1,203 @@
+#include "gpu_memory_allocator.h"
+#include "test_utils.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+
+// ============================================================================
+// A heap factory that hands out fake heap handles and counts the live heaps.
+// ============================================================================
+class CountingHeapFactory : public GpuHeapFactory
+{
+public:
+	void* CreateHeap(HeapType, ResourceClass, uint64_t size) override
+	{
+		mLiveCount++;
+		mLastSize = size;
+		return reinterpret_cast<void*>(++mHeapCount);
+	}
+	void DestroyHeap(void*) override { mLiveCount--; }
+	unsigned LiveCount() const { return mLiveCount; }
+	uint64_t LastSize() const { return mLastSize; }
+private:
+	uintptr_t	mHeapCount = 0;
+	unsigned	mLiveCount = 0;
+	uint64_t	mLastSize = 0;
+};
+
+// ============================================================================
+// Random allocations never overlap and respect their alignment.
+// ============================================================================
+void TestTlsfOverlap()
+{
+	TlsfAllocator allocator(64ull << 20);
+	std::mt19937_64 random(5);
+	std::map<uint64_t, uint64_t> live;
+	auto overlaps = 0u, misaligned = 0u, miscounted = 0u;
+	for (auto i = 0u; i < 200000; i++) {
+		if (live.empty() || random() % 2 == 0) {
+			uint64_t size = 1 + random() % ((random() % 4 == 0) ? 4 << 20 : 64 << 10);
+			uint64_t alignment = 1ull << (random() % 23);
+			uint64_t offset = 0;
+			if (!allocator.Allocate(size, alignment, offset)) {
+				continue;
+			}
+			misaligned += (offset % std::max<uint64_t>(alignment, TLSF_MIN_BLOCK_SIZE) != 0 || offset + size > allocator.Size()) ? 1 : 0;
+			auto next = live.lower_bound(offset);
+			if (next != live.end() && offset + size > next->first) {
+				overlaps++;
+			}
+			if (next != live.begin() && std::prev(next)->first + std::prev(next)->second > offset) {
+				overlaps++;
+			}
+			live[offset] = size;
+		} else {
+			auto allocation = std::next(live.begin(), random() % live.size());
+			allocator.Free(allocation->first);
+			live.erase(allocation);
+		}
+		miscounted += (allocator.AllocationCount() != live.size()) ? 1 : 0;
+	}
+	CHECK(overlaps == 0);
+	CHECK(misaligned == 0);
+	CHECK(miscounted == 0);
+	CHECK(allocator.Allocations().size() == live.size());
+	CHECK_THROWS(allocator.Free(1), std::invalid_argument);
+
+	// freeing everything coalesces the range back into a single free block.
+	for (auto& allocation : live) {
+		allocator.Free(allocation.first);
+	}
+	CHECK(allocator.UsedBytes() == 0);
+	CHECK(allocator.LargestFreeBlock() == allocator.Size());
+}
+
+// ============================================================================
+// Freed neighbours merge so the range they covered can be allocated again.
+// ============================================================================
+void TestTlsfCoalescing()
+{
+	TlsfAllocator allocator(4096);
+	uint64_t offsets[16] = {};
+	for (auto& offset : offsets) {
+		CHECK(allocator.Allocate(256, 1, offset));
+	}
+	uint64_t offset = 0;
+	CHECK(!allocator.Allocate(256, 1, offset));
+	CHECK(allocator.LargestFreeBlock() == 0);
+
+	// free every other block, which leaves the free memory in small pieces.
+	for (auto i = 0; i < 16; i += 2) {
+		allocator.Free(offsets[i]);
+	}
+	CHECK(allocator.LargestFreeBlock() == 256);
+	CHECK(!allocator.Allocate(512, 1, offset));
+
+	// freeing the blocks in between merges the free neighbours on both sides.
+	allocator.Free(offsets[5]);
+	CHECK(allocator.LargestFreeBlock() == 768);
+	CHECK(allocator.Allocate(768, 1, offset) && offset == offsets[4]);
+	allocator.Free(offset);
+	for (auto i = 1; i < 16; i += 2) {
+		if (i != 5) {
+			allocator.Free(offsets[i]);
+		}
+	}
+	CHECK(allocator.LargestFreeBlock() == 4096);
+	CHECK(allocator.Allocate(4096, 4096, offset) && offset == 0);
+}
+
+// ============================================================================
+// Large allocations get dedicated blocks and empty blocks can be released.
+// ============================================================================
+void TestDedicatedBlocks()
+{
+	CountingHeapFactory factory;
+	{
+		GpuMemoryAllocator allocator(factory, 1024);
+		auto small = allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 300, 4);
+		CHECK(small.offset == 0 && small.block == 0);
+
+		// sizes and alignments below the granularity still fit the dedicated block.
+		auto large = allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 1100, 4);
+		CHECK(large.offset == 0 && large.block == 1);
+		CHECK(factory.LastSize() % TLSF_MIN_BLOCK_SIZE == 0 && factory.LastSize() >= 1100);
+		auto aligned = allocator.Allocate(HeapType::Default, ResourceClass::Texture, 1000, 65536);
+		CHECK(aligned.offset == 0 && factory.LastSize() == 65536);
+		CHECK(factory.LiveCount() == 3);
+
+		auto statistics = allocator.Statistics(HeapType::Default);
+		CHECK(statistics.blockCount == 3 && statistics.allocationCount == 3);
+		CHECK(allocator.Statistics(HeapType::Upload).blockCount == 0);
+
+		allocator.Free(large);
+		allocator.ReleaseEmptyBlocks();
+		CHECK(factory.LiveCount() == 2);
+		std::vector<void*> heaps;
+		allocator.Heaps(heaps);
+		CHECK(heaps.size() == 2);
+
+		// the released slot is reused without changing the block of the live allocations.
+		CHECK(allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 2000, 256).block == 1);
+		CHECK(allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 256, 256).block == 0);
+	}
+	CHECK(factory.LiveCount() == 0);
+}
+
+// ============================================================================
+// Moved ranges are freed only after the fence of their copy has completed.
+// ============================================================================
+void TestDefragment()
+{
+	CountingHeapFactory factory;
+	GpuMemoryAllocator allocator(factory, 4096);
+	std::vector<GpuAllocation> allocations;
+	for (auto i = 0; i < 8; i++) {
+		allocations.push_back(allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 1024, 256));
+	}
+	CHECK(allocations[3].block == 0 && allocations[4].block == 1);
+	allocator.Free(allocations[0]);
+	allocator.Free(allocations[1]);
+	allocator.Free(allocations[2]);
+	allocator.Free(allocations[5]);
+
+	// a rejected move frees its new range right away and keeps the old one.
+	auto rejected = allocator.Defragment(HeapType::Default, ResourceClass::Buffer, UINT64_MAX, 1, [](const GpuAllocation&, const GpuAllocation&) { return false; });
+	CHECK(rejected == 0 && allocator.Statistics(HeapType::Default).allocationCount == 4);
+
+	// the last range of the emptier block moves into the hole of the fuller block.
+	std::vector<std::pair<GpuAllocation, GpuAllocation>> moves;
+	auto moveCount = allocator.Defragment(HeapType::Default, ResourceClass::Buffer, UINT64_MAX, 5, [&](const GpuAllocation& from, const GpuAllocation& to) {
+		moves.push_back({ from, to });
+		return true;
+	});
+	CHECK(moveCount == 1 && moves.size() == 1);
+	CHECK(moves[0].first.block == 0 && moves[0].first.offset == allocations[3].offset);
+	CHECK(moves[0].second.block == 1 && moves[0].second.offset == allocations[5].offset);
+
+	// a retired range is neither moved again nor handed out before its fence completes.
+	auto again = allocator.Defragment(HeapType::Default, ResourceClass::Buffer, UINT64_MAX, 6, [](const GpuAllocation&, const GpuAllocation&) { return true; });
+	CHECK(again == 0);
+	allocator.ReleaseRetired(4);
+	allocator.ReleaseEmptyBlocks();
+	CHECK(factory.LiveCount() == 2);
+	for (auto i = 0; i < 3; i++) {
+		auto filler = allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 1024, 256);
+		CHECK(filler.block == 0 && filler.offset != allocations[3].offset);
+	}
+	CHECK(allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 1024, 256).block == 2);
+
+	allocator.ReleaseRetired(5);
+	auto reused = allocator.Allocate(HeapType::Default, ResourceClass::Buffer, 1024, 256);
+	CHECK(reused.block == 0 && reused.offset == allocations[3].offset);
+}
+
+int main()
+{
+	TestTlsfOverlap();
+	TestTlsfCoalescing();
+	TestDedicatedBlocks();
+	TestDefragment();
+	return TestResult("heap_allocator_test");
+}
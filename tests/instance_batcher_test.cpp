@@ -0,0 +1,153 @@
+#include "instance_batcher.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+// ============================================================================
+// A submitted draw with the instance data the batcher should pack for it.
+// ============================================================================
+struct Submission
+{
+	uint32_t		pipeline;
+	uint32_t		geometry;
+	InstanceData	instance;
+};
+
+// ============================================================================
+// Generate random draws whose color is the index of the submission.
+// ============================================================================
+std::vector<Submission> GenerateSubmissions(unsigned count, uint32_t pipelines, uint32_t geometries, unsigned seed)
+{
+	std::vector<Submission> submissions(count);
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> value(-1.f, 1.f);
+	for (auto i = 0u; i < count; i++) {
+		submissions[i].pipeline = random() % pipelines;
+		submissions[i].geometry = random() % geometries;
+		submissions[i].instance = { { value(random), value(random) }, value(random), value(random), i };
+	}
+	return submissions;
+}
+
+// ============================================================================
+// Get the bits of a float as the batcher stores them in a stream.
+// ============================================================================
+uint32_t FloatBits(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+// ============================================================================
+// Build the batches of the draws and compare them with a reference.
+//
+// The reference is the submission order stably sorted by the sort key with
+// the standard library. The streams must hold the instance data in that
+// order, and each batch must cover the whole run of a sort key in it.
+// ============================================================================
+void CheckBatches(InstanceBatcher& batcher, const std::vector<Submission>& submissions)
+{
+	batcher.Reset();
+	for (auto& submission : submissions) {
+		batcher.Submit(submission.pipeline, submission.geometry, submission.instance);
+	}
+	batcher.Build();
+
+	std::vector<uint32_t> order(submissions.size());
+	std::iota(order.begin(), order.end(), 0u);
+	auto key = [&](uint32_t index) { return InstanceBatcher::SortKey(submissions[index].pipeline, submissions[index].geometry); };
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+
+	// the streams are packed in the order of the reference.
+	CHECK(batcher.InstanceCount() == submissions.size());
+	auto misplaced = 0u;
+	for (size_t i = 0; i < order.size(); i++) {
+		auto& instance = submissions[order[i]].instance;
+		misplaced += (batcher.Stream(InstanceStream::Color)[i] != instance.color
+			|| batcher.Stream(InstanceStream::OffsetX)[i] != FloatBits(instance.offset[0])
+			|| batcher.Stream(InstanceStream::OffsetY)[i] != FloatBits(instance.offset[1])
+			|| batcher.Stream(InstanceStream::Scale)[i] != FloatBits(instance.scale)
+			|| batcher.Stream(InstanceStream::Rotation)[i] != FloatBits(instance.rotation)) ? 1 : 0;
+	}
+	CHECK(misplaced == 0);
+
+	// each run of a sort key in the reference is a batch of its own.
+	std::vector<InstanceBatch> expected;
+	for (uint32_t i = 0; i < order.size(); i++) {
+		auto& submission = submissions[order[i]];
+		if (i == 0 || key(order[i]) != key(order[i - 1])) {
+			expected.push_back({ submission.pipeline, submission.geometry, i, 0 });
+		}
+		expected.back().instanceCount++;
+	}
+	auto& batches = batcher.Batches();
+	CHECK(batches.size() == expected.size());
+	auto mismatched = 0u;
+	for (size_t i = 0; i < std::min(batches.size(), expected.size()); i++) {
+		mismatched += (batches[i].pipeline != expected[i].pipeline || batches[i].geometry != expected[i].geometry
+			|| batches[i].firstInstance != expected[i].firstInstance || batches[i].instanceCount != expected[i].instanceCount) ? 1 : 0;
+	}
+	CHECK(mismatched == 0);
+}
+
+// ============================================================================
+// Identifiers are packed into the key and out of range identifiers rejected.
+// ============================================================================
+void TestSortKey()
+{
+	CHECK(InstanceBatcher::SortKey(0, 0) == 0);
+	CHECK(InstanceBatcher::SortKey(1, 2) == ((1u << BATCH_GEOMETRY_BITS) | 2));
+	CHECK(InstanceBatcher::SortKey(3, 0) > InstanceBatcher::SortKey(2, (1u << BATCH_GEOMETRY_BITS) - 1));
+	CHECK_THROWS(InstanceBatcher::SortKey(1u << BATCH_PIPELINE_BITS, 0), std::out_of_range);
+	CHECK_THROWS(InstanceBatcher::SortKey(0, 1u << BATCH_GEOMETRY_BITS), std::out_of_range);
+}
+
+// ============================================================================
+// The batches and streams match the reference for every digit of the key.
+//
+// A few pipelines and geometries leave the high digits equal, so the radix
+// sort skips their passes, while the full identifier ranges use every pass.
+// ============================================================================
+void TestBatches()
+{
+	InstanceBatcher batcher;
+	CheckBatches(batcher, GenerateSubmissions(20000, 8, 64, 1));
+	CheckBatches(batcher, GenerateSubmissions(20000, 1u << BATCH_PIPELINE_BITS, 1u << BATCH_GEOMETRY_BITS, 2));
+	CheckBatches(batcher, GenerateSubmissions(1000, 1, 1, 3));
+	CHECK(batcher.Batches().size() == 1 && batcher.Batches()[0].instanceCount == 1000);
+	CheckBatches(batcher, {});
+	CHECK(batcher.Batches().empty() && batcher.InstanceCount() == 0);
+}
+
+// ============================================================================
+// The state changes count the pipelines and geometries between the batches.
+// ============================================================================
+void TestStateChanges()
+{
+	InstanceBatcher batcher;
+	InstanceData instance = {};
+	batcher.Submit(1, 5, instance);
+	batcher.Submit(0, 5, instance);
+	batcher.Submit(1, 5, instance);
+	batcher.Submit(0, 7, instance);
+	batcher.Submit(1, 6, instance);
+	batcher.Build();
+	CHECK(batcher.Batches().size() == 4);
+	CHECK(batcher.PipelineChangeCount() == 2 && batcher.GeometryChangeCount() == 4);
+
+	batcher.Reset();
+	CHECK(batcher.InstanceCount() == 0 && batcher.Batches().empty() && batcher.PipelineChangeCount() == 0);
+}
+
+int main()
+{
+	TestSortKey();
+	TestBatches();
+	TestStateChanges();
+	return TestResult("instance_batcher_test");
+}
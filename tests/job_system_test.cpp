@@ -0,0 +1,201 @@
+#include "job_system.h"
+#include "test_utils.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// the amount of worker threads of the tested job systems.
+const unsigned ThreadCount = 4;
+
+// ============================================================================
+// Each job of the deque is taken exactly once by the owner or by a thief.
+// ============================================================================
+void TestDequeStealing()
+{
+	const int count = 200000;
+	std::vector<Job*> jobs(count);
+	for (auto i = 0; i < count; i++) {
+		jobs[i] = reinterpret_cast<Job*>(static_cast<intptr_t>(i + 1));
+	}
+	std::vector<std::atomic<unsigned>> taken(count);
+	JobDeque deque;
+	std::atomic<bool> done(false);
+	auto take = [&](Job* job) { taken[reinterpret_cast<intptr_t>(job) - 1].fetch_add(1, std::memory_order_relaxed); };
+	std::vector<std::thread> thieves;
+	for (auto i = 0u; i < ThreadCount; i++) {
+		thieves.emplace_back([&] {
+			while (!done.load(std::memory_order_acquire)) {
+				if (auto job = deque.Steal()) {
+					take(job);
+				}
+			}
+		});
+	}
+
+	// the owner pushes bursts and pops half of each, so the thieves race for the last jobs.
+	auto pushed = 0;
+	while (pushed < count) {
+		for (auto i = 0; i < 64 && pushed < count; i++) {
+			if (deque.Push(jobs[pushed])) {
+				pushed++;
+			}
+		}
+		for (auto i = 0; i < 32; i++) {
+			if (auto job = deque.Pop()) {
+				take(job);
+			}
+		}
+	}
+	while (auto job = deque.Pop()) {
+		take(job);
+	}
+	done = true;
+	for (auto& thief : thieves) {
+		thief.join();
+	}
+	auto once = 0;
+	for (auto& value : taken) {
+		once += value.load() == 1;
+	}
+	CHECK(once == count);
+}
+
+// ============================================================================
+// A deque holds its capacity of jobs and refuses more.
+// ============================================================================
+void TestDequeCapacity()
+{
+	JobDeque deque;
+	Job* job = reinterpret_cast<Job*>(static_cast<intptr_t>(1));
+	for (auto i = 0; i < JOB_DEQUE_CAPACITY; i++) {
+		deque.Push(job);
+	}
+	CHECK(!deque.Push(job));
+	CHECK(deque.Steal() == job);
+	CHECK(deque.Push(job));
+}
+
+// ============================================================================
+// Parallel loops visit each index exactly once with any grain size.
+// ============================================================================
+void TestParallelFor()
+{
+	JobSystem jobs(ThreadCount);
+	CHECK(jobs.ThreadCount() == ThreadCount);
+	CHECK(jobs.ThreadIndex() == 0);
+	for (auto grainSize : { 0u, 1u, 7u, 64u, 10000u }) {
+		const unsigned count = 10000;
+		std::vector<std::atomic<unsigned>> visits(count);
+		jobs.ParallelFor(count, grainSize, [&](unsigned begin, unsigned end) {
+			for (auto i = begin; i < end; i++) {
+				visits[i].fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+		auto once = 0u;
+		for (auto& value : visits) {
+			once += value.load() == 1;
+		}
+		CHECK(once == count);
+	}
+}
+
+// ============================================================================
+// Jobs that start and wait for jobs of their own do not deadlock.
+// ============================================================================
+void Spawn(JobSystem& jobs, unsigned depth, std::atomic<unsigned>& leaves)
+{
+	if (depth == 0) {
+		leaves.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	JobCounter counter;
+	for (auto i = 0; i < 4; i++) {
+		jobs.Run([&jobs, depth, &leaves] { Spawn(jobs, depth - 1, leaves); }, &counter);
+	}
+	jobs.Wait(counter);
+}
+
+void TestNestedJobs()
+{
+	JobSystem jobs(ThreadCount);
+	std::atomic<unsigned> leaves(0);
+	Spawn(jobs, 6, leaves);
+	CHECK(leaves.load() == 4096);
+
+	// more jobs than a deque holds go to the shared queue.
+	JobCounter counter;
+	std::atomic<unsigned> runs(0);
+	for (auto i = 0; i < 3 * JOB_DEQUE_CAPACITY; i++) {
+		jobs.Run([&runs] { runs.fetch_add(1, std::memory_order_relaxed); }, &counter);
+	}
+	jobs.Wait(counter);
+	CHECK(runs.load() == 3 * JOB_DEQUE_CAPACITY);
+	CHECK(counter.IsDone());
+}
+
+// ============================================================================
+// Continuations run after all jobs of their dependency have finished.
+// ============================================================================
+void TestContinuations()
+{
+	JobSystem jobs(ThreadCount);
+	for (auto round = 0; round < 100; round++) {
+		JobCounter first, second;
+		std::atomic<unsigned> finished(0);
+		std::atomic<unsigned> early(0);
+		for (auto i = 0; i < 16; i++) {
+			jobs.Run([&finished] { finished.fetch_add(1, std::memory_order_relaxed); }, &first);
+		}
+		for (auto i = 0; i < 4; i++) {
+			jobs.RunAfter(first, [&] { early.fetch_add(finished.load() != 16, std::memory_order_relaxed); }, &second);
+		}
+		jobs.Wait(second);
+		CHECK(early.load() == 0);
+		CHECK(first.IsDone());
+
+		// a continuation of a finished counter starts right away.
+		jobs.RunAfter(first, [&finished] { finished.fetch_add(1, std::memory_order_relaxed); }, &second);
+		jobs.Wait(second);
+		CHECK(finished.load() == 17);
+	}
+}
+
+// ============================================================================
+// Threads outside the system may start jobs and wait for them.
+// ============================================================================
+void TestExternalThreads()
+{
+	JobSystem jobs(ThreadCount);
+	std::atomic<unsigned> runs(0);
+	std::atomic<unsigned> foreign(0);
+	std::vector<std::thread> threads;
+	for (auto i = 0; i < 4; i++) {
+		threads.emplace_back([&] {
+			foreign.fetch_add(jobs.ThreadIndex() == JOB_NO_THREAD, std::memory_order_relaxed);
+			for (auto round = 0; round < 100; round++) {
+				JobCounter counter;
+				for (auto j = 0; j < 32; j++) {
+					jobs.Run([&runs] { runs.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}
+				jobs.Wait(counter);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	CHECK(foreign.load() == 4);
+	CHECK(runs.load() == 4 * 100 * 32);
+}
+
+int main()
+{
+	TestDequeStealing();
+	TestDequeCapacity();
+	TestParallelFor();
+	TestNestedJobs();
+	TestContinuations();
+	TestExternalThreads();
+	return TestResult("job_system_test");
+}
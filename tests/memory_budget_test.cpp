@@ -0,0 +1,181 @@
+#include "memory_budget.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+
+// ============================================================================
+// The budget is polled at the interval and trimmed towards the trim target.
+// ============================================================================
+void TestPollAndTrim()
+{
+	SimulatedBudgetProvider provider;
+	CHECK_THROWS(MemoryBudget(provider, { 0.8, 0.9, 1 }), std::invalid_argument);
+	MemoryBudget budget(provider, { 0.9, 0.8, 10 });
+	uint64_t requested = 0;
+	budget.AddTrimmer(MemorySegment::Local, "Cache", [&](uint64_t bytes) { requested = bytes; return bytes; });
+	budget.Allocate(MemoryCategory::Geometry, MemorySegment::Local, 600);
+	CHECK_THROWS(budget.Free(MemoryCategory::Upload, MemorySegment::Local, 1), std::invalid_argument);
+	provider.Set(MemorySegment::Local, 1000, 700);
+	for (auto i = 0; i < 10; i++) {
+		budget.Update(false);
+	}
+	CHECK(provider.QueryCount() == MEMORY_SEGMENT_COUNT);
+	CHECK(budget.Statistics().untracked[static_cast<unsigned>(MemorySegment::Local)] == 100);
+	CHECK(!budget.OverBudget(MemorySegment::Local));
+
+	// the next poll sees the usage over the threshold and trims it to the target.
+	provider.Set(MemorySegment::Local, 1000, 950);
+	budget.Update(false);
+	CHECK(provider.QueryCount() == 2 * MEMORY_SEGMENT_COUNT);
+	CHECK(requested == 150);
+	CHECK(budget.Statistics().segments[static_cast<unsigned>(MemorySegment::Local)].usage == 800);
+	CHECK(budget.Statistics().trimmedBytes == 150 && budget.Statistics().trimCount == 1 && budget.Statistics().overBudgetPolls == 1);
+}
+
+// ============================================================================
+// Own allocations that may cross the threshold poll before the interval.
+// ============================================================================
+void TestEarlyPoll()
+{
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.9, 0.8, 100 });
+	provider.Set(MemorySegment::Local, 1000, 500);
+	budget.Update(false);
+	budget.Allocate(MemoryCategory::Geometry, MemorySegment::Local, 300);
+	budget.Update(false);
+	CHECK(provider.QueryCount() == MEMORY_SEGMENT_COUNT);
+
+	// the usage would be 500 + 300 + 200 with the new allocation.
+	budget.Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, 200);
+	provider.Set(MemorySegment::Local, 1000, 1000);
+	budget.Update(false);
+	CHECK(provider.QueryCount() == 2 * MEMORY_SEGMENT_COUNT);
+	CHECK(budget.OverBudget(MemorySegment::Local));
+
+	// frees that bring the tracked memory back to the polled amount do not poll.
+	budget.Free(MemoryCategory::RenderTargets, MemorySegment::Local, 200);
+	budget.Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, 200);
+	budget.Update(false);
+	CHECK(provider.QueryCount() == 2 * MEMORY_SEGMENT_COUNT);
+}
+
+// ============================================================================
+// A segment the trimmers cannot bring down is trimmed once per interval.
+// ============================================================================
+void TestStuckOverBudget()
+{
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.9, 0.8, 30 });
+	auto trimmerCalls = 0u;
+	budget.AddTrimmer(MemorySegment::Local, "Nothing", [&](uint64_t) { trimmerCalls++; return uint64_t(0); });
+	provider.Set(MemorySegment::Local, 1000, 990);
+	for (auto i = 0; i < 120; i++) {
+		budget.Update(false);
+	}
+	CHECK(provider.QueryCount() == 4 * MEMORY_SEGMENT_COUNT);
+	CHECK(trimmerCalls == 4);
+	CHECK(budget.Statistics().overBudgetPolls == 4 && budget.Statistics().trimCount == 0);
+
+	// allocations while over the threshold wait for the next poll as well.
+	for (auto i = 0; i < 30; i++) {
+		budget.Allocate(MemoryCategory::Upload, MemorySegment::Local, 1);
+		budget.Update(false);
+	}
+	CHECK(provider.QueryCount() == 5 * MEMORY_SEGMENT_COUNT);
+	CHECK(trimmerCalls == 5);
+}
+
+// ============================================================================
+// A segment stuck over the threshold does not hold back the other segment.
+// ============================================================================
+void TestSegmentsTrimmedApart()
+{
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.9, 0.8, 30 });
+	auto localCalls = 0u, nonLocalCalls = 0u;
+	budget.AddTrimmer(MemorySegment::Local, "Nothing", [&](uint64_t) { localCalls++; return uint64_t(0); });
+	budget.AddTrimmer(MemorySegment::NonLocal, "Staging", [&](uint64_t) {
+		nonLocalCalls++;
+		budget.Free(MemoryCategory::Upload, MemorySegment::NonLocal, 200);
+		provider.Set(MemorySegment::NonLocal, 1000, 750);
+		return uint64_t(200);
+	});
+	provider.Set(MemorySegment::Local, 1000, 990);
+	provider.Set(MemorySegment::NonLocal, 1000, 750);
+	for (auto i = 0; i < 10; i++) {
+		budget.Update(false);
+	}
+	CHECK(localCalls == 1 && nonLocalCalls == 0);
+
+	// the staging memory grows over the threshold and is trimmed on the early poll.
+	budget.Allocate(MemoryCategory::Upload, MemorySegment::NonLocal, 200);
+	provider.Set(MemorySegment::NonLocal, 1000, 950);
+	budget.Update(false);
+	CHECK(provider.QueryCount() == 2 * MEMORY_SEGMENT_COUNT);
+	CHECK(nonLocalCalls == 1 && localCalls == 1);
+	CHECK(budget.Statistics().trimCount == 1 && budget.Statistics().trimmedBytes == 200);
+}
+
+// ============================================================================
+// Memory trimmed and created again the next frame is trimmed once per poll.
+// ============================================================================
+void TestRecreatedMemory()
+{
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.9, 0.8, 30 });
+	uint64_t transient = 400;
+	auto trimmerCalls = 0u;
+	budget.Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, transient);
+	budget.AddTrimmer(MemorySegment::Local, "Transient", [&](uint64_t) {
+		trimmerCalls++;
+		budget.Free(MemoryCategory::RenderTargets, MemorySegment::Local, transient);
+		return transient;
+	});
+	provider.Set(MemorySegment::Local, 1000, 950);
+	for (auto i = 0; i < 120; i++) {
+		budget.Update(false);
+		if (budget.Statistics().categories[static_cast<unsigned>(MemorySegment::Local)][static_cast<unsigned>(MemoryCategory::RenderTargets)] == 0) {
+			budget.Allocate(MemoryCategory::RenderTargets, MemorySegment::Local, transient);
+		}
+	}
+	CHECK(provider.QueryCount() == 4 * MEMORY_SEGMENT_COUNT);
+	CHECK(trimmerCalls == 4);
+}
+
+// ============================================================================
+// Background only trimmers run just when the app moves into the background.
+// ============================================================================
+void TestBackground()
+{
+	SimulatedBudgetProvider provider;
+	MemoryBudget budget(provider, { 0.9, 0.8, 1 });
+	auto cheapCalls = 0u, costlyCalls = 0u, nonLocalCalls = 0u;
+	budget.AddTrimmer(MemorySegment::Local, "Cheap", [&](uint64_t) { cheapCalls++; return uint64_t(10); });
+	budget.AddTrimmer(MemorySegment::Local, "Costly", [&](uint64_t) { costlyCalls++; return uint64_t(500); }, true);
+	budget.AddTrimmer(MemorySegment::NonLocal, "Staging", [&](uint64_t) { nonLocalCalls++; return uint64_t(0); });
+	provider.Set(MemorySegment::Local, 1000, 990);
+	budget.Update(false);
+	CHECK(cheapCalls == 1 && costlyCalls == 0 && nonLocalCalls == 0);
+
+	// moving into the background runs every trimmer once, and the policy is idle until visible again.
+	budget.Update(true);
+	budget.Update(true);
+	CHECK(budget.Statistics().background);
+	CHECK(cheapCalls == 2 && costlyCalls == 1 && nonLocalCalls == 1);
+	auto queries = provider.QueryCount();
+	budget.Update(false);
+	CHECK(!budget.Statistics().background);
+	CHECK(provider.QueryCount() == queries + MEMORY_SEGMENT_COUNT);
+	CHECK(costlyCalls == 1);
+}
+
+int main()
+{
+	TestPollAndTrim();
+	TestEarlyPoll();
+	TestStuckOverBudget();
+	TestSegmentsTrimmedApart();
+	TestRecreatedMemory();
+	TestBackground();
+	return TestResult("memory_budget_test");
+}
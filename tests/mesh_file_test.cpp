@@ -0,0 +1,137 @@
+#include "mesh_file.h"
+#include "test_utils.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// ============================================================================
+// A helper to write a mesh of half float vertices into the bytes of a file.
+// ============================================================================
+std::vector<uint8_t> WriteHalfMesh(const std::vector<HalfVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::ostringstream output;
+	MeshBounds bounds = { { -1.f, -2.f, -3.f }, { 1.f, 2.f, 3.f } };
+	WriteMesh(output, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), bounds, 0.5f);
+	auto bytes = output.str();
+	return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+// ============================================================================
+// A helper to open the bytes of a file as mesh file contents.
+// ============================================================================
+std::unique_ptr<FileContents> OpenBytes(std::vector<uint8_t> bytes)
+{
+	FakeFileSource source;
+	source.Add("mesh", std::move(bytes));
+	return source.Open("mesh");
+}
+
+// ============================================================================
+// A helper to get a vertex with distinct bits in each of its values.
+// ============================================================================
+HalfVertex MakeVertex(uint32_t index)
+{
+	HalfVertex vertex;
+	for (auto i = 0; i < 4; i++) {
+		vertex.position.value[i] = static_cast<uint16_t>(index * 4 + i);
+		vertex.color.value[i] = static_cast<uint8_t>(index + i);
+	}
+	return vertex;
+}
+
+// ============================================================================
+// A written mesh reads back with the same layout, bounds and streams.
+// ============================================================================
+void TestRoundTrip()
+{
+	std::vector<HalfVertex> vertices;
+	for (auto i = 0u; i < 5; i++) {
+		vertices.push_back(MakeVertex(i));
+	}
+	std::vector<uint32_t> indices = { 0, 1, 2, 2, 3, 4 };
+	MeshFile mesh(OpenBytes(WriteHalfMesh(vertices, indices)));
+	auto& header = mesh.Header();
+	CHECK(mesh.HasLayout<HalfVertex>());
+	CHECK(!mesh.HasLayout<SnormVertex>());
+	CHECK(header.vertexCount == 5 && header.indexCount == 6);
+	CHECK(header.boundsMin[1] == -2.f && header.boundsMax[2] == 3.f && header.positionScale == 0.5f);
+	CHECK(header.vertices.offset % MESH_STREAM_ALIGNMENT == 0 && header.indices.offset % MESH_STREAM_ALIGNMENT == 0);
+	CHECK(std::memcmp(mesh.VertexData(), vertices.data(), vertices.size() * sizeof(HalfVertex)) == 0);
+	CHECK(mesh.IndexSize() == 2);
+	auto index = reinterpret_cast<const uint16_t*>(mesh.IndexData());
+	CHECK(std::vector<uint32_t>(index, index + 6) == indices);
+
+	// the streams are copied as they are into the buffers.
+	SimulatedCopyQueue queue(4096);
+	GeometryUploader uploader(queue, 1024);
+	std::vector<uint8_t> vertexBuffer(header.vertices.size), indexBuffer(header.indices.size);
+	mesh.Upload(uploader, vertexBuffer.data(), indexBuffer.data());
+	uploader.Flush();
+	CHECK(std::memcmp(vertexBuffer.data(), mesh.VertexData(), vertexBuffer.size()) == 0);
+	CHECK(std::memcmp(indexBuffer.data(), mesh.IndexData(), indexBuffer.size()) == 0);
+}
+
+// ============================================================================
+// Meshes with many vertices use 32-bit indices and meshes may have none.
+// ============================================================================
+void TestIndexFormats()
+{
+	std::vector<HalfVertex> vertices(0x10001, MakeVertex(0));
+	std::vector<uint32_t> indices = { 0, 0x10000, 1 };
+	auto asset = DecodeMesh(OpenBytes(WriteHalfMesh(vertices, indices)));
+	auto& mesh = static_cast<MeshAsset&>(*asset).Mesh();
+	CHECK(mesh.IndexSize() == 4);
+	CHECK(reinterpret_cast<const uint32_t*>(mesh.IndexData())[1] == 0x10000);
+	CHECK(asset->UploadSize() == vertices.size() * sizeof(HalfVertex) + 3 * 4);
+
+	MeshFile unindexed(OpenBytes(WriteHalfMesh({ MakeVertex(1) }, {})));
+	CHECK(unindexed.IndexSize() == 0 && unindexed.Header().indices.size == 0);
+	CHECK(unindexed.Header().indexFormat == static_cast<uint32_t>(MeshIndexFormat::None));
+}
+
+// ============================================================================
+// Truncated and corrupted files are rejected before the streams are used.
+// ============================================================================
+void TestCorruptFiles()
+{
+	auto valid = WriteHalfMesh({ MakeVertex(0), MakeVertex(1), MakeVertex(2) }, { 0, 1, 2 });
+	auto corrupt = [&](void (*change)(MeshFileHeader& header)) {
+		auto bytes = valid;
+		change(*reinterpret_cast<MeshFileHeader*>(bytes.data()));
+		return OpenBytes(bytes);
+	};
+	CHECK_THROWS(MeshFile(OpenBytes(std::vector<uint8_t>(valid.begin(), valid.begin() + 100))), std::runtime_error);
+	CHECK_THROWS(MeshFile(OpenBytes(std::vector<uint8_t>(valid.begin(), valid.end() - 2))), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.magic = 0; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.version++; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.elementCount = MESH_MAX_ELEMENTS + 1; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.elements[0].format = 99; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.elements[1].offset = header.vertexStride; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { std::memset(header.elements[0].semantic, 'A', MESH_SEMANTIC_LENGTH); })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.indexFormat = 3; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.indexFormat = static_cast<uint32_t>(MeshIndexFormat::None); header.indices.size = 0; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.vertexCount = 0; header.vertices.size = 0; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.vertexCount++; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.vertices.offset += MESH_STREAM_ALIGNMENT; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.indices.offset = 0x7fffffffffffff00ull; })), std::runtime_error);
+	CHECK_THROWS(MeshFile(corrupt([](MeshFileHeader& header) { header.indices.offset = 0; })), std::runtime_error);
+
+	// an index past the vertices only fails the validation of the streams.
+	auto bytes = valid;
+	auto header = reinterpret_cast<const MeshFileHeader*>(bytes.data());
+	reinterpret_cast<uint16_t*>(bytes.data() + header->indices.offset)[2] = 3;
+	MeshFile mesh(OpenBytes(bytes));
+	CHECK_THROWS(mesh.ValidateStreams(), std::runtime_error);
+	CHECK_THROWS(DecodeMesh(OpenBytes(bytes)), std::runtime_error);
+	DecodeMesh(OpenBytes(valid));
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestIndexFormats();
+	TestCorruptFiles();
+	return TestResult("mesh_file_test");
+}
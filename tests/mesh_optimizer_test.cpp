@@ -0,0 +1,174 @@
+#include "mesh_optimizer.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+// ============================================================================
+// Generate a shuffled unindexed grid of the given amount of quads.
+//
+// Each corner of a triangle is stored as its own vertex, so the vertices of
+// the grid are all duplicated as in an unoptimized export.
+// ============================================================================
+std::vector<Vertex> GenerateGrid(unsigned size)
+{
+	std::vector<std::array<Vertex, 3>> triangles;
+	auto vertex = [&](unsigned x, unsigned y) {
+		return Vertex{ { static_cast<float>(x), static_cast<float>(y), 0.f }, { x / static_cast<float>(size), y / static_cast<float>(size), 0.f, 1.f } };
+	};
+	for (auto y = 0u; y < size; y++) {
+		for (auto x = 0u; x < size; x++) {
+			triangles.push_back({ vertex(x, y), vertex(x + 1, y), vertex(x, y + 1) });
+			triangles.push_back({ vertex(x + 1, y), vertex(x + 1, y + 1), vertex(x, y + 1) });
+		}
+	}
+	std::mt19937 random(18);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+	std::vector<Vertex> vertices;
+	for (auto& triangle : triangles) {
+		vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+	}
+	return vertices;
+}
+
+// ============================================================================
+// Get the triangles as sorted corner positions rotated to a canonical start.
+//
+// Rotating the corners keeps the winding, so the result only matches when
+// the triangles are the same and face the same way, in any order.
+// ============================================================================
+std::vector<std::array<float, 9>> TriangleSet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::vector<std::array<float, 9>> triangles;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::array<std::array<float, 3>, 3> corners = { vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position };
+		std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+		std::array<float, 9> triangle;
+		for (auto j = 0; j < 9; j++) {
+			triangle[j] = corners[j / 3][j % 3];
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// ============================================================================
+// The simulated cache counts the misses of a FIFO cache of the given size.
+// ============================================================================
+void TestVertexCacheAnalysis()
+{
+	std::vector<uint32_t> strip = { 0, 1, 2, 2, 1, 3, 2, 3, 4 };
+	auto statistics = AnalyzeVertexCache(strip, 5);
+	CHECK(statistics.transformedCount == 5);
+	CHECK(statistics.acmr == 5.f / 3.f && statistics.atvr == 1.f);
+
+	// a cache of three entries has evicted the first vertex when it is used again.
+	std::vector<uint32_t> reuse = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	CHECK(AnalyzeVertexCache(reuse, 6, 3).transformedCount == 9);
+	CHECK(AnalyzeVertexCache(reuse, 6, 6).transformedCount == 6);
+}
+
+// ============================================================================
+// Duplicates map into the first equal vertex and unused vertices are dropped.
+// ============================================================================
+void TestVertexRemapping()
+{
+	std::vector<Vertex> vertices = { { { 0.f, 0.f, 0.f }, {} }, { { 1.f, 0.f, 0.f }, {} }, { { 0.f, 0.f, 0.f }, {} }, { { 2.f, 0.f, 0.f }, {} } };
+	std::vector<uint32_t> remap;
+	CHECK(DeduplicateVertices(vertices.data(), vertices.size(), sizeof(Vertex), remap) == 3);
+	CHECK(remap == std::vector<uint32_t>({ 0, 1, 0, 2 }));
+
+	// vertices are placed in the order of their first use.
+	std::vector<uint32_t> indices = { 3, 1, 0 };
+	CHECK(OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices) == 3);
+	CHECK(indices == std::vector<uint32_t>({ 0, 1, 2 }));
+	CHECK(vertices[0].position[0] == 2.f && vertices[1].position[0] == 1.f && vertices[2].position[0] == 0.f);
+}
+
+// ============================================================================
+// The stages reorder the triangles without changing any of them.
+// ============================================================================
+void TestStagesKeepTriangles()
+{
+	auto source = GenerateGrid(32);
+	std::vector<uint32_t> remap;
+	auto uniqueCount = DeduplicateVertices(source.data(), source.size(), sizeof(Vertex), remap);
+	CHECK(uniqueCount == 33 * 33);
+	std::vector<Vertex> vertices(uniqueCount);
+	RemapVertices(source.data(), source.size(), sizeof(Vertex), remap, vertices.data());
+	auto indices = remap;
+	auto triangles = TriangleSet(vertices, indices);
+	auto before = AnalyzeVertexCache(indices, vertices.size()).acmr;
+
+	// the cache order must at least halve the invocations of the shuffled triangles.
+	OptimizeVertexCache(indices, vertices.size());
+	auto cached = AnalyzeVertexCache(indices, vertices.size()).acmr;
+	CHECK(cached < before / 2.f);
+	CHECK(cached < 0.8f);
+	CHECK(TriangleSet(vertices, indices) == triangles);
+
+	// the overdraw order may only give back the allowed part of the gain.
+	OptimizeOverdraw(indices, vertices[0].position.data(), sizeof(Vertex), vertices.size());
+	CHECK(AnalyzeVertexCache(indices, vertices.size()).acmr <= cached * MESH_OVERDRAW_THRESHOLD);
+	CHECK(TriangleSet(vertices, indices) == triangles);
+
+	vertices.resize(OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices));
+	CHECK(vertices.size() == uniqueCount);
+	CHECK(TriangleSet(vertices, indices) == triangles);
+}
+
+// ============================================================================
+// The whole optimization indexes the mesh and reports its improvements.
+// ============================================================================
+void TestOptimizeMesh()
+{
+	auto vertices = GenerateGrid(64);
+	auto source = vertices;
+	std::vector<uint32_t> sourceIndices(source.size());
+	for (size_t i = 0; i < sourceIndices.size(); i++) {
+		sourceIndices[i] = static_cast<uint32_t>(i);
+	}
+	std::vector<uint32_t> indices;
+	auto report = OptimizeMesh(vertices, indices, 12);
+	CHECK(report.vertexCountBefore == 64 * 64 * 6 && report.vertexCountAfter == 65 * 65);
+	CHECK(report.indexCount == 64 * 64 * 6);
+	CHECK(report.acmrBefore == 3.f && report.acmrAfter < 0.8f);
+	CHECK(report.atvrBefore == 1.f && report.atvrAfter < 1.5f);
+	CHECK(report.bytesAfter < report.bytesBefore);
+	CHECK(report.bytesAfter == MeshStreamSize(65 * 65, 12, 64 * 64 * 6));
+	CHECK(TriangleSet(vertices, indices) == TriangleSet(source, sourceIndices));
+	CHECK(*std::max_element(indices.begin(), indices.end()) == vertices.size() - 1);
+}
+
+// ============================================================================
+// Meshes without a whole triangle are left as they are.
+// ============================================================================
+void TestDegenerateMesh()
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	auto report = OptimizeMesh(vertices, indices, 12);
+	CHECK(vertices.empty() && indices.empty() && report.vertexCountAfter == 0 && report.bytesAfter == 0);
+
+	vertices = GenerateGrid(1);
+	vertices.resize(2);
+	auto source = vertices;
+	report = OptimizeMesh(vertices, indices, 12);
+	CHECK(vertices.size() == 2 && indices.empty());
+	CHECK(vertices[1].position == source[1].position);
+	CHECK(report.vertexCountBefore == 2 && report.vertexCountAfter == 2 && report.indexCount == 0);
+	CHECK(report.bytesAfter == report.bytesBefore);
+}
+
+int main()
+{
+	TestVertexCacheAnalysis();
+	TestVertexRemapping();
+	TestStagesKeepTriangles();
+	TestOptimizeMesh();
+	TestDegenerateMesh();
+	return TestResult("mesh_optimizer_test");
+}
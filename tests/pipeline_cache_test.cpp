@@ -0,0 +1,293 @@
+#include "pipeline_cache.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// the shader program the mock factory fails to create a pipeline for.
+const uint16_t FailingProgram = 999;
+
+// ============================================================================
+// A pipeline of the mock factory that knows the key it was created for.
+// ============================================================================
+class MockPipeline : public PipelineObject
+{
+public:
+	explicit MockPipeline(uint64_t key) : mKey(key) {}
+	uint64_t Key() const { return mKey; }
+private:
+	uint64_t	mKey;
+};
+
+// ============================================================================
+// A pipeline factory that counts the pipelines it creates.
+//
+// Creation waits while the factory is closed, so a test can hold the workers
+// in the middle of a build. The library is the list of the created keys.
+// ============================================================================
+class MockPipelineFactory : public PipelineFactory
+{
+public:
+	MockPipelineFactory() : mOpen(true) {}
+	std::shared_ptr<PipelineObject> Create(const PipelineStateDesc& desc) override;
+	void LoadPipelineLibrary(const std::vector<uint8_t>& data) override;
+	std::vector<uint8_t> SerializePipelineLibrary() override;
+	void SetOpen(bool open);
+	unsigned CreateCount(uint64_t key);
+	std::vector<uint8_t> LoadedLibrary();
+private:
+	std::mutex				mMutex;
+	std::condition_variable	mOpened;
+	std::vector<uint64_t>	mCreated;
+	std::vector<uint8_t>	mLoaded;
+	bool					mOpen;
+};
+
+std::shared_ptr<PipelineObject> MockPipelineFactory::Create(const PipelineStateDesc& desc)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mOpened.wait(lock, [this] { return mOpen; });
+	mCreated.push_back(desc.Key());
+	if (desc.shaderProgram == FailingProgram) {
+		throw std::runtime_error("invalid shader program");
+	}
+	return std::make_shared<MockPipeline>(desc.Key());
+}
+
+void MockPipelineFactory::LoadPipelineLibrary(const std::vector<uint8_t>& data)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mLoaded = data;
+}
+
+std::vector<uint8_t> MockPipelineFactory::SerializePipelineLibrary()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto bytes = reinterpret_cast<const uint8_t*>(mCreated.data());
+	return std::vector<uint8_t>(bytes, bytes + mCreated.size() * sizeof(uint64_t));
+}
+
+void MockPipelineFactory::SetOpen(bool open)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mOpen = open;
+	mOpened.notify_all();
+}
+
+unsigned MockPipelineFactory::CreateCount(uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return static_cast<unsigned>(std::count(mCreated.begin(), mCreated.end(), key));
+}
+
+std::vector<uint8_t> MockPipelineFactory::LoadedLibrary()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLoaded;
+}
+
+// a helper to describe a pipeline state with the given shader program.
+PipelineStateDesc Desc(uint16_t shaderProgram, BlendMode blendMode = BlendMode::Opaque)
+{
+	return { shaderProgram, 1, FillMode::Solid, CullMode::Back, blendMode, RenderTargetFormat::BGRA8, PrimitiveTopology::Triangle };
+}
+
+// a helper to get the key of the mock pipeline a cache handed out.
+uint64_t KeyOf(const std::shared_ptr<PipelineObject>& pipeline)
+{
+	return pipeline ? static_cast<const MockPipeline&>(*pipeline).Key() : 0;
+}
+
+// ============================================================================
+// Every field is packed into its own bits and unpacked back unchanged.
+// ============================================================================
+void TestKeyPacking()
+{
+	std::set<uint64_t> keys;
+	auto roundTrips = true;
+	for (auto fill : { FillMode::Solid, FillMode::Wireframe }) {
+		for (auto cull : { CullMode::None, CullMode::Front, CullMode::Back }) {
+			for (auto blend : { BlendMode::Opaque, BlendMode::Alpha, BlendMode::Additive }) {
+				for (auto format : { RenderTargetFormat::RGBA8, RenderTargetFormat::BGRA8, RenderTargetFormat::RGBA16F }) {
+					for (auto topology : { PrimitiveTopology::Triangle, PrimitiveTopology::Line, PrimitiveTopology::Point }) {
+						for (uint16_t program : { 0, 1, 0xffff }) {
+							PipelineStateDesc desc = { program, static_cast<uint16_t>(0xffff - program), fill, cull, blend, format, topology };
+							auto unpacked = PipelineStateDesc::FromKey(desc.Key());
+							roundTrips &= unpacked.shaderProgram == desc.shaderProgram && unpacked.inputLayout == desc.inputLayout
+								&& unpacked.fillMode == fill && unpacked.cullMode == cull && unpacked.blendMode == blend
+								&& unpacked.renderTargetFormat == format && unpacked.topology == topology;
+							keys.insert(desc.Key());
+						}
+					}
+				}
+			}
+		}
+	}
+	CHECK(roundTrips);
+	CHECK(keys.size() == 2 * 3 * 3 * 3 * 3 * 3);
+	CHECK(Desc(1).Key() == (1ull | 1ull << 16 | 2ull << 40 | 1ull << 56));
+}
+
+// ============================================================================
+// Concurrent requests of the same pipelines build each pipeline only once.
+// ============================================================================
+void TestDeduplication()
+{
+	MockPipelineFactory factory;
+	PipelineCache cache(factory, 4);
+	factory.SetOpen(false);
+	std::vector<std::thread> threads;
+	for (auto i = 0; i < 8; i++) {
+		threads.emplace_back([&cache] {
+			for (auto j = 0; j < 100; j++) {
+				cache.Get(Desc(static_cast<uint16_t>(1 + j % 4)), Desc(0));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	factory.SetOpen(true);
+	cache.WaitIdle();
+	CHECK(cache.RequestCount() == 800);
+	CHECK(cache.CompileCount() == 4);
+	auto once = true;
+	for (uint16_t program = 1; program <= 4; program++) {
+		once &= factory.CreateCount(Desc(program).Key()) == 1;
+	}
+	CHECK(once);
+}
+
+// ============================================================================
+// The fallback pipeline is handed out until the pipeline has been built.
+// ============================================================================
+void TestFallback()
+{
+	MockPipelineFactory factory;
+	PipelineCache cache(factory, 1);
+	CHECK(cache.Get(Desc(1), Desc(0)) == nullptr);
+	cache.WaitIdle();
+	auto fallback = cache.GetBlocking(Desc(0));
+	CHECK(KeyOf(fallback) == Desc(0).Key());
+
+	factory.SetOpen(false);
+	CHECK(cache.Get(Desc(2), Desc(0)) == fallback);
+	CHECK(cache.Get(Desc(2), Desc(0)) == fallback);
+	factory.SetOpen(true);
+	cache.WaitIdle();
+	CHECK(KeyOf(cache.Get(Desc(2), Desc(0))) == Desc(2).Key());
+	CHECK(factory.CreateCount(Desc(2).Key()) == 1);
+}
+
+// ============================================================================
+// Without workers the pipelines are built by the blocking calls.
+// ============================================================================
+void TestBlocking()
+{
+	MockPipelineFactory factory;
+	PipelineCache cache(factory, 0);
+	CHECK(KeyOf(cache.GetBlocking(Desc(1))) == Desc(1).Key());
+	CHECK(cache.CompileCount() == 1);
+
+	// the prewarmed pipelines are built when waiting for the idle cache.
+	cache.Prewarm(Desc(2));
+	cache.Prewarm(Desc(3));
+	CHECK(cache.Get(Desc(2), Desc(1)) == cache.GetBlocking(Desc(1)));
+	cache.WaitIdle();
+	CHECK(cache.CompileCount() == 3);
+	CHECK(KeyOf(cache.Get(Desc(3), Desc(1))) == Desc(3).Key());
+
+	// a failed pipeline throws and is never built again.
+	CHECK_THROWS(cache.GetBlocking(Desc(FailingProgram)), std::runtime_error);
+	CHECK_THROWS(cache.GetBlocking(Desc(FailingProgram)), std::runtime_error);
+	CHECK(factory.CreateCount(Desc(FailingProgram).Key()) == 1);
+	CHECK(cache.Get(Desc(FailingProgram), Desc(1)) == cache.GetBlocking(Desc(1)));
+}
+
+// ============================================================================
+// A saved cache restores the library and builds the same pipelines again.
+// ============================================================================
+void TestSaveLoad()
+{
+	std::stringstream stream;
+	std::vector<uint8_t> library;
+	{
+		MockPipelineFactory factory;
+		PipelineCache cache(factory, 2);
+		cache.Prewarm(Desc(1));
+		cache.Prewarm(Desc(2, BlendMode::Alpha));
+		cache.Prewarm(Desc(FailingProgram));
+		cache.WaitIdle();
+		cache.Save(stream);
+		library = factory.SerializePipelineLibrary();
+	}
+
+	MockPipelineFactory factory;
+	PipelineCache cache(factory, 2);
+	CHECK(cache.Load(stream));
+	cache.WaitIdle();
+	CHECK(factory.LoadedLibrary() == library);
+	CHECK(cache.CompileCount() == 2);
+	CHECK(factory.CreateCount(Desc(1).Key()) == 1);
+	CHECK(factory.CreateCount(Desc(2, BlendMode::Alpha).Key()) == 1);
+	CHECK(factory.CreateCount(Desc(FailingProgram).Key()) == 0);
+}
+
+// ============================================================================
+// A cache with counts or sizes beyond the end of the file is discarded.
+// ============================================================================
+void TestCorruptCache()
+{
+	std::string saved;
+	{
+		MockPipelineFactory factory;
+		PipelineCache cache(factory, 0);
+		cache.GetBlocking(Desc(1));
+		cache.GetBlocking(Desc(2));
+		std::stringstream stream;
+		cache.Save(stream);
+		saved = stream.str();
+	}
+
+	// a helper to load a modified copy of the saved cache into a new cache.
+	auto load = [](const std::string& data) {
+		MockPipelineFactory factory;
+		PipelineCache cache(factory, 0);
+		std::stringstream stream(data);
+		auto loaded = cache.Load(stream);
+		cache.WaitIdle();
+		return loaded || !factory.LoadedLibrary().empty() || cache.CompileCount() != 0;
+	};
+	CHECK(load(saved));
+	CHECK(!load(""));
+	CHECK(!load(saved.substr(0, saved.size() - 1)));
+	CHECK(!load(saved + "x"));
+
+	// the key count is after the magic and the version, the library size after the keys.
+	auto hugeCount = saved;
+	hugeCount[8] = hugeCount[9] = hugeCount[10] = hugeCount[11] = '\xff';
+	CHECK(!load(hugeCount));
+	auto hugeSize = saved;
+	hugeSize[12 + 2 * 8 + 7] = '\x7f';
+	CHECK(!load(hugeSize));
+	auto badMagic = saved;
+	badMagic[0] ^= 1;
+	CHECK(!load(badMagic));
+}
+
+int main()
+{
+	TestKeyPacking();
+	TestDeduplication();
+	TestFallback();
+	TestBlocking();
+	TestSaveLoad();
+	TestCorruptCache();
+	return TestResult("pipeline_cache_test");
+}
@@ -0,0 +1,221 @@
+#include "render_graph.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ============================================================================
+// A render graph backend that hands out fake textures and keeps the barriers.
+//
+// Textures are cached by their offset and description like the D3D12 backend,
+// so a texture is only created again when its description changes.
+// ============================================================================
+class NullRenderGraphBackend : public RenderGraphBackend
+{
+public:
+	void TextureAllocationInfo(const TextureDesc& desc, uint64_t& size, uint64_t& alignment) override
+	{
+		alignment = 256;
+		size = static_cast<uint64_t>(desc.width) * desc.height * 4;
+	}
+	void ReserveTransientMemory(uint64_t size) override { mReservedBytes = std::max(mReservedBytes, size); }
+	void* AcquireTransientTexture(const TextureDesc& desc, uint64_t offset, bool& created) override
+	{
+		for (auto& texture : mTextures) {
+			if (texture.offset == offset && texture.desc.width == desc.width && texture.desc.height == desc.height && texture.desc.format == desc.format) {
+				created = false;
+				return texture.handle;
+			}
+		}
+		created = true;
+		mTextures.push_back({ desc, offset, reinterpret_cast<void*>(mTextures.size() + 1) });
+		return mTextures.back().handle;
+	}
+	void ResourceBarriers(const std::vector<ResourceBarrier>& barriers) override { mBarriers.insert(mBarriers.end(), barriers.begin(), barriers.end()); }
+	unsigned AliasingBarriers(void* texture) const
+	{
+		return static_cast<unsigned>(std::count_if(mBarriers.begin(), mBarriers.end(), [&](const ResourceBarrier& barrier) { return barrier.type == ResourceBarrier::Type::Aliasing && barrier.resource == texture; }));
+	}
+	uint64_t ReservedBytes() const { return mReservedBytes; }
+	std::vector<ResourceBarrier>	mBarriers;
+private:
+	struct Texture
+	{
+		TextureDesc		desc;
+		uint64_t		offset;
+		void*			handle;
+	};
+	std::vector<Texture>	mTextures;
+	uint64_t				mReservedBytes = 0;
+};
+
+// the description of the textures used by the tests, which take 4 KB each.
+const TextureDesc SmallTexture = { 32, 32, TextureFormat::RGBA8 };
+
+// ============================================================================
+// Passes that do not lead to an output are culled with their inputs.
+// ============================================================================
+void TestCulling()
+{
+	NullRenderGraphBackend backend;
+	RenderGraph graph(backend);
+	int backBuffer = 0;
+	auto output = graph.ImportTexture("BackBuffer", &backBuffer, ResourceState::Present);
+	auto scene = graph.CreateTexture("Scene", SmallTexture);
+	auto unused = graph.CreateTexture("Unused", SmallTexture);
+	auto history = graph.CreateTexture("History", SmallTexture);
+
+	auto drawScene = graph.AddPass("DrawScene", nullptr);
+	graph.Write(drawScene, scene, ResourceState::RenderTarget);
+	auto drawUnused = graph.AddPass("DrawUnused", nullptr);
+	graph.Read(drawUnused, scene, ResourceState::ShaderResource);
+	graph.Write(drawUnused, unused, ResourceState::RenderTarget);
+	auto readback = graph.AddPass("Readback", nullptr);
+	graph.Write(readback, history, ResourceState::CopyDest);
+	graph.KeepAlive(readback);
+	auto compose = graph.AddPass("Compose", nullptr);
+	graph.Read(compose, scene, ResourceState::ShaderResource);
+	graph.Write(compose, output, ResourceState::RenderTarget);
+	graph.Compile();
+
+	CHECK(!graph.IsCulled(drawScene));
+	CHECK(graph.IsCulled(drawUnused));
+	CHECK(!graph.IsCulled(readback));
+	CHECK(graph.Schedule() == std::vector<uint32_t>({ drawScene, readback, compose }));
+	CHECK(graph.Statistics().culledPassCount == 1);
+	CHECK(graph.Statistics().transientTextureCount == 2);
+
+	// the back buffer is left in its final state after the execution.
+	ResourceStateTracker tracker;
+	tracker.Register(&backBuffer, 1, ResourceState::Present);
+	graph.Execute(tracker);
+	CHECK(tracker.State(&backBuffer) == ResourceState::Present);
+	CHECK(tracker.State(graph.Texture(scene)) == ResourceState::ShaderResource);
+
+	// a transient texture must be written before it is read.
+	graph.Reset();
+	auto texture = graph.CreateTexture("Texture", SmallTexture);
+	auto pass = graph.AddPass("Pass", nullptr);
+	graph.Read(pass, texture, ResourceState::ShaderResource);
+	graph.KeepAlive(pass);
+	CHECK_THROWS(graph.Compile(), std::logic_error);
+	CHECK_THROWS(graph.Execute(tracker), std::logic_error);
+}
+
+// ============================================================================
+// Declare a chain of passes where the first and the last texture alias.
+//
+// The first texture is dead once the second pass has read it, so the third
+// texture is placed over it while the second texture is still alive.
+// ============================================================================
+void DeclareChain(RenderGraph& graph, void* backBuffer, const TextureDesc& firstDesc, uint32_t textures[3])
+{
+	graph.Reset();
+	auto output = graph.ImportTexture("BackBuffer", backBuffer, ResourceState::Present);
+	textures[0] = graph.CreateTexture("First", firstDesc);
+	textures[1] = graph.CreateTexture("Second", SmallTexture);
+	textures[2] = graph.CreateTexture("Third", SmallTexture);
+	auto first = graph.AddPass("First", nullptr);
+	graph.Write(first, textures[0], ResourceState::RenderTarget);
+	auto second = graph.AddPass("Second", nullptr);
+	graph.Read(second, textures[0], ResourceState::ShaderResource);
+	graph.Write(second, textures[1], ResourceState::RenderTarget);
+	auto third = graph.AddPass("Third", nullptr);
+	graph.Read(third, textures[1], ResourceState::ShaderResource);
+	graph.Write(third, textures[2], ResourceState::RenderTarget);
+	auto compose = graph.AddPass("Compose", nullptr);
+	graph.Read(compose, textures[2], ResourceState::ShaderResource);
+	graph.Write(compose, output, ResourceState::RenderTarget);
+	graph.Compile();
+}
+
+// ============================================================================
+// Textures with disjoint lifetimes share memory and are activated on use.
+// ============================================================================
+void TestAliasing()
+{
+	NullRenderGraphBackend backend;
+	RenderGraph graph(backend);
+	ResourceStateTracker tracker;
+	int backBuffer = 0;
+	tracker.Register(&backBuffer, 1, ResourceState::Present);
+	uint32_t textures[3];
+	const TextureDesc firstDesc = { 32, 32, TextureFormat::BGRA8 };
+	DeclareChain(graph, &backBuffer, firstDesc, textures);
+	CHECK(graph.TransientOffset(textures[0]) == graph.TransientOffset(textures[2]));
+	CHECK(graph.TransientOffset(textures[1]) != graph.TransientOffset(textures[0]));
+	CHECK(graph.Statistics().transientBytes == 3 * 4096);
+	CHECK(graph.Statistics().aliasedBytes == 2 * 4096);
+
+	// only the texture placed over the memory of another one is activated in the first frame.
+	graph.Execute(tracker);
+	CHECK(backend.ReservedBytes() == 2 * 4096);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[0])) == 0);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[1])) == 0);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[2])) == 1);
+
+	// the next frame activates the first texture again over the memory of the third one.
+	backend.mBarriers.clear();
+	DeclareChain(graph, &backBuffer, firstDesc, textures);
+	graph.Execute(tracker);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[0])) == 1);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[1])) == 0);
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[2])) == 1);
+
+	// textures with the same description at the same offset share a texture that needs no activation.
+	backend.mBarriers.clear();
+	DeclareChain(graph, &backBuffer, SmallTexture, textures);
+	graph.Execute(tracker);
+	CHECK(graph.Texture(textures[0]) == graph.Texture(textures[2]));
+	CHECK(backend.AliasingBarriers(graph.Texture(textures[0])) == 0);
+}
+
+// ============================================================================
+// A texture created again over memory that was used before is activated.
+//
+// This happens e.g. when the dynamic resolution changes the size of a texture
+// and the backend creates a new placed texture at the same offset.
+// ============================================================================
+void TestRecreatedTexture()
+{
+	NullRenderGraphBackend backend;
+	RenderGraph graph(backend);
+	ResourceStateTracker tracker;
+	int backBuffer = 0;
+	tracker.Register(&backBuffer, 1, ResourceState::Present);
+	auto declare = [&](const TextureDesc& desc) {
+		graph.Reset();
+		auto output = graph.ImportTexture("BackBuffer", &backBuffer, ResourceState::Present);
+		auto scene = graph.CreateTexture("Scene", desc);
+		auto draw = graph.AddPass("Draw", nullptr);
+		graph.Write(draw, scene, ResourceState::RenderTarget);
+		auto upscale = graph.AddPass("Upscale", nullptr);
+		graph.Read(upscale, scene, ResourceState::ShaderResource);
+		graph.Write(upscale, output, ResourceState::RenderTarget);
+		graph.Compile();
+		graph.Execute(tracker);
+		return graph.Texture(scene);
+	};
+	auto full = declare({ 64, 64, TextureFormat::RGBA8 });
+	CHECK(backend.AliasingBarriers(full) == 0);
+	CHECK(declare({ 64, 64, TextureFormat::RGBA8 }) == full);
+	CHECK(backend.AliasingBarriers(full) == 0);
+
+	// the smaller texture takes the same offset as a new texture.
+	auto scaled = declare({ 48, 48, TextureFormat::RGBA8 });
+	CHECK(scaled != full);
+	CHECK(backend.AliasingBarriers(scaled) == 1);
+	CHECK(tracker.State(scaled) == ResourceState::ShaderResource);
+
+	// going back to the full size texture activates it again over the scaled one.
+	CHECK(declare({ 64, 64, TextureFormat::RGBA8 }) == full);
+	CHECK(backend.AliasingBarriers(full) == 1);
+}
+
+int main()
+{
+	TestCulling();
+	TestAliasing();
+	TestRecreatedTexture();
+	return TestResult("render_graph_test");
+}
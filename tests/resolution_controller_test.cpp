@@ -0,0 +1,155 @@
+#include "resolution_controller.h"
+#include "test_utils.h"
+
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// the tuning of the renderer with a 15 ms budget and two frames in flight.
+const ResolutionControllerDesc Tuning = { 15.0, 0.5f, 1.f, 0.05f, 0.75, 1.0, 30, 2, 2 };
+
+// ============================================================================
+// The results of a trace replayed through a controller.
+// ============================================================================
+struct ReplayResult
+{
+	unsigned			overBudgetFrames;
+	unsigned			changeCount;
+	std::vector<float>	scales;
+};
+
+// ============================================================================
+// Replay a trace of the frame times measured at the full resolution.
+//
+// The frame time at a scale follows the pixel count, and the measurement of
+// a frame reaches the controller after the frames in flight like on the GPU.
+// ============================================================================
+ReplayResult Replay(ResolutionController& controller, const std::vector<double>& trace, unsigned latency)
+{
+	ReplayResult result = {};
+	std::deque<double> inFlight;
+	for (auto frame : trace) {
+		auto scale = controller.Scale();
+		auto measured = frame * scale * scale;
+		result.overBudgetFrames += (measured > Tuning.budgetMilliseconds) ? 1 : 0;
+		result.scales.push_back(scale);
+		inFlight.push_back(measured);
+		if (inFlight.size() > latency) {
+			controller.Update(inFlight.front());
+			inFlight.pop_front();
+		}
+	}
+	result.changeCount = controller.ChangeCount();
+	return result;
+}
+
+// ============================================================================
+// Invalid tunings are rejected.
+// ============================================================================
+void TestInvalidTuning()
+{
+	auto tuning = Tuning;
+	tuning.scaleStep = 0.f;
+	CHECK_THROWS(ResolutionController controller(tuning), std::invalid_argument);
+	tuning = Tuning;
+	tuning.minimumScale = 1.5f;
+	CHECK_THROWS(ResolutionController controller(tuning), std::invalid_argument);
+	tuning = Tuning;
+	tuning.lowerThreshold = tuning.upperThreshold;
+	CHECK_THROWS(ResolutionController controller(tuning), std::invalid_argument);
+	tuning = Tuning;
+	tuning.decreaseDelay = 0;
+	CHECK_THROWS(ResolutionController controller(tuning), std::invalid_argument);
+}
+
+// ============================================================================
+// The scale changes after the delays and ignores the frames that settle.
+// ============================================================================
+void TestHysteresis()
+{
+	ResolutionController controller(Tuning);
+	CHECK(controller.Scale() == 1.f);
+	CHECK(controller.Update(0.0) == 1.f);
+
+	// a frame within the band resets the delay of the frames over the budget.
+	CHECK(controller.Update(18.0) == 1.f);
+	CHECK(controller.Update(14.0) == 1.f);
+	CHECK(controller.Update(18.0) == 1.f);
+
+	// the second frame in a row over the budget aims the time at the middle of the band.
+	auto scale = controller.Update(18.0);
+	CHECK(scale < 1.f && scale >= 0.85f - 1e-6f && scale <= 0.85f + 1e-6f);
+	CHECK(controller.ChangeCount() == 1);
+
+	// the frames in flight during the change are ignored.
+	CHECK(controller.Update(40.0) == scale);
+	CHECK(controller.Update(40.0) == scale);
+	CHECK(controller.Update(40.0) == scale);
+	CHECK(controller.Update(40.0) < scale);
+	CHECK(controller.ChangeCount() == 2);
+
+	// a long overload stops at the minimum scale.
+	for (auto i = 0; i < 20; i++) {
+		controller.Update(100.0);
+	}
+	CHECK(controller.Scale() == Tuning.minimumScale);
+	unsigned width, height;
+	controller.RenderSize(1920, 1080, width, height);
+	CHECK(width == 960 && height == 540);
+
+	// the scale only grows after the frames stayed under the lower threshold for the whole delay.
+	auto changes = controller.ChangeCount();
+	for (auto i = 1u; i < Tuning.increaseDelay; i++) {
+		controller.Update(5.0);
+	}
+	CHECK(controller.ChangeCount() == changes && controller.Scale() == Tuning.minimumScale);
+	CHECK(controller.Update(5.0) > Tuning.minimumScale);
+
+	controller.Reset();
+	CHECK(controller.Scale() == 1.f);
+}
+
+// ============================================================================
+// Recorded traces are kept within the budget without oscillating.
+// ============================================================================
+void TestTraces()
+{
+	std::mt19937 random(21);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	std::vector<double> overload, spikes, noisy, recovery;
+	for (auto i = 0; i < 3000; i++) {
+		overload.push_back(24.0 + noise(random));
+		spikes.push_back((i % 250 == 100) ? 40.0 : 11.0 + 0.5 * noise(random));
+		noisy.push_back(13.0 + 0.5 * noise(random));
+		recovery.push_back((i < 1000) ? 24.0 + noise(random) : 9.0 + 0.5 * noise(random));
+	}
+
+	// a constant overload settles at a scale which fits the budget with few changes.
+	ResolutionController overloadController(Tuning);
+	auto result = Replay(overloadController, overload, Tuning.settleFrames);
+	CHECK(result.overBudgetFrames < 100);
+	CHECK(result.changeCount <= 6);
+	CHECK(result.scales.back() < 0.8f && result.scales.back() >= 0.7f);
+
+	// single frame spikes and a noisy load within the band never change the scale.
+	ResolutionController spikesController(Tuning);
+	CHECK(Replay(spikesController, spikes, Tuning.settleFrames).changeCount == 0);
+	ResolutionController noisyController(Tuning);
+	CHECK(Replay(noisyController, noisy, Tuning.settleFrames).changeCount == 0);
+
+	// the full resolution returns after the load drops.
+	ResolutionController recoveryController(Tuning);
+	result = Replay(recoveryController, recovery, Tuning.settleFrames);
+	CHECK(result.scales[999] < 0.8f);
+	CHECK(result.scales.back() == 1.f);
+	CHECK(result.changeCount <= 8);
+}
+
+int main()
+{
+	TestInvalidTuning();
+	TestHysteresis();
+	TestTraces();
+	return TestResult("resolution_controller_test");
+}
@@ -0,0 +1,112 @@
+#include "resource_state_tracker.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+
+// ============================================================================
+// Repeated and cancelling transitions are merged or dropped from the batch.
+// ============================================================================
+void TestMergedTransitions()
+{
+	ResourceStateTracker tracker;
+	int backBuffer = 0;
+	tracker.Register(&backBuffer, 1, ResourceState::Present);
+	std::vector<ResourceBarrier> barriers;
+
+	tracker.Transition(&backBuffer, ResourceState::RenderTarget);
+	tracker.Transition(&backBuffer, ResourceState::RenderTarget);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 1);
+	CHECK(barriers[0].type == ResourceBarrier::Type::Transition && barriers[0].subresource == ALL_SUBRESOURCES);
+	CHECK(barriers[0].before == ResourceState::Present && barriers[0].after == ResourceState::RenderTarget);
+	CHECK(!tracker.HasPendingBarriers());
+
+	// a transition away and back again cancels out.
+	barriers.clear();
+	tracker.Transition(&backBuffer, ResourceState::Present);
+	tracker.Transition(&backBuffer, ResourceState::RenderTarget);
+	tracker.Flush(barriers);
+	CHECK(barriers.empty());
+
+	// present and common are the same state, so moving between them needs no barrier.
+	tracker.Transition(&backBuffer, ResourceState::Present);
+	tracker.Flush(barriers);
+	barriers.clear();
+	tracker.Transition(&backBuffer, ResourceState::Common);
+	tracker.Flush(barriers);
+	CHECK(barriers.empty());
+	CHECK(tracker.State(&backBuffer) == ResourceState::Common);
+	CHECK_THROWS(tracker.Transition(&barriers, ResourceState::Common), std::invalid_argument);
+}
+
+// ============================================================================
+// Read-only states are combined and subresources get their own barriers.
+// ============================================================================
+void TestSubresources()
+{
+	ResourceStateTracker tracker;
+	int texture = 0;
+	tracker.Register(&texture, 4, ResourceState::RenderTarget);
+	std::vector<ResourceBarrier> barriers;
+
+	tracker.Transition(&texture, ResourceState::ShaderResource, 2);
+	tracker.Transition(&texture, ResourceState::CopySource, 2);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 1 && barriers[0].subresource == 2);
+	CHECK(barriers[0].after == (ResourceState::ShaderResource | ResourceState::CopySource));
+
+	// the subresource already readable as a shader resource needs no barrier.
+	barriers.clear();
+	tracker.Transition(&texture, ResourceState::ShaderResource);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 3);
+	for (auto& barrier : barriers) {
+		CHECK(barrier.subresource != 2 && barrier.after == ResourceState::ShaderResource);
+	}
+
+	// once the subresources are in the same state, the whole resource gets a single barrier.
+	barriers.clear();
+	tracker.Transition(&texture, ResourceState::RenderTarget);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 4);
+	barriers.clear();
+	tracker.Transition(&texture, ResourceState::ShaderResource);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 1 && barriers[0].subresource == ALL_SUBRESOURCES);
+}
+
+// ============================================================================
+// Writes in the unordered access state are separated by their own barriers.
+// ============================================================================
+void TestUnorderedAccess()
+{
+	ResourceStateTracker tracker;
+	int buffer = 0, other = 0;
+	tracker.Register(&buffer, 1, ResourceState::CopyDest);
+	tracker.Register(&other, 1, ResourceState::CopyDest);
+	std::vector<ResourceBarrier> barriers;
+	tracker.Transition(&buffer, ResourceState::UnorderedAccess);
+	tracker.Transition(&buffer, ResourceState::UnorderedAccess);
+	tracker.Transition(&other, ResourceState::VertexBuffer);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 3);
+	CHECK(barriers[0].type == ResourceBarrier::Type::Transition && barriers[0].after == ResourceState::UnorderedAccess);
+	CHECK(barriers[1].type == ResourceBarrier::Type::UnorderedAccess && barriers[1].resource == &buffer);
+	CHECK(barriers[2].resource == &other);
+
+	// unregistering a resource drops its queued barriers.
+	barriers.clear();
+	tracker.Transition(&buffer, ResourceState::CopySource);
+	tracker.Transition(&other, ResourceState::CopySource);
+	tracker.Unregister(&buffer);
+	tracker.Flush(barriers);
+	CHECK(barriers.size() == 1 && barriers[0].resource == &other);
+}
+
+int main()
+{
+	TestMergedTransitions();
+	TestSubresources();
+	TestUnorderedAccess();
+	return TestResult("resource_state_tracker_test");
+}
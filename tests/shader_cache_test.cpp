@@ -0,0 +1,121 @@
+#include "shader_cache.h"
+#include "test_utils.h"
+
+#include <sstream>
+
+// ============================================================================
+// A compiler that derives the bytecode from the entry point and counts calls.
+// ============================================================================
+class StubCompiler : public ShaderCompiler
+{
+public:
+	ShaderBytecode Compile(const ShaderSource& source) override
+	{
+		mCompileCount++;
+		return ShaderBytecode(source.entryPoint.begin(), source.entryPoint.end());
+	}
+	unsigned CompileCount() const { return mCompileCount; }
+private:
+	unsigned mCompileCount = 0;
+};
+
+// the shader programs used by the tests.
+const ShaderSource VertexShader = { "float4 main() {}", "VSMain", "vs_5_0", 0 };
+const ShaderSource PixelShader = { "float4 main() {}", "PSMain", "ps_5_0", 0 };
+
+// ============================================================================
+// Write a cache file with both of the test shaders.
+// ============================================================================
+std::string SavedCache()
+{
+	StubCompiler compiler;
+	ShaderCache cache(compiler);
+	cache.GetOrCompile(VertexShader);
+	cache.GetOrCompile(PixelShader);
+	std::ostringstream stream;
+	cache.Save(stream);
+	return stream.str();
+}
+
+// ============================================================================
+// The key separates the fields and the compiler only runs on a miss.
+// ============================================================================
+void TestKeysAndMisses()
+{
+	CHECK(ShaderCache::Key(VertexShader) != ShaderCache::Key(PixelShader));
+	CHECK(ShaderCache::Key({ "a", "bc", "", 0 }) != ShaderCache::Key({ "a", "b", "c", 0 }));
+	CHECK(ShaderCache::Key({ "a", "b", "c", 0 }) != ShaderCache::Key({ "a", "b", "c", 1 }));
+
+	StubCompiler compiler;
+	ShaderCache cache(compiler);
+	CHECK(!cache.IsDirty());
+	CHECK(cache.GetOrCompile(VertexShader) == ShaderBytecode({ 'V', 'S', 'M', 'a', 'i', 'n' }));
+	cache.GetOrCompile(VertexShader);
+	CHECK(compiler.CompileCount() == 1);
+	CHECK(cache.MissCount() == 1 && cache.HitCount() == 1);
+	CHECK(cache.IsDirty());
+
+	// embedded blobs are hits, but they are not saved into the file.
+	const uint8_t blob[] = { 1, 2, 3 };
+	EmbeddedShader embedded = { ShaderCache::Key(PixelShader), blob, sizeof(blob) };
+	cache.AddEmbedded(&embedded, 1);
+	CHECK(cache.GetOrCompile(PixelShader) == ShaderBytecode({ 1, 2, 3 }));
+	CHECK(compiler.CompileCount() == 1);
+	CHECK(cache.Entries().size() == 1);
+}
+
+// ============================================================================
+// A saved cache is loaded back without compiling anything.
+// ============================================================================
+void TestRoundTrip()
+{
+	StubCompiler compiler;
+	ShaderCache cache(compiler);
+	std::istringstream stream(SavedCache());
+	CHECK(cache.Load(stream));
+	CHECK(cache.Entries().size() == 2);
+	CHECK(cache.GetOrCompile(PixelShader) == ShaderBytecode({ 'P', 'S', 'M', 'a', 'i', 'n' }));
+	CHECK(compiler.CompileCount() == 0);
+	CHECK(!cache.IsDirty());
+}
+
+// ============================================================================
+// Corrupt files are rejected as a whole and then compiled as cache misses.
+// ============================================================================
+void TestCorruptFiles()
+{
+	auto saved = SavedCache();
+	auto patched = [&](size_t offset, uint32_t value) {
+		auto data = saved;
+		data.replace(offset, sizeof(value), reinterpret_cast<const char*>(&value), sizeof(value));
+		return data;
+	};
+	std::vector<std::string> files = {
+		"",
+		saved.substr(0, 8),
+		saved.substr(0, saved.size() - 1),
+		patched(0, 0),					// magic
+		patched(4, 2),					// version
+		patched(8, 3),					// count
+		patched(20, 0xffffffffu),		// size of the first entry
+		patched(20, 0x7fffffffu),		// size of the first entry
+		patched(24, 0),					// checksum of the first entry
+	};
+	for (auto& file : files) {
+		StubCompiler compiler;
+		ShaderCache cache(compiler);
+		std::istringstream stream(file);
+		CHECK(!cache.Load(stream));
+		CHECK(cache.Entries().empty());
+		cache.GetOrCompile(VertexShader);
+		CHECK(compiler.CompileCount() == 1);
+	}
+}
+
+int main()
+{
+	TestKeysAndMisses();
+	TestRoundTrip();
+	TestCorruptFiles();
+	return TestResult("shader_cache_test");
+}
@@ -0,0 +1,181 @@
+#include "simulation.h"
+#include "test_utils.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+// the step duration of the tests, 60 steps per second.
+const uint64_t StepNanoseconds = 16666667;
+
+// ============================================================================
+// Steps are due at multiples of the step and the excess steps are dropped.
+// ============================================================================
+void TestFixedTimestep()
+{
+	CHECK_THROWS(FixedTimestep(0, 4), std::invalid_argument);
+	CHECK_THROWS(FixedTimestep(StepNanoseconds, 0), std::invalid_argument);
+	FixedTimestep timestep(1000, 4);
+	timestep.Reset(500);
+	CHECK(timestep.Advance(1499) == 0);
+	CHECK(timestep.Advance(1500) == 1);
+	CHECK(timestep.NextStepTime() == 2500 && timestep.LastStepTime() == 1500);
+	CHECK(timestep.Alpha(1500) == 0.0);
+	CHECK(timestep.Alpha(2000) == 0.5);
+	CHECK(timestep.Alpha(9000) == 1.0);
+	CHECK(timestep.Advance(4700) == 3);
+	CHECK(timestep.NextStepTime() == 5500);
+
+	// a stall only runs the maximum amount of steps and keeps the phase.
+	CHECK(timestep.Advance(15600) == 4);
+	CHECK(timestep.DroppedStepCount() == 7);
+	CHECK(timestep.StepCount() == 8);
+	CHECK(timestep.NextStepTime() == 16500);
+}
+
+// ============================================================================
+// The reader always gets the latest published value and only new ones.
+// ============================================================================
+void TestTripleBuffer()
+{
+	TripleBuffer<int> buffer;
+	CHECK(!buffer.Update());
+	buffer.Back() = 1;
+	buffer.Publish();
+	buffer.Back() = 2;
+	buffer.Publish();
+	CHECK(buffer.Update());
+	CHECK(buffer.Front() == 2);
+	CHECK(!buffer.Update());
+	CHECK(buffer.Front() == 2);
+	buffer.Back() = 3;
+	buffer.Publish();
+	CHECK(buffer.Update());
+	CHECK(buffer.Front() == 3);
+}
+
+// ============================================================================
+// A reader racing the writer only sees complete values in increasing order.
+// ============================================================================
+void TestTripleBufferThreads()
+{
+	struct Value
+	{
+		uint64_t	sequence;
+		uint64_t	check;
+	};
+	const uint64_t count = 200000;
+	TripleBuffer<Value> buffer;
+	buffer.Back() = { 0, ~0ull };
+	std::thread writer([&] {
+		for (auto i = 1ull; i <= count; i++) {
+			auto& value = buffer.Back();
+			value.sequence = i;
+			value.check = ~i;
+			buffer.Publish();
+		}
+	});
+	auto last = 0ull;
+	auto torn = 0u, backwards = 0u;
+	while (last != count) {
+		if (buffer.Update()) {
+			auto value = buffer.Front();
+			torn += value.check != ~value.sequence;
+			backwards += value.sequence <= last;
+			last = value.sequence;
+		}
+	}
+	writer.join();
+	CHECK(torn == 0);
+	CHECK(backwards == 0);
+	CHECK(!buffer.Update());
+}
+
+// ============================================================================
+// A stopped simulation runs the due steps and publishes the last two states.
+// ============================================================================
+void TestSimulationTicks()
+{
+	SimulatedClock clock(1000);
+	auto updates = 0u;
+	Simulation simulation(clock, StepNanoseconds, 5, { 0.f }, [&](SceneState& state, double deltaSeconds) {
+		state.rotation += static_cast<float>(deltaSeconds);
+		updates++;
+	});
+	SceneSnapshot snapshot;
+	CHECK(simulation.Tick() == 0);
+	CHECK(!simulation.Latest(snapshot));
+
+	clock.Advance(StepNanoseconds);
+	CHECK(simulation.Tick() == 1);
+	CHECK(simulation.Latest(snapshot));
+	CHECK(snapshot.step == 1 && snapshot.time == 1000 + StepNanoseconds);
+	CHECK(snapshot.previous.rotation == 0.f);
+	CHECK(std::fabs(snapshot.current.rotation - StepNanoseconds / 1e9f) < 1e-6f);
+
+	// a frame that took three steps publishes only the state after the last two.
+	clock.Advance(3 * StepNanoseconds + StepNanoseconds / 2);
+	CHECK(simulation.Tick() == 3);
+	CHECK(simulation.Latest(snapshot));
+	CHECK(snapshot.step == 4 && updates == 4);
+	CHECK(std::fabs(snapshot.current.rotation - 4 * StepNanoseconds / 1e9f) < 1e-6f);
+	CHECK(std::fabs(snapshot.previous.rotation - 3 * StepNanoseconds / 1e9f) < 1e-6f);
+
+	// the scene is presented between the two states with the time since the last step.
+	auto state = Interpolate(snapshot, clock.Now(), StepNanoseconds);
+	CHECK(std::fabs(state.rotation - 3.5f * StepNanoseconds / 1e9f) < 1e-6f);
+
+	// a long stall drops the steps beyond the maximum.
+	clock.Advance(20 * StepNanoseconds);
+	CHECK(simulation.Tick() == 5);
+	CHECK(simulation.Timestep().DroppedStepCount() == 15);
+}
+
+// ============================================================================
+// Rotation is interpolated along the shorter arc across the full turn.
+// ============================================================================
+void TestInterpolationWrap()
+{
+	SceneSnapshot snapshot = { { 6.2f }, { 0.1f }, 1000, 2 };
+	auto state = Interpolate(snapshot, 1000 + StepNanoseconds / 2, StepNanoseconds);
+	auto expected = 6.2f + (0.1f + 6.28318531f - 6.2f) / 2.f - 6.28318531f;
+	CHECK(std::fabs(state.rotation - expected) < 1e-5f);
+	CHECK(Interpolate(snapshot, 0, StepNanoseconds).rotation == 6.2f);
+	CHECK(std::fabs(Interpolate(snapshot, 1000 + 2 * StepNanoseconds, StepNanoseconds).rotation - 0.1f) < 1e-5f);
+}
+
+// ============================================================================
+// The loop thread keeps stepping with a simulated clock until it is stopped.
+// ============================================================================
+void TestSimulationThread()
+{
+	SimulatedClock clock;
+	Simulation simulation(clock, StepNanoseconds, 5, { 0.f }, [](SceneState& state, double) { state.rotation += 1.f; });
+	simulation.Start();
+	SceneSnapshot snapshot;
+	auto last = 0ull;
+	auto backwards = 0u, inconsistent = 0u;
+	while (last < 1000) {
+		if (simulation.Latest(snapshot)) {
+			backwards += snapshot.step < last;
+			inconsistent += snapshot.current.rotation != snapshot.step || snapshot.previous.rotation + 1.f != snapshot.current.rotation;
+			last = snapshot.step;
+		}
+	}
+	simulation.Stop();
+	CHECK(backwards == 0);
+	CHECK(inconsistent == 0);
+	CHECK(clock.SleepCount() >= 1000);
+	CHECK(simulation.PublishedStep() == simulation.Timestep().StepCount());
+}
+
+int main()
+{
+	TestFixedTimestep();
+	TestTripleBuffer();
+	TestTripleBufferThreads();
+	TestSimulationTicks();
+	TestInterpolationWrap();
+	TestSimulationThread();
+	return TestResult("simulation_test");
+}
@@ -0,0 +1,111 @@
+#include "software_renderer.h"
+#include "test_utils.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// the size of the rendered frames, which is not a multiple of the tile size or of four pixels.
+const unsigned Width = 317;
+const unsigned Height = 203;
+
+// ============================================================================
+// Generate the application triangle with a deterministic set of triangles.
+//
+// The triangles overlap each other and the tile borders, and some of them
+// are back facing or outside the guard band, so that they are culled.
+// ============================================================================
+std::vector<Vertex> GenerateScene()
+{
+	auto vertices = TriangleVertices();
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-1.2f, 1.2f), size(0.02f, 0.4f), color(0.f, 1.f), angle(0.f, 6.2831853f);
+	for (auto i = 0; i < 500; i++) {
+		auto x = position(random), y = position(random), r = size(random), a = angle(random);
+		auto direction = (i % 7 == 0) ? 1.f : -1.f;
+		for (auto j = 0; j < 3; j++) {
+			auto corner = a + direction * j * 2.0943951f;
+			vertices.push_back({ { x + r * std::cos(corner), y + r * std::sin(corner), 0.f }, { color(random), color(random), color(random), 1.f } });
+		}
+	}
+	vertices.push_back({ { 0.f, 3.f, 0.f }, { 1.f, 1.f, 1.f, 1.f } });
+	vertices.push_back({ { 0.5f, 0.f, 0.f }, { 1.f, 1.f, 1.f, 1.f } });
+	vertices.push_back({ { -0.5f, 0.f, 0.f }, { 1.f, 1.f, 1.f, 1.f } });
+	return vertices;
+}
+
+// ============================================================================
+// Render a few frames of the vertices and get the pixels of the last frame.
+// ============================================================================
+std::vector<uint8_t> Render(const std::vector<Vertex>& vertices, unsigned threadCount, unsigned frameLatency)
+{
+	SoftwareRenderer renderer(threadCount, frameLatency);
+	renderer.SetWindow(Width, Height);
+	renderer.SetGeometry(vertices);
+	for (auto i = 0; i < 4; i++) {
+		renderer.Render();
+	}
+	renderer.WaitForGPU();
+	CHECK(renderer.Width() == Width && renderer.Height() == Height && renderer.Pitch() == 320 * 4);
+	return renderer.Framebuffer();
+}
+
+// a helper to get the pixel at the given normalized device coordinates.
+const uint8_t* PixelAt(const std::vector<uint8_t>& pixels, float x, float y)
+{
+	auto column = static_cast<unsigned>((x * 0.5f + 0.5f) * Width);
+	auto row = static_cast<unsigned>((0.5f - y * 0.5f) * Height);
+	return &pixels[row * 320 * 4 + column * 4];
+}
+
+// a helper to check that a pixel has the expected color within a rounding tolerance.
+bool HasColor(const uint8_t* pixel, int r, int g, int b, int tolerance)
+{
+	return std::abs(pixel[0] - r) <= tolerance && std::abs(pixel[1] - g) <= tolerance && std::abs(pixel[2] - b) <= tolerance && pixel[3] == 255;
+}
+
+// ============================================================================
+// The application triangle is interpolated between its vertex colors.
+// ============================================================================
+void TestKnownPixels()
+{
+	auto pixels = Render(TriangleVertices(), 4, 2);
+	CHECK(HasColor(PixelAt(pixels, -0.99f, 0.99f), 0, 0, 0, 0));
+	CHECK(HasColor(PixelAt(pixels, 0.99f, -0.99f), 0, 0, 0, 0));
+	CHECK(HasColor(PixelAt(pixels, 0.4f, 0.4f), 0, 0, 0, 0));
+	CHECK(HasColor(PixelAt(pixels, 0.f, 0.f), 128, 64, 64, 4));
+	CHECK(HasColor(PixelAt(pixels, 0.f, 0.45f), 242, 6, 6, 4));
+	CHECK(HasColor(PixelAt(pixels, 0.f, -0.45f), 13, 121, 121, 4));
+
+	// a counter-clockwise triangle is back facing and leaves the frame cleared.
+	auto vertices = TriangleVertices();
+	std::swap(vertices[1], vertices[2]);
+	pixels = Render(vertices, 4, 2);
+	CHECK(HasColor(PixelAt(pixels, 0.f, 0.f), 0, 0, 0, 0));
+}
+
+// ============================================================================
+// The pixels are identical byte for byte with any thread count and latency.
+// ============================================================================
+void TestThreadCounts()
+{
+	auto vertices = GenerateScene();
+	auto reference = Render(vertices, 1, 1);
+	auto covered = 0u;
+	for (size_t i = 0; i < reference.size(); i += 4) {
+		covered += (reference[i] | reference[i + 1] | reference[i + 2]) != 0;
+	}
+	CHECK(covered > Width * Height / 4);
+	CHECK(Render(vertices, 2, 1) == reference);
+	CHECK(Render(vertices, 2, 3) == reference);
+	CHECK(Render(vertices, 8, 2) == reference);
+	CHECK(Render(vertices, 16, 1) == reference);
+}
+
+int main()
+{
+	TestKnownPixels();
+	TestThreadCounts();
+	return TestResult("software_renderer_test");
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdio>
+
+// ============================================================================
+// Check a condition and report it with its location in case it fails.
+// ============================================================================
+#define CHECK(condition) CheckCondition((condition), #condition, __FILE__, __LINE__)
+
+// ============================================================================
+// Check that an expression throws an exception of the given type.
+// ============================================================================
+#define CHECK_THROWS(expression, exception) \
+	do { \
+		auto thrown = false; \
+		try { expression; } catch (const exception&) { thrown = true; } \
+		CheckCondition(thrown, #expression " throws " #exception, __FILE__, __LINE__); \
+	} while (false)
+
+// ============================================================================
+// Get the amount of failed checks of the test program.
+// ============================================================================
+inline unsigned& FailureCount()
+{
+	static unsigned count = 0;
+	return count;
+}
+
+// ============================================================================
+// Count and print a failed check.
+// ============================================================================
+inline void CheckCondition(bool passed, const char* condition, const char* file, int line)
+{
+	if (!passed) {
+		std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+		FailureCount()++;
+	}
+}
+
+// ============================================================================
+// Print the result of the test program and get the exit code for it.
+// ============================================================================
+inline int TestResult(const char* name)
+{
+	if (FailureCount() != 0) {
+		std::printf("%s: %u checks failed\n", name, FailureCount());
+		return 1;
+	}
+	std::printf("%s: ok\n", name);
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include "upload_ring.h"
+#include "test_utils.h"
+
+#include <stdexcept>
+#include <vector>
+
+// ============================================================================
+// Allocations are aligned and wrap to the start by waiting the oldest frame.
+// ============================================================================
+void TestWraparound()
+{
+	SimulatedTimeline timeline;
+	std::vector<uint8_t> memory(1024);
+	UploadRing ring(timeline, memory.data(), 0x10000, 1024);
+	auto first = ring.Allocate(100, 1);
+	CHECK(first.offset == 0 && first.cpuAddress == memory.data() && first.gpuAddress == 0x10000);
+	CHECK(ring.Allocate(10, 256).offset == 256);
+	ring.EndFrame(timeline.Signal());
+	CHECK(ring.Allocate(500, 256).offset == 512);
+	ring.EndFrame(timeline.Signal());
+	CHECK(ring.UsedBytes() == 1012);
+
+	// the block does not fit the end, so the skipped end is spent and the first frame waited.
+	auto wrapped = ring.Allocate(200, 4);
+	CHECK(wrapped.offset == 0);
+	CHECK(ring.WaitCount() == 1 && timeline.StallCount() == 1);
+	CHECK(ring.UsedBytes() == 1024 + 200 - 266);
+	ring.EndFrame(timeline.Signal());
+
+	// completed frames are reclaimed without waiting.
+	timeline.Advance(2);
+	ring.Reclaim();
+	CHECK(ring.UsedBytes() == 0);
+	CHECK(ring.WaitCount() == 1);
+}
+
+// ============================================================================
+// An empty ring uses its whole capacity wherever the previous frame ended.
+// ============================================================================
+void TestEmptyRingRestarts()
+{
+	SimulatedTimeline timeline;
+	std::vector<uint8_t> memory(100);
+	UploadRing ring(timeline, memory.data(), 0, 100);
+	ring.Allocate(50, 1);
+	ring.EndFrame(timeline.Signal());
+	timeline.Advance();
+	ring.Reclaim();
+	CHECK(ring.UsedBytes() == 0);
+	CHECK(ring.Allocate(60, 1).offset == 0);
+	CHECK(ring.WaitCount() == 0);
+	ring.EndFrame(timeline.Signal());
+	timeline.Advance();
+	ring.Reclaim();
+	CHECK(ring.Allocate(100, 1).offset == 0);
+}
+
+// ============================================================================
+// Allocations that can never fit and misaligned requests are rejected.
+// ============================================================================
+void TestErrors()
+{
+	SimulatedTimeline timeline;
+	std::vector<uint8_t> memory(1024);
+	CHECK_THROWS(UploadRing(timeline, memory.data(), 0, 0), std::invalid_argument);
+	UploadRing ring(timeline, memory.data(), 0, 1024);
+	CHECK_THROWS(ring.Allocate(16, 3), std::invalid_argument);
+	CHECK_THROWS(ring.Allocate(2000, 1), std::length_error);
+
+	// a single frame needing more than the ring can never be satisfied.
+	ring.Allocate(800, 1);
+	CHECK_THROWS(ring.Allocate(800, 1), std::length_error);
+}
+
+// ============================================================================
+// An allocation never overlaps the memory of the frames still on the GPU.
+// ============================================================================
+void TestFenceReclaim()
+{
+	struct Live
+	{
+		uint64_t	offset;
+		uint64_t	size;
+		uint64_t	fenceValue;
+	};
+	SimulatedTimeline timeline;
+	std::vector<uint8_t> memory(1024);
+	UploadRing ring(timeline, memory.data(), 0, 1024);
+	std::vector<Live> live, frame;
+	auto overlaps = 0u, misaligned = 0u;
+	for (auto i = 0u; i < 10000; i++) {
+		for (auto j = 0u; j < 3; j++) {
+			auto allocation = ring.Allocate(16 + (i * 7 + j * 13) % 200, 16);
+			misaligned += (allocation.offset % 16 != 0 || allocation.offset + allocation.size > 1024) ? 1 : 0;
+			for (auto& other : live) {
+				if (other.fenceValue > timeline.CompletedValue() && allocation.offset < other.offset + other.size && other.offset < allocation.offset + allocation.size) {
+					overlaps++;
+				}
+			}
+			frame.push_back({ allocation.offset, allocation.size, 0 });
+		}
+		auto fenceValue = timeline.Signal();
+		ring.EndFrame(fenceValue);
+		for (auto& allocation : frame) {
+			allocation.fenceValue = fenceValue;
+			live.push_back(allocation);
+		}
+		frame.clear();
+		if (timeline.PendingCount() > 2) {
+			timeline.Advance();
+		}
+		ring.Reclaim();
+		if (live.size() > 64) {
+			live.erase(live.begin(), live.begin() + 32);
+		}
+	}
+	CHECK(overlaps == 0);
+	CHECK(misaligned == 0);
+}
+
+int main()
+{
+	TestWraparound();
+	TestEmptyRingRestarts();
+	TestErrors();
+	TestFenceReclaim();
+	return TestResult("upload_ring_test");
+}
@@ -0,0 +1,117 @@
+#include "vertex_packing.h"
+#include "test_utils.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// a helper to make a float out of its bits.
+static float FloatFromBits(uint32_t bits)
+{
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// ============================================================================
+// Every half float converts to a float and back into the same bits.
+// ============================================================================
+void TestHalfRoundTrip()
+{
+	auto mismatches = 0u;
+	for (auto half = 0u; half <= 0xffffu; half++) {
+		auto isNaN = (half & 0x7c00u) == 0x7c00u && (half & 0x3ffu) != 0;
+		auto expected = isNaN ? ((half & 0x8000u) | 0x7e00u) : half;
+		mismatches += FloatToHalf(HalfToFloat(static_cast<uint16_t>(half))) != expected;
+	}
+	CHECK(mismatches == 0);
+	CHECK(HalfToFloat(0x3c00) == 1.f);
+	CHECK(HalfToFloat(0x0001) == std::ldexp(1.f, -24));
+	CHECK(HalfToFloat(0x7bff) == 65504.f);
+	CHECK(std::isinf(HalfToFloat(0xfc00)) && HalfToFloat(0xfc00) < 0.f);
+}
+
+// ============================================================================
+// Floats between two half floats round to the nearest one and ties to even.
+// ============================================================================
+void TestHalfRounding()
+{
+	auto mismatches = 0u;
+	for (auto half = 0u; half < 0x7bffu; half++) {
+		auto low = HalfToFloat(static_cast<uint16_t>(half));
+		auto high = HalfToFloat(static_cast<uint16_t>(half + 1));
+		auto middle = (low + high) / 2.f;
+		auto even = (half & 1) ? half + 1 : half;
+		mismatches += FloatToHalf(middle) != even;
+		mismatches += FloatToHalf(std::nextafter(middle, 0.f)) != half;
+		mismatches += FloatToHalf(std::nextafter(middle, high)) != half + 1;
+	}
+	CHECK(mismatches == 0);
+
+	// the largest half float rounds into an infinity at the tie with the next power of two.
+	CHECK(FloatToHalf(65519.f) == 0x7bff);
+	CHECK(FloatToHalf(65520.f) == 0x7c00);
+	CHECK(FloatToHalf(-1e10f) == 0xfc00);
+	CHECK(FloatToHalf(std::ldexp(1.f, -26)) == 0x0000);
+	CHECK(FloatToHalf(std::nextafter(std::ldexp(1.f, -25), 1.f)) == 0x0001);
+	CHECK(FloatToHalf(-0.f) == 0x8000);
+	CHECK(FloatToHalf(FloatFromBits(0xffc00001u)) == 0xfe00);
+}
+
+// ============================================================================
+// The normalized integers are clamped and rounded to the nearest value.
+// ============================================================================
+void TestNormalizedIntegers()
+{
+	CHECK(FloatToSnorm16(1.f) == 32767 && FloatToSnorm16(-1.f) == -32767);
+	CHECK(FloatToSnorm16(2.f) == 32767 && FloatToSnorm16(-2.f) == -32767);
+	CHECK(FloatToSnorm16(0.5f) == 16384);
+	CHECK(FloatToSnorm16(std::nanf("")) == -32767);
+	CHECK(FloatToUnorm8(0.5f) == 128 && FloatToUnorm8(1.5f) == 255 && FloatToUnorm8(-1.f) == 0);
+	CHECK(FloatToUnorm8(std::nanf("")) == 0);
+}
+
+// ============================================================================
+// The vectorized kernels produce the same bits as the scalar references.
+//
+// The positions sweep the float bit patterns with a prime stride, so every
+// exponent, the NaNs, infinities and subnormals are all covered, while the
+// colors are random bit patterns around the [0, 1] range.
+// ============================================================================
+void TestKernelsMatchScalar()
+{
+	const uint32_t stride = 4099;
+	std::vector<Vertex> vertices;
+	std::mt19937 random(15);
+	std::uniform_real_distribution<float> color(-0.25f, 1.25f);
+	for (uint64_t bits = 0; bits <= 0xffffffffull; bits += 3 * stride) {
+		Vertex vertex;
+		for (auto j = 0; j < 3; j++) {
+			vertex.position[j] = FloatFromBits(static_cast<uint32_t>(bits + j * stride));
+		}
+		for (auto j = 0; j < 4; j++) {
+			vertex.color[j] = (random() % 16 == 0) ? FloatFromBits(random()) : color(random);
+		}
+		vertices.push_back(vertex);
+	}
+	std::vector<HalfVertex> half(vertices.size()), halfScalar(vertices.size());
+	PackVertices(vertices.data(), vertices.size(), half.data());
+	PackVerticesScalar(vertices.data(), vertices.size(), halfScalar.data());
+	CHECK(std::memcmp(half.data(), halfScalar.data(), half.size() * sizeof(HalfVertex)) == 0);
+
+	std::vector<SnormVertex> snorm(vertices.size()), snormScalar(vertices.size());
+	PackVertices(vertices.data(), vertices.size(), 1e-30f, snorm.data());
+	PackVerticesScalar(vertices.data(), vertices.size(), 1e-30f, snormScalar.data());
+	CHECK(std::memcmp(snorm.data(), snormScalar.data(), snorm.size() * sizeof(SnormVertex)) == 0);
+	CHECK(half[1].position.value[3] == 0x3c00 && snorm[1].position.value[3] == 32767);
+}
+
+int main()
+{
+	TestHalfRoundTrip();
+	TestHalfRounding();
+	TestNormalizedIntegers();
+	TestKernelsMatchScalar();
+	return TestResult("vertex_packing_test");
+}
@@ -0,0 +1,302 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// a value for the block links that do not refer to any block.
+const uint32_t NoBlock = UINT32_MAX;
+
+// helpers to find the index of the highest and lowest set bit of a value.
+static unsigned HighestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+static unsigned LowestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// a helper to round a value up to a multiple of a power of two.
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+TlsfAllocator::TlsfAllocator(uint64_t size) : mSize(size - size % TLSF_MIN_BLOCK_SIZE), mUsedBytes(0), mFirstLevelBitmap(0), mSecondLevelBitmaps{}
+{
+	if (mSize == 0) {
+		throw std::invalid_argument("allocator size must be at least the minimum block size");
+	}
+	for (auto& lists : mFreeLists) {
+		std::fill(std::begin(lists), std::end(lists), NoBlock);
+	}
+	InsertFree(CreateBlock(0, mSize));
+}
+
+// ============================================================================
+// Allocate a range with the given size and power of two alignment.
+//
+// Size is rounded up to the allocation granularity. Alignments above the
+// granularity are served by searching for a block that is large enough for
+// the padding, which is then split off as a separate free block.
+// Function returns false if there is no free block that fits the request.
+// ============================================================================
+bool TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		throw std::invalid_argument("allocation alignment must be a power of two");
+	}
+	size = AlignUp(std::max<uint64_t>(size, 1), TLSF_MIN_BLOCK_SIZE);
+	alignment = std::max<uint64_t>(alignment, TLSF_MIN_BLOCK_SIZE);
+	if (size > mSize) {
+		return false;
+	}
+	auto block = FindFree(size, alignment);
+	if (block == NoBlock) {
+		return false;
+	}
+	RemoveFree(block);
+
+	// split off the padding in front of the aligned offset.
+	auto padding = AlignUp(mBlocks[block].offset, alignment) - mBlocks[block].offset;
+	if (padding != 0) {
+		auto aligned = Split(block, padding);
+		InsertFree(block);
+		block = aligned;
+	}
+
+	// split off the unused tail of the block.
+	if (mBlocks[block].size - size >= TLSF_MIN_BLOCK_SIZE) {
+		InsertFree(Split(block, size));
+	}
+
+	mBlocks[block].free = false;
+	mBlocks[block].alignment = alignment;
+	mUsedBytes += mBlocks[block].size;
+	mAllocated[mBlocks[block].offset] = block;
+	offset = mBlocks[block].offset;
+	return true;
+}
+
+// ============================================================================
+// Free an allocation and merge it with its free physical neighbours.
+// ============================================================================
+void TlsfAllocator::Free(uint64_t offset)
+{
+	auto allocation = mAllocated.find(offset);
+	if (allocation == mAllocated.end()) {
+		throw std::invalid_argument("freeing an offset that has not been allocated");
+	}
+	auto block = allocation->second;
+	mAllocated.erase(allocation);
+	mBlocks[block].free = true;
+	mUsedBytes -= mBlocks[block].size;
+
+	auto next = mBlocks[block].nextPhysical;
+	if (next != NoBlock && mBlocks[next].free) {
+		RemoveFree(next);
+		Merge(block, next);
+	}
+	auto prev = mBlocks[block].prevPhysical;
+	if (prev != NoBlock && mBlocks[prev].free) {
+		RemoveFree(prev);
+		Merge(prev, block);
+		block = prev;
+	}
+	InsertFree(block);
+}
+
+// ============================================================================
+// Get the live allocations in the order of their offsets.
+// ============================================================================
+std::vector<TlsfAllocation> TlsfAllocator::Allocations() const
+{
+	std::vector<TlsfAllocation> allocations;
+	for (auto& allocation : mAllocated) {
+		auto& block = mBlocks[allocation.second];
+		allocations.push_back({ block.offset, block.size, block.alignment });
+	}
+	std::sort(allocations.begin(), allocations.end(), [](const TlsfAllocation& a, const TlsfAllocation& b) { return a.offset < b.offset; });
+	return allocations;
+}
+
+// ============================================================================
+// Get the size of the largest free block.
+//
+// Only the blocks of the highest non-empty size class need to be inspected.
+// ============================================================================
+uint64_t TlsfAllocator::LargestFreeBlock() const
+{
+	if (mFirstLevelBitmap == 0) {
+		return 0;
+	}
+	auto firstLevel = HighestBit(mFirstLevelBitmap);
+	auto secondLevel = HighestBit(mSecondLevelBitmaps[firstLevel]);
+	uint64_t largest = 0;
+	for (auto block = mFreeLists[firstLevel][secondLevel]; block != NoBlock; block = mBlocks[block].nextFree) {
+		largest = std::max(largest, mBlocks[block].size);
+	}
+	return largest;
+}
+
+// ============================================================================
+// Map a block size into the indices of its first and second level size class.
+// ============================================================================
+void TlsfAllocator::Mapping(uint64_t size, unsigned& firstLevel, unsigned& secondLevel)
+{
+	firstLevel = HighestBit(size);
+	secondLevel = static_cast<unsigned>(size >> (firstLevel - TLSF_SECOND_LEVEL_BITS)) & (TLSF_SECOND_LEVEL_COUNT - 1);
+}
+
+// ============================================================================
+// Create a new block or reuse a released block structure.
+// ============================================================================
+uint32_t TlsfAllocator::CreateBlock(uint64_t offset, uint64_t size)
+{
+	Block block = { offset, size, 0, NoBlock, NoBlock, NoBlock, NoBlock, true };
+	if (!mUnusedBlocks.empty()) {
+		auto index = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		mBlocks[index] = block;
+		return index;
+	}
+	mBlocks.push_back(block);
+	return static_cast<uint32_t>(mBlocks.size() - 1);
+}
+
+// ============================================================================
+// Insert a free block at the head of the list of its size class.
+// ============================================================================
+void TlsfAllocator::InsertFree(uint32_t block)
+{
+	unsigned firstLevel, secondLevel;
+	Mapping(mBlocks[block].size, firstLevel, secondLevel);
+	auto& head = mFreeLists[firstLevel][secondLevel];
+	mBlocks[block].free = true;
+	mBlocks[block].prevFree = NoBlock;
+	mBlocks[block].nextFree = head;
+	if (head != NoBlock) {
+		mBlocks[head].prevFree = block;
+	}
+	head = block;
+	mFirstLevelBitmap |= 1ull << firstLevel;
+	mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+// ============================================================================
+// Remove a free block from the list of its size class.
+// ============================================================================
+void TlsfAllocator::RemoveFree(uint32_t block)
+{
+	auto prev = mBlocks[block].prevFree;
+	auto next = mBlocks[block].nextFree;
+	if (next != NoBlock) {
+		mBlocks[next].prevFree = prev;
+	}
+	if (prev != NoBlock) {
+		mBlocks[prev].nextFree = next;
+		return;
+	}
+	unsigned firstLevel, secondLevel;
+	Mapping(mBlocks[block].size, firstLevel, secondLevel);
+	mFreeLists[firstLevel][secondLevel] = next;
+	if (next == NoBlock) {
+		mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (mSecondLevelBitmaps[firstLevel] == 0) {
+			mFirstLevelBitmap &= ~(1ull << firstLevel);
+		}
+	}
+}
+
+// ============================================================================
+// Find a free block that fits the given size with the given alignment.
+//
+// The worst case size is rounded up to the next size class, so any block of
+// the found class fits without scanning the list. If that fails, the classes
+// from the size up to the worst case are scanned for a block whose padding
+// fits, so e.g. a request for the whole range with a large alignment works.
+// ============================================================================
+uint32_t TlsfAllocator::FindFree(uint64_t size, uint64_t alignment) const
+{
+	unsigned firstLevel, secondLevel;
+	auto worstCase = size + alignment - TLSF_MIN_BLOCK_SIZE;
+	Mapping(worstCase + (1ull << (HighestBit(worstCase) - TLSF_SECOND_LEVEL_BITS)) - 1, firstLevel, secondLevel);
+	auto secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0) {
+		auto firstLevelMap = (firstLevel < 63) ? mFirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+		if (firstLevelMap != 0) {
+			firstLevel = LowestBit(firstLevelMap);
+			secondLevelMap = mSecondLevelBitmaps[firstLevel];
+		}
+	}
+	if (secondLevelMap != 0) {
+		return mFreeLists[firstLevel][LowestBit(secondLevelMap)];
+	}
+
+	// fall back to the first fit within the classes between the size and the worst case size.
+	unsigned lastFirstLevel, lastSecondLevel;
+	Mapping(worstCase, lastFirstLevel, lastSecondLevel);
+	Mapping(size, firstLevel, secondLevel);
+	for (;;) {
+		for (auto block = mFreeLists[firstLevel][secondLevel]; block != NoBlock; block = mBlocks[block].nextFree) {
+			auto padding = AlignUp(mBlocks[block].offset, alignment) - mBlocks[block].offset;
+			if (mBlocks[block].size >= size + padding) {
+				return block;
+			}
+		}
+		if (firstLevel == lastFirstLevel && secondLevel == lastSecondLevel) {
+			return NoBlock;
+		}
+		if (++secondLevel == TLSF_SECOND_LEVEL_COUNT) {
+			secondLevel = 0;
+			firstLevel++;
+		}
+	}
+}
+
+// ============================================================================
+// Split a block into the given size and return the remaining new block.
+// ============================================================================
+uint32_t TlsfAllocator::Split(uint32_t block, uint64_t size)
+{
+	auto remainder = CreateBlock(mBlocks[block].offset + size, mBlocks[block].size - size);
+	auto next = mBlocks[block].nextPhysical;
+	mBlocks[remainder].prevPhysical = block;
+	mBlocks[remainder].nextPhysical = next;
+	if (next != NoBlock) {
+		mBlocks[next].prevPhysical = remainder;
+	}
+	mBlocks[block].nextPhysical = remainder;
+	mBlocks[block].size = size;
+	return remainder;
+}
+
+// ============================================================================
+// Merge the next physical neighbour into a block and release the neighbour.
+// ============================================================================
+void TlsfAllocator::Merge(uint32_t block, uint32_t next)
+{
+	auto after = mBlocks[next].nextPhysical;
+	mBlocks[block].size += mBlocks[next].size;
+	mBlocks[block].nextPhysical = after;
+	if (after != NoBlock) {
+		mBlocks[after].prevPhysical = block;
+	}
+	mUnusedBlocks.push_back(next);
+}
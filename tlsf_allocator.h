@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// the amount of second level subdivisions of each power of two size class.
+#define TLSF_SECOND_LEVEL_BITS 4
+#define TLSF_SECOND_LEVEL_COUNT (1 << TLSF_SECOND_LEVEL_BITS)
+
+// the smallest block size and the granularity of the allocations in bytes.
+#define TLSF_MIN_BLOCK_SIZE 256
+
+// ============================================================================
+// An allocation of a TLSF allocator with its offset, size and alignment.
+// ============================================================================
+struct TlsfAllocation
+{
+	uint64_t	offset;
+	uint64_t	size;
+	uint64_t	alignment;
+};
+
+// ============================================================================
+// A two-level segregated fit allocator of a linear address range.
+//
+// Allocator does not touch the memory it manages, it only hands out offsets.
+// Free blocks are kept in size class lists found with two bitmaps, so both
+// the allocation and the free are constant time regardless of the history.
+// ============================================================================
+class TlsfAllocator
+{
+public:
+	explicit TlsfAllocator(uint64_t size);
+	bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+	void Free(uint64_t offset);
+	std::vector<TlsfAllocation> Allocations() const;
+	uint64_t Size() const { return mSize; }
+	uint64_t UsedBytes() const { return mUsedBytes; }
+	uint64_t LargestFreeBlock() const;
+	unsigned AllocationCount() const { return static_cast<unsigned>(mAllocated.size()); }
+private:
+	struct Block
+	{
+		uint64_t	offset;
+		uint64_t	size;
+		uint64_t	alignment;
+		uint32_t	prevPhysical;
+		uint32_t	nextPhysical;
+		uint32_t	prevFree;
+		uint32_t	nextFree;
+		bool		free;
+	};
+	static void Mapping(uint64_t size, unsigned& firstLevel, unsigned& secondLevel);
+	uint32_t CreateBlock(uint64_t offset, uint64_t size);
+	void InsertFree(uint32_t block);
+	void RemoveFree(uint32_t block);
+	uint32_t FindFree(uint64_t size, uint64_t alignment) const;
+	uint32_t Split(uint32_t block, uint64_t size);
+	void Merge(uint32_t block, uint32_t next);
+private:
+	uint64_t								mSize;
+	uint64_t								mUsedBytes;
+	std::vector<Block>						mBlocks;
+	std::vector<uint32_t>					mUnusedBlocks;
+	std::unordered_map<uint64_t, uint32_t>	mAllocated;
+	uint64_t								mFirstLevelBitmap;
+	uint32_t								mSecondLevelBitmaps[64];
+	uint32_t								mFreeLists[64][TLSF_SECOND_LEVEL_COUNT];
+};
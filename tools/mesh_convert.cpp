@@ -0,0 +1,164 @@
+#include "mesh_file.h"
+#include "mesh_optimizer.h"
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Read the vertices and the triangles of a Wavefront OBJ file.
+//
+// Only the positions are used, with the optional vertex colors that follow
+// the position on the same line. Polygons are triangulated as fans.
+// ============================================================================
+bool ReadObj(const char* path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::ifstream input(path);
+	if (!input) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(input, line)) {
+		std::istringstream stream(line);
+		std::string type;
+		stream >> type;
+		if (type == "v") {
+			Vertex vertex = { { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f, 1.f } };
+			stream >> vertex.position[0] >> vertex.position[1] >> vertex.position[2];
+			if (!stream) {
+				return false;
+			}
+			stream >> vertex.color[0] >> vertex.color[1] >> vertex.color[2];
+			vertices.push_back(vertex);
+		} else if (type == "f") {
+			std::vector<uint32_t> polygon;
+			std::string corner;
+			while (stream >> corner) {
+				auto index = std::atol(corner.c_str());
+				index = (index < 0) ? static_cast<long>(vertices.size()) + index : index - 1;
+				if (index < 0 || index >= static_cast<long>(vertices.size())) {
+					return false;
+				}
+				polygon.push_back(static_cast<uint32_t>(index));
+			}
+			for (size_t i = 2; i < polygon.size(); i++) {
+				indices.insert(indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+			}
+		}
+	}
+	return true;
+}
+
+// ============================================================================
+// Get the stride of the vertices in the requested format.
+// ============================================================================
+unsigned FormatStride(const std::string& format)
+{
+	if (format == "float") {
+		return sizeof(Vertex);
+	}
+	if (format == "snorm16") {
+		return sizeof(SnormVertex);
+	}
+	return sizeof(HalfVertex);
+}
+
+// ============================================================================
+// Pack the vertices into the requested format and write the mesh file.
+// ============================================================================
+bool WriteMeshFile(const char* path, const std::string& format, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	MeshBounds bounds = { { vertices[0].position }, { vertices[0].position } };
+	for (auto& vertex : vertices) {
+		for (auto i = 0; i < 3; i++) {
+			bounds.minimum[i] = std::min(bounds.minimum[i], vertex.position[i]);
+			bounds.maximum[i] = std::max(bounds.maximum[i], vertex.position[i]);
+		}
+	}
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	auto vertexCount = static_cast<uint32_t>(vertices.size());
+	auto indexCount = static_cast<uint32_t>(indices.size());
+	if (format == "float") {
+		WriteMesh(output, vertices.data(), vertexCount, indices.data(), indexCount, bounds);
+	} else if (format == "half") {
+		std::vector<HalfVertex> packed(vertices.size());
+		PackVertices(vertices.data(), vertices.size(), packed.data());
+		WriteMesh(output, packed.data(), vertexCount, indices.data(), indexCount, bounds);
+	} else if (format == "snorm16") {
+		// scale the positions so the largest coordinate maps to one.
+		auto extent = 0.f;
+		for (auto i = 0; i < 3; i++) {
+			extent = std::max({ extent, std::fabs(bounds.minimum[i]), std::fabs(bounds.maximum[i]) });
+		}
+		auto scale = (extent > 0.f) ? 1.f / extent : 1.f;
+		std::vector<SnormVertex> packed(vertices.size());
+		PackVertices(vertices.data(), vertices.size(), scale, packed.data());
+		WriteMesh(output, packed.data(), vertexCount, indices.data(), indexCount, bounds, scale);
+	} else {
+		std::fprintf(stderr, "unknown format: %s\n", format.c_str());
+		return false;
+	}
+	return static_cast<bool>(output);
+}
+
+// ============================================================================
+// The entry point of the mesh conversion tool.
+//
+// Tool converts an OBJ file, or the triangle of the application when the
+// input is "triangle", into a mesh file with the given vertex format. The
+// mesh is optimized unless asked otherwise, which also indexes the mesh.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	std::string format = "half";
+	auto optimize = true;
+	auto first = 1;
+	for (; first < argc && argv[first][0] == '-' && argv[first][1] == '-'; first++) {
+		std::string option = argv[first];
+		if (option == "--format" && first + 1 < argc) {
+			format = argv[++first];
+		} else if (option == "--no-optimize") {
+			optimize = false;
+		} else {
+			first = argc;
+		}
+	}
+	if (argc - first != 2) {
+		std::fprintf(stderr, "usage: %s [--format float|half|snorm16] [--no-optimize] <input.obj|triangle> <output.mesh>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	if (std::string(argv[first]) == "triangle") {
+		vertices = TriangleVertices();
+	} else if (!ReadObj(argv[first], vertices, indices)) {
+		std::fprintf(stderr, "failed to read obj file: %s\n", argv[first]);
+		return 1;
+	}
+	if (vertices.empty()) {
+		std::fprintf(stderr, "no vertices in: %s\n", argv[first]);
+		return 1;
+	}
+	if (optimize) {
+		auto report = OptimizeMesh(vertices, indices, FormatStride(format));
+		std::printf("vertices: %zu -> %zu\n", report.vertexCountBefore, report.vertexCountAfter);
+		std::printf("acmr: %.3f -> %.3f, atvr: %.3f -> %.3f\n", report.acmrBefore, report.acmrAfter, report.atvrBefore, report.atvrAfter);
+		std::printf("overdraw: %.3f -> %.3f\n", report.overdrawBefore, report.overdrawAfter);
+		std::printf("bytes: %llu -> %llu (%lld saved)\n", static_cast<unsigned long long>(report.bytesBefore), static_cast<unsigned long long>(report.bytesAfter),
+			static_cast<long long>(report.bytesBefore) - static_cast<long long>(report.bytesAfter));
+	}
+	if (!WriteMeshFile(argv[first + 1], format, vertices, indices)) {
+		std::fprintf(stderr, "failed to write mesh file: %s\n", argv[first + 1]);
+		return 1;
+	}
+	std::printf("%s: %zu vertices, %zu indices, %s\n", argv[first + 1], vertices.size(), indices.size(), format.c_str());
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "benchmark/benchmark_utils.h"
+#include "capture_replay.h"
+#include "null_renderer.h"
+#include "software_renderer.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+// ============================================================================
+// The options of the capture replay tool parsed from the command line.
+// ============================================================================
+struct Options
+{
+	std::string	backend = "software";
+	unsigned	threads = std::max(std::thread::hardware_concurrency(), 1u);
+	unsigned	latency = 2;
+	unsigned	repeat = 1;
+};
+
+// ============================================================================
+// Create the rendering backend used for the replay.
+// ============================================================================
+std::unique_ptr<RenderBackend> CreateBackend(const Options& options)
+{
+	if (options.backend == "null") {
+		return std::make_unique<NullRenderer>(options.latency, std::chrono::microseconds(0));
+	}
+	if (options.backend == "software") {
+		return std::make_unique<SoftwareRenderer>(options.threads, options.latency);
+	}
+	return nullptr;
+}
+
+// ============================================================================
+// The entry point of the capture replay tool.
+//
+// Tool replays a capture on a headless backend the given amount of times and
+// prints the time and the hashes of each frame of the last replay as JSON.
+// The frames of a software replay are also hashed from the frame buffer, so
+// the output of two builds can be compared frame by frame.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	Options options;
+	auto first = 1;
+	for (; first + 1 < argc && argv[first][0] == '-' && argv[first][1] == '-'; first += 2) {
+		std::string name = argv[first], value = argv[first + 1];
+		if (name == "--backend") {
+			options.backend = value;
+		} else if (name == "--threads") {
+			options.threads = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--latency") {
+			options.latency = std::max(ParseList(value)[0], 1u);
+		} else if (name == "--repeat") {
+			options.repeat = std::max(ParseList(value)[0], 1u);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", name.c_str());
+			return 1;
+		}
+	}
+	if (argc - first != 1) {
+		std::fprintf(stderr, "usage: %s [--backend software|null] [--threads n] [--latency n] [--repeat n] <capture.bin>\n", argv[0]);
+		return 1;
+	}
+
+	std::ifstream input(argv[first], std::ios::binary);
+	std::vector<uint8_t> capture;
+	if (input) {
+		capture.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	}
+	if (capture.empty()) {
+		std::fprintf(stderr, "failed to read capture file: %s\n", argv[first]);
+		return 1;
+	}
+	auto backend = CreateBackend(options);
+	if (!backend) {
+		std::fprintf(stderr, "unknown backend: %s\n", options.backend.c_str());
+		return 1;
+	}
+
+	// hash the frame buffer of the software renderer, while the other backends have no output.
+	CaptureReplayer::OutputHashCallback outputHash;
+	if (auto software = dynamic_cast<SoftwareRenderer*>(backend.get())) {
+		outputHash = [software] {
+			auto hash = 14695981039346656037ull;
+			for (auto byte : software->Framebuffer()) {
+				hash = (hash ^ byte) * 1099511628211ull;
+			}
+			return hash;
+		};
+	}
+
+	SteadyClock clock;
+	CaptureReplayer replayer(*backend, clock);
+	std::vector<CaptureFrameStats> frames, firstFrames;
+	std::vector<double> frameTimes;
+	auto deterministic = true;
+	try {
+		for (auto i = 0u; i < options.repeat; i++) {
+			frames = replayer.Replay(capture.data(), capture.size(), outputHash);
+			for (auto& frame : frames) {
+				frameTimes.push_back(frame.milliseconds);
+			}
+			if (i == 0) {
+				firstFrames = frames;
+			}
+			for (size_t j = 0; j < frames.size(); j++) {
+				deterministic &= (frames[j].geometryHash == firstFrames[j].geometryHash && frames[j].outputHash == firstFrames[j].outputHash);
+			}
+		}
+	} catch (const std::exception& exception) {
+		std::fprintf(stderr, "failed to replay capture: %s\n", exception.what());
+		return 1;
+	}
+
+	std::printf("{\"capture\": \"%s\", \"backend\": \"%s\", \"repeat\": %u, \"deterministic\": %s, \"frameMs\": %s, \"frames\": [",
+		argv[first], options.backend.c_str(), options.repeat, deterministic ? "true" : "false", SummaryJson(Summarize(frameTimes)).c_str());
+	for (size_t i = 0; i < frames.size(); i++) {
+		auto& frame = frames[i];
+		std::printf("%s\n    {\"frame\": %zu, \"ms\": %.6f, \"draws\": %u, \"triangles\": %u, \"geometryHash\": \"%016llx\", \"outputHash\": \"%016llx\"}", (i == 0) ? "" : ",",
+			i, frame.milliseconds, frame.drawCount, frame.triangleCount, static_cast<unsigned long long>(frame.geometryHash), static_cast<unsigned long long>(frame.outputHash));
+	}
+	std::printf("\n]}\n");
+	return deterministic ? 0 : 2;
+}
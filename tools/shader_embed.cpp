@@ -0,0 +1,63 @@
+#include "shader_cache.h"
+
+#include <cstdio>
+#include <fstream>
+
+// ============================================================================
+// A compiler stub for the tool as it only reads already compiled blobs.
+// ============================================================================
+class NoShaderCompiler : public ShaderCompiler
+{
+public:
+	ShaderBytecode Compile(const ShaderSource&) override { return ShaderBytecode(); }
+};
+
+// ============================================================================
+// The entry point of the shader embedding tool.
+//
+// Tool converts a shader cache file into a C++ header with the blobs, which is
+// included by the renderer when it is built with EMBEDDED_SHADERS defined.
+// ============================================================================
+int main(int argc, char* argv[])
+{
+	if (argc != 3) {
+		std::fprintf(stderr, "usage: %s <shaders.bin> <embedded_shaders.h>\n", argv[0]);
+		return 1;
+	}
+
+	// load the shader cache file.
+	NoShaderCompiler compiler;
+	ShaderCache cache(compiler);
+	std::ifstream input(argv[1], std::ios::binary);
+	if (!input || !cache.Load(input)) {
+		std::fprintf(stderr, "failed to load shader cache: %s\n", argv[1]);
+		return 1;
+	}
+
+	// write each blob as a byte array followed by the table of the blobs. Arrays must not be empty
+	// in C++, so an empty blob or table is written with a single element and a size of zero.
+	std::ofstream output(argv[2], std::ios::binary);
+	output << "#pragma once\r\n\r\n#include \"shader_cache.h\"\r\n\r\n";
+	output << "// this file is generated with the shader_embed tool. Do not edit by hand.\r\n";
+	auto index = 0u;
+	for (auto& entry : cache.Entries()) {
+		output << "static const uint8_t EmbeddedShader" << index++ << "[] = {";
+		for (size_t i = 0; i < entry.second.size(); i++) {
+			output << ((i % 16 == 0) ? "\r\n\t" : " ") << static_cast<unsigned>(entry.second[i]) << ",";
+		}
+		output << (entry.second.empty() ? "\r\n\t0,\r\n};\r\n" : "\r\n};\r\n");
+	}
+	output << "static const EmbeddedShader EmbeddedShaders[] = {\r\n";
+	index = 0;
+	for (auto& entry : cache.Entries()) {
+		char key[32];
+		std::snprintf(key, sizeof(key), "0x%016llxull", static_cast<unsigned long long>(entry.first));
+		output << "\t{ " << key << ", EmbeddedShader" << index << ", " << entry.second.size() << " },\r\n";
+		index++;
+	}
+	if (cache.Entries().empty()) {
+		output << "\t{ 0, nullptr, 0 },\r\n";
+	}
+	output << "};\r\nstatic const size_t EmbeddedShaderCount = " << cache.Entries().size() << ";\r\n";
+	return output ? 0 : 1;
+}
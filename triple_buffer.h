@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ============================================================================
+// A lock-free triple buffer that hands values from a writer to a reader.
+//
+// Writer fills the back slot and publishes it by swapping it with the middle
+// slot, while the reader swaps the middle slot with its front slot when a new
+// value is available. Neither side ever waits and the reader always sees the
+// latest complete value. Only a single writer and reader thread are allowed.
+// ============================================================================
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : mMiddle(1), mBack(2), mFront(0) {}
+	T& Back() { return mSlots[mBack]; }
+	const T& Front() const { return mSlots[mFront]; }
+	void Publish();
+	bool Update();
+private:
+	// a flag in the middle index that marks a value the reader has not taken.
+	static const uint8_t NewValue = 4;
+	T						mSlots[3];
+	std::atomic<uint8_t>	mMiddle;
+	uint8_t					mBack;
+	uint8_t					mFront;
+};
+
+// ============================================================================
+// Publish the back slot to the reader and take the middle slot as a new back.
+// ============================================================================
+template <typename T>
+void TripleBuffer<T>::Publish()
+{
+	auto middle = mMiddle.exchange(static_cast<uint8_t>(mBack | NewValue), std::memory_order_acq_rel);
+	mBack = middle & (NewValue - 1);
+}
+
+// ============================================================================
+// Take the latest published value into the front slot if there is a new one.
+// ============================================================================
+template <typename T>
+bool TripleBuffer<T>::Update()
+{
+	if ((mMiddle.load(std::memory_order_relaxed) & NewValue) == 0) {
+		return false;
+	}
+	auto middle = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+	mFront = middle & (NewValue - 1);
+	return true;
+}
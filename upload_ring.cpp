@@ -0,0 +1,22 @@
+#include "upload_ring.h"
+
+#include <stdexcept>
+
+UploadRing::UploadRing(GpuTimeline& timeline, uint8_t* cpuAddress, uint64_t gpuAddress, uint64_t capacity) : mCpuAddress(cpuAddress), mGpuAddress(gpuAddress), mRing(timeline, capacity)
+{
+}
+
+// ============================================================================
+// Allocate a block of memory with the given power of two alignment.
+//
+// The ring places the block after the previous block or wraps around to the
+// start of the buffer. Throws a length error if the block can never fit.
+// ============================================================================
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (size > mRing.Capacity()) {
+		throw std::length_error("upload ring is too small for the allocation");
+	}
+	auto offset = mRing.Allocate(size, alignment);
+	return { mCpuAddress + offset, mGpuAddress + offset, offset, size };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "fenced_ring.h"
+
+#include <cstdint>
+
+// ============================================================================
+// An allocation from the upload ring with the CPU and GPU addresses.
+// ============================================================================
+struct UploadAllocation
+{
+	uint8_t*	cpuAddress;
+	uint64_t	gpuAddress;
+	uint64_t	offset;
+	uint64_t	size;
+};
+
+// ============================================================================
+// A linear ring allocator over a persistently mapped upload buffer.
+//
+// Each frame allocates a contiguous region after the previous frame. Regions
+// are closed with the fence of the frame and reclaimed when the GPU has
+// completed the fence. The allocator only waits when the ring is full.
+// ============================================================================
+class UploadRing
+{
+public:
+	UploadRing(GpuTimeline& timeline, uint8_t* cpuAddress, uint64_t gpuAddress, uint64_t capacity);
+	UploadAllocation Allocate(uint64_t size, uint64_t alignment);
+	void EndFrame(uint64_t fenceValue) { mRing.EndFrame(fenceValue); }
+	void Reclaim() { mRing.Reclaim(); }
+	uint64_t Capacity() const { return mRing.Capacity(); }
+	uint64_t UsedBytes() const { return mRing.UsedCount(); }
+	unsigned WaitCount() const { return mRing.WaitCount(); }
+private:
+	uint8_t*	mCpuAddress;
+	uint64_t	mGpuAddress;
+	FencedRing	mRing;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+// vertex structure
+struct Vertex
+{
+	std::array<float, 3> position;
+	std::array<float, 4> color;
+};
+
+// ============================================================================
+// Get the vertices of the simple triangle shown by the application.
+//
+// Vertices are defined in normalized device coordinates with clockwise order
+// so they appear as front facing with the default rasterizer configuration.
+// ============================================================================
+inline std::vector<Vertex> TriangleVertices()
+{
+	return {
+	  {{  0.0f,  0.5f, 0.0f }, { 1.f, 0.f, 0.f, 1.f }},
+	  {{  0.5f, -0.5f, 0.0f }, { 0.f, 1.f, 0.f, 1.f }},
+	  {{ -0.5f, -0.5f, 0.0f }, { 0.f, 0.f, 1.f, 1.f }}
+	};
+}
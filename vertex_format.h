@@ -0,0 +1,149 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// The formats of the vertex elements.
+// ============================================================================
+enum class VertexElementFormat
+{
+	Float3,
+	Float4,
+	Half4,
+	Snorm16x4,
+	Unorm8x4
+};
+
+// ============================================================================
+// An element of a vertex layout with its semantic and byte offset.
+// ============================================================================
+struct VertexElement
+{
+	const char*			semantic;
+	unsigned			semanticIndex;
+	VertexElementFormat	format;
+	unsigned			offset;
+};
+
+// ============================================================================
+// The packed element types of the quantized vertices.
+// ============================================================================
+struct Half4
+{
+	uint16_t	value[4];
+};
+
+struct Snorm16x4
+{
+	int16_t	value[4];
+};
+
+struct Unorm8x4
+{
+	uint8_t	value[4];
+};
+
+// ============================================================================
+// A vertex with half float position and RGBA8 color in 12 bytes.
+// ============================================================================
+struct HalfVertex
+{
+	Half4		position;
+	Unorm8x4	color;
+};
+
+// ============================================================================
+// A vertex with SNORM16 position and RGBA8 color in 12 bytes.
+//
+// The positions must be normalized into the [-1, 1] range, e.g. by the mesh
+// bounds, with the inverse scale folded into the transform of the mesh.
+// ============================================================================
+struct SnormVertex
+{
+	Snorm16x4	position;
+	Unorm8x4	color;
+};
+
+// ============================================================================
+// Traits that map the member types of the vertices to the element formats.
+// ============================================================================
+template <typename T> struct VertexElementTraits;
+template <> struct VertexElementTraits<std::array<float, 3>> { static constexpr VertexElementFormat Format = VertexElementFormat::Float3; };
+template <> struct VertexElementTraits<std::array<float, 4>> { static constexpr VertexElementFormat Format = VertexElementFormat::Float4; };
+template <> struct VertexElementTraits<Half4> { static constexpr VertexElementFormat Format = VertexElementFormat::Half4; };
+template <> struct VertexElementTraits<Snorm16x4> { static constexpr VertexElementFormat Format = VertexElementFormat::Snorm16x4; };
+template <> struct VertexElementTraits<Unorm8x4> { static constexpr VertexElementFormat Format = VertexElementFormat::Unorm8x4; };
+
+// a macro to describe a member of a vertex with the format deduced from its type.
+#define VERTEX_ELEMENT(VERTEX, MEMBER, SEMANTIC) VertexElement{ SEMANTIC, 0, VertexElementTraits<decltype(VERTEX::MEMBER)>::Format, static_cast<unsigned>(offsetof(VERTEX, MEMBER)) }
+
+// ============================================================================
+// The layouts of the vertices as compile time arrays of elements.
+//
+// Each vertex type specializes the template with an Elements() function that
+// lists its members in the order of their offsets.
+// ============================================================================
+template <typename T> struct VertexLayout;
+
+template <> struct VertexLayout<Vertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements()
+	{
+		return { { VERTEX_ELEMENT(Vertex, position, "POSITION"), VERTEX_ELEMENT(Vertex, color, "COLOR") } };
+	}
+};
+
+template <> struct VertexLayout<HalfVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements()
+	{
+		return { { VERTEX_ELEMENT(HalfVertex, position, "POSITION"), VERTEX_ELEMENT(HalfVertex, color, "COLOR") } };
+	}
+};
+
+template <> struct VertexLayout<SnormVertex>
+{
+	static constexpr std::array<VertexElement, 2> Elements()
+	{
+		return { { VERTEX_ELEMENT(SnormVertex, position, "POSITION"), VERTEX_ELEMENT(SnormVertex, color, "COLOR") } };
+	}
+};
+
+// ============================================================================
+// Get the size of an element format in bytes.
+// ============================================================================
+constexpr unsigned VertexElementSize(VertexElementFormat format)
+{
+	return format == VertexElementFormat::Float3 ? 12
+		: format == VertexElementFormat::Float4 ? 16
+		: format == VertexElementFormat::Half4 || format == VertexElementFormat::Snorm16x4 ? 8
+		: 4;
+}
+
+// ============================================================================
+// Check whether the layout of a vertex matches the vertex type.
+//
+// Elements must be 4 byte aligned, ordered by their offsets and cover the
+// whole vertex without any gaps so that the stride is the size of the type.
+// ============================================================================
+template <typename T>
+constexpr bool IsValidVertexLayout()
+{
+	const auto elements = VertexLayout<T>::Elements();
+	unsigned offset = 0;
+	for (size_t i = 0; i < elements.size(); i++) {
+		if (elements[i].offset != offset || elements[i].offset % 4 != 0) {
+			return false;
+		}
+		offset += VertexElementSize(elements[i].format);
+	}
+	return offset == sizeof(T);
+}
+
+static_assert(IsValidVertexLayout<Vertex>(), "invalid layout of Vertex");
+static_assert(IsValidVertexLayout<HalfVertex>(), "invalid layout of HalfVertex");
+static_assert(IsValidVertexLayout<SnormVertex>(), "invalid layout of SnormVertex");
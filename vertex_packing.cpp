@@ -0,0 +1,220 @@
+#include "vertex_packing.h"
+
+#include <cmath>
+#include <cstring>
+
+// use the SSE2 kernels on the x86 processors.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define VERTEX_PACKING_SSE2
+#include <emmintrin.h>
+#endif
+
+// the bits of the smallest float which overflows into a half float infinity.
+const uint32_t HalfOverflowBits = (127 + 16) << 23;
+
+// the bits of the smallest float which converts into a normal half float.
+const uint32_t HalfNormalBits = (127 - 14) << 23;
+
+// the bits of a float whose addition rounds the mantissa into a subnormal half float.
+const uint32_t HalfSubnormalMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+
+// ============================================================================
+// Convert a float into a half float with rounding to nearest even.
+//
+// Normal results rebias the exponent and round the mantissa with integer math
+// and subnormal results let the float addition do the rounding of the bits.
+// ============================================================================
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	auto sign = bits & 0x80000000u;
+	bits ^= sign;
+	uint32_t half;
+	if (bits >= HalfOverflowBits) {
+		half = (bits > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+	} else if (bits < HalfNormalBits) {
+		float magic, rounded;
+		std::memcpy(&magic, &HalfSubnormalMagicBits, sizeof(magic));
+		std::memcpy(&rounded, &bits, sizeof(rounded));
+		rounded += magic;
+		std::memcpy(&half, &rounded, sizeof(half));
+		half -= HalfSubnormalMagicBits;
+	} else {
+		auto mantissaOdd = (bits >> 13) & 1;
+		bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff + mantissaOdd;
+		half = bits >> 13;
+	}
+	return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+// ============================================================================
+// Convert a half float back into a float.
+// ============================================================================
+float HalfToFloat(uint16_t value)
+{
+	auto sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	auto exponent = (value >> 10) & 0x1f;
+	auto mantissa = static_cast<uint32_t>(value & 0x3ff);
+	uint32_t bits;
+	if (exponent == 0x1f) {
+		bits = sign | 0x7f800000u | (mantissa << 13);
+	} else if (exponent != 0) {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	} else {
+		auto magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -magnitude : magnitude;
+	}
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+// a helper to clamp a value into a range, where NaN maps to the minimum like with SSE.
+static float Clamp(float value, float minimum, float maximum)
+{
+	value = (value > minimum) ? value : minimum;
+	return (value < maximum) ? value : maximum;
+}
+
+// ============================================================================
+// Convert a float into a SNORM16 value.
+// ============================================================================
+int16_t FloatToSnorm16(float value)
+{
+	return static_cast<int16_t>(std::nearbyint(Clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+// ============================================================================
+// Convert a float into a UNORM8 value.
+// ============================================================================
+uint8_t FloatToUnorm8(float value)
+{
+	return static_cast<uint8_t>(std::nearbyint(Clamp(value, 0.f, 1.f) * 255.f));
+}
+
+// ============================================================================
+// Pack the vertices into the half float vertices one value at a time.
+// ============================================================================
+void PackVerticesScalar(const Vertex* vertices, size_t count, HalfVertex* output)
+{
+	for (size_t i = 0; i < count; i++) {
+		for (auto j = 0; j < 3; j++) {
+			output[i].position.value[j] = FloatToHalf(vertices[i].position[j]);
+		}
+		output[i].position.value[3] = FloatToHalf(1.f);
+		for (auto j = 0; j < 4; j++) {
+			output[i].color.value[j] = FloatToUnorm8(vertices[i].color[j]);
+		}
+	}
+}
+
+// ============================================================================
+// Pack the vertices into the snorm vertices one value at a time.
+// ============================================================================
+void PackVerticesScalar(const Vertex* vertices, size_t count, float positionScale, SnormVertex* output)
+{
+	for (size_t i = 0; i < count; i++) {
+		for (auto j = 0; j < 3; j++) {
+			output[i].position.value[j] = FloatToSnorm16(vertices[i].position[j] * positionScale);
+		}
+		output[i].position.value[3] = FloatToSnorm16(1.f);
+		for (auto j = 0; j < 4; j++) {
+			output[i].color.value[j] = FloatToUnorm8(vertices[i].color[j]);
+		}
+	}
+}
+
+#if defined(VERTEX_PACKING_SSE2)
+
+// a helper to convert four floats into half floats in the low halves of the lanes.
+static __m128i FloatToHalf(__m128 value)
+{
+	auto sign = _mm_and_ps(value, _mm_set1_ps(-0.f));
+	auto absolute = _mm_xor_ps(value, sign);
+	auto bits = _mm_castps_si128(absolute);
+
+	// NaN keeps a mantissa bit, while the overflows turn into infinities.
+	auto isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+	auto special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+	auto isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(static_cast<int>(HalfOverflowBits)), bits);
+
+	// let the float addition round the mantissa of the subnormal results.
+	auto magic = _mm_set1_epi32(static_cast<int>(HalfSubnormalMagicBits));
+	auto subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(magic))), magic);
+	auto isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(static_cast<int>(HalfNormalBits)), bits);
+
+	// rebias the exponent of the normal results and round the mantissa to nearest even.
+	auto mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+	auto rounded = _mm_sub_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), mantissaOdd);
+	auto normal = _mm_srli_epi32(rounded, 13);
+
+	// select the result of each lane and put the sign back.
+	auto finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+	auto half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+	return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+// a helper to convert four floats into UNORM8 values in the low bytes of the register.
+static int FloatToUnorm8(__m128 value)
+{
+	auto clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	auto integers = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.f)));
+	auto words = _mm_packs_epi32(integers, integers);
+	return _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+}
+
+// a helper to load the position of a vertex with the fourth component set to one.
+static __m128 LoadPosition(const Vertex& vertex)
+{
+	auto mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	auto position = _mm_loadu_ps(vertex.position.data());
+	return _mm_or_ps(_mm_and_ps(position, mask), _mm_setr_ps(0.f, 0.f, 0.f, 1.f));
+}
+
+// ============================================================================
+// Pack the vertices into the half float vertices.
+//
+// The position of a vertex is read with a single load which also covers the
+// first color component, as it directly follows the position in the vertex.
+// ============================================================================
+void PackVertices(const Vertex* vertices, size_t count, HalfVertex* output)
+{
+	static_assert(offsetof(Vertex, color) == offsetof(Vertex, position) + 12, "color must follow the position");
+	for (size_t i = 0; i < count; i++) {
+		auto half = FloatToHalf(LoadPosition(vertices[i]));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[i].position), _mm_packs_epi32(half, half));
+		auto color = FloatToUnorm8(_mm_loadu_ps(vertices[i].color.data()));
+		std::memcpy(&output[i].color, &color, sizeof(color));
+	}
+}
+
+// ============================================================================
+// Pack the vertices into the snorm vertices.
+// ============================================================================
+void PackVertices(const Vertex* vertices, size_t count, float positionScale, SnormVertex* output)
+{
+	auto scale = _mm_setr_ps(positionScale, positionScale, positionScale, 1.f);
+	for (size_t i = 0; i < count; i++) {
+		auto position = _mm_mul_ps(LoadPosition(vertices[i]), scale);
+		auto clamped = _mm_min_ps(_mm_max_ps(position, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+		auto integers = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(32767.f)));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&output[i].position), _mm_packs_epi32(integers, integers));
+		auto color = FloatToUnorm8(_mm_loadu_ps(vertices[i].color.data()));
+		std::memcpy(&output[i].color, &color, sizeof(color));
+	}
+}
+
+#else
+
+void PackVertices(const Vertex* vertices, size_t count, HalfVertex* output)
+{
+	PackVerticesScalar(vertices, count, output);
+}
+
+void PackVertices(const Vertex* vertices, size_t count, float positionScale, SnormVertex* output)
+{
+	PackVerticesScalar(vertices, count, positionScale, output);
+}
+
+#endif
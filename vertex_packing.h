@@ -0,0 +1,30 @@
+#pragma once
+
+#include "vertex_format.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// Conversions of single values into the quantized vertex formats.
+//
+// These are the reference for the vectorized kernels, which produce exactly
+// the same bits. Half floats are rounded to nearest even and the normalized
+// integers are clamped and rounded to the nearest value.
+// ============================================================================
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+int16_t FloatToSnorm16(float value);
+uint8_t FloatToUnorm8(float value);
+
+// ============================================================================
+// Pack float authoring vertices into the quantized vertex formats.
+//
+// Kernels use SSE2 where available and fall back to the scalar conversions
+// otherwise. The snorm position is multiplied by the given scale, which must
+// map the positions of the mesh into the [-1, 1] range.
+// ============================================================================
+void PackVertices(const Vertex* vertices, size_t count, HalfVertex* output);
+void PackVertices(const Vertex* vertices, size_t count, float positionScale, SnormVertex* output);
+void PackVerticesScalar(const Vertex* vertices, size_t count, HalfVertex* output);
+void PackVerticesScalar(const Vertex* vertices, size_t count, float positionScale, SnormVertex* output);
@@ -1,4 +1,9 @@
 #include "view.h"
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 
 using namespace Platform;
 using namespace Windows::ApplicationModel;
@@ -6,6 +11,7 @@ using namespace Windows::ApplicationModel::Activation;
 using namespace Windows::ApplicationModel::Core;
 using namespace Windows::Foundation;
 using namespace Windows::Graphics::Display;
+using namespace Windows::Storage;
 using namespace Windows::UI::Core;
 
 // ============================================================================
@@ -19,8 +25,22 @@ void View::Initialize(CoreApplicationView^ applicationView)
 	// observe the activation of the main view of the application.
 	applicationView->Activated += ref new TypedEventHandler<CoreApplicationView^, IActivatedEventArgs^>(this, &View::OnActivated);
 
+	// create a job system with a thread for each core, where this thread is the first one.
+	mJobSystem = std::make_unique<JobSystem>(std::max(std::thread::hardware_concurrency(), 1u));
+
+	// create the simulation which updates the scene at a fixed rate on its own thread.
+	mClock = std::make_unique<SteadyClock>();
+	auto update = [](SceneState& state, double deltaSeconds) {
+		state.rotation = static_cast<float>(std::fmod(state.rotation + TRIANGLE_ROTATION_SPEED * deltaSeconds, 6.28318531));
+	};
+	mSimulation = std::make_unique<Simulation>(*mClock, 1000000000ull / SIMULATION_STEP_RATE, SIMULATION_MAX_STEPS, SceneState{ 0.f }, update);
+
+	// create a streamer which loads the assets of the package in the background.
+	mFileSource = std::make_unique<MappedFileSource>(Package::Current->InstalledLocation->Path->Data());
+	mAssetStreamer = std::make_unique<AssetStreamer>(*mFileSource, STREAMING_THREADS);
+
 	// create a renderer for the application.
-	mRenderer = ref new Renderer();
+	mRenderer = ref new Renderer(FRAME_LATENCY, { PRESENT_MODE, PRESENT_MAX_LATENCY, PRESENT_MARGIN_NANOSECONDS, PRESENT_HISTORY_FRAMES }, *mJobSystem);
 }
 
 // ============================================================================
@@ -34,6 +54,7 @@ void View::SetWindow(CoreWindow^ window)
 	// observe the events of the main window of the application.
 	window->VisibilityChanged += ref new TypedEventHandler<CoreWindow^, VisibilityChangedEventArgs^>(this, &View::OnVisibilityChanged);
 	window->Closed += ref new TypedEventHandler<CoreWindow^, CoreWindowEventArgs^>(this, &View::OnClosed);
+	window->KeyDown += ref new TypedEventHandler<CoreWindow^, KeyEventArgs^>(this, &View::OnKeyDown);
 }
 
 // ============================================================================
@@ -44,7 +65,8 @@ void View::SetWindow(CoreWindow^ window)
 // ============================================================================
 void View::Load(String^ entryPoint)
 {
-	// ... nothing
+	// request the mesh shipped with the application package, which is drawn once it's loaded.
+	mAssetStreamer->Request(MESH_ASSET_PATH, 0, CancellationToken(), DecodeMesh);
 }
 
 // ============================================================================
@@ -55,15 +77,35 @@ void View::Load(String^ entryPoint)
 // ============================================================================
 void View::Run()
 {
+	FrameProfiler::Instance().SetThreadName("UI");
+	mSimulation->Start();
 	while (!mWindowClosed) {
 		auto window = CoreWindow::GetForCurrentThread();
 		if (mWindowVisible) {
-			window->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+			FrameProfiler::Instance().BeginFrame();
+			mRenderer->WaitForFrameStart();
+			{
+				PROFILE_SCOPE("ProcessEvents");
+				window->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+			}
+			mAssetStreamer->Update(STREAMING_UPLOAD_BUDGET, [this](AssetCompletion& completion) {
+				if (completion.status == AssetStatus::Loaded) {
+					mRenderer->LoadMesh(static_cast<MeshAsset&>(*completion.asset).Mesh());
+				}
+			});
+			SceneSnapshot snapshot;
+			if (mSimulation->Latest(snapshot)) {
+				mRenderer->SetScene(Interpolate(snapshot, mClock->Now(), mSimulation->Timestep().StepNanoseconds()));
+			}
 			mRenderer->Render();
+			if (mRenderer->CaptureComplete()) {
+				ExportCapture();
+			}
 		} else {
 			window->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
 		}
 	}
+	mSimulation->Stop();
 }
 
 // ============================================================================
@@ -99,6 +141,7 @@ void View::OnActivated(CoreApplicationView^ applicationView, IActivatedEventArgs
 void View::OnVisibilityChanged(CoreWindow^ sender, VisibilityChangedEventArgs^ args)
 {
 	mWindowVisible = args->Visible;
+	mRenderer->SetVisible(mWindowVisible);
 }
 
 // ============================================================================
@@ -110,4 +153,63 @@ void View::OnVisibilityChanged(CoreWindow^ sender, VisibilityChangedEventArgs^ a
 void View::OnClosed(CoreWindow^ sender, CoreWindowEventArgs^ args)
 {
 	mWindowClosed = true;
+
+	// write the pipeline cache, the trace file and the memory statistics at the same time.
+	JobCounter counter;
+	mJobSystem->Run([this] { mRenderer->SavePipelineCache(); }, &counter);
+	mJobSystem->Run([this] { ExportTrace(); }, &counter);
+	mJobSystem->Run([this] { ExportMemoryStatistics(); }, &counter);
+	mJobSystem->Wait(counter);
+}
+
+// ============================================================================
+// Listener for key presses within the window.
+//
+// Runtime calls this function when a key is pressed in the window. Pressing F12
+// starts a command capture of the next frames, which is written once complete.
+// ============================================================================
+void View::OnKeyDown(CoreWindow^ sender, KeyEventArgs^ args)
+{
+	if (args->VirtualKey == Windows::System::VirtualKey::F12 && !args->KeyStatus.WasKeyDown) {
+		mRenderer->StartCapture(CAPTURE_FRAME_COUNT);
+	}
+}
+
+// ============================================================================
+// Export the profiled frames into a trace file.
+//
+// Writes the last frames as a Chrome trace into the local folder of the app,
+// where it can be fetched e.g. with the device portal and opened in Chrome.
+// ============================================================================
+void View::ExportTrace()
+{
+	auto folder = ApplicationData::Current->LocalFolder->Path;
+	std::ofstream file(std::wstring(folder->Data()) + L"\\frame_trace.json", std::ios::binary);
+	file << FrameProfiler::Instance().ExportChromeTrace(TRACE_EXPORT_FRAMES);
+}
+
+// ============================================================================
+// Export the memory statistics of the renderer into a JSON file.
+//
+// Writes the memory budget, the usage of each category and the trimmed memory
+// into the local folder of the app next to the trace file.
+// ============================================================================
+void View::ExportMemoryStatistics()
+{
+	auto folder = ApplicationData::Current->LocalFolder->Path;
+	std::ofstream file(std::wstring(folder->Data()) + L"\\memory_budget.json", std::ios::binary);
+	file << mRenderer->ExportMemoryStatistics();
+}
+
+// ============================================================================
+// Export the completed command capture into a capture file.
+//
+// Writes the captured frames into the local folder of the app, where it can be
+// fetched and replayed on a headless backend with the replay capture tool.
+// ============================================================================
+void View::ExportCapture()
+{
+	auto folder = ApplicationData::Current->LocalFolder->Path;
+	std::ofstream file(std::wstring(folder->Data()) + L"\\capture.bin", std::ios::binary);
+	mRenderer->SaveCapture(file);
 }
\ No newline at end of file
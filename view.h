@@ -1,6 +1,36 @@
 #pragma once
 
+#include "asset_streamer.h"
+#include "job_system.h"
+#include "mapped_file.h"
 #include "renderer.h"
+#include "simulation.h"
+
+#include <memory>
+
+// the amount of frames written into the trace file when the view is closed.
+#define TRACE_EXPORT_FRAMES 120
+
+// the amount of frames recorded into the command capture when it's requested.
+#define CAPTURE_FRAME_COUNT 60
+
+// the path of the mesh drawn by the application within the package.
+#define MESH_ASSET_PATH "Assets\\triangle.mesh"
+
+// the amount of background threads which load the assets.
+#define STREAMING_THREADS 1
+
+// the maximum amount of streamed asset bytes uploaded per frame.
+#define STREAMING_UPLOAD_BUDGET (4 * 1024 * 1024)
+
+// the amount of simulation steps per second.
+#define SIMULATION_STEP_RATE 60
+
+// the maximum amount of simulation steps to catch up after a stall.
+#define SIMULATION_MAX_STEPS 4
+
+// the rotation speed of the triangle in radians per second.
+#define TRIANGLE_ROTATION_SPEED 1.0
 
 // ============================================================================
 // An object that presents the view for the application.
@@ -20,8 +50,18 @@ protected:
 	void OnActivated(Windows::ApplicationModel::Core::CoreApplicationView^ applicationView, Windows::ApplicationModel::Activation::IActivatedEventArgs^ args);
 	void OnVisibilityChanged(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::VisibilityChangedEventArgs^ args);
 	void OnClosed(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::CoreWindowEventArgs^ args);
+	void OnKeyDown(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::KeyEventArgs^ args);
+private:
+	void ExportTrace();
+	void ExportCapture();
+	void ExportMemoryStatistics();
 private:
-	bool		mWindowClosed;
-	bool		mWindowVisible;
-	Renderer^	mRenderer;
+	bool								mWindowClosed;
+	bool								mWindowVisible;
+	std::unique_ptr<JobSystem>			mJobSystem;
+	std::unique_ptr<SteadyClock>		mClock;
+	std::unique_ptr<Simulation>			mSimulation;
+	std::unique_ptr<MappedFileSource>	mFileSource;
+	std::unique_ptr<AssetStreamer>		mAssetStreamer;
+	Renderer^							mRenderer;
 };
@@ -0,0 +1,93 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(unsigned threadCount) : mTask(nullptr), mNextIndex(0), mCount(0), mGeneration(0), mActiveCount(0), mExit(false)
+{
+	// the calling thread works as one of the threads so spawn one less.
+	for (auto i = 1u; i < threadCount; i++) {
+		mThreads.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWakeup.notify_all();
+	for (auto& thread : mThreads) {
+		thread.join();
+	}
+}
+
+// ============================================================================
+// Run the given task for each index in range [0, count) in parallel.
+//
+// Function returns after all indices have been processed. Indices are handed
+// out dynamically so workers that finish early will pick up remaining work.
+// ============================================================================
+void WorkerPool::ParallelFor(unsigned count, const std::function<void(unsigned)>& task)
+{
+	// run the loop directly on the calling thread when there are no workers.
+	if (mThreads.empty() || count <= 1) {
+		for (auto i = 0u; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	// publish the loop for the workers.
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTask = &task;
+		mCount = count;
+		mNextIndex = 0;
+		mActiveCount = static_cast<unsigned>(mThreads.size());
+		mGeneration++;
+	}
+	mWakeup.notify_all();
+
+	// take part in the work and wait until all workers have finished.
+	RunTasks();
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this] { return mActiveCount == 0; });
+	mTask = nullptr;
+}
+
+// ============================================================================
+// The main loop of a worker thread.
+//
+// Workers sleep until a new loop is published or the pool is being destroyed.
+// Each worker reports back when no more indices are left for it to process.
+// ============================================================================
+void WorkerPool::WorkerMain()
+{
+	auto generation = 0u;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWakeup.wait(lock, [&] { return mExit || mGeneration != generation; });
+			if (mExit) {
+				return;
+			}
+			generation = mGeneration;
+		}
+		RunTasks();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mActiveCount == 0) {
+				mDone.notify_one();
+			}
+		}
+	}
+}
+
+// ============================================================================
+// Process loop indices until all of them have been handed out.
+// ============================================================================
+void WorkerPool::RunTasks()
+{
+	for (auto i = mNextIndex++; i < mCount; i = mNextIndex++) {
+		(*mTask)(i);
+	}
+}
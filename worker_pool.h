@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// A pool of persistent worker threads for data parallel loops.
+//
+// Pool distributes the indices of a loop to the workers and the calling thread
+// which also takes part in the work. Threads are kept alive between the loops.
+// ============================================================================
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned threadCount);
+	~WorkerPool();
+	void ParallelFor(unsigned count, const std::function<void(unsigned)>& task);
+	unsigned ThreadCount() const { return static_cast<unsigned>(mThreads.size()) + 1; }
+private:
+	void WorkerMain();
+	void RunTasks();
+private:
+	std::vector<std::thread>				mThreads;
+	std::mutex								mMutex;
+	std::condition_variable					mWakeup;
+	std::condition_variable					mDone;
+	const std::function<void(unsigned)>*	mTask;
+	std::atomic<unsigned>					mNextIndex;
+	unsigned								mCount;
+	unsigned								mGeneration;
+	unsigned								mActiveCount;
+	bool									mExit;
+};